@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cxxmidi/message.hpp>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "event_view.hpp"
+#include "midi_constants.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Which notes are sounding, per channel, as sent to the output port
+ * 
+ * A 16 x 128 bitmap of lock-free atomic words. The playback engine calls
+ * observe() for every message it sends; NoteOn sets a bit, NoteOff or
+ * NoteOn with velocity 0 clears it, and All Notes Off / All Sound Off clear
+ * the channel.
+ * 
+ * release() sends a NoteOn with velocity 0 for each held note only, instead
+ * of sweeping every note on every channel. It takes each word with an atomic
+ * exchange and writes into a caller-provided 3-byte message, so it neither
+ * locks nor allocates and may be called from a signal handler.
+ */
+class ActiveNotes {
+public:
+    static constexpr size_t CHANNELS = 16;
+    static constexpr size_t NOTES = 128;
+    
+    ActiveNotes() { clear(); }
+    
+    // Disable copy/move: shared by reference between threads
+    ActiveNotes(const ActiveNotes&) = delete;
+    ActiveNotes& operator=(const ActiveNotes&) = delete;
+    
+    /**
+     * @brief Update the bitmap for a message about to be sent
+     */
+    void observe(const EventView& message) noexcept {
+        if (message.size() < 3) {
+            return;
+        }
+        uint8_t type = message[0] & Midi::STATUS_TYPE_MASK;
+        uint8_t channel = message[0] & Midi::CHANNEL_MASK;
+        uint8_t data1 = message[1] & 0x7F;
+        
+        if (type == Midi::NOTE_ON && message[2] > 0) {
+            word(channel, data1).fetch_or(bit(data1), std::memory_order_relaxed);
+            channels_.fetch_or(static_cast<uint16_t>(1u << channel), std::memory_order_relaxed);
+        } else if (type == Midi::NOTE_ON || type == Midi::NOTE_OFF) {
+            word(channel, data1).fetch_and(~bit(data1), std::memory_order_relaxed);
+        } else if (type == Midi::CONTROL_CHANGE
+                   && (data1 == Midi::CC_ALL_NOTES_OFF || data1 == Midi::CC_ALL_SOUND_OFF)) {
+            bits_[channel][0].store(0, std::memory_order_relaxed);
+            bits_[channel][1].store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    bool isHeld(uint8_t channel, uint8_t note) const noexcept {
+        return (bits_[channel & Midi::CHANNEL_MASK][(note & 0x7F) / 64].load(std::memory_order_relaxed)
+                & bit(note & 0x7F)) != 0;
+    }
+    
+    /**
+     * @brief Number of notes currently held on all channels
+     */
+    size_t count() const noexcept {
+        size_t total = 0;
+        for (const auto& channel : bits_) {
+            for (const auto& w : channel) {
+                total += static_cast<size_t>(std::popcount(w.load(std::memory_order_relaxed)));
+            }
+        }
+        return total;
+    }
+    
+    /**
+     * @brief Channels that have played a note since construction, bit n for channel n
+     */
+    uint16_t getChannelsUsed() const noexcept { return channels_.load(std::memory_order_relaxed); }
+    
+    void clear() noexcept {
+        for (auto& channel : bits_) {
+            for (auto& w : channel) {
+                w.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    /**
+     * @brief Release every held note; async-signal-safe
+     * @param output Anything with SendMessage(const cxxmidi::Message*)
+     * @param scratch Message of exactly 3 bytes, reused for every send
+     * @param allNotesOff Also send All Notes Off on every channel that has played
+     * @return Number of notes released
+     */
+    template <typename Output>
+    size_t release(Output& output, cxxmidi::Message& scratch, bool allNotesOff = false) noexcept {
+        size_t released = 0;
+        
+        for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+            for (uint8_t half = 0; half < 2; half++) {
+                uint64_t held = bits_[channel][half].exchange(0, std::memory_order_relaxed);
+                while (held != 0) {
+                    int index = std::countr_zero(held);
+                    held &= held - 1;
+                    
+                    scratch[0] = static_cast<uint8_t>(Midi::NOTE_ON | channel);
+                    scratch[1] = static_cast<uint8_t>(half * 64 + index);
+                    scratch[2] = 0;
+                    output.SendMessage(&scratch);
+                    released++;
+                }
+            }
+        }
+        
+        if (allNotesOff) {
+            uint16_t used = channels_.load(std::memory_order_relaxed);
+            for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+                if (used & (1u << channel)) {
+                    scratch[0] = static_cast<uint8_t>(Midi::CONTROL_CHANGE | channel);
+                    scratch[1] = Midi::CC_ALL_NOTES_OFF;
+                    scratch[2] = 0;
+                    output.SendMessage(&scratch);
+                }
+            }
+        }
+        
+        return released;
+    }
+    
+private:
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "note bitmap must be lock-free");
+    static_assert(std::atomic<uint16_t>::is_always_lock_free, "channel mask must be lock-free");
+    
+    static constexpr uint64_t bit(uint8_t note) noexcept { return uint64_t{1} << (note % 64); }
+    std::atomic<uint64_t>& word(uint8_t channel, uint8_t note) noexcept { return bits_[channel][note / 64]; }
+    
+    std::array<std::array<std::atomic<uint64_t>, 2>, CHANNELS> bits_;
+    std::atomic<uint16_t> channels_{0};
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <unistd.h>
+
+namespace MidiPlay {
+
+/**
+ * @brief Append-only buffer for building binary cache images
+ *
+ * Fixed-size values are written in host byte order; cache files are
+ * machine-local and are rebuilt whenever the format version changes.
+ * Variable-length quantities use LEB128 (7 bits per byte, low group first).
+ */
+class ByteWriter {
+public:
+    template<typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>, "put() requires a trivially copyable type");
+        putBytes(&value, sizeof(value));
+    }
+
+    void putVarint(uint32_t value) {
+        do {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            if (value != 0) {
+                byte |= 0x80;
+            }
+            buffer_.push_back(byte);
+        } while (value != 0);
+    }
+
+    void putBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    void putString(const std::string& text) {
+        putVarint(static_cast<uint32_t>(text.size()));
+        putBytes(text.data(), text.size());
+    }
+
+    /**
+     * @brief Overwrite a previously written fixed-size value
+     * @param offset Byte offset returned by size() before the value was written
+     */
+    template<typename T>
+    void patch(size_t offset, T value) {
+        static_assert(std::is_trivially_copyable_v<T>, "patch() requires a trivially copyable type");
+        std::memcpy(buffer_.data() + offset, &value, sizeof(value));
+    }
+
+    void reserve(size_t size) { buffer_.reserve(size); }
+    size_t size() const { return buffer_.size(); }
+    const std::vector<uint8_t>& data() const { return buffer_; }
+
+private:
+    std::vector<uint8_t> buffer_;
+};
+
+/**
+ * @brief Bounds-checked reader over a binary cache image
+ *
+ * Every accessor returns false instead of reading past the end, so a
+ * truncated or corrupt cache file is simply treated as a cache miss.
+ */
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size)
+        : data_(data)
+        , size_(size)
+        , offset_(0)
+    {
+    }
+
+    template<typename T>
+    bool get(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "get() requires a trivially copyable type");
+        if (remaining() < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool getVarint(uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (offset_ >= size_) {
+                return false;
+            }
+            uint8_t byte = data_[offset_++];
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;   // Over-long encoding
+    }
+
+    /**
+     * @brief Zero-copy access to the next @p size bytes
+     */
+    bool getBytes(const uint8_t*& bytes, size_t size) {
+        if (remaining() < size) {
+            return false;
+        }
+        bytes = data_ + offset_;
+        offset_ += size;
+        return true;
+    }
+
+    bool getString(std::string& text) {
+        uint32_t length = 0;
+        const uint8_t* bytes = nullptr;
+        if (!getVarint(length) || !getBytes(bytes, length)) {
+            return false;
+        }
+        text.assign(reinterpret_cast<const char*>(bytes), length);
+        return true;
+    }
+
+    size_t remaining() const { return size_ - offset_; }
+    size_t offset() const { return offset_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+};
+
+/**
+ * @brief Replace a file's contents without ever exposing a partial write
+ *
+ * Writes to a temporary file next to @p path, private to the process and the
+ * call (loaders on several threads may store at once), then renames it over
+ * the destination. Readers see either the old or the new image.
+ *
+ * @return true if the file was replaced
+ */
+inline bool writeFileAtomically(const std::string& path, const std::vector<uint8_t>& data) {
+    static std::atomic<unsigned> sequence{0};
+    std::string tempPath = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(sequence++);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            out.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace MidiPlay
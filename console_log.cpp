@@ -0,0 +1,138 @@
+#include "console_log.hpp"
+#include "i18n.hpp"
+#include "midi_markers.hpp"
+#include "realtime_scheduler.hpp"
+
+#include <cxxmidi/event.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <system_error>
+
+#ifdef DEBUG
+#include <ecocommon/utility.hpp>
+#endif
+
+namespace MidiPlay {
+
+ConsoleLog::ConsoleLog(std::ostream& out)
+    : out_(out)
+{
+}
+
+ConsoleLog::~ConsoleLog() {
+    stop();
+}
+
+ConsoleLog& ConsoleLog::immediate() {
+    static ConsoleLog log(std::cout);   // Never started
+    return log;
+}
+
+bool ConsoleLog::start() {
+    if (running_) {
+        return true;
+    }
+    quit_ = false;
+    try {
+        thread_ = std::thread([this]() { run(); });
+    } catch (const std::system_error&) {
+        return false;
+    }
+    running_.store(true, std::memory_order_release);
+    return true;
+}
+
+void ConsoleLog::stop() {
+    if (!running_) {
+        return;
+    }
+    quit_ = true;
+    thread_.join();
+    running_.store(false, std::memory_order_release);
+    drain();    // Posted after the thread's last look
+}
+
+void ConsoleLog::post(ConsoleMessage message, int32_t value) {
+    Record record{};
+    record.message = message;
+    record.value = value;
+    enqueue(record);
+}
+
+void ConsoleLog::postEvent(const EventView& event) {
+    Record record{};
+    record.message = ConsoleMessage::Event;
+    record.dt = event.dt();
+    record.size = static_cast<uint8_t>(std::min(event.size(), EVENT_BYTES));
+    std::memcpy(record.bytes.data(), event.data(), record.size);
+    enqueue(record);
+}
+
+void ConsoleLog::enqueue(const Record& record) {
+    if (!running_.load(std::memory_order_acquire)) {
+        write(record);
+    } else if (!queue_.push(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Drain thread
+void ConsoleLog::run() {
+    // Started from the main thread, which may be under --realtime: never compete with the player
+    RealtimeScheduler::releaseCurrentThread();
+
+    while (!quit_.load(std::memory_order_acquire)) {
+        drain();
+        std::this_thread::sleep_for(DRAIN_INTERVAL);
+    }
+    drain();
+}
+
+void ConsoleLog::drain() {
+    while (std::optional<Record> record = queue_.pop()) {
+        write(*record);
+    }
+}
+
+void ConsoleLog::write(const Record& record) {
+    switch (record.message) {
+    case ConsoleMessage::PlayingIntroduction:
+        out_ << _(" Playing introduction") << std::endl;
+        break;
+
+    case ConsoleMessage::PlayingVerse:
+        out_ << _(" Playing verse ") << record.value << std::endl;
+        break;
+
+    case ConsoleMessage::PlayingLastVerse:
+        out_ << _(" Playing verse ") << record.value << _(", last verse") << std::endl;
+        break;
+
+    case ConsoleMessage::Ritardando:
+        out_ << _("  Ritardando") << std::endl;
+        break;
+
+    case ConsoleMessage::DaCapoAlFine:
+        out_ << MidiMarkers::D_C_AL_FINE << std::endl;
+        break;
+
+    case ConsoleMessage::IntroMarkerWarning:
+        out_ << _("   Warning: Final intro marker not past last NoteOff event") << std::endl;
+        break;
+
+    case ConsoleMessage::Event:
+#ifdef DEBUG
+        {
+            cxxmidi::Event event;
+            event.SetDt(record.dt);
+            event.assign(record.bytes.begin(), record.bytes.begin() + record.size);
+            dumpEvent(event);
+        }
+#endif
+        break;
+    }
+}
+
+} // namespace MidiPlay
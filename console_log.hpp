@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+
+#include "event_view.hpp"
+#include "spsc_queue.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Line printed while a hymn plays
+ */
+enum class ConsoleMessage : uint8_t {
+    PlayingIntroduction,
+    PlayingVerse,           // value: verse number
+    PlayingLastVerse,       // value: verse number
+    Ritardando,
+    DaCapoAlFine,
+    IntroMarkerWarning,     // Final intro marker not past the last NoteOff
+    Event                   // Debug dump of the event bytes (verbose DEBUG builds)
+};
+
+/**
+ * @brief Console output of the player thread, written by another thread
+ *
+ * Writing to the terminal can block for as long as the terminal likes (a
+ * slow SSH session, a paused terminal), so the player thread does not
+ * print. It posts a message ID with its number into a lock-free ring, and
+ * a drain thread, started for the duration of playback, formats, translates
+ * and writes the lines. Posting is a few stores: no lock, no allocation,
+ * no system call. The drain thread drops any real-time scheduling it
+ * inherits (RealtimeScheduler::releaseCurrentThread()), so it runs at normal
+ * priority off the player's core, and polls the ring every DRAIN_INTERVAL:
+ * lines appear at most that late. A full ring drops the message and counts it.
+ *
+ * Only one thread posts at a time: the player thread while it plays, and
+ * the thread sequencing the sections while the player is stopped. When the
+ * drain thread is not running, post() writes the line at once.
+ */
+class ConsoleLog {
+public:
+    static constexpr size_t CAPACITY = 256;
+    static constexpr size_t EVENT_BYTES = 16;   // Longer events are dumped truncated
+    static constexpr std::chrono::milliseconds DRAIN_INTERVAL{20};
+
+    /**
+     * @param out Stream the lines are written to
+     */
+    explicit ConsoleLog(std::ostream& out);
+
+    /**
+     * @brief Stops the drain thread after writing what is left
+     */
+    ~ConsoleLog();
+
+    // Disable copy/move
+    ConsoleLog(const ConsoleLog&) = delete;
+    ConsoleLog& operator=(const ConsoleLog&) = delete;
+
+    /**
+     * @brief Start the drain thread; post() queues from now on
+     * @return false if the thread could not be started (lines are then written at once)
+     */
+    bool start();
+
+    /**
+     * @brief Write everything queued and stop the drain thread
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Print a line, from the drain thread if it runs
+     * @param value Number the message carries (verse)
+     */
+    void post(ConsoleMessage message, int32_t value = 0);
+
+    /**
+     * @brief Dump an event, from the drain thread if it runs
+     */
+    void postEvent(const EventView& event);
+
+    /**
+     * @brief Log writing to standard output at once, for components used without a running log
+     */
+    static ConsoleLog& immediate();
+
+    /**
+     * @brief Messages lost to a full ring
+     */
+    size_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Record {
+        ConsoleMessage message;
+        uint8_t size;           // Event bytes kept
+        int32_t value;
+        uint32_t dt;
+        std::array<uint8_t, EVENT_BYTES> bytes;
+    };
+
+    void enqueue(const Record& record);
+    void run();
+    void drain();
+    void write(const Record& record);
+
+    std::ostream& out_;
+    SpscQueue<Record, CAPACITY> queue_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> quit_{false};
+    std::atomic<size_t> dropped_{0};
+    std::thread thread_;
+};
+
+} // namespace MidiPlay
@@ -3,11 +3,13 @@
 namespace MidiPlay {
     // Application-wide shared constants
     constexpr int MICROSECONDS_PER_MINUTE = 60000000;
+    constexpr int MICROSECONDS_PER_SECOND = 1000000;
     constexpr int SECONDS_PER_MINUTE = 60;
     constexpr int QUARTER_NOTE_DENOMINATOR = 4;
     constexpr int EXIT_FILE_NOT_FOUND = 2;
     constexpr int EXIT_DEVICE_NOT_FOUND = 6;
     constexpr int EXIT_ENVIRONMENT_ERROR = 3;
+    constexpr int EXIT_LINT_ISSUES = 7;         // --lint found problems in at least one file
     constexpr int DEFAULT_VERSES = 1;
     
     // Options parse result codes
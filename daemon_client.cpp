@@ -0,0 +1,106 @@
+#include "daemon_client.hpp"
+#include "binary_io.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace MidiPlay {
+
+DaemonClient::DaemonClient(std::string socketPath)
+    : socketPath_(std::move(socketPath))
+{
+}
+
+DaemonClient::~DaemonClient() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool DaemonClient::connect() {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath_.empty() || socketPath_.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath_.c_str(), socketPath_.size() + 1);
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+int DaemonClient::run(int argc, char** argv, std::ostream& out) {
+    if (fd_ < 0) {
+        return EXIT_FAILURE;
+    }
+
+    std::error_code ec;
+    ByteWriter payload;
+    payload.putString(std::filesystem::current_path(ec).string());
+    payload.putVarint(static_cast<uint32_t>(argc));
+    for (int i = 0; i < argc; i++) {
+        payload.putString(argv[i]);
+    }
+
+    ByteWriter message;
+    message.put(static_cast<uint32_t>(payload.size()));
+    message.putBytes(payload.data().data(), payload.size());
+
+    const std::vector<uint8_t>& bytes = message.data();
+    if (::send(fd_, bytes.data(), bytes.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(bytes.size())) {
+        return EXIT_FAILURE;
+    }
+
+    // Output until NUL, then the exit code
+    char buffer[4096];
+    std::string trailer;
+    bool done = false;
+    while (true) {
+        ssize_t n = ::read(fd_, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+
+        size_t length = static_cast<size_t>(n);
+        if (!done) {
+            const char* end = static_cast<const char*>(std::memchr(buffer, '\0', length));
+            size_t text = end ? static_cast<size_t>(end - buffer) : length;
+            out.write(buffer, static_cast<std::streamsize>(text));
+            out.flush();
+            if (!end) {
+                continue;
+            }
+            done = true;
+            trailer.append(end + 1, length - text - 1);
+        } else {
+            trailer.append(buffer, length);
+        }
+    }
+
+    int32_t code = EXIT_FAILURE;
+    if (!done || trailer.size() < sizeof(code)) {
+        return EXIT_FAILURE;
+    }
+    std::memcpy(&code, trailer.data(), sizeof(code));
+    return code;
+}
+
+} // namespace MidiPlay
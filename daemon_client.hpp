@@ -0,0 +1,43 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+namespace MidiPlay {
+
+/**
+ * @brief Thin `play` client that hands its command line to a running daemon
+ *
+ * See DaemonServer for the wire format. The client prints whatever the
+ * daemon sends and exits with the daemon's exit code. Ctrl-C closes the
+ * connection, which makes the daemon stop the hymn and silence the organ.
+ */
+class DaemonClient {
+public:
+    explicit DaemonClient(std::string socketPath);
+    ~DaemonClient();
+
+    DaemonClient(const DaemonClient&) = delete;
+    DaemonClient& operator=(const DaemonClient&) = delete;
+
+    /**
+     * @brief Connect to the daemon
+     * @return false if no daemon is listening; play standalone instead
+     */
+    bool connect();
+
+    /**
+     * @brief Send the command line and relay the daemon's output until it is done
+     * @param argc Argument count, as passed to main
+     * @param argv Arguments, as passed to main
+     * @param out Where the daemon's output goes
+     * @return Exit code of the request, or EXIT_FAILURE if the connection broke
+     */
+    int run(int argc, char** argv, std::ostream& out = std::cout);
+
+private:
+    std::string socketPath_;
+    int fd_ = -1;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,285 @@
+#include "daemon_server.hpp"
+#include "binary_io.hpp"
+#include "realtime_scheduler.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace MidiPlay {
+
+namespace {
+
+bool readFully(int fd, void* data, size_t size) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = ::read(fd, bytes, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool makeAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+DaemonServer::DaemonServer(std::string socketPath)
+    : socketPath_(std::move(socketPath))
+{
+}
+
+DaemonServer::~DaemonServer() {
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        ::unlink(socketPath_.c_str());
+    }
+}
+
+bool DaemonServer::listen() {
+    sockaddr_un address;
+    if (!makeAddress(socketPath_, address)) {
+        error_ = "socket path too long: " + socketPath_;
+        return false;
+    }
+
+    // Replace a socket file left by a daemon that did not exit cleanly
+    std::error_code ec;
+    if (std::filesystem::exists(socketPath_, ec)) {
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool running = probe >= 0
+            && ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (running) {
+            error_ = "a daemon is already listening on " + socketPath_;
+            return false;
+        }
+        ::unlink(socketPath_.c_str());
+    }
+
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        error_ = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listenFd_, 4) != 0) {
+        error_ = socketPath_ + ": " + std::strerror(errno);
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    // A client that goes away must not take the daemon with it
+    std::signal(SIGPIPE, SIG_IGN);
+    return true;
+}
+
+void DaemonServer::serve(const Handler& handler) {
+    while (listenFd_ >= 0) {
+        if (!serveOne(handler) && errno != EINTR) {
+            std::perror("accept");
+        }
+    }
+}
+
+bool DaemonServer::serveOne(const Handler& handler) {
+    int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    DaemonRequest request;
+    if (readRequest(fd, request)) {
+        int rc = handle(fd, request, handler);
+
+        uint8_t end = 0;
+        int32_t code = rc;
+        writeFully(fd, &end, sizeof(end));
+        writeFully(fd, &code, sizeof(code));
+    }
+
+    ::close(fd);
+    return true;
+}
+
+void DaemonServer::setHangupCallback(const Callback& callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    hangupCallback_ = callback;
+    
+    // The client may already be gone, e.g. while the hymn was loading
+    if (hungUp_ && hangupCallback_) {
+        hangupCallback_();
+    }
+}
+
+std::string DaemonServer::defaultSocketPath() {
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && *runtimeDir) {
+        return std::string(runtimeDir) + "/midiplay.sock";
+    }
+    return "/tmp/midiplay-" + std::to_string(getuid()) + ".sock";
+}
+
+bool DaemonServer::readRequest(int fd, DaemonRequest& request) {
+    uint32_t size = 0;
+    if (!readFully(fd, &size, sizeof(size)) || size > MAX_REQUEST_SIZE) {
+        return false;
+    }
+
+    std::vector<uint8_t> payload(size);
+    if (!readFully(fd, payload.data(), payload.size())) {
+        return false;
+    }
+
+    ByteReader reader(payload.data(), payload.size());
+    uint32_t argc = 0;
+    if (!reader.getString(request.workingDirectory) || !reader.getVarint(argc) || argc == 0) {
+        return false;
+    }
+
+    request.args.resize(argc);
+    for (std::string& arg : request.args) {
+        if (!reader.getString(arg)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs the handler with standard output going to the client
+int DaemonServer::handle(int fd, const DaemonRequest& request, const Handler& handler) {
+    int wake[2];
+    if (::pipe2(wake, O_CLOEXEC) != 0) {
+        return EXIT_FAILURE;
+    }
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        hungUp_ = false;
+    }
+    std::thread watcher([this, fd, &wake]() { watchHangup(fd, wake[0]); });
+
+    std::error_code ec;
+    std::filesystem::path previousDirectory = std::filesystem::current_path(ec);
+    if (!request.workingDirectory.empty()) {
+        std::filesystem::current_path(request.workingDirectory, ec);
+    }
+
+    std::cout.flush();
+    std::fflush(stdout);
+    std::cerr.flush();
+    int savedStdout = ::dup(STDOUT_FILENO);
+    int savedStderr = ::dup(STDERR_FILENO);
+    ::dup2(fd, STDOUT_FILENO);
+    ::dup2(fd, STDERR_FILENO);
+
+    int rc = EXIT_FAILURE;
+    try {
+        rc = handler(request);
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+    }
+
+    // Writes fail once the client is gone; clear that before the next request
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(stdout);
+    std::cout.clear();
+    std::cerr.clear();
+    std::clearerr(stdout);
+    ::dup2(savedStdout, STDOUT_FILENO);
+    ::dup2(savedStderr, STDERR_FILENO);
+    ::close(savedStdout);
+    ::close(savedStderr);
+
+    if (!previousDirectory.empty()) {
+        std::filesystem::current_path(previousDirectory, ec);
+    }
+
+    uint8_t done = 0;
+    ssize_t ignored = ::write(wake[1], &done, sizeof(done));
+    (void)ignored;
+    watcher.join();
+    ::close(wake[0]);
+    ::close(wake[1]);
+
+    setHangupCallback(nullptr);
+    return rc;
+}
+
+// Watcher thread: the client sends nothing after its request, so anything
+// readable on its socket means it hung up
+void DaemonServer::watchHangup(int fd, int wakeFd) {
+    RealtimeScheduler::releaseCurrentThread();  // Started from the main thread, which may play
+
+    pollfd fds[2] = {
+        {fd, POLLIN | POLLRDHUP, 0},
+        {wakeFd, POLLIN, 0}
+    };
+
+    while (true) {
+        int n = ::poll(fds, 2, -1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 || fds[1].revents != 0) {
+            return;
+        }
+        if (fds[0].revents != 0) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    hungUp_ = true;
+    if (hangupCallback_) {
+        hangupCallback_();
+    }
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MidiPlay {
+
+/**
+ * @brief Command line forwarded by a `play` client to the daemon
+ */
+struct DaemonRequest {
+    std::vector<std::string> args;      // argv of the client, including argv[0]
+    std::string workingDirectory;       // Client's current directory, for relative file names
+};
+
+/**
+ * @brief Unix domain socket server behind `play --daemon`
+ *
+ * The daemon keeps the MIDI port open and the device configured; each
+ * client connection carries one request. While the request is handled,
+ * standard output and standard error are redirected to the client so
+ * everything the player prints appears in the client's terminal. The exit
+ * code follows the output after a NUL byte.
+ *
+ * Wire format, client to daemon: uint32 payload length, then the payload
+ * written with ByteWriter: working directory string, varint argument count,
+ * argument strings. Daemon to client: output text, NUL, int32 exit code.
+ * Both in host byte order; the socket never leaves the machine.
+ *
+ * Requests are served one at a time. If the client goes away while its
+ * request is running (Ctrl-C in the client), the hangup callback fires on
+ * a watcher thread so playback can be cancelled.
+ */
+class DaemonServer {
+public:
+    using Handler = std::function<int(const DaemonRequest& request)>;
+    using Callback = std::function<void()>;
+
+    /**
+     * @param socketPath Path of the socket file
+     */
+    explicit DaemonServer(std::string socketPath);
+
+    /**
+     * @brief Closes the socket and removes the socket file
+     */
+    ~DaemonServer();
+
+    DaemonServer(const DaemonServer&) = delete;
+    DaemonServer& operator=(const DaemonServer&) = delete;
+
+    /**
+     * @brief Create the socket file and start listening
+     *
+     * A leftover socket file without a daemon behind it is replaced.
+     * @return false if the socket cannot be created or another daemon is running;
+     *         see getError()
+     */
+    bool listen();
+
+    /**
+     * @brief Accept and handle requests until the process ends
+     */
+    void serve(const Handler& handler);
+
+    /**
+     * @brief Accept and handle one request
+     * @return false if accepting failed
+     */
+    bool serveOne(const Handler& handler);
+
+    /**
+     * @brief Called on a watcher thread if the client of the running request disconnects
+     * Called at once if it already has. Thread-safe; pass nullptr to clear
+     */
+    void setHangupCallback(const Callback& callback);
+
+    const std::string& getSocketPath() const { return socketPath_; }
+    const std::string& getError() const { return error_; }
+
+    /**
+     * @brief Socket used when none is given
+     * @return $XDG_RUNTIME_DIR/midiplay.sock, or /tmp/midiplay-<uid>.sock
+     */
+    static std::string defaultSocketPath();
+
+    static constexpr size_t MAX_REQUEST_SIZE = 64 * 1024;
+
+private:
+    bool readRequest(int fd, DaemonRequest& request);
+    int handle(int fd, const DaemonRequest& request, const Handler& handler);
+    void watchHangup(int fd, int wakeFd);
+
+    std::string socketPath_;
+    int listenFd_ = -1;
+    std::string error_;
+
+    std::mutex callbackMutex_;
+    Callback hangupCallback_;
+    bool hungUp_ = false;
+};
+
+} // namespace MidiPlay
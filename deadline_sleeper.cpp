@@ -0,0 +1,31 @@
+#include "deadline_sleeper.hpp"
+
+#include <cerrno>
+#include <ctime>
+#include <sys/prctl.h>
+
+namespace MidiPlay {
+
+void DeadlineSleeper::sleepUntil(Clock::time_point deadline, std::chrono::nanoseconds spin) {
+    Clock::time_point wake = deadline - spin;
+    if (Clock::now() < wake) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wake.time_since_epoch()).count();
+        timespec target;
+        target.tv_sec = static_cast<time_t>(ns / 1000000000);
+        target.tv_nsec = static_cast<long>(ns % 1000000000);
+
+        // Absolute, so a signal only means sleeping again to the same time
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR) {
+        }
+    }
+
+    while (Clock::now() < deadline) {
+        // Spin the last stretch
+    }
+}
+
+bool DeadlineSleeper::reduceTimerSlack() {
+    return prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL) == 0;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+
+namespace MidiPlay {
+
+/**
+ * @brief Waits for an absolute CLOCK_MONOTONIC deadline as closely as the kernel allows
+ *
+ * sleepUntil() sleeps with clock_nanosleep(TIMER_ABSTIME) to a little before
+ * the deadline, then spins on the clock for the rest. The sleep is to a time,
+ * not for a duration, so a late wake-up or a signal never shifts the next
+ * deadline; the spin takes out the scheduler's wake-up latency and the
+ * timer slack.
+ *
+ * std::chrono::steady_clock is CLOCK_MONOTONIC on Linux, so a deadline
+ * computed from it can be passed straight in.
+ */
+class DeadlineSleeper {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Return at @p deadline, not before; at once if it has passed
+     * @param spin Time before the deadline spent spinning instead of sleeping
+     */
+    static void sleepUntil(Clock::time_point deadline, std::chrono::nanoseconds spin = DEFAULT_SPIN);
+
+    /**
+     * @brief Ask for timer wake-ups on time rather than up to 50 us late (calling thread only)
+     * @return false if the kernel refused
+     */
+    static bool reduceTimerSlack();
+
+    static constexpr std::chrono::nanoseconds DEFAULT_SPIN{50000};
+};
+
+} // namespace MidiPlay
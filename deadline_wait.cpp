@@ -0,0 +1,15 @@
+#include "deadline_wait.hpp"
+#include "deadline_sleeper.hpp"
+
+namespace MidiPlay {
+
+// Player thread, with no lock held
+void DeadlineWait::sleepUntil(Clock::time_point deadline) {
+    if (!timerSlackReduced_) {
+        DeadlineSleeper::reduceTimerSlack();
+        timerSlackReduced_ = true;
+    }
+    DeadlineSleeper::sleepUntil(deadline, SPIN);
+}
+
+} // namespace MidiPlay
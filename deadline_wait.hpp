@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "jitter_recorder.hpp"
+#include "virtual_clock.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief How the player thread waits for its next deadline
+ *
+ * By default on the player's condition variable, so a transport change cuts
+ * the wait short. With precise timing only until WAKE_AHEAD before the
+ * deadline; DeadlineSleeper covers the rest with an absolute clock_nanosleep
+ * and a spin of SPIN, and a change during that stretch is seen once it ends.
+ * With a VirtualClock it never waits: the clock moves to the deadline.
+ *
+ * Configured before playback; until() runs on the player thread only.
+ */
+class DeadlineWait {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param clock Clock that outlives the wait, or nullptr for real time
+     */
+    void setVirtualClock(VirtualClock* clock) { virtualClock_ = clock; }
+    void setPrecise(bool precise) { precise_ = precise; }
+    bool isPrecise() const { return precise_; }
+
+    Clock::time_point now() const { return virtualClock_ ? virtualClock_->now() : Clock::now(); }
+
+    /**
+     * @brief Time in nanoseconds as JitterRecorder samples are, on the same clock as now()
+     */
+    int64_t nowNs() const { return virtualClock_ ? virtualClock_->nowNs() : JitterRecorder::now(); }
+
+    /**
+     * @brief Wait for @p deadline unless @p changed holds first
+     * @param lock Lock on the mutex behind @p condition; held on entry and on return
+     * @return false if @p changed cut the wait short
+     */
+    template <typename Predicate>
+    bool until(std::condition_variable& condition, std::unique_lock<std::mutex>& lock,
+               Clock::time_point deadline, Predicate changed) {
+        if (virtualClock_) {
+            virtualClock_->advanceTo(deadline);     // Nothing to wait for
+            return true;
+        }
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+        if (!precise_) {
+            return !condition.wait_until(lock, deadline, changed);
+        }
+
+        // Interruptible most of the way, then an absolute sleep and a spin without the lock
+        if (condition.wait_until(lock, deadline - WAKE_AHEAD, changed)) {
+            return false;
+        }
+        lock.unlock();
+        sleepUntil(deadline);
+        lock.lock();
+        return !changed();
+    }
+
+    /**
+     * @brief Times the player thread woke from a wait
+     */
+    uint64_t getWakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+    static constexpr std::chrono::microseconds WAKE_AHEAD{1000};    // Uninterruptible stretch before a deadline
+    static constexpr std::chrono::microseconds SPIN{50};            // Spun rather than slept
+
+private:
+    void sleepUntil(Clock::time_point deadline);
+
+    VirtualClock* virtualClock_ = nullptr;
+    bool precise_ = false;
+    bool timerSlackReduced_ = false;    // Player thread only
+    std::atomic<uint64_t> wakeups_{0};
+};
+
+} // namespace MidiPlay
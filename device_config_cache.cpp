@@ -0,0 +1,197 @@
+#include "device_config_cache.hpp"
+#include "binary_io.hpp"
+#include "mapped_file.hpp"
+
+#include <filesystem>
+#include <system_error>
+
+namespace MidiPlay {
+
+DeviceConfigCache::DeviceConfigCache(std::string directory)
+    : directory_(std::move(directory))
+{
+}
+
+std::string DeviceConfigCache::getCachePath() const {
+    return directory_ + "/" + FILE_NAME;
+}
+
+bool DeviceConfigCache::load(const std::string& yamlPath, DeviceManager::YamlConfig& config) const {
+    if (directory_.empty()) {
+        return false;
+    }
+
+    HymnCache::SourceStamp stamp;
+    if (!HymnCache::stampSource(yamlPath, stamp)) {
+        return false;
+    }
+
+    MappedFile image(getCachePath());
+    if (!image.isOpen()) {
+        return false;
+    }
+
+    ByteReader reader(image.data(), image.size());
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    std::string cachedPath;
+    if (!reader.get(magic) || magic != MAGIC
+        || !reader.get(version) || version != FORMAT_VERSION
+        || !reader.get(size) || size != stamp.size
+        || !reader.get(mtimeNs) || mtimeNs != stamp.mtimeNs
+        || !reader.getString(cachedPath) || cachedPath != stamp.canonicalPath) {
+        return false;   // Missing, stale, another YAML file or another format version
+    }
+
+    // Decode into a scratch config so a corrupt image never leaves the caller half-populated
+    DeviceManager::YamlConfig decoded;
+    int32_t timeoutIterations = 0;
+    int32_t pollSleepSeconds = 0;
+    uint64_t minPortCount = 0;
+    int32_t outputPortIndex = 0;
+    uint32_t secondaryCount = 0;
+    if (!reader.getString(decoded.version)
+        || !reader.get(timeoutIterations)
+        || !reader.get(pollSleepSeconds)
+        || !reader.get(minPortCount)
+        || !reader.get(outputPortIndex)
+        || !reader.getVarint(secondaryCount)
+        || secondaryCount > reader.remaining()) {
+        return false;
+    }
+    decoded.connection.secondary_outputs.resize(secondaryCount);
+    for (std::string& port : decoded.connection.secondary_outputs) {
+        if (!reader.getString(port)) {
+            return false;
+        }
+    }
+
+    uint32_t deviceCount = 0;
+    if (!reader.getVarint(deviceCount)) {
+        return false;
+    }
+    decoded.connection.timeout_iterations = timeoutIterations;
+    decoded.connection.poll_sleep_seconds = pollSleepSeconds;
+    decoded.connection.min_port_count = static_cast<std::size_t>(minPortCount);
+    decoded.connection.output_port_index = outputPortIndex;
+
+    for (uint32_t d = 0; d < deviceCount; d++) {
+        std::string key;
+        DeviceManager::DeviceConfig device;
+        uint32_t detectionCount = 0;
+        if (!reader.getString(key)
+            || !reader.getString(device.name)
+            || !reader.getString(device.description)
+            || !reader.getVarint(detectionCount)
+            || detectionCount > reader.remaining()) {
+            return false;
+        }
+
+        device.detection_strings.resize(detectionCount);
+        for (std::string& detection : device.detection_strings) {
+            if (!reader.getString(detection)) {
+                return false;
+            }
+        }
+
+        uint32_t channelCount = 0;
+        if (!reader.getVarint(channelCount) || channelCount > reader.remaining()) {
+            return false;
+        }
+        for (uint32_t c = 0; c < channelCount; c++) {
+            int32_t number = 0;
+            DeviceManager::ChannelConfig channel;
+            if (!reader.get(number)
+                || !reader.get(channel.bank_msb)
+                || !reader.get(channel.bank_lsb)
+                || !reader.get(channel.program)
+                || !reader.getString(channel.description)) {
+                return false;
+            }
+            device.channels[number] = std::move(channel);
+        }
+
+        uint32_t setupSize = 0;
+        const uint8_t* setup = nullptr;
+        if (!reader.getVarint(setupSize) || !reader.getBytes(setup, setupSize)) {
+            return false;
+        }
+        device.setupMessages.assign(setup, setup + setupSize);
+
+        if (!reader.getString(device.output) || !reader.getString(device.rawmidi_device)) {
+            return false;
+        }
+
+        decoded.devices[key] = std::move(device);
+    }
+
+    config = std::move(decoded);
+    return true;
+}
+
+bool DeviceConfigCache::store(const std::string& yamlPath, const DeviceManager::YamlConfig& config) const {
+    if (directory_.empty()) {
+        return false;
+    }
+
+    HymnCache::SourceStamp stamp;
+    if (!HymnCache::stampSource(yamlPath, stamp)) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        return false;
+    }
+
+    ByteWriter writer;
+    writer.put(MAGIC);
+    writer.put(FORMAT_VERSION);
+    writer.put(stamp.size);
+    writer.put(stamp.mtimeNs);
+    writer.putString(stamp.canonicalPath);
+
+    writer.putString(config.version);
+    writer.put(static_cast<int32_t>(config.connection.timeout_iterations));
+    writer.put(static_cast<int32_t>(config.connection.poll_sleep_seconds));
+    writer.put(static_cast<uint64_t>(config.connection.min_port_count));
+    writer.put(static_cast<int32_t>(config.connection.output_port_index));
+    writer.putVarint(static_cast<uint32_t>(config.connection.secondary_outputs.size()));
+    for (const std::string& port : config.connection.secondary_outputs) {
+        writer.putString(port);
+    }
+
+    writer.putVarint(static_cast<uint32_t>(config.devices.size()));
+    for (const auto& [key, device] : config.devices) {
+        writer.putString(key);
+        writer.putString(device.name);
+        writer.putString(device.description);
+
+        writer.putVarint(static_cast<uint32_t>(device.detection_strings.size()));
+        for (const std::string& detection : device.detection_strings) {
+            writer.putString(detection);
+        }
+
+        writer.putVarint(static_cast<uint32_t>(device.channels.size()));
+        for (const auto& [number, channel] : device.channels) {
+            writer.put(static_cast<int32_t>(number));
+            writer.put(channel.bank_msb);
+            writer.put(channel.bank_lsb);
+            writer.put(channel.program);
+            writer.putString(channel.description);
+        }
+
+        writer.putVarint(static_cast<uint32_t>(device.setupMessages.size()));
+        writer.putBytes(device.setupMessages.data(), device.setupMessages.size());
+        writer.putString(device.output);
+        writer.putString(device.rawmidi_device);
+    }
+
+    return writeFileAtomically(getCachePath(), writer.data());
+}
+
+} // namespace MidiPlay
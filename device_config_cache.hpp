@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "device_manager.hpp"
+#include "hymn_cache.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief On-disk cache of the parsed device configuration
+ *
+ * Stores DeviceManager::YamlConfig, including each device's ready-to-send
+ * setup messages, in one compact binary image next to the hymn cache, so
+ * startup needs neither yaml-cpp nor rebuilding the setup messages. The
+ * image is keyed like a HymnCache entry by the YAML file's canonical path,
+ * modification time and size; editing midi_devices.yaml makes it stale.
+ *
+ * Cache failures are never fatal: load() reports a miss and the caller
+ * parses the YAML file.
+ *
+ * Image layout (host byte order, LEB128 for variable-length values):
+ *   header:     magic, format version, source size, source mtime (ns), source path
+ *   connection: version string, timeout iterations, poll sleep, min port count, port index
+ *   devices:    device count, then per device: key, name, description,
+ *               detection strings, channels (number, bank MSB/LSB, program,
+ *               description), setup message bytes, output, rawmidi device
+ */
+class DeviceConfigCache {
+public:
+    /**
+     * @param directory Directory holding the image (created on first store)
+     */
+    explicit DeviceConfigCache(std::string directory = HymnCache::defaultDirectory());
+
+    /**
+     * @brief Load the cached configuration of a YAML file
+     * @return true on a cache hit, false if missing, stale or unreadable
+     */
+    bool load(const std::string& yamlPath, DeviceManager::YamlConfig& config) const;
+
+    /**
+     * @brief Store the configuration parsed from a YAML file
+     * @return true if the image was written
+     */
+    bool store(const std::string& yamlPath, const DeviceManager::YamlConfig& config) const;
+
+    std::string getCachePath() const;
+
+    static constexpr uint32_t FORMAT_VERSION = 3;
+
+private:
+    std::string directory_;
+
+    static constexpr uint32_t MAGIC = 0x4344504D;   // "MPDC"
+    static constexpr const char* FILE_NAME = "devices.mdc";
+};
+
+} // namespace MidiPlay
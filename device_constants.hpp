@@ -9,6 +9,11 @@ namespace MidiPlay {
         constexpr std::size_t MIN_PORT_COUNT = 2;
         constexpr int POLL_SLEEP_SECONDS = 2;
         constexpr int OUTPUT_PORT_INDEX = 1;
+        constexpr int RECONNECT_TIMEOUT_SECONDS = 30;   // --reconnect: longest wait for a device that went away mid-hymn
+        
+        // Values of a device's "output" setting
+        constexpr const char* OUTPUT_SEQUENCER = "sequencer";
+        constexpr const char* OUTPUT_RAWMIDI = "rawmidi";
         
         // Casio CTX-3000 device-specific constants
         namespace Casio {
@@ -2,12 +2,20 @@
 #include "constants.hpp"
 #include "options.hpp"
 #include "i18n.hpp"
+#include "port_watcher.hpp"
+#include "hymn_cache.hpp"
+#include "device_config_cache.hpp"
+#include "output_fan_out.hpp"
+#include "rawmidi_output.hpp"
 
 #include <cxxmidi/output/default.hpp>
 #include <cxxmidi/message.hpp>
 #include <cxxmidi/event.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
+#include <thread>
 #include <iostream>
 #include <unistd.h>
 #include <cstdlib>
@@ -48,6 +56,7 @@ namespace MidiPlay {
     DeviceManager::DeviceManager(const Options& options)
         : options_(options)
         , yamlConfig_()  // Initialize as empty optional
+        , cacheDirectory_(HymnCache::defaultDirectory())
     {
     }
 
@@ -85,6 +94,82 @@ namespace MidiPlay {
         configureDeviceFromYaml(deviceKey, outport);
     }
 
+    bool DeviceManager::connectRawMidi(DeviceType type, const DeviceInfo& device, cxxmidi::output::Default& outport,
+                                       OutputFanOut& fanOut) {
+        if (!yamlConfig_.has_value() || type == DeviceType::UNKNOWN) {
+            return false;
+        }
+        auto deviceIt = yamlConfig_->devices.find(deviceTypeToKey(type));
+        if (deviceIt == yamlConfig_->devices.end() || !deviceIt->second.usesRawMidi()) {
+            return false;
+        }
+
+        const DeviceConfig& config = deviceIt->second;
+        std::string rawDevice = config.rawmidi_device.empty()
+            ? RawMidiOutput::deviceForPort(device.portName) : config.rawmidi_device;
+        if (rawDevice.empty()) {
+            if (options_.isDisplayWarnings()) {
+                std::cout << _("   Warning: ") << _("No rawmidi device behind ") << device.portName
+                          << _("; playing through the sequencer.") << std::endl;
+            }
+            return false;
+        }
+
+        // The sequencer keeps the rawmidi device open while its port is subscribed
+        outport.ClosePort();
+        auto raw = std::make_unique<RawMidiOutput>();
+        if (!raw->open(rawDevice)) {
+            if (options_.isDisplayWarnings()) {
+                std::cout << _("   Warning: ") << raw->getError() << _("; playing through the sequencer.") << std::endl;
+            }
+            outport.OpenPort(device.portIndex);
+            return false;
+        }
+
+        if (options_.isVerbose()) {
+            std::cout << _("Playing directly to: ") << rawDevice << std::endl;
+        }
+        fanOut.setPrimary(std::move(raw), true);
+        return true;
+    }
+
+    std::size_t DeviceManager::connectSecondaryOutputs(OutputFanOut& fanOut, const std::string& primaryPortName) {
+        if (!yamlConfig_.has_value()) {
+            return 0;
+        }
+
+        std::size_t added = 0;
+        cxxmidi::output::Default scanner;
+        for (const std::string& wanted : yamlConfig_->connection.secondary_outputs) {
+            if (wanted.empty()) {
+                continue;
+            }
+
+            bool found = false;
+            size_t portCount = scanner.GetPortCount();
+            for (unsigned int i = 0; i < portCount && !found; i++) {
+                std::string portName = scanner.GetPortName(i);
+                if (portName == primaryPortName || portName.find(wanted) != 0) {
+                    continue;
+                }
+                auto port = std::make_unique<cxxmidi::output::Default>();
+                port->OpenPort(i);
+                fanOut.addPort(std::move(port), portName);
+                found = true;
+                added++;
+
+                if (options_.isVerbose()) {
+                    std::cout << _("Also sending to: ") << portName << std::endl;
+                }
+            }
+
+            if (!found && options_.isDisplayWarnings()) {
+                std::cout << _("   Warning: ") << _("Secondary output not connected: ") << wanted << std::endl;
+            }
+        }
+        return added;
+    }
+
     std::string DeviceManager::getDeviceTypeName(DeviceType type) {
         // If YAML is loaded, get device name from configuration
         if (yamlConfig_.has_value() && type != DeviceType::UNKNOWN) {
@@ -122,11 +207,30 @@ namespace MidiPlay {
                                    "  ./midi_devices.yaml (local)"));
         }
 
-        parseYamlFile(yamlPath);
-        // yamlConfig_ is now set by parseYamlContent
+        // The cache holds the parsed configuration and the setup messages, keyed by the YAML file's mtime
+        bool useCache = options_.isCacheEnabled() && !cacheDirectory_.empty();
+        DeviceConfigCache cache(cacheDirectory_);
+        YamlConfig cached;
+        loadedFromCache_ = useCache && cache.load(yamlPath, cached);
+
+        if (loadedFromCache_) {
+            yamlConfig_ = std::move(cached);
+        } else {
+            parseYamlFile(yamlPath);
+            // yamlConfig_ is now set by parseYamlContent
+
+            for (auto& [deviceKey, device] : yamlConfig_->devices) {
+                device.setupMessages = buildSetupMessages(device);
+            }
+
+            if (useCache) {
+                cache.store(yamlPath, *yamlConfig_);
+            }
+        }
         
         if (options_.isVerbose()) {
-            std::cout << _("Loaded device configuration from: ") << yamlPath << std::endl;
+            std::cout << _("Loaded device configuration from: ") << yamlPath
+                      << (loadedFromCache_ ? _(" (cached)") : "") << std::endl;
         }
     }
 
@@ -204,6 +308,11 @@ namespace MidiPlay {
                 if (conn["output_port_index"]) {
                     newConfig.connection.output_port_index = conn["output_port_index"].as<int>();
                 }
+                if (conn["secondary_outputs"]) {
+                    for (const auto& port : conn["secondary_outputs"]) {
+                        newConfig.connection.secondary_outputs.push_back(port.as<std::string>());
+                    }
+                }
             }
 
             // Parse device configurations
@@ -223,6 +332,16 @@ namespace MidiPlay {
                         deviceConfig.description = deviceNode["description"].as<std::string>();
                     }
                     
+                    if (deviceNode["output"]) {
+                        deviceConfig.output = deviceNode["output"].as<std::string>();
+                        if (deviceConfig.output != MidiPlay::Device::OUTPUT_SEQUENCER && !deviceConfig.usesRawMidi()) {
+                            throw std::runtime_error(_("Unknown output for device ") + deviceKey + ": " + deviceConfig.output);
+                        }
+                    }
+                    if (deviceNode["rawmidi_device"]) {
+                        deviceConfig.rawmidi_device = deviceNode["rawmidi_device"].as<std::string>();
+                    }
+                    
                     // Parse detection strings
                     if (deviceNode["detection_strings"]) {
                         const YAML::Node& detectionStrings = deviceNode["detection_strings"];
@@ -310,38 +429,122 @@ namespace MidiPlay {
         }
 
         const DeviceConfig& config = deviceIt->second;
+        sendSetupMessages(config, outport);
         
-        // Configure each channel according to YAML specification
+        if (options_.isVerbose()) {
+            for (const auto& [channelNum, channelConfig] : config.channels) {
+                std::cout << _("  Channel ") << channelNum << ": " << channelConfig.description
+                          << _(" (Bank ") << static_cast<int>(channelConfig.bank_msb) << ":"
+                          << static_cast<int>(channelConfig.bank_lsb) << _(", Program ")
+                          << static_cast<int>(channelConfig.program) << ")" << std::endl;
+            }
+        }
+    }
+
+    // Sends the precomputed setup messages; the sequencer port takes one message per write
+    void DeviceManager::sendSetupMessages(const DeviceConfig& config, cxxmidi::output::Abstract& port) {
+        const std::vector<std::uint8_t>& setup = config.setupMessages.empty()
+            ? buildSetupMessages(config) : config.setupMessages;
+        Message message;
+        for (std::size_t i = 0; i < setup.size(); ) {
+            std::size_t length = (setup[i] & 0xF0) == Message::kProgramChange ? 2 : 3;
+            length = std::min(length, setup.size() - i);
+            message.assign(setup.begin() + i, setup.begin() + i + length);
+            port.SendMessage(&message);
+            i += length;
+        }
+    }
+
+    const DeviceManager::DeviceConfig* DeviceManager::findDeviceConfig(DeviceType type) const {
+        if (!yamlConfig_.has_value() || type == DeviceType::UNKNOWN) {
+            return nullptr;
+        }
+        auto deviceIt = yamlConfig_->devices.find(deviceTypeToKey(type));
+        return deviceIt == yamlConfig_->devices.end() ? nullptr : &deviceIt->second;
+    }
+
+    // Port of a device that was connected before, or -1 if it is not (yet) back
+    int DeviceManager::findDevicePort(const DeviceInfo& device, cxxmidi::output::Default& outport) {
+        // The sequencer may give the device a new client number when it comes back
+        auto withoutAddress = [](const std::string& name) {
+            int client = 0;
+            int port = 0;
+            return RawMidiOutput::parseSequencerAddress(name, client, port) ? name.substr(0, name.rfind(' ')) : name;
+        };
+        std::string name = withoutAddress(device.portName);
+
+        int sameType = -1;
+        std::size_t portCount = outport.GetPortCount();
+        for (std::size_t i = 0; i < portCount; i++) {
+            std::string portName = outport.GetPortName(static_cast<unsigned int>(i));
+            if (withoutAddress(portName) == name) {
+                return static_cast<int>(i);
+            }
+            if (sameType < 0 && device.type != DeviceType::UNKNOWN && detectDeviceType(portName) == device.type) {
+                sameType = static_cast<int>(i);
+            }
+        }
+        return sameType;
+    }
+
+    bool DeviceManager::reconnectDevice(DeviceInfo& device, cxxmidi::output::Default& outport, OutputFanOut& fanOut) {
+        int portIndex = findDevicePort(device, outport);
+        if (portIndex < 0) {
+            return false;
+        }
+        std::string portName = outport.GetPortName(static_cast<unsigned int>(portIndex));
+        const DeviceConfig* config = findDeviceConfig(device.type);
+
+        if (auto* raw = dynamic_cast<RawMidiOutput*>(&fanOut.getPrimary())) {
+            std::string rawDevice = config && !config->rawmidi_device.empty()
+                ? config->rawmidi_device : RawMidiOutput::deviceForPort(portName);
+            if (rawDevice.empty() || !raw->open(rawDevice)) {
+                return false;   // The card may not have its rawmidi device yet
+            }
+            if (config) {
+                const std::vector<std::uint8_t>& setup = config->setupMessages.empty()
+                    ? buildSetupMessages(*config) : config->setupMessages;
+                raw->write(setup.data(), setup.size());
+            }
+        } else {
+            outport.ClosePort();
+            outport.OpenPort(static_cast<unsigned int>(portIndex));
+            if (config) {
+                sendSetupMessages(*config, outport);
+            }
+        }
+
+        device.portName = portName;
+        device.portIndex = portIndex;
+        return true;
+    }
+
+    std::vector<std::uint8_t> DeviceManager::buildSetupMessages(const DeviceConfig& config) {
+        std::vector<std::uint8_t> setup;
+        setup.reserve(config.channels.size() * 8);
+
         for (const auto& [channelNum, channelConfig] : config.channels) {
             // Convert 1-based channel numbers to MIDI channel messages
             std::uint8_t midiChannel = static_cast<std::uint8_t>(channelNum - 1);
-            
-            // Send Bank Select MSB
+
+            // Bank Select MSB
             if (channelConfig.bank_msb != 0) {
-                Event bankMsbEvent(0, midiChannel | Message::kControlChange,
-                                  0, channelConfig.bank_msb);
-                outport.SendMessage(&bankMsbEvent);
+                setup.insert(setup.end(), {static_cast<std::uint8_t>(midiChannel | Message::kControlChange),
+                                           0, channelConfig.bank_msb});
             }
-            
-            // Send Bank Select LSB
+
+            // Bank Select LSB
             if (channelConfig.bank_lsb != 0) {
-                Event bankLsbEvent(0, midiChannel | Message::kControlChange,
-                                  32, channelConfig.bank_lsb);
-                outport.SendMessage(&bankLsbEvent);
-            }
-            
-            // Send Program Change
-            Event programEvent(0, midiChannel | Message::kProgramChange,
-                              channelConfig.program);
-            outport.SendMessage(&programEvent);
-            
-            if (options_.isVerbose()) {
-                std::cout << _("  Channel ") << channelNum << ": " << channelConfig.description
-                          << _(" (Bank ") << static_cast<int>(channelConfig.bank_msb) << ":"
-                          << static_cast<int>(channelConfig.bank_lsb) << _(", Program ")
-                          << static_cast<int>(channelConfig.program) << ")" << std::endl;
+                setup.insert(setup.end(), {static_cast<std::uint8_t>(midiChannel | Message::kControlChange),
+                                           32, channelConfig.bank_lsb});
             }
+
+            // Program Change
+            setup.insert(setup.end(), {static_cast<std::uint8_t>(midiChannel | Message::kProgramChange),
+                                       channelConfig.program});
         }
+
+        return setup;
     }
 
     bool DeviceManager::waitForDeviceConnection(cxxmidi::output::Default& outport) {
@@ -350,14 +553,14 @@ namespace MidiPlay {
         int pollSleep = yamlConfig_.has_value() ? yamlConfig_->connection.poll_sleep_seconds : MidiPlay::Device::POLL_SLEEP_SECONDS;
         std::size_t minPortCount = yamlConfig_.has_value() ? yamlConfig_->connection.min_port_count : MidiPlay::Device::MIN_PORT_COUNT;
         
-        for (int i = 0; i <= timeoutLimit; i++) {
-            // Check if we've reached the timeout limit
-            if (i > timeoutLimit) {
-                std::cout << _("Device connection timeout. No device found. Connect a MIDI device and try again.\n")
-                         << std::endl;
-                return false;  // Timeout reached
-            }
-
+        // The connection settings bound the total wait; a port announcement ends it early
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutLimit * pollSleep);
+        
+        // Subscribed before the first scan, so a device switched on in between is not missed
+        PortWatcher watcher;
+        bool prompted = false;
+        
+        while (true) {
             // Check current port count
             size_t portCount = outport.GetPortCount();
 
@@ -372,19 +575,26 @@ namespace MidiPlay {
 
             // Check if we have sufficient ports for device connection
             if (portCount >= minPortCount) {
-                break;  // We have a device. Exit the polling loop.
+                return true;  // We have a device
             }
-            else {
-                // No device connected yet, continue polling
+            
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                return false;  // Timeout reached
+            }
+            
+            // No device connected yet; wait for one to be announced
+            if (watcher.isActive()) {
+                if (!prompted) {
+                    std::cout << _("No device connected. Connect a device.") << std::endl;
+                    prompted = true;
+                }
+                watcher.waitForChange(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now));
+            } else {
                 std::cout << _("No device connected. Connect a device.") << std::endl;
-                sleep(pollSleep);
-                
-                // Refresh port count for next iteration
-                // Note: GetPortCount() will re-scan for available ports
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - now, std::chrono::seconds(pollSleep)));
             }
         }
-
-        return true;  // Device connection successful
     }
 
 } // namespace MidiPlay
\ No newline at end of file
@@ -17,6 +17,8 @@ class Options;
 
 namespace MidiPlay {
 
+    class OutputFanOut;
+
     /**
      * @brief Device key constants for YAML configuration
      */
@@ -102,6 +104,55 @@ namespace MidiPlay {
          */
         void createAndConfigureDevice(DeviceType type, cxxmidi::output::Default& outport);
 
+        /**
+         * @brief Play through the device's rawmidi port if it is configured for it
+         *
+         * With output: rawmidi for the detected device, the sequencer port
+         * (already used for the setup messages) is closed, as it holds the
+         * rawmidi device while open, and a RawMidiOutput on the device named
+         * by rawmidi_device, or found behind the port, becomes the fan-out's
+         * primary port. If the device cannot be opened, the sequencer port
+         * is opened again and playback goes through it as before.
+         *
+         * @param type The detected device type
+         * @param device Connected port
+         * @param outport The open sequencer port
+         * @param fanOut Fan-out whose primary port is @p outport
+         * @return true if the fan-out now writes to the rawmidi device
+         */
+        bool connectRawMidi(DeviceType type, const DeviceInfo& device, cxxmidi::output::Default& outport,
+                            OutputFanOut& fanOut);
+
+        /**
+         * @brief Reopen a device that went away and came back, and send its setup again
+         *
+         * The port is found by its name without the sequencer address,
+         * which may change, or failing that by device type. The cached
+         * setup messages are sent again. A fan-out playing to a rawmidi
+         * port gets the same RawMidiOutput reopened, and the setup written
+         * to it in one go; the sequencer port is left closed as before.
+         * Returns at once; the caller waits for the device (DeviceReconnector).
+         *
+         * @param device Device connected before; updated to the new port
+         * @param outport Sequencer port; reopened unless playing to rawmidi
+         * @param fanOut Fan-out whose primary port is @p outport or a RawMidiOutput
+         * @return false if the device is not back yet or could not be opened
+         */
+        bool reconnectDevice(DeviceInfo& device, cxxmidi::output::Default& outport, OutputFanOut& fanOut);
+
+        /**
+         * @brief Open the configured secondary output ports and add them to a fan-out
+         *
+         * Each entry of connection.secondary_outputs is matched against the
+         * beginning of the port names, like detection_strings. A port that is
+         * not connected is reported and skipped; the performance goes ahead.
+         *
+         * @param fanOut Fan-out whose primary port is already open
+         * @param primaryPortName Never opened a second time
+         * @return Number of ports added
+         */
+        std::size_t connectSecondaryOutputs(OutputFanOut& fanOut, const std::string& primaryPortName);
+
         /**
          * @brief Get human-readable name for device type
          * @param type The device type
@@ -121,31 +172,6 @@ namespace MidiPlay {
          */
         void loadDevicePresets(const std::string& configPath = "");
 
-    private:
-        /**
-         * @brief Detect device type based on MIDI port name
-         * 
-         * Analyzes the port name string to determine which type of
-         * MIDI device is connected. Uses string matching against
-         * known device identifier patterns.
-         * 
-         * @param portName The MIDI port name as reported by the system
-         * @return DeviceType enumeration value
-         */
-        DeviceType detectDeviceType(const std::string& portName);
-
-        /**
-         * @brief Wait for MIDI device connection with timeout
-         * 
-         * Polls for device availability until either a device is found
-         * or the connection timeout is reached. Provides user feedback
-         * during the waiting process.
-         * 
-         * @param outport Reference to the MIDI output port
-         * @return true if device connected successfully, false on timeout
-         */
-        bool waitForDeviceConnection(cxxmidi::output::Default& outport);
-
         // YAML configuration data structures
         struct ChannelConfig {
             std::uint8_t bank_msb = 0;
@@ -159,6 +185,11 @@ namespace MidiPlay {
             std::string description;
             std::vector<std::string> detection_strings;
             std::map<int, ChannelConfig> channels;
+            std::vector<std::uint8_t> setupMessages;    ///< Bank select and program changes for every channel, back to back
+            std::string output = MidiPlay::Device::OUTPUT_SEQUENCER;  ///< "rawmidi" writes the performance straight to the device
+            std::string rawmidi_device;     ///< ALSA rawmidi name, e.g. "hw:1,0,0"; empty: the one behind the port
+
+            bool usesRawMidi() const { return output == MidiPlay::Device::OUTPUT_RAWMIDI; }
         };
 
         struct ConnectionConfig {
@@ -166,6 +197,7 @@ namespace MidiPlay {
             int poll_sleep_seconds = MidiPlay::Device::POLL_SLEEP_SECONDS;
             std::size_t min_port_count = MidiPlay::Device::MIN_PORT_COUNT;
             int output_port_index = MidiPlay::Device::OUTPUT_PORT_INDEX;
+            std::vector<std::string> secondary_outputs;    ///< Port name prefixes that get a copy of every event
         };
 
         struct YamlConfig {
@@ -174,11 +206,58 @@ namespace MidiPlay {
             std::map<std::string, DeviceConfig> devices;
         };
 
+        /**
+         * @brief Override the config cache location (default: HymnCache::defaultDirectory())
+         * @param directory Cache directory; empty disables caching
+         */
+        void setCacheDirectory(const std::string& directory) { cacheDirectory_ = directory; }
+
+        /**
+         * @brief Whether the last loadDevicePresets() came from the config cache
+         */
+        bool isLoadedFromCache() const { return loadedFromCache_; }
+
+        /**
+         * @brief Build the setup messages a device is sent on connection
+         * @return Bank select MSB/LSB (when not 0) and program change per channel
+         */
+        static std::vector<std::uint8_t> buildSetupMessages(const DeviceConfig& config);
+
+    private:
+        /**
+         * @brief Detect device type based on MIDI port name
+         * 
+         * Analyzes the port name string to determine which type of
+         * MIDI device is connected. Uses string matching against
+         * known device identifier patterns.
+         * 
+         * @param portName The MIDI port name as reported by the system
+         * @return DeviceType enumeration value
+         */
+        DeviceType detectDeviceType(const std::string& portName);
+
+        /**
+         * @brief Wait for MIDI device connection with timeout
+         * 
+         * Rescans the ports whenever the ALSA sequencer announces a new or
+         * changed port (see PortWatcher), until a device is found or
+         * timeout_iterations x poll_sleep_seconds have passed. Falls back to
+         * rescanning every poll_sleep_seconds if announcements are unavailable.
+         * Provides user feedback during the waiting process.
+         * 
+         * @param outport Reference to the MIDI output port
+         * @return true if device connected successfully, false on timeout
+         */
+        bool waitForDeviceConnection(cxxmidi::output::Default& outport);
+
         // Options reference for configuration access
         const Options& options_;
         
         // YAML configuration state (using std::optional for clear semantics)
         std::optional<YamlConfig> yamlConfig_;
+        
+        std::string cacheDirectory_;
+        bool loadedFromCache_ = false;
 
         // YAML parsing and file discovery methods
         std::string findConfigFile(const std::string& specifiedPath = "");
@@ -186,6 +265,9 @@ namespace MidiPlay {
         void parseYamlContent(const YAML::Node& config);
         DeviceType detectDeviceTypeFromYaml(const std::string& portName);
         void configureDeviceFromYaml(const std::string& deviceKey, cxxmidi::output::Default& outport);
+        const DeviceConfig* findDeviceConfig(DeviceType type) const;
+        int findDevicePort(const DeviceInfo& device, cxxmidi::output::Default& outport);
+        static void sendSetupMessages(const DeviceConfig& config, cxxmidi::output::Abstract& port);
         
         // Helper methods for device key conversion
         std::string deviceTypeToKey(DeviceType type) const;
@@ -0,0 +1,150 @@
+#include "device_reconnector.hpp"
+
+#include "output_fan_out.hpp"
+#include "port_watcher.hpp"
+#include "rawmidi_output.hpp"
+#include "realtime_scheduler.hpp"
+
+#include <algorithm>
+
+namespace MidiPlay {
+
+namespace {
+
+int clientOf(const std::string& portName) {
+    int client = -1;
+    int port = 0;
+    return RawMidiOutput::parseSequencerAddress(portName, client, port) ? client : -1;
+}
+
+} // namespace
+
+DeviceReconnector::DeviceReconnector(DeviceManager& manager, const DeviceInfo& device,
+                                     cxxmidi::output::Default& outport, OutputFanOut& fanOut)
+    : manager_(manager)
+    , device_(device)
+    , outport_(outport)
+    , fanOut_(fanOut)
+    , timeout_(std::chrono::seconds(Device::RECONNECT_TIMEOUT_SECONDS))
+    , client_(clientOf(device.portName))
+{
+}
+
+DeviceReconnector::~DeviceReconnector() {
+    unwatch();
+}
+
+void DeviceReconnector::watch(const LostCallback& lost) {
+    unwatch();
+    lost_ = lost;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+        isLost_ = false;
+        errorBaseline_ = writeErrors();
+    }
+    thread_ = std::thread([this]() { run(); });
+}
+
+void DeviceReconnector::unwatch() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool DeviceReconnector::reconnect() {
+    auto deadline = std::chrono::steady_clock::now() + timeout_;
+
+    // Subscribed before the first look, so a device announced in between is not missed
+    PortWatcher watcher;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_) {
+                return false;
+            }
+        }
+        if (manager_.reconnectDevice(device_, outport_, fanOut_)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            client_ = clientOf(device_.portName);
+            errorBaseline_ = writeErrors();
+            isLost_ = false;
+            cv_.notify_all();
+            return true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        auto wait = std::min(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now), POLL_INTERVAL);
+        // Looked at again without an announcement too, e.g. for a card whose rawmidi device was not ready
+        if (watcher.isActive()) {
+            watcher.waitForChange(wait);
+        } else {
+            std::this_thread::sleep_for(wait);
+        }
+    }
+}
+
+// Watching thread: wait for the device to go, report it, wait for reconnect()
+void DeviceReconnector::run() {
+    RealtimeScheduler::releaseCurrentThread();
+
+    PortWatcher watcher;
+
+    while (true) {
+        int client;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (isLost_) {
+                cv_.wait(lock, [this]() { return stop_ || !isLost_; });
+                if (!stop_) {
+                    lock.unlock();
+                    watcher.waitForChange(std::chrono::milliseconds(0));    // Drop the old port's departure
+                    continue;
+                }
+            }
+            if (stop_) {
+                return;
+            }
+            client = client_;
+        }
+
+        bool gone = false;
+        if (watcher.isActive() && client >= 0) {
+            gone = watcher.waitForExit(client, POLL_INTERVAL);
+        } else {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, POLL_INTERVAL, [this]() { return stop_; });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_) {
+                return;
+            }
+            gone = gone || writeErrors() > errorBaseline_;
+            if (!gone) {
+                continue;
+            }
+            isLost_ = true;
+        }
+        if (lost_) {
+            lost_();
+        }
+    }
+}
+
+uint64_t DeviceReconnector::writeErrors() const {
+    auto* raw = dynamic_cast<const RawMidiOutput*>(&fanOut_.getPrimary());
+    return raw ? raw->getWriteErrors() : 0;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cxxmidi/output/default.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "device_manager.hpp"
+
+namespace MidiPlay {
+
+class OutputFanOut;
+
+/**
+ * @brief Notices the organ's port going away mid-hymn and brings it back
+ *
+ * A USB-MIDI adapter that resets, as cheap ones next to an organ's power
+ * supply do, leaves the ALSA sequencer and is announced again a moment
+ * later. While watching, a thread waits on the sequencer's announcements
+ * for the device's client to leave, and checks a rawmidi port, if one is
+ * played to, for failed writes; either is reported once through the lost
+ * callback. reconnect(), run by the player (TimelinePlayer's reconnect
+ * callback), waits for the device to be announced again and reopens it
+ * with DeviceManager::reconnectDevice(), which sends the cached setup
+ * again. Nothing is reloaded; the hymn stays in memory throughout.
+ *
+ * The device, port and fan-out are only touched by reconnect(), so the
+ * thread calling it must be the only one sending at the time.
+ */
+class DeviceReconnector {
+public:
+    using LostCallback = std::function<void()>;
+
+    /**
+     * @param manager Manager that connected the device, with its configuration loaded
+     * @param device The connected device
+     * @param outport Sequencer port the device was connected on
+     * @param fanOut Fan-out the performance is sent to
+     */
+    DeviceReconnector(DeviceManager& manager, const DeviceInfo& device,
+                      cxxmidi::output::Default& outport, OutputFanOut& fanOut);
+
+    /**
+     * @brief Stops watching
+     */
+    ~DeviceReconnector();
+
+    // Disable copy/move: the watching thread refers to this object
+    DeviceReconnector(const DeviceReconnector&) = delete;
+    DeviceReconnector& operator=(const DeviceReconnector&) = delete;
+
+    /**
+     * @brief Start watching the device
+     * @param lost Runs on the watching thread when the device is lost, once until reconnect() succeeds
+     */
+    void watch(const LostCallback& lost);
+
+    /**
+     * @brief Stop watching; a reconnect() waiting for the device gives up
+     */
+    void unwatch();
+
+    /**
+     * @brief Wait for the lost device to come back and reopen it
+     * @return false if it is not back within the timeout, or unwatch() was called
+     */
+    bool reconnect();
+
+    /**
+     * @brief Longest wait in reconnect(); default RECONNECT_TIMEOUT_SECONDS
+     */
+    void setTimeout(std::chrono::milliseconds timeout) { timeout_ = timeout; }
+
+    /**
+     * @brief The device, with the port it was last connected on
+     */
+    const DeviceInfo& getDevice() const { return device_; }
+
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{100};  // Longest wait between checks
+
+private:
+    void run();
+    uint64_t writeErrors() const;
+
+    DeviceManager& manager_;
+    DeviceInfo device_;
+    cxxmidi::output::Default& outport_;
+    OutputFanOut& fanOut_;
+    std::chrono::milliseconds timeout_;
+    LostCallback lost_;
+
+    // === State (guarded by mutex_) ===
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int client_ = -1;               // Sequencer client of the device's port
+    uint64_t errorBaseline_ = 0;    // Failed rawmidi writes already accounted for
+    bool isLost_ = false;
+    bool stop_ = false;
+
+    std::thread thread_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,137 @@
+#include "dry_run.hpp"
+
+#include <cxxmidi/output/abstract.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+#include "active_notes.hpp"
+#include "i18n.hpp"
+#include "jitter_recorder.hpp"
+#include "playback_orchestrator.hpp"
+#include "playback_synchronizer.hpp"
+#include "timeline_player.hpp"
+#include "timing_manager.hpp"
+#include "virtual_clock.hpp"
+
+namespace MidiPlay {
+
+namespace {
+
+// Port that only counts what it is sent
+class NullOutput : public cxxmidi::output::Abstract {
+public:
+    void OpenPort(unsigned int) override {}
+    void ClosePort() override {}
+    void OpenVirtualPort(const std::string&) override {}
+    size_t GetPortCount() override { return 1; }
+    std::string GetPortName(unsigned int) override { return "dry-run"; }
+    void SendMessage(const cxxmidi::Message*) override { messages_.fetch_add(1, std::memory_order_relaxed); }
+
+    size_t getMessageCount() const { return messages_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<size_t> messages_{0};
+};
+
+std::string formatSeconds(int64_t microseconds) {
+    std::ostringstream text;
+    int64_t tenths = (microseconds + 50000) / 100000;
+    text << TimingManager::formatTime(static_cast<int>(tenths / 10)) << "." << tenths % 10;
+    return text.str();
+}
+
+} // namespace
+
+DryRun::DryRun(MidiLoader& midiLoader)
+    : midiLoader_(midiLoader)
+{
+}
+
+DryRun::Report DryRun::run(bool displayWarnings) {
+    Report report;
+    auto started = std::chrono::steady_clock::now();
+    midiLoader_.finishStreaming();  // getEvents() is empty until then
+
+    VirtualClock clock;
+    NullOutput output;
+    ActiveNotes notes;
+    JitterRecorder recorder(midiLoader_.getEventCount() * (midiLoader_.getVerses() + 2));
+    {
+        TimelinePlayer player(output, midiLoader_.getEvents());
+        player.setVirtualClock(&clock);
+        player.setActiveNotes(&notes);
+
+        PlaybackSynchronizer synchronizer;
+        PlaybackOrchestrator orchestrator(player, synchronizer, midiLoader_);
+        orchestrator.initialize();
+        orchestrator.setDisplayWarnings(displayWarnings);
+        orchestrator.setJitterRecorder(&recorder);
+        orchestrator.executePlayback();
+
+        report.durationUs = clock.nowNs() / 1000;
+    }   // Joins the player thread before the counts are read
+
+    // Consecutive samples of one section; a D.C. al Fine pass counts with the last verse
+    for (size_t i = 0; i < recorder.size(); i++) {
+        const JitterRecorder::Sample& sample = recorder.at(i);
+        if (report.sections.empty() || report.sections.back().number != sample.section) {
+            report.sections.push_back({sample.section, sample.scheduledNs / 1000, sample.scheduledNs / 1000, 0});
+        }
+        report.sections.back().endUs = sample.scheduledNs / 1000;
+        report.sections.back().events++;
+    }
+
+    report.messages = output.getMessageCount();
+    report.notesHeldAtEnd = notes.count();
+
+    if (midiLoader_.hasPotentialStuckNote()) {
+        report.warnings.push_back(_("Final intro marker not past last NoteOff event"));
+    }
+    if (report.notesHeldAtEnd > 0) {
+        report.warnings.push_back(std::to_string(report.notesHeldAtEnd) + _(" notes still sounding at the end"));
+    }
+    const std::vector<Directive>& directives = midiLoader_.getDirectives();
+    auto has = [&directives](DirectiveKind kind) {
+        return std::any_of(directives.begin(), directives.end(),
+                           [kind](const Directive& directive) { return directive.kind == kind; });
+    };
+    if (has(DirectiveKind::DaCapoAlFine) && !has(DirectiveKind::Fine)) {
+        report.warnings.push_back(_("D.C. al Fine without a Fine marker; the repeat plays to the end"));
+    }
+    if (recorder.dropped() > 0) {
+        report.warnings.push_back(_("Event counts incomplete: ") + std::to_string(recorder.dropped()) + _(" events not recorded"));
+    }
+
+    report.renderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return report;
+}
+
+void DryRun::print(const Report& report, std::ostream& out) {
+    out << std::endl << _("Dry run:") << std::endl;
+    for (const Section& section : report.sections) {
+        std::ostringstream name;
+        if (section.number == 0) {
+            name << _("Introduction");
+        } else {
+            name << _("Verse ") << section.number;
+        }
+        out << "  " << std::left << std::setw(14) << name.str() << std::right
+            << std::setw(9) << formatSeconds(section.startUs) << " - "
+            << std::setw(9) << formatSeconds(section.endUs) << "  "
+            << std::setw(6) << section.events << _(" events") << std::endl;
+    }
+    out << "  " << std::left << std::setw(14) << _("Total") << std::right
+        << std::setw(9) << formatSeconds(report.durationUs)
+        << _("   (") << report.durationUs << _(" us, ") << report.messages << _(" messages)") << std::endl;
+
+    for (const std::string& warning : report.warnings) {
+        out << _("   Warning: ") << warning << std::endl;
+    }
+    out << std::fixed << std::setprecision(1) << _("Rendered in ") << report.renderMs << _(" ms") << std::endl;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "midi_loader.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Plays a loaded hymn through the whole playback flow without an organ (--dry-run)
+ *
+ * The PlaybackOrchestrator runs exactly as for a performance (introduction
+ * segments, verses and the pauses between them, ritardando, D.C. al Fine)
+ * on a TimelinePlayer driven by a VirtualClock and sending to a port that
+ * only counts what it is given. Nothing waits, so a hymn takes a few
+ * milliseconds, and every time reported is what the performance will take at
+ * the options given. A streaming load (--stream) is read to the end first,
+ * so the report covers the whole hymn.
+ */
+class DryRun {
+public:
+    /**
+     * @brief One section as played: the introduction (0) or a verse
+     */
+    struct Section {
+        uint16_t number = 0;
+        int64_t startUs = 0;    // First event, from the start of the performance
+        int64_t endUs = 0;      // Last event
+        size_t events = 0;
+    };
+
+    struct Report {
+        int64_t durationUs = 0;         // First event to the end of the last section
+        std::vector<Section> sections;  // In playing order
+        size_t messages = 0;            // Sent to the port, including note releases
+        size_t notesHeldAtEnd = 0;      // NoteOn without NoteOff when the hymn ends
+        std::vector<std::string> warnings;
+        double renderMs = 0.0;          // Wall clock time the dry run took
+    };
+
+    /**
+     * @param midiLoader Loaded hymn; its options (verses, tempo, intro) apply
+     */
+    explicit DryRun(MidiLoader& midiLoader);
+
+    /**
+     * @brief Play the hymn on the virtual clock
+     * @param displayWarnings Show the warnings of a real performance as they happen
+     */
+    Report run(bool displayWarnings);
+
+    /**
+     * @brief Write a report for people
+     */
+    static void print(const Report& report, std::ostream& out);
+
+private:
+    MidiLoader& midiLoader_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,63 @@
+#include "event_arena.hpp"
+
+#include <cxxmidi/event.hpp>
+
+namespace MidiPlay {
+
+EventArena::EventArena(const cxxmidi::File& file) {
+    assign(file);
+}
+
+void EventArena::assign(const cxxmidi::File& file) {
+    clear();
+
+    // Count first so each block is allocated exactly once
+    size_t events = 0;
+    size_t longMessageBytes = 0;
+    for (const cxxmidi::Track& track : file) {
+        events += track.size();
+        for (const cxxmidi::Event& event : track) {
+            if (event.size() > PackedEvent::INLINE_BYTES) {
+                longMessageBytes += event.size();
+            }
+        }
+    }
+    reserve(file.size(), events, longMessageBytes);
+    timeDivision_ = file.TimeDivision();
+
+    for (const cxxmidi::Track& track : file) {
+        addTrack();
+        for (const cxxmidi::Event& event : track) {
+            append(event.Dt(), event.data(), event.size());
+        }
+    }
+}
+
+void EventArena::addTrack() {
+    if (trackStarts_.empty()) {
+        trackStarts_.push_back(0);
+    }
+    trackStarts_.push_back(static_cast<uint32_t>(events_.size()));
+}
+
+void EventArena::append(uint32_t dt, const uint8_t* data, size_t size) {
+    events_.append(dt, data, size);
+    trackStarts_.back() = static_cast<uint32_t>(events_.size());
+}
+
+void EventArena::reserve(size_t tracks, size_t events, size_t longMessageBytes) {
+    trackStarts_.reserve(tracks + 1);
+    events_.reserve(events, PackedEvents::sideBytesFor(longMessageBytes));
+}
+
+void EventArena::clear() {
+    events_.clear();
+    std::vector<uint32_t>().swap(trackStarts_);     // Releases the capacity too
+    timeDivision_ = 0;
+}
+
+size_t EventArena::getMemoryBytes() const {
+    return events_.getMemoryBytes() + trackStarts_.capacity() * sizeof(uint32_t);
+}
+
+} // namespace MidiPlay
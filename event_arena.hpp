@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cxxmidi/file.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "event_view.hpp"
+#include "packed_events.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Events of a loaded file, track by track, in three contiguous blocks
+ *
+ * A cxxmidi::Event owns its bytes in a std::vector of its own, so a loaded
+ * cxxmidi::File is one small heap block per event spread wherever the
+ * allocator put it. The arena keeps the same events as PackedEvent records
+ * in one array, delta time in the tick field, with every channel message
+ * inside its record and the longer meta and SysEx messages back to back in
+ * the side table. A track is a range of records.
+ *
+ * MidiLoader fills one per load, so timelines are built from it without
+ * chasing a pointer per event, and clear() gives everything back in one go.
+ * Views returned by at() are valid until the arena is changed.
+ */
+class EventArena {
+public:
+    EventArena() = default;
+
+    /**
+     * @brief Copy every track of a file
+     */
+    explicit EventArena(const cxxmidi::File& file);
+
+    /**
+     * @brief Replace the contents with the tracks of a file
+     */
+    void assign(const cxxmidi::File& file);
+
+    /**
+     * @brief Start a new track; following append()s go to it
+     */
+    void addTrack();
+
+    /**
+     * @brief Append an event to the last track
+     */
+    void append(uint32_t dt, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Make room so loading allocates each block once
+     */
+    void reserve(size_t tracks, size_t events, size_t longMessageBytes);
+
+    /**
+     * @brief Free all storage
+     */
+    void clear();
+
+    uint16_t getTimeDivision() const { return timeDivision_; }
+    void setTimeDivision(uint16_t timeDivision) { timeDivision_ = timeDivision; }
+
+    size_t getTrackCount() const { return trackStarts_.empty() ? 0 : trackStarts_.size() - 1; }
+    size_t getTrackSize(size_t track) const { return trackStarts_[track + 1] - trackStarts_[track]; }
+
+    /**
+     * @brief Events in all tracks
+     */
+    size_t size() const { return events_.size(); }
+    bool empty() const { return events_.empty(); }
+
+    /**
+     * @brief Event @p index of a track
+     */
+    EventView at(size_t track, size_t index) const {
+        size_t position = trackStarts_[track] + index;
+        return events_.viewAt(position, events_.tickAt(position));
+    }
+
+    /**
+     * @brief Bytes held, including unused capacity
+     */
+    size_t getMemoryBytes() const;
+
+private:
+    PackedEvents events_;                   // Tick field holds the delta time
+    std::vector<uint32_t> trackStarts_;    // getTrackCount() + 1 entries into events_
+    uint16_t timeDivision_ = 0;
+};
+
+} // namespace MidiPlay
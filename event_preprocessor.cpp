@@ -4,6 +4,7 @@
 #include <iostream>
 #include <cmath>
 #include <cstdlib>
+#include <algorithm>
 
 #include "midi_constants.hpp"
 
@@ -18,6 +19,57 @@ const char* const EventPreProcessor::keys_[] = {
     "G", "D", "A", "E", "B", "F#", "C#", "G#", "D#", "A#", "e#"
 };
 
+EventRewrite::EventRewrite() {
+    for (size_t channel = 0; channel < channelMap.size(); channel++) {
+        channelMap[channel] = static_cast<uint8_t>(channel);
+    }
+}
+
+EventRewrite::EventRewrite(const Options& options)
+    : transpose(options.getTranspose()), channelMap(options.getChannelMap()) {
+}
+
+bool EventRewrite::isIdentity() const {
+    return transpose == 0 && channelMap == EventRewrite().channelMap;
+}
+
+bool EventRewrite::apply(cxxmidi::Event& event) const {
+    if (event.size() < 2) {
+        return true;
+    }
+    
+    uint8_t status = event[0];
+    if (status == Midi::META_STATUS) {
+        if (transpose != 0 && event[1] == Midi::META_KEY_SIGNATURE && event.size() >= 4) {
+            int sf = static_cast<int8_t>(event[2]);
+            event[2] = static_cast<uint8_t>(static_cast<int8_t>(transposeKey(sf, transpose)));
+        }
+        return true;
+    }
+    
+    uint8_t type = status & Midi::STATUS_TYPE_MASK;
+    if (type != Midi::NOTE_OFF && type != Midi::NOTE_ON && type != Midi::POLY_AFTERTOUCH) {
+        return true;
+    }
+    
+    uint8_t channel = status & Midi::CHANNEL_MASK;
+    if (transpose != 0 && channel != Midi::PERCUSSION_CHANNEL) {
+        int note = event[1] + transpose;
+        if (note < 0 || note > Midi::NOTE_MAX) {
+            return false;   // NoteOn and its NoteOff both go, so nothing is left sounding
+        }
+        event[1] = static_cast<uint8_t>(note);
+    }
+    event[0] = type | channelMap[channel];
+    return true;
+}
+
+// Each semitone up is seven steps round the circle of fifths
+int EventRewrite::transposeKey(int sharpsOrFlats, int semitones) {
+    int key = ((sharpsOrFlats + 7 * semitones) % 12 + 12) % 12;    // 0 (C) to 11 sharps
+    return key > 5 ? key - 12 : key;                                // Gb rather than F#, and so on
+}
+
 // Constructor
 EventPreProcessor::EventPreProcessor() {
     reset();
@@ -29,29 +81,40 @@ void EventPreProcessor::reset() {
     keySignature_.clear();
     timeSignature_ = TimeSignature();
     introSegments_.clear();
+    directives_.clear();
     
     verses_ = 0;
     uSecPerQuarter_ = 0;
+    fileTempo_ = 0;
+    bpm_ = 0;
     pauseTicks_ = MidiTicks();
+    tempoChanges_.clear();
     
     potentialStuckNote_ = false;
     firstTempo_ = true;
+    tempoDenominator_ = 0;
+    warnings_ = 0;
     
     // Load callback state variables
     currentTrack_ = 0;
     totalTrackTicks_ = 0;
     lastNoteOn_ = 0;
     lastNoteOff_ = 0;
+    rewrite_.reset();
 }
 
 // Main event processing method
-bool EventPreProcessor::processEvent(cxxmidi::Event& event, const Options& options) {
-    Message message = event;
-    uint8_t status = message[0];
+bool EventPreProcessor::processEvent(cxxmidi::Event& midiEvent, const Options& options) {
+    EventView event(midiEvent);     // No copy: helpers read the loaded bytes in place
+    
+    totalTrackTicks_ += event.dt();
     
-    totalTrackTicks_ += event.Dt();
+    // Rewritten once here, so playback sends the stored events as they are
+    if (options.isRewritingEvents() && !rewriteFor(options).apply(midiEvent)) {
+        return false;
+    }
     
-    if (message.IsSysex()) {
+    if (event.isSysex()) {
         return false;  // Throw away SysEx events. Player doesn't handle them.
     }
     
@@ -59,14 +122,12 @@ bool EventPreProcessor::processEvent(cxxmidi::Event& event, const Options& optio
     // NRPN (Non-Registered Parameter Number MSB & LSB)
     // Data Entry MSB & LSB
     // These exceptions are used for organ stop settings.
-    if (message.IsControlChange()) {
+    if (event.isControlChange()) {
         return shouldLoadControlChangeEvent(event);
     }
     
-    if (message.IsMeta()) {
-        uint8_t type = message[1];
-        
-        if (message.IsMeta(Message::MetaType::Lyrics)) {
+    if (event.isMeta()) {
+        if (event.isMeta(Message::MetaType::Lyrics)) {
             return false;   // Throw away lyrics. Player doesn't handle them.
         }
         
@@ -82,22 +143,26 @@ bool EventPreProcessor::processEvent(cxxmidi::Event& event, const Options& optio
                 return false;
             }
         }
+        
+        recordTempoChange(event);
     }   // Time 0
     
     if (currentTrack_ == 0) {   // Track 0-only messages
         processIntroductionMarkers(event);
     }   // Track 0-only message handling
     
-    if (event.IsVoiceCategory(Message::Type::NoteOn) && event[2] != 0) {
+    processDirectiveMarker(event);
+    
+    if (event.isVoiceCategory(Message::Type::NoteOn) && event[2] != 0) {
         lastNoteOn_ = totalTrackTicks_;
     }
     
-    if ((event.IsVoiceCategory(Message::Type::NoteOn) && event[2] == 0) || 
-        event.IsVoiceCategory(Message::Type::NoteOff)) {
+    if ((event.isVoiceCategory(Message::Type::NoteOn) && event[2] == 0) || 
+        event.isVoiceCategory(Message::Type::NoteOff)) {
         lastNoteOff_ = totalTrackTicks_;
     }
     
-    if (event.IsMeta(Message::MetaType::EndOfTrack)) {
+    if (event.isMeta(Message::MetaType::EndOfTrack)) {
         currentTrack_++;
         
         if (introSegments_.size()) {
@@ -119,32 +184,24 @@ bool EventPreProcessor::processEvent(cxxmidi::Event& event, const Options& optio
 }
 
 // Process time signature events
-void EventPreProcessor::processTimeSignatureEvent(const Event& event) {
-    Message message = event;
-    
-    if (message.IsMeta(Message::MetaType::TimeSignature)) {
-        timeSignature_.beatsPerMeasure = message[2];
-        timeSignature_.denominator = message[3];
-        timeSignature_.clocksPerClick = message[4];
-        timeSignature_.n32ndNotesPerQuaver = message[5];
+void EventPreProcessor::processTimeSignatureEvent(const EventView& event) {
+    if (event.isMeta(Message::MetaType::TimeSignature)) {
+        timeSignature_.beatsPerMeasure = event[2];
+        timeSignature_.denominator = event[3];
+        timeSignature_.clocksPerClick = event[4];
+        timeSignature_.n32ndNotesPerQuaver = event[5];
     }
 }
 
 // Process tempo events
-void EventPreProcessor::processTempoEvent(const Event& event, const Options& options) {
-    Message message = event;
-    
-    if (message.IsMeta(Message::MetaType::Tempo)) {
+void EventPreProcessor::processTempoEvent(const EventView& event, const Options& options) {
+    if (event.isMeta(Message::MetaType::Tempo)) {
         // Get tempo from file - manual extraction of 24-bit value
         uSecPerQuarter_ = (static_cast<uint32_t>(event[2]) << 16) |
                           (static_cast<uint32_t>(event[3]) << 8) |
                           static_cast<uint32_t>(event[4]);
         
         if (firstTempo_) {
-            bpm_ = options.getBpm();
-            int uSecPerBeat = options.getUsecPerBeat();
-            float speed = options.getSpeed();
-
             if (uSecPerQuarter_ > 0) {
                 double qpm = static_cast<double>(MidiPlay::MICROSECONDS_PER_MINUTE) / uSecPerQuarter_;
                 fileTempo_ = static_cast<int>(qpm * (std::pow(2.0, timeSignature_.denominator) / MidiPlay::QUARTER_NOTE_DENOMINATOR));
@@ -154,30 +211,44 @@ void EventPreProcessor::processTempoEvent(const Event& event, const Options& opt
                 fileTempo_ = Midi::DEFAULT_TEMPO_BPM;
             }
 
-            if (bpm_ > 0) {
-                int qpm = MidiPlay::MICROSECONDS_PER_MINUTE / uSecPerBeat;  // Quarter notes per minute
-                bpm_ = qpm * (std::pow(2.0, timeSignature_.denominator) / MidiPlay::QUARTER_NOTE_DENOMINATOR);
-                
-                if (uSecPerBeat) {
-                    // Note: speed calculation would need to be handled by caller
-                }
-            }
-            else {
-                bpm_ = fileTempo_;
-            }
+            // BPM is expressed in the denominator in effect at the first tempo
+            tempoDenominator_ = timeSignature_.denominator;
+            applyTempoOptions(options);
            
             firstTempo_ = false;
         }
     }
 }
 
+// Keep every tempo event for the tempo map, whatever its tick
+void EventPreProcessor::recordTempoChange(const EventView& event) {
+    if (event.isMeta(Message::MetaType::Tempo) && event.size() >= 5) {
+        uint32_t uSecPerQuarter = (static_cast<uint32_t>(event[2]) << 16) |
+                                  (static_cast<uint32_t>(event[3]) << 8) |
+                                  static_cast<uint32_t>(event[4]);
+        tempoChanges_.push_back({static_cast<uint32_t>(totalTrackTicks_), uSecPerQuarter});
+    }
+}
+
+// Apply the command-line tempo override (if any) to the file tempo
+void EventPreProcessor::applyTempoOptions(const Options& options) {
+    bpm_ = options.getBpm();
+    int uSecPerBeat = options.getUsecPerBeat();
+
+    if (bpm_ > 0) {
+        int qpm = MidiPlay::MICROSECONDS_PER_MINUTE / uSecPerBeat;  // Quarter notes per minute
+        bpm_ = qpm * (std::pow(2.0, tempoDenominator_) / MidiPlay::QUARTER_NOTE_DENOMINATOR);
+    }
+    else {
+        bpm_ = fileTempo_;
+    }
+}
+
 // Process key signature events
-void EventPreProcessor::processKeySignatureEvent(const Event& event) {
-    Message message = event;
-    
-    if (message.IsMeta(Message::MetaType::KeySignature)) {
-        int sf = static_cast<int8_t>(static_cast<uint8_t>(message[2]));
-        int mi = (uint8_t)message[3];
+void EventPreProcessor::processKeySignatureEvent(const EventView& event) {
+    if (event.isMeta(Message::MetaType::KeySignature)) {
+        int sf = static_cast<int8_t>(static_cast<uint8_t>(event[2]));
+        int mi = (uint8_t)event[3];
 
         // TODO: DRY up the following code.
         if (mi == 0)
@@ -205,51 +276,46 @@ void EventPreProcessor::processKeySignatureEvent(const Event& event) {
 }
 
 // Process custom meta events for data extraction
-bool EventPreProcessor::processCustomMetaEvents(const Event& event, const Options& options) {
-    Message message = event;
-    uint8_t type = message[1];
+bool EventPreProcessor::processCustomMetaEvents(const EventView& event, const Options& options) {
+    uint8_t type = event[1];
     
     // Handle deprecated events
+    // The file's verse count is always recorded so it can be cached;
+    // setVersesFromOptions() gives a command-line count priority afterwards.
     if (DEPRECATED_META_EVENT_VERSES == type) {
-        // Only use MIDI file verses if not overridden by command line
-        int cmdLineVerses = options.getVerses();
-        if (cmdLineVerses == 0 && verses_ == 0) {
-            char c = static_cast<char>(message[2]);
+        if (verses_ == 0) {
+            char c = static_cast<char>(event[2]);
             if (std::isdigit(c)) {
                 verses_ = std::stoi(std::string{c});
             }
         }
         
-        if (options.isVerbose() || options.isDisplayWarnings()) {
-            std::cout << _("Warning: Deprecated Meta event for number of verses found") << std::endl;
-        }
+        warnings_ |= WARNING_DEPRECATED_VERSES;
+        displayWarning(WARNING_DEPRECATED_VERSES, options);
         
         return false; // Custom event found - discard it
     }
     
     if (DEPRECATED_META_EVENT_PAUSE == type) {
-        pauseTicks_ = (static_cast<uint16_t>(message[2]) << 8) | message[3];
+        pauseTicks_ = (static_cast<uint16_t>(event[2]) << 8) | event[3];
         
-        if (options.isVerbose() || options.isDisplayWarnings()) {
-            std::cout << _("Warning: Deprecated Meta event for pause found") << std::endl;
-        }
+        warnings_ |= WARNING_DEPRECATED_PAUSE;
+        displayWarning(WARNING_DEPRECATED_PAUSE, options);
         
         return false; // Custom event found - discard it
     }
     
     // Handle sequencer-specific events
-    if (message.IsMeta(Message::MetaType::SequencerSpecific)) {
+    if (event.isMeta(Message::MetaType::SequencerSpecific)) {
         int index = 2;
-        if (message[index] != midiplay::CustomMessage::Type::Private) {
+        if (event[index] != midiplay::CustomMessage::Type::Private) {
             index++;    // Some early files have an extra byte here, which is now meaningless.  This is for backward compatibility.
         }
         
-        if (message[index++] == midiplay::CustomMessage::Type::Private) {
-            if (message[index] == midiplay::CustomMessage::PrivateType::NumberOfVerses) {
-                // Only use MIDI file verses if not overridden by command line
-                int cmdLineVerses = options.getVerses();
-                if (cmdLineVerses == 0 && verses_ == 0) {
-                    char c = static_cast<char>(message[++index]);
+        if (event[index++] == midiplay::CustomMessage::Type::Private) {
+            if (event[index] == midiplay::CustomMessage::PrivateType::NumberOfVerses) {
+                if (verses_ == 0) {
+                    char c = static_cast<char>(event[++index]);
                     if (std::isdigit(c)) {
                         verses_ = std::stoi(std::string{c});
                     }
@@ -257,8 +323,8 @@ bool EventPreProcessor::processCustomMetaEvents(const Event& event, const Option
                 return false; // Custom event found - discard it
             }
             
-            if (message[index] == midiplay::CustomMessage::PrivateType::PauseBetweenVerses) {
-                pauseTicks_ = (static_cast<uint16_t>(message[++index]) << 8) | message[++index];
+            if (event[index] == midiplay::CustomMessage::PrivateType::PauseBetweenVerses) {
+                pauseTicks_ = (static_cast<uint16_t>(event[index + 1]) << 8) | event[index + 2];
                 return false; // Custom event found - discard it
             }
         }
@@ -269,9 +335,9 @@ bool EventPreProcessor::processCustomMetaEvents(const Event& event, const Option
 }
 
 // Process introduction markers
-void EventPreProcessor::processIntroductionMarkers(const Event& event) {
-    if (event.IsMeta(Message::MetaType::Marker) && event.size() == 3) {
-        std::string text = event.GetText();
+void EventPreProcessor::processIntroductionMarkers(const EventView& event) {
+    if (event.isMeta(Message::MetaType::Marker) && event.size() == 3) {
+        std::string_view text = event.text();
         if (text == MidiMarkers::INTRO_BEGIN) {    // Beginning of introduction segment
             IntroductionSegment seg;
             seg.start = totalTrackTicks_;
@@ -288,32 +354,137 @@ void EventPreProcessor::processIntroductionMarkers(const Event& event) {
     }
 }
 
-// Process track name events
-void EventPreProcessor::processTrackNameEvent(const Event& event) {
-    Message message = event;
+// Resolve marker events into the directive table
+void EventPreProcessor::processDirectiveMarker(const EventView& event) {
+    if (!event.isMeta(Message::MetaType::Marker)) {
+        return;
+    }
+    
+    Directive directive(static_cast<uint32_t>(totalTrackTicks_), static_cast<uint16_t>(currentTrack_),
+                        classifyMarker(event.text()));
     
-    if (message.IsMeta(Message::MetaType::TrackName) && title_.empty()) {
-        title_ = message.GetText();
+    // Tracks arrive one after another, so inserting after every entry at the
+    // same tick keeps the table ordered by tick, then track
+    auto position = std::upper_bound(directives_.begin(), directives_.end(), directive.tick,
+                                     [](uint32_t tick, const Directive& entry) { return tick < entry.tick; });
+    directives_.insert(position, directive);
+}
+
+DirectiveKind EventPreProcessor::classifyMarker(std::string_view text) {
+    if (text == MidiMarkers::INTRO_BEGIN) {
+        return DirectiveKind::IntroBegin;
+    }
+    if (text == MidiMarkers::INTRO_END) {
+        return DirectiveKind::IntroEnd;
+    }
+    if (text == MidiMarkers::RITARDANDO_INDICATOR) {
+        return DirectiveKind::Ritardando;
+    }
+    if (text == MidiMarkers::D_C_AL_FINE) {
+        return DirectiveKind::DaCapoAlFine;
+    }
+    if (text == MidiMarkers::FINE_INDICATOR) {
+        return DirectiveKind::Fine;
+    }
+    return DirectiveKind::Other;
+}
+
+// Process track name events
+void EventPreProcessor::processTrackNameEvent(const EventView& event) {
+    if (event.isMeta(Message::MetaType::TrackName) && title_.empty()) {
+        title_ = std::string(event.text());
+    }
+}
+
+// Options do not change during a load, so one rewrite serves every event of the file
+const EventRewrite& EventPreProcessor::rewriteFor(const Options& options) {
+    if (!rewrite_) {
+        rewrite_.emplace(options);
     }
+    return *rewrite_;
 }
 
 // Event filtering logic for control change events
-bool EventPreProcessor::shouldLoadControlChangeEvent(const cxxmidi::Event& event) {
-    Message message = event;
-    
+bool EventPreProcessor::shouldLoadControlChangeEvent(const EventView& event) {
     // Allow NRPN (Non-Registered Parameter Number MSB & LSB)
     // Allow Data Entry MSB & LSB
     // These exceptions are used for organ stop settings.
-    if (message.IsControlChange(Message::ControlType::NonRegisteredParameterNumberLsb) 
-        || message.IsControlChange(Message::ControlType::NonRegisteredParameterNumberMsb) 
-        || message.IsControlChange(Message::ControlType::DataEntryMsb) 
-        || message.IsControlChange(Message::ControlType::DataEntryLsb)) {
+    if (event.isControlChange(Message::ControlType::NonRegisteredParameterNumberLsb) 
+        || event.isControlChange(Message::ControlType::NonRegisteredParameterNumberMsb) 
+        || event.isControlChange(Message::ControlType::DataEntryMsb) 
+        || event.isControlChange(Message::ControlType::DataEntryLsb)) {
         return true;   // Load these specific control change messages
     }
     
     return false;   // Throw away most control change messages. Use organ controls instead.
 }
 
+// Display a load-time warning if verbose or warning output is enabled
+void EventPreProcessor::displayWarning(uint8_t warning, const Options& options) const {
+    if (!(options.isVerbose() || options.isDisplayWarnings())) {
+        return;
+    }
+    
+    if (warning == WARNING_DEPRECATED_VERSES) {
+        std::cout << _("Warning: Deprecated Meta event for number of verses found") << std::endl;
+    }
+    
+    if (warning == WARNING_DEPRECATED_PAUSE) {
+        std::cout << _("Warning: Deprecated Meta event for pause found") << std::endl;
+    }
+}
+
+// Capture option-independent metadata for persistence
+PreprocessedMetadata EventPreProcessor::getMetadata() const {
+    PreprocessedMetadata metadata;
+    metadata.title = title_;
+    metadata.keySignature = keySignature_;
+    metadata.timeSignature = timeSignature_;
+    metadata.introSegments = introSegments_;
+    metadata.directives = directives_;
+    metadata.verses = verses_;
+    metadata.uSecPerQuarter = uSecPerQuarter_;
+    metadata.fileTempo = fileTempo_;
+    metadata.tempoDenominator = tempoDenominator_;
+    metadata.tempoFound = !firstTempo_;
+    metadata.tempoChanges = tempoChanges_;
+    metadata.pauseTicks = pauseTicks_;
+    metadata.potentialStuckNote = potentialStuckNote_;
+    metadata.warnings = warnings_;
+    return metadata;
+}
+
+// Restore previously captured metadata and re-apply this run's options
+void EventPreProcessor::restoreMetadata(const PreprocessedMetadata& metadata, const Options& options) {
+    reset();
+    
+    title_ = metadata.title;
+    keySignature_ = metadata.keySignature;
+    timeSignature_ = metadata.timeSignature;
+    introSegments_ = metadata.introSegments;
+    directives_ = metadata.directives;
+    verses_ = metadata.verses;
+    uSecPerQuarter_ = metadata.uSecPerQuarter;
+    fileTempo_ = metadata.fileTempo;
+    tempoDenominator_ = metadata.tempoDenominator;
+    pauseTicks_ = metadata.pauseTicks;
+    tempoChanges_ = metadata.tempoChanges;
+    potentialStuckNote_ = metadata.potentialStuckNote;
+    warnings_ = metadata.warnings;
+    
+    if (metadata.tempoFound) {
+        applyTempoOptions(options);
+        firstTempo_ = false;
+    }
+    
+    // Replay the warnings a full load would have printed
+    for (uint8_t warning : {WARNING_DEPRECATED_VERSES, WARNING_DEPRECATED_PAUSE}) {
+        if (warnings_ & warning) {
+            displayWarning(warning, options);
+        }
+    }
+}
+
 // Set verses from command-line options
 void EventPreProcessor::setVersesFromOptions(int optionVerses) {
     // Command-line option takes priority over MIDI file
@@ -2,7 +2,10 @@
 
 #include <cxxmidi/event.hpp>
 #include <cxxmidi/message.hpp>
+#include <array>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 
@@ -10,6 +13,8 @@
 #include "custommessage.hpp"
 #include "constants.hpp"
 #include "midi_markers.hpp"
+#include "event_view.hpp"
+#include "tempo_map.hpp"
 
 // Forward declaration
 class Options;
@@ -41,6 +46,92 @@ struct IntroductionSegment {
     IntroductionSegment(uint32_t s, uint32_t e) : start(s), end(e) {}
 };
 
+/**
+ * Musical direction carried by a marker meta event
+ */
+enum class DirectiveKind : uint8_t {
+    IntroBegin,     // MidiMarkers::INTRO_BEGIN
+    IntroEnd,       // MidiMarkers::INTRO_END
+    Ritardando,     // MidiMarkers::RITARDANDO_INDICATOR
+    DaCapoAlFine,   // MidiMarkers::D_C_AL_FINE
+    Fine,           // MidiMarkers::FINE_INDICATOR
+    Other           // Any other marker text; kept so the table stays in step with playback
+};
+
+/**
+ * Marker resolved at load time
+ * 
+ * The directive table holds one entry per marker event in the loaded file,
+ * in the order the player emits them: by tick, then by track. MusicalDirector
+ * walks it with a cursor, so marker text is never inspected during playback.
+ */
+struct Directive {
+    uint32_t tick;
+    uint16_t track;
+    DirectiveKind kind;
+    
+    Directive() : tick(0), track(0), kind(DirectiveKind::Other) {}
+    Directive(uint32_t t, uint16_t tr, DirectiveKind k) : tick(t), track(tr), kind(k) {}
+};
+
+/**
+ * Option-independent metadata extracted while preprocessing a MIDI file
+ * 
+ * Captured after loading so it can be persisted (see HymnCache) and later
+ * restored without running the preprocessor again. Values that depend on
+ * command-line options (BPM override, verse override) are not stored here;
+ * they are re-applied by EventPreProcessor::restoreMetadata().
+ */
+struct PreprocessedMetadata {
+    std::string title;
+    std::string keySignature;
+    TimeSignature timeSignature;
+    std::vector<IntroductionSegment> introSegments;
+    std::vector<Directive> directives;
+    
+    int verses = 0;                 // Verses from the file (0 if not specified)
+    int uSecPerQuarter = 0;
+    int fileTempo = 0;
+    uint8_t tempoDenominator = 0;   // Time signature denominator in effect at the first tempo
+    bool tempoFound = false;
+    std::vector<TempoChange> tempoChanges;     // Every tempo event, in load order
+    MidiTicks pauseTicks;
+    
+    bool potentialStuckNote = false;
+    uint8_t warnings = 0;           // EventPreProcessor::WARNING_* bits seen during load
+};
+
+/**
+ * Transposition and channel remap, applied to each event as it is loaded
+ * 
+ * The stored events are rewritten once, so they already sound as requested
+ * and the player sends them unchanged. Notes move by the transposition,
+ * except on the percussion channel; note messages (NoteOn, NoteOff and
+ * polyphonic aftertouch) move to their new channel, while controllers and
+ * programs stay with the manual they set up. Key signatures are rewritten
+ * to the transposed key, written with flats rather than six sharps.
+ */
+struct EventRewrite {
+    int transpose = 0;                          // Semitones
+    std::array<uint8_t, 16> channelMap{};       // New channel for the notes of each channel, 0-based
+    
+    EventRewrite();                             // Leaves every event as it is
+    explicit EventRewrite(const Options& options);
+    
+    bool isIdentity() const;
+    
+    /**
+     * Rewrite the event in place
+     * @return false if a note is moved out of the MIDI range; the event is then discarded
+     */
+    bool apply(cxxmidi::Event& event) const;
+    
+    /**
+     * Key signature sharps (positive) or flats (negative) after transposing
+     */
+    static int transposeKey(int sharpsOrFlats, int semitones);
+};
+
 /**
  * EventPreProcessor - Handles MIDI event filtering and metadata extraction
  * 
@@ -69,6 +160,7 @@ public:
     
     /**
      * Main event processing method
+     * Events are first rewritten in place for --transpose and --remap (see EventRewrite).
      * @param event MIDI event to process
      * @param options Command line options affecting processing
      * @return true if event should be loaded, false if it should be discarded
@@ -80,6 +172,14 @@ public:
     const std::string& getKeySignature() const { return keySignature_; }
     const TimeSignature& getTimeSignature() const { return timeSignature_; }
     const std::vector<IntroductionSegment>& getIntroSegments() const { return introSegments_; }
+    const std::vector<Directive>& getDirectives() const { return directives_; }
+    
+    /**
+     * Classify marker text
+     * @param text Marker text
+     * @return Directive kind, DirectiveKind::Other if the text is not a musical direction
+     */
+    static DirectiveKind classifyMarker(std::string_view text);
     
     // Calculated values
     int getVerses() const { return verses_; }
@@ -88,15 +188,40 @@ public:
     int getBpm() const { return bpm_; }
     MidiTicks getPauseTicks() const { return pauseTicks_; }
     
+    /**
+     * Every tempo event of the file, at any tick and on any track, in load order
+     * (track by track). TempoMap sorts them.
+     */
+    const std::vector<TempoChange>& getTempoChanges() const { return tempoChanges_; }
+    
     // State flags
     bool hasPotentialStuckNote() const { return potentialStuckNote_; }
     bool isFirstTempo() const { return firstTempo_; }
+    uint8_t getWarnings() const { return warnings_; }   // WARNING_* bits seen so far
     
     /**
      * Reset processor state for new file
      */
     void reset();
     
+    /**
+     * Capture option-independent metadata for persistence
+     * Must be called before setVersesFromOptions() so the file's own verse count is kept.
+     */
+    PreprocessedMetadata getMetadata() const;
+    
+    /**
+     * Restore previously captured metadata instead of processing events
+     * Re-applies tempo options and replays load-time warnings.
+     * @param metadata Metadata captured by getMetadata()
+     * @param options Command line options for this run
+     */
+    void restoreMetadata(const PreprocessedMetadata& metadata, const Options& options);
+    
+    // Warning bits recorded in PreprocessedMetadata::warnings
+    static constexpr uint8_t WARNING_DEPRECATED_VERSES = 0x01;
+    static constexpr uint8_t WARNING_DEPRECATED_PAUSE = 0x02;
+    
     /**
      * Set verses from command-line options (called after loading)
      * Only sets if verses not already extracted from MIDI file
@@ -106,9 +231,12 @@ public:
 
 private:
     // Event processing helpers (moved from MidiLoader)
-    void processTempoEvent(const cxxmidi::Event& event, const Options& options);
-    void processKeySignatureEvent(const cxxmidi::Event& event);
-    void processTimeSignatureEvent(const cxxmidi::Event& event);
+    void processTempoEvent(const EventView& event, const Options& options);
+    void recordTempoChange(const EventView& event);
+    void applyTempoOptions(const Options& options);
+    void displayWarning(uint8_t warning, const Options& options) const;
+    void processKeySignatureEvent(const EventView& event);
+    void processTimeSignatureEvent(const EventView& event);
     
     /**
      * Process custom meta events for data extraction
@@ -117,34 +245,43 @@ private:
      * @return true if no custom event found (continue processing), 
      *         false if custom event found and should be discarded
      */
-    bool processCustomMetaEvents(const cxxmidi::Event& event, const Options& options);
+    bool processCustomMetaEvents(const EventView& event, const Options& options);
     
-    void processIntroductionMarkers(const cxxmidi::Event& event);
-    void processTrackNameEvent(const cxxmidi::Event& event);
+    void processIntroductionMarkers(const EventView& event);
+    void processDirectiveMarker(const EventView& event);
+    void processTrackNameEvent(const EventView& event);
     
     // Event filtering logic
-    bool shouldLoadControlChangeEvent(const cxxmidi::Event& event);
+    bool shouldLoadControlChangeEvent(const EventView& event);
+    
+    // Built from the options on the first event of each file
+    const EventRewrite& rewriteFor(const Options& options);
     
     // Member variables (moved from MidiLoader)
     std::string title_;
     std::string keySignature_;
     TimeSignature timeSignature_;
     std::vector<IntroductionSegment> introSegments_;
+    std::vector<Directive> directives_;    // Sorted by tick, then track
     
     int verses_;
     int uSecPerQuarter_;
     int fileTempo_;
     int bpm_;
     MidiTicks pauseTicks_;
+    std::vector<TempoChange> tempoChanges_;
     
     bool potentialStuckNote_;
     bool firstTempo_;
+    uint8_t tempoDenominator_;
+    uint8_t warnings_;
     
     // Load callback state variables
     int currentTrack_;
     int totalTrackTicks_;
     int lastNoteOn_;
     int lastNoteOff_;
+    std::optional<EventRewrite> rewrite_;  // --transpose and --remap, for the file being loaded
     
     // Constants (moved from MidiLoader)
     static const char* const keys_[18];
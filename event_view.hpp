@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/message.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#include "midi_constants.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Read-only, non-owning view of a MIDI event
+ *
+ * Pointer, length and delta time only: constructing one from a cxxmidi::Event
+ * copies nothing, unlike converting to cxxmidi::Message. The predicates mirror
+ * the cxxmidi::Message ones so code can switch between the two unchanged.
+ *
+ * The view is valid only while the underlying event bytes are alive and
+ * unmodified.
+ */
+class EventView {
+public:
+    EventView(const uint8_t* data, size_t size, uint32_t dt)
+        : data_(data)
+        , size_(size)
+        , dt_(dt)
+    {
+    }
+
+    EventView(const cxxmidi::Event& event)
+        : EventView(event.data(), event.size(), event.Dt())
+    {
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint32_t dt() const { return dt_; }
+    uint8_t operator[](size_t index) const { return data_[index]; }
+
+    uint8_t status() const { return size_ > 0 ? data_[0] : 0; }
+
+    bool isMeta() const {
+        return size_ >= 2 && data_[0] == Midi::META_STATUS;
+    }
+
+    bool isMeta(cxxmidi::Message::MetaType type) const {
+        return isMeta() && data_[1] == static_cast<uint8_t>(type);
+    }
+
+    bool isSysex() const {
+        return size_ > 0 && (data_[0] == Midi::SYSEX_BEGIN || data_[0] == Midi::SYSEX_END);
+    }
+
+    bool isVoiceCategory(cxxmidi::Message::Type type) const {
+        return size_ > 0 && (data_[0] & Midi::STATUS_TYPE_MASK) == static_cast<uint8_t>(type);
+    }
+
+    bool isControlChange() const {
+        return isVoiceCategory(cxxmidi::Message::Type::ControlChange);
+    }
+
+    bool isControlChange(cxxmidi::Message::ControlType controller) const {
+        return size_ >= 2 && isControlChange() && data_[1] == static_cast<uint8_t>(controller);
+    }
+
+    /**
+     * @brief Text of a meta event (track name, marker, ...)
+     * @return View of the bytes after the meta type; empty for other events
+     */
+    std::string_view text() const {
+        if (!isMeta()) {
+            return std::string_view();
+        }
+        return std::string_view(reinterpret_cast<const char*>(data_ + 2), size_ - 2);
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    uint32_t dt_;
+};
+
+} // namespace MidiPlay
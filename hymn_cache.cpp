@@ -0,0 +1,310 @@
+#include "hymn_cache.hpp"
+#include "binary_io.hpp"
+#include "mapped_file.hpp"
+
+#include <cxxmidi/event.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <sys/stat.h>
+
+using cxxmidi::Event;
+
+namespace MidiPlay {
+
+namespace {
+
+// FNV-1a keeps cache file names short and stable across runs
+uint64_t hashPath(const std::string& path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void writeMetadata(ByteWriter& writer, const PreprocessedMetadata& metadata) {
+    writer.putString(metadata.title);
+    writer.putString(metadata.keySignature);
+    writer.put(metadata.timeSignature.beatsPerMeasure);
+    writer.put(metadata.timeSignature.denominator);
+    writer.put(metadata.timeSignature.clocksPerClick);
+    writer.put(metadata.timeSignature.n32ndNotesPerQuaver);
+
+    writer.putVarint(static_cast<uint32_t>(metadata.introSegments.size()));
+    for (const IntroductionSegment& segment : metadata.introSegments) {
+        writer.put(segment.start);
+        writer.put(segment.end);
+    }
+    
+    writer.putVarint(static_cast<uint32_t>(metadata.directives.size()));
+    for (const Directive& directive : metadata.directives) {
+        writer.put(directive.tick);
+        writer.put(directive.track);
+        writer.put(static_cast<uint8_t>(directive.kind));
+    }
+
+    writer.put(static_cast<int32_t>(metadata.verses));
+    writer.put(static_cast<int32_t>(metadata.uSecPerQuarter));
+    writer.put(static_cast<int32_t>(metadata.fileTempo));
+    writer.put(metadata.tempoDenominator);
+    writer.put(static_cast<uint8_t>(metadata.tempoFound));
+    writer.putVarint(static_cast<uint32_t>(metadata.tempoChanges.size()));
+    for (const TempoChange& change : metadata.tempoChanges) {
+        writer.put(change.tick);
+        writer.put(change.uSecPerQuarter);
+    }
+    writer.put(static_cast<uint8_t>(!metadata.pauseTicks.isNull()));
+    writer.put(static_cast<int32_t>(metadata.pauseTicks.getTicks().value_or(0)));
+    writer.put(static_cast<uint8_t>(metadata.potentialStuckNote));
+    writer.put(metadata.warnings);
+}
+
+bool readMetadata(ByteReader& reader, PreprocessedMetadata& metadata) {
+    uint32_t segmentCount = 0;
+    if (!reader.getString(metadata.title)
+        || !reader.getString(metadata.keySignature)
+        || !reader.get(metadata.timeSignature.beatsPerMeasure)
+        || !reader.get(metadata.timeSignature.denominator)
+        || !reader.get(metadata.timeSignature.clocksPerClick)
+        || !reader.get(metadata.timeSignature.n32ndNotesPerQuaver)
+        || !reader.getVarint(segmentCount)) {
+        return false;
+    }
+
+    metadata.introSegments.clear();
+    for (uint32_t i = 0; i < segmentCount; i++) {
+        IntroductionSegment segment;
+        if (!reader.get(segment.start) || !reader.get(segment.end)) {
+            return false;
+        }
+        metadata.introSegments.push_back(segment);
+    }
+    
+    uint32_t directiveCount = 0;
+    if (!reader.getVarint(directiveCount) || directiveCount > reader.remaining()) {
+        return false;
+    }
+    
+    metadata.directives.clear();
+    metadata.directives.reserve(directiveCount);
+    for (uint32_t i = 0; i < directiveCount; i++) {
+        Directive directive;
+        uint8_t kind = 0;
+        if (!reader.get(directive.tick) || !reader.get(directive.track) || !reader.get(kind)
+            || kind > static_cast<uint8_t>(DirectiveKind::Other)) {
+            return false;
+        }
+        directive.kind = static_cast<DirectiveKind>(kind);
+        metadata.directives.push_back(directive);
+    }
+
+    int32_t verses = 0;
+    int32_t uSecPerQuarter = 0;
+    int32_t fileTempo = 0;
+    uint8_t tempoFound = 0;
+    uint8_t hasPause = 0;
+    int32_t pauseTicks = 0;
+    uint8_t potentialStuckNote = 0;
+    if (!reader.get(verses)
+        || !reader.get(uSecPerQuarter)
+        || !reader.get(fileTempo)
+        || !reader.get(metadata.tempoDenominator)
+        || !reader.get(tempoFound)) {
+        return false;
+    }
+    
+    uint32_t tempoCount = 0;
+    if (!reader.getVarint(tempoCount) || tempoCount > reader.remaining()) {
+        return false;
+    }
+    
+    metadata.tempoChanges.clear();
+    metadata.tempoChanges.reserve(tempoCount);
+    for (uint32_t i = 0; i < tempoCount; i++) {
+        TempoChange change;
+        if (!reader.get(change.tick) || !reader.get(change.uSecPerQuarter)) {
+            return false;
+        }
+        metadata.tempoChanges.push_back(change);
+    }
+    
+    if (!reader.get(hasPause)
+        || !reader.get(pauseTicks)
+        || !reader.get(potentialStuckNote)
+        || !reader.get(metadata.warnings)) {
+        return false;
+    }
+
+    metadata.verses = verses;
+    metadata.uSecPerQuarter = uSecPerQuarter;
+    metadata.fileTempo = fileTempo;
+    metadata.tempoFound = tempoFound != 0;
+    metadata.pauseTicks = hasPause ? MidiTicks(pauseTicks) : MidiTicks();
+    metadata.potentialStuckNote = potentialStuckNote != 0;
+    return true;
+}
+
+} // namespace
+
+HymnCache::HymnCache(std::string directory)
+    : directory_(std::move(directory))
+{
+}
+
+std::string HymnCache::defaultDirectory() {
+    const char* cacheHome = getenv("XDG_CACHE_HOME");
+    if (cacheHome && *cacheHome) {
+        return std::string(cacheHome) + "/midiplay";
+    }
+
+    const char* homeDir = getenv("HOME");
+    if (homeDir && *homeDir) {
+        return std::string(homeDir) + "/.cache/midiplay";
+    }
+
+    return "";   // No usable location; caching is disabled
+}
+
+std::string HymnCache::cachePathFor(const std::string& path) const {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    std::string key = ec ? path : canonical.string();
+
+    std::ostringstream name;
+    name << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << hashPath(key) << FILE_EXTENSION;
+    return name.str();
+}
+
+bool HymnCache::stampSource(const std::string& path, SourceStamp& stamp) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    stamp.canonicalPath = ec ? path : canonical.string();
+    stamp.size = static_cast<uint64_t>(info.st_size);
+    stamp.mtimeNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    return true;
+}
+
+bool HymnCache::load(const std::string& path, cxxmidi::File& file, PreprocessedMetadata& metadata) const {
+    if (directory_.empty()) {
+        return false;
+    }
+
+    SourceStamp stamp;
+    if (!stampSource(path, stamp)) {
+        return false;
+    }
+
+    MappedFile image(cachePathFor(path));
+    if (!image.isOpen()) {
+        return false;
+    }
+
+    return decode(image.data(), image.size(), stamp, file, metadata);
+}
+
+bool HymnCache::decode(const uint8_t* data, size_t size, const SourceStamp& stamp,
+                       cxxmidi::File& file, PreprocessedMetadata& metadata) {
+    ByteReader reader(data, size);
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t sourceSize = 0;
+    int64_t mtimeNs = 0;
+    std::string cachedPath;
+    if (!reader.get(magic) || magic != MAGIC
+        || !reader.get(version) || version != FORMAT_VERSION
+        || !reader.get(sourceSize) || sourceSize != stamp.size
+        || !reader.get(mtimeNs) || mtimeNs != stamp.mtimeNs
+        || !reader.getString(cachedPath) || cachedPath != stamp.canonicalPath) {
+        return false;   // Missing, stale or from another format version
+    }
+
+    uint16_t timeDivision = 0;
+    PreprocessedMetadata cachedMetadata;
+    uint32_t trackCount = 0;
+    if (!reader.get(timeDivision) || !readMetadata(reader, cachedMetadata) || !reader.getVarint(trackCount)) {
+        return false;
+    }
+
+    // Decode into a scratch file so a corrupt image never leaves the caller half-populated
+    cxxmidi::File decoded;
+    decoded.SetTimeDivision(timeDivision);
+
+    for (uint32_t t = 0; t < trackCount; t++) {
+        uint32_t eventCount = 0;
+        if (!reader.getVarint(eventCount) || eventCount > reader.remaining()) {
+            return false;
+        }
+
+        cxxmidi::Track& track = decoded.AddTrack();
+        track.reserve(eventCount);
+
+        for (uint32_t e = 0; e < eventCount; e++) {
+            uint32_t dt = 0;
+            uint32_t length = 0;
+            const uint8_t* bytes = nullptr;
+            if (!reader.getVarint(dt) || !reader.getVarint(length) || !reader.getBytes(bytes, length)) {
+                return false;
+            }
+
+            Event& event = track.emplace_back();
+            event.SetDt(dt);
+            event.assign(bytes, bytes + length);
+        }
+    }
+
+    file = std::move(decoded);
+    metadata = std::move(cachedMetadata);
+    return true;
+}
+
+bool HymnCache::store(const std::string& path, const cxxmidi::File& file, const PreprocessedMetadata& metadata) const {
+    if (directory_.empty()) {
+        return false;
+    }
+
+    SourceStamp stamp;
+    if (!stampSource(path, stamp)) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        return false;
+    }
+
+    ByteWriter writer;
+    writer.put(MAGIC);
+    writer.put(FORMAT_VERSION);
+    writer.put(stamp.size);
+    writer.put(stamp.mtimeNs);
+    writer.putString(stamp.canonicalPath);
+
+    writer.put(file.TimeDivision());
+    writeMetadata(writer, metadata);
+
+    writer.putVarint(static_cast<uint32_t>(file.size()));
+    for (const cxxmidi::Track& track : file) {
+        writer.putVarint(static_cast<uint32_t>(track.size()));
+        for (const Event& event : track) {
+            writer.putVarint(event.Dt());
+            writer.putVarint(static_cast<uint32_t>(event.size()));
+            writer.putBytes(event.data(), event.size());
+        }
+    }
+
+    return writeFileAtomically(cachePathFor(path), writer.data());
+}
+
+} // namespace MidiPlay
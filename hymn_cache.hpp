@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cxxmidi/file.hpp>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "event_preprocessor.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief On-disk cache of preprocessed hymns
+ *
+ * Stores the events that survived EventPreProcessor filtering, with their
+ * registration changes rescheduled (RegistrationScheduler), together with
+ * all option-independent metadata in a compact binary image, so a repeat play
+ * of the same hymn never touches the MIDI parser or the load callback.
+ *
+ * Entries are keyed by the source file's canonical path, modification time
+ * and size; any change to the source file makes the entry stale. Cache images
+ * are read with mmap and written atomically (temporary file + rename), so a
+ * crash or a concurrent writer can never leave a half-written entry behind.
+ *
+ * Cache failures are never fatal: load() reports a miss and the caller falls
+ * back to a full parse.
+ *
+ * Image layout (host byte order, LEB128 for variable-length values):
+ *   header:   magic, format version, source size, source mtime (ns), source path
+ *   metadata: time division, PreprocessedMetadata fields
+ *   tracks:   track count, then per track: event count, then per event:
+ *             delta time, byte count, message bytes
+ */
+class HymnCache {
+public:
+    /**
+     * @brief Constructor
+     * @param directory Directory holding cache images (created on first store)
+     */
+    explicit HymnCache(std::string directory = defaultDirectory());
+
+    /**
+     * @brief Default cache location
+     * @return $XDG_CACHE_HOME/midiplay, or ~/.cache/midiplay
+     */
+    static std::string defaultDirectory();
+
+    /**
+     * @brief Load a cached hymn
+     * @param path Path of the source MIDI file
+     * @param file Receives the filtered tracks (replaces any existing tracks)
+     * @param metadata Receives the preprocessed metadata
+     * @return true on a cache hit, false if missing, stale or unreadable
+     */
+    bool load(const std::string& path, cxxmidi::File& file, PreprocessedMetadata& metadata) const;
+
+    /**
+     * @brief Store a freshly loaded hymn
+     * @param path Path of the source MIDI file
+     * @param file Filtered tracks as loaded through EventPreProcessor
+     * @param metadata Metadata captured with EventPreProcessor::getMetadata()
+     * @return true if the cache image was written
+     */
+    bool store(const std::string& path, const cxxmidi::File& file, const PreprocessedMetadata& metadata) const;
+
+    /**
+     * @brief Cache image path for a source file
+     */
+    std::string cachePathFor(const std::string& path) const;
+
+    const std::string& getDirectory() const { return directory_; }
+
+    static constexpr uint32_t FORMAT_VERSION = 4;
+
+    /**
+     * @brief Identity of a source file at a point in time
+     */
+    struct SourceStamp {
+        std::string canonicalPath;
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+    };
+
+    /**
+     * @brief Stamp a source file; also used by DeviceConfigCache
+     * @return false if the file cannot be stat'ed
+     */
+    static bool stampSource(const std::string& path, SourceStamp& stamp);
+
+    /**
+     * @brief Decode a cache image held in memory
+     *
+     * Images are also read out of a published HymnLibrary.
+     * @param stamp The source file as it is now; an image of another version of it is stale
+     * @return false if the image is stale, from another format version or corrupt
+     */
+    static bool decode(const uint8_t* data, size_t size, const SourceStamp& stamp,
+                       cxxmidi::File& file, PreprocessedMetadata& metadata);
+
+private:
+    std::string directory_;
+
+    static constexpr uint32_t MAGIC = 0x4348504D;   // "MPHC"
+    static constexpr const char* FILE_EXTENSION = ".mpc";
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,221 @@
+#include "hymn_library.hpp"
+#include "binary_io.hpp"
+#include "midi_loader.hpp"
+#include "options.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace MidiPlay {
+
+namespace {
+
+bool isMidiFile(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".mid";
+}
+
+struct Record {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;
+};
+
+} // namespace
+
+std::string HymnLibrary::pathIn(const std::string& cacheDirectory, bool staging) {
+    if (cacheDirectory.empty()) {
+        return "";
+    }
+    return cacheDirectory + (staging ? "/hymnal-staging.mpl" : "/hymnal.mpl");
+}
+
+// FNV-1a of the canonical path, as HymnCache names its images
+uint64_t HymnLibrary::hashPath(const std::string& canonicalPath) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : canonicalPath) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool HymnLibrary::attach(const std::string& path) {
+    struct stat info;
+    if (path.empty() || stat(path.c_str(), &info) != 0) {
+        image_ = MappedFile();
+        count_ = 0;
+        return false;
+    }
+
+    int64_t mtimeNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    if (image_.isOpen() && path == path_ && info.st_ino == inode_ && mtimeNs == mtimeNs_) {
+        return true;    // Still the file published last
+    }
+
+    image_ = MappedFile(path);
+    count_ = 0;
+    path_ = path;
+    inode_ = info.st_ino;
+    mtimeNs_ = mtimeNs;
+
+    ByteReader reader(image_.data(), image_.size());
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t count = 0;
+    if (!image_.isOpen()
+        || !reader.get(magic) || magic != MAGIC
+        || !reader.get(version) || version != FORMAT_VERSION
+        || !reader.get(count) || count > reader.remaining() / RECORD_SIZE) {
+        image_ = MappedFile();
+        return false;
+    }
+    count_ = count;
+    return true;
+}
+
+bool HymnLibrary::load(const std::string& path, cxxmidi::File& file, PreprocessedMetadata& metadata) const {
+    HymnCache::SourceStamp stamp;
+    if (!image_.isOpen() || !HymnCache::stampSource(path, stamp)) {
+        return false;
+    }
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    return findImage(stamp, data, size, file, metadata);
+}
+
+bool HymnLibrary::findImage(const HymnCache::SourceStamp& stamp, const uint8_t*& data, size_t& size,
+                            cxxmidi::File& file, PreprocessedMetadata& metadata) const {
+    if (!image_.isOpen()) {
+        return false;
+    }
+
+    const uint8_t* index = image_.data() + HEADER_SIZE;
+    auto recordAt = [index](size_t i) {
+        Record record;
+        std::memcpy(&record, index + i * RECORD_SIZE, RECORD_SIZE);
+        return record;
+    };
+
+    // Binary search on the hash; neighbours with the same hash are told apart by the stamp
+    uint64_t hash = hashPath(stamp.canonicalPath);
+    size_t low = 0;
+    size_t high = count_;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (recordAt(middle).hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (size_t i = low; i < count_; i++) {
+        Record record = recordAt(i);
+        if (record.hash != hash) {
+            break;
+        }
+        if (record.offset > image_.size() || record.size > image_.size() - record.offset) {
+            continue;   // Corrupt record
+        }
+        data = image_.data() + record.offset;
+        size = static_cast<size_t>(record.size);
+        if (HymnCache::decode(data, size, stamp, file, metadata)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+HymnLibrary::PublishStats HymnLibrary::publish(const std::string& directory, const HymnCache& cache,
+                                               const std::string& libraryPath) {
+    PublishStats stats;
+
+    std::vector<fs::path> paths;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && isMidiFile(it->path())) {
+            paths.push_back(it->path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    HymnLibrary previous;
+    previous.attach(libraryPath);
+
+    // Each hymn's image, copied: the previous library is replaced below
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> images;
+    images.reserve(paths.size());
+    Options defaults(0, nullptr);
+    for (const fs::path& path : paths) {
+        HymnCache::SourceStamp stamp;
+        if (!HymnCache::stampSource(path.string(), stamp)) {
+            stats.failed++;
+            continue;
+        }
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        cxxmidi::File file;
+        PreprocessedMetadata metadata;
+        MappedFile cached;
+        if (!previous.findImage(stamp, data, size, file, metadata)) {
+            // Loading stores the hymn's image in the cache, unless a fresh one is there already
+            std::string imagePath = cache.cachePathFor(path.string());
+            cached = MappedFile(imagePath);
+            if (!cached.isOpen() || !HymnCache::decode(cached.data(), cached.size(), stamp, file, metadata)) {
+                MidiLoader loader;
+                loader.setCacheDirectory(cache.getDirectory());
+                cached = loader.loadFile(path.string(), defaults) ? MappedFile(imagePath) : MappedFile();
+                if (!cached.isOpen() || !HymnCache::decode(cached.data(), cached.size(), stamp, file, metadata)) {
+                    stats.failed++;
+                    continue;
+                }
+            }
+            data = cached.data();
+            size = cached.size();
+            stats.loaded++;
+        }
+        images.emplace_back(hashPath(stamp.canonicalPath), std::vector<uint8_t>(data, data + size));
+    }
+
+    std::stable_sort(images.begin(), images.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    ByteWriter writer;
+    writer.put(MAGIC);
+    writer.put(FORMAT_VERSION);
+    writer.put(static_cast<uint32_t>(images.size()));
+    uint64_t offset = HEADER_SIZE + images.size() * RECORD_SIZE;
+    for (const auto& [hash, image] : images) {
+        writer.put(hash);
+        writer.put(offset);
+        writer.put(static_cast<uint64_t>(image.size()));
+        offset += image.size();
+    }
+    for (const auto& image : images) {
+        writer.putBytes(image.second.data(), image.second.size());
+    }
+
+    fs::create_directories(fs::path(libraryPath).parent_path(), ec);
+    if (!writeFileAtomically(libraryPath, writer.data())) {
+        stats.failed += images.size();
+        return stats;
+    }
+    stats.published = images.size();
+    stats.bytes = writer.size();
+    return stats;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cxxmidi/file.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "event_preprocessor.hpp"
+#include "hymn_cache.hpp"
+#include "mapped_file.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Read-only library of preprocessed hymns, shared by every process that maps it
+ *
+ * A library is one file holding the HymnCache image of every hymn in a
+ * directory behind a sorted index. It is published once (play
+ * --publish-library) and then mapped read-only by the player, the daemon,
+ * a touch-screen UI or any other tool: the kernel keeps a single copy of
+ * its pages however many processes have it mapped, so memory stays flat
+ * and any hymn is a binary search away, without touching its MIDI file.
+ *
+ * Each image keeps its source stamp, so a hymn changed since publishing
+ * is simply not found and is read the usual way. Publishing replaces the
+ * file atomically; attach() notices the new file and maps it, while
+ * processes that have not looked again keep reading the old one.
+ *
+ * Layout (host byte order):
+ *   header:  magic, format version, hymn count
+ *   index:   per hymn, sorted by path hash: path hash, image offset, image size
+ *   images:  HymnCache images, back to back
+ */
+class HymnLibrary {
+public:
+    /**
+     * @brief Result of publishing a directory
+     */
+    struct PublishStats {
+        size_t published = 0;   // Hymns in the new library
+        size_t loaded = 0;      // Of those, hymns that were not in the previous library
+        size_t failed = 0;      // Files that could not be loaded
+        size_t bytes = 0;       // Size of the library file; 0 if it could not be written
+    };
+
+    HymnLibrary() = default;
+
+    // Disable copy/move
+    HymnLibrary(const HymnLibrary&) = delete;
+    HymnLibrary& operator=(const HymnLibrary&) = delete;
+
+    /**
+     * @brief Library location inside a cache directory
+     * @param staging true for the staging directory's library
+     * @return Library path, or empty if there is no cache directory
+     */
+    static std::string pathIn(const std::string& cacheDirectory, bool staging);
+
+    /**
+     * @brief Load every hymn of a directory and publish them as a library
+     *
+     * Hymns already in the library at @p libraryPath are copied from it;
+     * the others are loaded through MidiLoader and taken from @p cache.
+     * @param directory Directory holding the MIDI files
+     * @param cache Cache the hymns are loaded through
+     * @param libraryPath Library file to replace
+     */
+    static PublishStats publish(const std::string& directory, const HymnCache& cache, const std::string& libraryPath);
+
+    /**
+     * @brief Map a library, or the newer file published since it was mapped
+     * @return false if there is no valid library at @p path
+     */
+    bool attach(const std::string& path);
+
+    bool isAttached() const { return image_.isOpen(); }
+    size_t size() const { return count_; }
+    size_t byteCount() const { return image_.size(); }
+
+    /**
+     * @brief Load a hymn from the library
+     * @param path Path of the source MIDI file
+     * @return true if the library has the hymn as its file is now
+     */
+    bool load(const std::string& path, cxxmidi::File& file, PreprocessedMetadata& metadata) const;
+
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+private:
+    /**
+     * @brief The cache image of a source file as it is now
+     */
+    bool findImage(const HymnCache::SourceStamp& stamp, const uint8_t*& data, size_t& size,
+                   cxxmidi::File& file, PreprocessedMetadata& metadata) const;
+
+    static uint64_t hashPath(const std::string& canonicalPath);
+
+    MappedFile image_;
+    std::string path_;
+    uint64_t inode_ = 0;        // Of the file mapped, to notice a newer one
+    int64_t mtimeNs_ = 0;
+    uint32_t count_ = 0;
+
+    static constexpr uint32_t MAGIC = 0x4C48504D;   // "MPHL"
+    static constexpr size_t HEADER_SIZE = 3 * sizeof(uint32_t);
+    static constexpr size_t RECORD_SIZE = 3 * sizeof(uint64_t);
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,72 @@
+#include "hymn_preloader.hpp"
+#include "options.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace MidiPlay {
+
+HymnPreloader::HymnPreloader(int playbackCpu)
+    : playbackCpu_(playbackCpu)
+{
+}
+
+HymnPreloader::~HymnPreloader() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void HymnPreloader::start(std::unique_ptr<MidiLoader> loader, std::string path, const Options& options) {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    loader_ = std::move(loader);
+    loaded_ = false;
+    done_.store(false, std::memory_order_relaxed);
+    thread_ = std::thread(&HymnPreloader::run, this, std::move(path), std::cref(options));
+}
+
+std::unique_ptr<MidiLoader> HymnPreloader::take() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    if (!loaded_) {
+        loader_.reset();
+    }
+    loaded_ = false;
+    done_.store(false, std::memory_order_relaxed);
+    return std::move(loader_);
+}
+
+void HymnPreloader::run(std::string path, const Options& options) {
+    yieldToPlayback();
+
+    loaded_ = loader_ && loader_->loadFile(path, options);
+    done_.store(true, std::memory_order_release);
+}
+
+void HymnPreloader::yieldToPlayback() const {
+    // Only idle time: never preempts the player, whatever its policy
+    sched_param param{};
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+    // Every core but the player's; a single-core system keeps its one core
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (long cpu = 0; cpu < online && cpu < CPU_SETSIZE; cpu++) {
+        if (cpu != playbackCpu_) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (CPU_COUNT(&cpus) > 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+}
+
+} // namespace MidiPlay
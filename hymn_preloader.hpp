@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "midi_loader.hpp"
+
+// Forward declaration
+class Options;
+
+namespace MidiPlay {
+
+/**
+ * @brief Loads the next hymn on a background thread while the current one plays
+ *
+ * Each start() hands a fresh MidiLoader to a worker thread, which runs
+ * MidiLoader::loadFile and keeps the result until take(). The worker shares
+ * nothing with the player: it has its own loader, file and event
+ * preprocessor, and the hand-off is a join on the main thread between
+ * hymns, never on the player thread.
+ *
+ * Threads inherit the creator's scheduling, so after --realtime the worker
+ * would run SCHED_FIFO on the playback core. It moves itself to SCHED_IDLE
+ * and off that core before loading, so it only ever uses time the player
+ * leaves over.
+ */
+class HymnPreloader {
+public:
+    /**
+     * @param playbackCpu Core the player is pinned to, kept free of loading;
+     *                    -1 if playback is not pinned
+     */
+    explicit HymnPreloader(int playbackCpu = -1);
+
+    /**
+     * @brief Waits for a load in progress
+     */
+    ~HymnPreloader();
+
+    HymnPreloader(const HymnPreloader&) = delete;
+    HymnPreloader& operator=(const HymnPreloader&) = delete;
+
+    /**
+     * @brief Start loading a hymn; a previous load not yet taken is discarded
+     * @param loader Loader to fill, already configured (e.g. its cache directory)
+     * @param path Full path of the MIDI file
+     * @param options Options of that hymn; must stay alive until take()
+     */
+    void start(std::unique_ptr<MidiLoader> loader, std::string path, const Options& options);
+
+    /**
+     * @brief Whether a started load has finished (without waiting)
+     */
+    bool isReady() const { return done_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Wait for the load and hand over its loader
+     * @return The loaded hymn, or nullptr if nothing was started or loading failed
+     */
+    std::unique_ptr<MidiLoader> take();
+
+private:
+    void run(std::string path, const Options& options);
+    void yieldToPlayback() const;
+
+    int playbackCpu_;
+    std::thread thread_;
+    std::unique_ptr<MidiLoader> loader_;
+    bool loaded_ = false;
+    std::atomic<bool> done_{false};
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,248 @@
+#include "hymnal_index.hpp"
+#include "hymn_cache.hpp"
+#include "midi_loader.hpp"
+#include "options.hpp"
+#include "binary_io.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <system_error>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace MidiPlay {
+
+namespace {
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+bool isMidiFile(const fs::path& path) {
+    return toLower(path.extension().string()) == ".mid";
+}
+
+bool statFile(const std::string& path, uint64_t& size, int64_t& mtimeNs) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    mtimeNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    return true;
+}
+
+} // namespace
+
+HymnalIndex::HymnalIndex(std::string indexPath)
+    : indexPath_(std::move(indexPath))
+{
+}
+
+std::string HymnalIndex::defaultIndexPath(bool staging) {
+    std::string directory = HymnCache::defaultDirectory();
+    if (directory.empty()) {
+        return "";
+    }
+    return directory + (staging ? "/hymnal-staging.idx" : "/hymnal.idx");
+}
+
+bool HymnalIndex::load() {
+    entries_.clear();
+    directory_.clear();
+
+    MappedFile image(indexPath_);
+    if (!image.isOpen()) {
+        return false;
+    }
+
+    ByteReader reader(image.data(), image.size());
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    std::string directory;
+    uint32_t count = 0;
+    if (!reader.get(magic) || magic != MAGIC
+        || !reader.get(version) || version != FORMAT_VERSION
+        || !reader.getString(directory)
+        || !reader.getVarint(count) || count > reader.remaining()) {
+        return false;
+    }
+
+    std::vector<HymnalEntry> entries;
+    entries.reserve(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        HymnalEntry entry;
+        int32_t verses = 0;
+        int32_t bpm = 0;
+        uint8_t hasIntro = 0;
+        if (!reader.getString(entry.fileName)
+            || !reader.get(entry.size)
+            || !reader.get(entry.mtimeNs)
+            || !reader.getString(entry.title)
+            || !reader.getString(entry.keySignature)
+            || !reader.get(verses)
+            || !reader.get(bpm)
+            || !reader.get(hasIntro)
+            || !reader.get(entry.durationSeconds)) {
+            return false;
+        }
+        entry.verses = verses;
+        entry.bpm = bpm;
+        entry.hasIntro = hasIntro != 0;
+        entries.push_back(std::move(entry));
+    }
+
+    directory_ = std::move(directory);
+    entries_ = std::move(entries);
+    return true;
+}
+
+bool HymnalIndex::save() const {
+    if (indexPath_.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::create_directories(fs::path(indexPath_).parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    ByteWriter writer;
+    writer.put(MAGIC);
+    writer.put(FORMAT_VERSION);
+    writer.putString(directory_);
+    writer.putVarint(static_cast<uint32_t>(entries_.size()));
+
+    for (const HymnalEntry& entry : entries_) {
+        writer.putString(entry.fileName);
+        writer.put(entry.size);
+        writer.put(entry.mtimeNs);
+        writer.putString(entry.title);
+        writer.putString(entry.keySignature);
+        writer.put(static_cast<int32_t>(entry.verses));
+        writer.put(static_cast<int32_t>(entry.bpm));
+        writer.put(static_cast<uint8_t>(entry.hasIntro));
+        writer.put(entry.durationSeconds);
+    }
+
+    return writeFileAtomically(indexPath_, writer.data());
+}
+
+HymnalIndex::UpdateStats HymnalIndex::update(const std::string& directory) {
+    UpdateStats stats;
+
+    // An index of some other directory has nothing worth reusing
+    if (directory != directory_) {
+        entries_.clear();
+        directory_ = directory;
+    }
+
+    std::vector<std::string> fileNames;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && isMidiFile(it->path())) {
+            fileNames.push_back(it->path().filename().string());
+        }
+    }
+    std::sort(fileNames.begin(), fileNames.end());
+
+    std::vector<HymnalEntry> updated;
+    updated.reserve(fileNames.size());
+
+    // Both lists are sorted by file name, so a single merge pass finds reusable entries
+    auto previous = entries_.begin();
+    for (const std::string& fileName : fileNames) {
+        while (previous != entries_.end() && previous->fileName < fileName) {
+            ++previous;
+            stats.removed++;
+        }
+
+        std::string path = (fs::path(directory) / fileName).string();
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+        if (!statFile(path, size, mtimeNs)) {
+            stats.failed++;
+            continue;
+        }
+
+        if (previous != entries_.end() && previous->fileName == fileName
+            && previous->size == size && previous->mtimeNs == mtimeNs) {
+            updated.push_back(std::move(*previous));
+            ++previous;
+            stats.reused++;
+            continue;
+        }
+
+        if (previous != entries_.end() && previous->fileName == fileName) {
+            ++previous;     // Modified; replaced by the fresh entry below
+        }
+
+        HymnalEntry entry;
+        entry.fileName = fileName;
+        entry.size = size;
+        entry.mtimeNs = mtimeNs;
+        if (indexEntry(path, entry)) {
+            updated.push_back(std::move(entry));
+            stats.indexed++;
+        } else {
+            stats.failed++;
+        }
+    }
+    stats.removed += static_cast<size_t>(entries_.end() - previous);
+
+    entries_ = std::move(updated);
+    return stats;
+}
+
+// Load one file with default options and capture what a listing needs
+bool HymnalIndex::indexEntry(const std::string& path, HymnalEntry& entry) {
+    Options defaults(0, nullptr);
+    MidiLoader loader;
+    if (!loader.loadFile(path, defaults)) {
+        return false;
+    }
+
+    entry.title = loader.getTitle();
+    entry.keySignature = loader.getKeySignature();
+    entry.verses = loader.getVerses();
+    entry.bpm = loader.getBpm();
+    entry.hasIntro = !loader.getIntroSegments().empty();
+    entry.durationSeconds = loader.getProjectedDurationSeconds();
+    return true;
+}
+
+std::vector<HymnalEntry> HymnalIndex::search(const std::string& query) const {
+    std::string needle = toLower(query);
+    std::vector<HymnalEntry> matches;
+
+    for (const HymnalEntry& entry : entries_) {
+        if (needle.empty()
+            || toLower(entry.title).find(needle) != std::string::npos
+            || toLower(entry.fileName).find(needle) != std::string::npos) {
+            matches.push_back(entry);
+        }
+    }
+
+    return matches;
+}
+
+const HymnalEntry* HymnalIndex::find(const std::string& fileName) const {
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), fileName,
+                               [](const HymnalEntry& entry, const std::string& name) {
+                                   return entry.fileName < name;
+                               });
+    if (it != entries_.end() && it->fileName == fileName) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace MidiPlay {
+
+/**
+ * @brief Metadata for one hymn in the index
+ */
+struct HymnalEntry {
+    std::string fileName;           // File name relative to the indexed directory
+    uint64_t size = 0;              // Source file size when indexed
+    int64_t mtimeNs = 0;            // Source modification time when indexed
+    std::string title;
+    std::string keySignature;
+    int verses = 0;                 // Verses played by default
+    int bpm = 0;                    // Beats per minute of the first tempo
+    bool hasIntro = false;          // File has introduction markers
+    double durationSeconds = 0.0;   // Projected default playing time
+};
+
+/**
+ * @brief Persistent metadata index of a hymn directory
+ *
+ * Every MIDI file in the directory is run through MidiLoader (and so the
+ * EventPreProcessor) once; the extracted metadata is kept in a compact binary
+ * index so listing or searching thousands of hymns never opens a MIDI file.
+ * update() is incremental: only files whose size or modification time changed
+ * since the last scan are loaded again.
+ *
+ * The index file is read with mmap and written atomically, like HymnCache.
+ * A missing, stale-format or corrupt index simply loads as empty and is
+ * rebuilt by the next update().
+ */
+class HymnalIndex {
+public:
+    /**
+     * @brief Result of an incremental update
+     */
+    struct UpdateStats {
+        size_t reused = 0;      // Unchanged entries kept from the previous index
+        size_t indexed = 0;     // New or modified files loaded
+        size_t removed = 0;     // Entries whose file has disappeared
+        size_t failed = 0;      // Files that could not be loaded
+    };
+
+    /**
+     * @brief Constructor
+     * @param indexPath Location of the index file
+     */
+    explicit HymnalIndex(std::string indexPath);
+
+    /**
+     * @brief Default index location inside HymnCache::defaultDirectory()
+     * @param staging true for the staging directory's index
+     * @return Index path, or empty if there is no usable cache directory
+     */
+    static std::string defaultIndexPath(bool staging);
+
+    /**
+     * @brief Read the index file
+     * @return true if a valid index was read; false leaves the index empty
+     */
+    bool load();
+
+    /**
+     * @brief Write the index file
+     * @return true if the index file was replaced
+     */
+    bool save() const;
+
+    /**
+     * @brief Bring the index up to date with a hymn directory
+     * @param directory Directory holding the MIDI files
+     * @return Counts of reused, re-indexed, removed and failed files
+     */
+    UpdateStats update(const std::string& directory);
+
+    /**
+     * @brief Case-insensitive search on title and file name
+     * @param query Text to look for; empty matches every entry
+     * @return Matching entries in file name order
+     */
+    std::vector<HymnalEntry> search(const std::string& query) const;
+
+    /**
+     * @brief Look up a single hymn by file name
+     * @return Entry, or nullptr if the file is not indexed
+     */
+    const HymnalEntry* find(const std::string& fileName) const;
+
+    const std::vector<HymnalEntry>& entries() const { return entries_; }
+    const std::string& getDirectory() const { return directory_; }
+    const std::string& getIndexPath() const { return indexPath_; }
+
+    static constexpr uint32_t FORMAT_VERSION = 2;
+
+private:
+    static bool indexEntry(const std::string& path, HymnalEntry& entry);
+
+    std::string indexPath_;
+    std::string directory_;                 // Directory the entries describe
+    std::vector<HymnalEntry> entries_;      // Sorted by file name
+
+    static constexpr uint32_t MAGIC = 0x4948504D;   // "MPHI"
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,279 @@
+#include "hymnal_linter.hpp"
+
+#include <cxxmidi/event.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include "event_preprocessor.hpp"
+#include "i18n.hpp"
+#include "options.hpp"
+#include "smf_reader.hpp"
+
+namespace fs = std::filesystem;
+
+namespace MidiPlay {
+
+namespace {
+
+bool isMidiFile(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".mid";
+}
+
+// File names may hold anything; escape what JSON requires
+std::string quoted(const std::string& text) {
+    std::string result = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            result += escape;
+        } else {
+            result += static_cast<char>(c);
+        }
+    }
+    return result + "\"";
+}
+
+// Introduction markers are only read on track 0; pair them in playing order
+void checkIntroMarkers(const std::vector<Directive>& directives, std::vector<LintIssue>& issues) {
+    bool open = false;
+    uint32_t openTick = 0;
+    for (const Directive& directive : directives) {
+        if (directive.track != 0) {
+            continue;
+        }
+        if (directive.kind == DirectiveKind::IntroBegin) {
+            if (open) {
+                issues.push_back({LintIssue::Kind::UnbalancedIntro, directive.tick,
+                                  _("'[' before the ']' of the '[' at tick ") + std::to_string(openTick)});
+            }
+            open = true;
+            openTick = directive.tick;
+        } else if (directive.kind == DirectiveKind::IntroEnd) {
+            if (!open) {
+                issues.push_back({LintIssue::Kind::UnbalancedIntro, directive.tick, _("']' without '['")});
+            }
+            open = false;
+        }
+    }
+    if (open) {
+        issues.push_back({LintIssue::Kind::UnbalancedIntro, openTick, _("'[' without ']'")});
+    }
+}
+
+} // namespace
+
+const char* LintIssue::code(Kind kind) {
+    switch (kind) {
+        case Kind::Unreadable:       return "unreadable";
+        case Kind::DeprecatedVerses: return "deprecated-verses";
+        case Kind::DeprecatedPause:  return "deprecated-pause";
+        case Kind::MissingTempo:     return "missing-tempo";
+        case Kind::StuckNote:        return "stuck-note";
+        case Kind::UnbalancedIntro:  return "unbalanced-intro";
+        case Kind::MissingFine:      return "missing-fine";
+    }
+    return "unknown";
+}
+
+HymnalLinter::HymnalLinter(unsigned workers)
+    : workers_(workers)
+{
+    if (workers_ == 0) {
+        workers_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+LintResult HymnalLinter::lintFile(const std::string& path, EventPreProcessor& processor, const Options& options) {
+    LintResult result;
+    result.path = path;
+    processor.reset();
+
+    SmfReader reader;
+    if (!reader.open(path)) {
+        result.issues.push_back({LintIssue::Kind::Unreadable, 0, reader.getError()});
+        return result;
+    }
+
+    // Track after track, as loading feeds the preprocessor
+    cxxmidi::Event event;
+    try {
+        for (size_t t = 0; t < reader.getTrackCount(); t++) {
+            SmfReader::Track track = reader.track(t);
+            while (track.nextLoadable(event)) {
+                processor.processEvent(event, options);
+            }
+        }
+    }
+    catch (const std::runtime_error& e) {
+        result.issues.push_back({LintIssue::Kind::Unreadable, 0, e.what()});
+        return result;
+    }
+
+    uint8_t warnings = processor.getWarnings();
+    if (warnings & EventPreProcessor::WARNING_DEPRECATED_VERSES) {
+        result.issues.push_back({LintIssue::Kind::DeprecatedVerses, 0,
+                                 _("Deprecated meta event 0x10 for verses; use the sequencer-specific event")});
+    }
+    if (warnings & EventPreProcessor::WARNING_DEPRECATED_PAUSE) {
+        result.issues.push_back({LintIssue::Kind::DeprecatedPause, 0,
+                                 _("Deprecated meta event 0x11 for the pause; use the sequencer-specific event")});
+    }
+
+    const std::vector<TempoChange>& tempoChanges = processor.getTempoChanges();
+    if (processor.isFirstTempo()) {
+        result.issues.push_back({LintIssue::Kind::MissingTempo, 0, _("No tempo event; plays at 120 bpm")});
+    } else {
+        auto first = std::min_element(tempoChanges.begin(), tempoChanges.end(),
+                                      [](const TempoChange& a, const TempoChange& b) { return a.tick < b.tick; });
+        if (first != tempoChanges.end() && first->tick > 0) {
+            result.issues.push_back({LintIssue::Kind::MissingTempo, first->tick,
+                                     _("No tempo event at the start; plays at 120 bpm until the first one")});
+        }
+    }
+
+    if (processor.hasPotentialStuckNote()) {
+        const std::vector<IntroductionSegment>& segments = processor.getIntroSegments();
+        result.issues.push_back({LintIssue::Kind::StuckNote, segments.empty() ? 0 : segments.back().end,
+                                 _("Final intro marker not past last NoteOff event")});
+    }
+
+    const std::vector<Directive>& directives = processor.getDirectives();
+    checkIntroMarkers(directives, result.issues);
+
+    auto daCapo = std::find_if(directives.begin(), directives.end(),
+                               [](const Directive& directive) { return directive.kind == DirectiveKind::DaCapoAlFine; });
+    bool hasFine = std::any_of(directives.begin(), directives.end(),
+                               [](const Directive& directive) { return directive.kind == DirectiveKind::Fine; });
+    if (daCapo != directives.end() && !hasFine) {
+        result.issues.push_back({LintIssue::Kind::MissingFine, daCapo->tick,
+                                 _("D.C. al Fine without a Fine marker; the repeat plays to the end")});
+    }
+
+    return result;
+}
+
+std::vector<LintResult> HymnalLinter::lintDirectory(const std::string& directory) {
+    auto started = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        throw std::runtime_error(_("Unable to read directory ") + directory + ": " + ec.message());
+    }
+
+    std::vector<std::string> paths;
+    for (fs::recursive_directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        if (it->is_regular_file(ec) && isMidiFile(it->path())) {
+            paths.push_back(it->path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // Each worker takes the next file until none are left; slots are written by one worker only
+    std::vector<LintResult> results(paths.size());
+    std::atomic<size_t> next{0};
+    Options defaults(0, nullptr);   // Quiet, no tempo or verse overrides; only read by the workers
+
+    auto work = [&]() {
+        EventPreProcessor processor;
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < paths.size();
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+            results[i] = lintFile(paths[i], processor, defaults);
+            results[i].path = fs::path(paths[i]).lexically_relative(directory).string();
+        }
+    };
+
+    unsigned threadCount = static_cast<unsigned>(std::min<size_t>(workers_, std::max<size_t>(paths.size(), 1)));
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; i++) {
+        threads.emplace_back(work);
+    }
+    work();     // The calling thread is one of the workers
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    summary_ = Summary();
+    summary_.files = results.size();
+    summary_.workers = threadCount;
+    for (const LintResult& result : results) {
+        if (!result.issues.empty()) {
+            summary_.filesWithIssues++;
+            summary_.issues += result.issues.size();
+        }
+    }
+    summary_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return results;
+}
+
+void HymnalLinter::printReport(const std::vector<LintResult>& results, std::ostream& out, bool verbose) const {
+    for (const LintResult& result : results) {
+        if (result.issues.empty()) {
+            if (verbose) {
+                out << result.path << ": " << _("ok") << std::endl;
+            }
+            continue;
+        }
+        for (const LintIssue& issue : result.issues) {
+            out << result.path << ":" << issue.tick << ": " << LintIssue::code(issue.kind) << ": "
+                << issue.detail << std::endl;
+        }
+    }
+
+    out << std::endl << summary_.files << _(" files, ") << summary_.filesWithIssues << _(" with issues, ")
+        << summary_.issues << _(" issues") << std::fixed << std::setprecision(1) << _(" (") << summary_.elapsedMs
+        << _(" ms on ") << summary_.workers << _(" threads)") << std::endl;
+}
+
+bool HymnalLinter::writeJson(const std::vector<LintResult>& results, const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    out << "{\n";
+    out << "  \"files\": " << summary_.files << ",\n";
+    out << "  \"files_with_issues\": " << summary_.filesWithIssues << ",\n";
+    out << "  \"issues\": " << summary_.issues << ",\n";
+    out << "  \"results\": [";
+    bool first = true;
+    for (const LintResult& result : results) {
+        if (result.issues.empty()) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n");
+        out << "    {\"file\": " << quoted(result.path) << ", \"issues\": [";
+        for (size_t i = 0; i < result.issues.size(); i++) {
+            const LintIssue& issue = result.issues[i];
+            out << (i ? ", " : "") << "{\"code\": " << quoted(LintIssue::code(issue.kind))
+                << ", \"tick\": " << issue.tick << ", \"detail\": " << quoted(issue.detail) << "}";
+        }
+        out << "]}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Forward declaration
+class Options;
+
+namespace MidiPlay {
+
+class EventPreProcessor;
+
+/**
+ * @brief Problem found in a hymn file by HymnalLinter
+ */
+struct LintIssue {
+    enum class Kind : uint8_t {
+        Unreadable,         // Not a Standard MIDI File, or truncated
+        DeprecatedVerses,   // Meta event 0x10 instead of the verses sequencer event
+        DeprecatedPause,    // Meta event 0x11 instead of the pause sequencer event
+        MissingTempo,       // No tempo event at the start; playback assumes 120 bpm
+        StuckNote,          // Final intro marker not past the last NoteOff
+        UnbalancedIntro,    // '[' without ']' or ']' without '['
+        MissingFine         // D.C. al Fine without a Fine marker
+    };
+
+    Kind kind;
+    uint32_t tick = 0;      // Where it is, if it has a place in the file
+    std::string detail;
+
+    /**
+     * @brief Stable name of the kind, for the report and for scripts
+     */
+    static const char* code(Kind kind);
+};
+
+/**
+ * @brief Issues of one file
+ */
+struct LintResult {
+    std::string path;       // Relative to the directory linted
+    std::vector<LintIssue> issues;
+};
+
+/**
+ * @brief Checks every hymn of a directory tree for problems that otherwise only show in a service
+ *
+ * Each file goes through EventPreProcessor exactly as loading does, decoded
+ * with SmfReader straight from the mapped file and nothing kept, and its
+ * load-time findings become issues. Files are shared out to a pool of
+ * worker threads, one per core by default, through an atomic index into the
+ * sorted file list; each worker has its own preprocessor, and results land
+ * in the file's own slot, so workers share nothing else and the report is in
+ * file order whatever the scheduling.
+ */
+class HymnalLinter {
+public:
+    struct Summary {
+        size_t files = 0;
+        size_t filesWithIssues = 0;
+        size_t issues = 0;
+        double elapsedMs = 0.0;
+        unsigned workers = 0;
+    };
+
+    /**
+     * @param workers Threads to use; 0 for one per core
+     */
+    explicit HymnalLinter(unsigned workers = 0);
+
+    /**
+     * @brief Lint every .mid file under a directory, including subdirectories
+     * @return One result per file, sorted by path; files without issues included
+     * @throws std::runtime_error if the directory cannot be read
+     */
+    std::vector<LintResult> lintDirectory(const std::string& directory);
+
+    /**
+     * @brief Lint one file with a caller's preprocessor, which is reset first
+     */
+    static LintResult lintFile(const std::string& path, EventPreProcessor& processor, const Options& options);
+
+    /**
+     * @brief Counts and timing of the last lintDirectory()
+     */
+    const Summary& getSummary() const { return summary_; }
+
+    /**
+     * @brief One line per issue, "<file>:<tick>: <code>: <detail>", then the summary
+     * @param verbose Also list files without issues
+     */
+    void printReport(const std::vector<LintResult>& results, std::ostream& out, bool verbose) const;
+
+    /**
+     * @brief Write the report as JSON
+     * @return false if the file cannot be written
+     */
+    bool writeJson(const std::vector<LintResult>& results, const std::string& path) const;
+
+private:
+    unsigned workers_;
+    Summary summary_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,70 @@
+#include "jitter_recorder.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <time.h>
+
+namespace MidiPlay {
+
+JitterRecorder::JitterRecorder(size_t capacity)
+    : samples_(std::make_unique<Sample[]>(capacity))
+    , capacity_(capacity)
+{
+    // Touch the buffer now so recording never page-faults
+    std::fill(samples_.get(), samples_.get() + capacity_, Sample{0, 0, 0});
+}
+
+int64_t JitterRecorder::now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+std::vector<JitterRecorder::SectionStats> JitterRecorder::summarize() const {
+    // Lateness in microseconds, grouped by section
+    std::map<uint16_t, std::vector<int64_t>> lateness;
+    size_t count = size();
+    for (size_t i = 0; i < count; i++) {
+        const Sample& sample = samples_[i];
+        lateness[sample.section].push_back((sample.actualNs - sample.scheduledNs) / 1000);
+    }
+    
+    std::vector<SectionStats> result;
+    for (auto& [section, values] : lateness) {
+        std::sort(values.begin(), values.end());
+        
+        SectionStats stats;
+        stats.section = section;
+        stats.count = values.size();
+        stats.p50Us = values[(values.size() - 1) / 2];
+        stats.p99Us = values[(values.size() - 1) * 99 / 100];
+        stats.maxUs = values.back();
+        
+        for (int64_t us : values) {
+            size_t bucket = static_cast<size_t>(
+                std::upper_bound(BUCKET_LIMITS_US.begin(), BUCKET_LIMITS_US.end(), us) - BUCKET_LIMITS_US.begin());
+            stats.histogram[bucket]++;
+        }
+        result.push_back(stats);
+    }
+    return result;
+}
+
+bool JitterRecorder::writeCsv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    
+    out << "section,scheduled_ns,actual_ns,lateness_us\n";
+    size_t count = size();
+    for (size_t i = 0; i < count; i++) {
+        const Sample& sample = samples_[i];
+        out << sample.section << ',' << sample.scheduledNs << ',' << sample.actualNs << ','
+            << (sample.actualNs - sample.scheduledNs) / 1000 << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+} // namespace MidiPlay
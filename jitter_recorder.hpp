@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MidiPlay {
+
+/**
+ * @brief Records scheduled and actual send time of every event (--jitter)
+ * 
+ * The playback engine calls record() on its player thread just before each
+ * message goes to the output port. Samples go into a buffer allocated up
+ * front; recording is a couple of stores and a release of the count, with
+ * no lock and no allocation. When the buffer is full further samples are
+ * counted as dropped.
+ * 
+ * Times are CLOCK_MONOTONIC nanoseconds (std::chrono::steady_clock on Linux).
+ * 
+ * Samples are grouped by section: the orchestrator calls beginSection()
+ * with 0 for the introduction and the verse number for each verse. Only one
+ * thread may call record(); summarize() and writeCsv() are for after playback.
+ */
+class JitterRecorder {
+public:
+    struct Sample {
+        int64_t scheduledNs;
+        int64_t actualNs;
+        uint16_t section;
+    };
+    
+    // Upper bounds of the lateness histogram buckets; the last bucket is open
+    static constexpr std::array<int64_t, 7> BUCKET_LIMITS_US = {100, 250, 500, 1000, 2000, 5000, 10000};
+    static constexpr size_t BUCKET_COUNT = BUCKET_LIMITS_US.size() + 1;
+    
+    struct SectionStats {
+        uint16_t section = 0;
+        size_t count = 0;
+        int64_t p50Us = 0;
+        int64_t p99Us = 0;
+        int64_t maxUs = 0;
+        std::array<size_t, BUCKET_COUNT> histogram{};   // Early sends count in the first bucket
+    };
+    
+    /**
+     * @brief Constructor; allocates the whole buffer
+     * @param capacity Maximum number of samples
+     */
+    explicit JitterRecorder(size_t capacity);
+    
+    // Disable copy/move
+    JitterRecorder(const JitterRecorder&) = delete;
+    JitterRecorder& operator=(const JitterRecorder&) = delete;
+    
+    /**
+     * @brief Current CLOCK_MONOTONIC time in nanoseconds
+     */
+    static int64_t now();
+    
+    /**
+     * @brief Record one send (player thread only)
+     */
+    void record(int64_t scheduledNs, int64_t actualNs) {
+        size_t index = count_.load(std::memory_order_relaxed);
+        if (index >= capacity_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        samples_[index] = {scheduledNs, actualNs, section_.load(std::memory_order_relaxed)};
+        count_.store(index + 1, std::memory_order_release);
+    }
+    
+    /**
+     * @brief Label the samples that follow (0 = introduction, n = verse n)
+     */
+    void beginSection(uint16_t section) { section_.store(section, std::memory_order_relaxed); }
+    uint16_t section() const { return section_.load(std::memory_order_relaxed); }
+    
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    const Sample& at(size_t index) const { return samples_[index]; }
+    
+    /**
+     * @brief Lateness statistics per section, in section order
+     */
+    std::vector<SectionStats> summarize() const;
+    
+    /**
+     * @brief Write every sample as CSV: section,scheduled_ns,actual_ns,lateness_us
+     * @return false if the file could not be written
+     */
+    bool writeCsv(const std::string& path) const;
+    
+private:
+    std::unique_ptr<Sample[]> samples_;
+    size_t capacity_;
+    std::atomic<size_t> count_{0};
+    std::atomic<size_t> dropped_{0};
+    std::atomic<uint16_t> section_{0};
+};
+
+} // namespace MidiPlay
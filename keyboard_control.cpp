@@ -0,0 +1,133 @@
+#include "keyboard_control.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+
+#include "i18n.hpp"
+#include "realtime_scheduler.hpp"
+
+namespace MidiPlay {
+
+KeyboardControl::KeyboardControl(PlaybackCommandQueue& queue, int fd)
+    : queue_(queue)
+    , fd_(fd)
+{
+}
+
+KeyboardControl::~KeyboardControl() {
+    if (thread_.joinable()) {
+        uint8_t done = 0;
+        ssize_t ignored = ::write(wake_[1], &done, sizeof(done));
+        (void)ignored;
+        thread_.join();
+    }
+    if (wake_[0] >= 0) {
+        ::close(wake_[0]);
+        ::close(wake_[1]);
+    }
+    restoreTerminal();
+}
+
+bool KeyboardControl::start() {
+    if (::pipe2(wake_, O_CLOEXEC) != 0) {
+        wake_[0] = wake_[1] = -1;
+        return false;
+    }
+
+    // Keys act without Enter and are not echoed; ISIG stays on for Ctrl-C
+    termios terminal;
+    if (::isatty(fd_) && ::tcgetattr(fd_, &terminal) == 0) {
+        static bool exitHandlerRegistered = false;
+        if (!exitHandlerRegistered) {
+            std::atexit(restoreTerminal);   // SignalHandler ends the process with std::exit
+            exitHandlerRegistered = true;
+        }
+        s_savedTerminal = terminal;
+        s_terminalFd = fd_;
+        terminal.c_lflag &= ~(ICANON | ECHO);
+        terminal.c_cc[VMIN] = 1;
+        terminal.c_cc[VTIME] = 0;
+        ::tcsetattr(fd_, TCSANOW, &terminal);
+    }
+
+    thread_ = std::thread([this]() { run(); });
+    return true;
+}
+
+std::optional<PlaybackCommand> KeyboardControl::commandForKey(char key) {
+    switch (key) {
+        case '+':
+        case '=':   // + without Shift
+            return PlaybackCommand{PlaybackCommand::Kind::Tempo, TEMPO_STEP_PERCENT};
+        case '-':
+            return PlaybackCommand{PlaybackCommand::Kind::Tempo, -TEMPO_STEP_PERCENT};
+        case 'l':
+        case 'L':
+            return PlaybackCommand{PlaybackCommand::Kind::LastVerse};
+        case 'e':
+        case 'E':
+            return PlaybackCommand{PlaybackCommand::Kind::EndAfterVerse};
+        case 'q':
+        case 'Q':
+            return PlaybackCommand{PlaybackCommand::Kind::Stop};
+        default:
+            return std::nullopt;
+    }
+}
+
+const char* KeyboardControl::keyHelp() {
+    return _(" Keys: + faster, - slower, l last verse, e end after this verse, q stop");
+}
+
+void KeyboardControl::run() {
+    RealtimeScheduler::releaseCurrentThread();  // Waiting for keys needs no real-time priority
+
+    pollfd fds[2] = {
+        {fd_, POLLIN, 0},
+        {wake_[0], POLLIN, 0}
+    };
+
+    while (true) {
+        int n = ::poll(fds, 2, -1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 || fds[1].revents != 0) {
+            return;
+        }
+        if ((fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) && !(fds[0].revents & POLLIN)) {
+            return;     // Input closed
+        }
+
+        char key;
+        if (::read(fd_, &key, 1) != 1) {
+            return;
+        }
+
+        std::optional<PlaybackCommand> command = commandForKey(key);
+        if (!command || !queue_.push(*command)) {
+            continue;
+        }
+        if (commandCallback_) {
+            commandCallback_();
+        }
+        if (command->kind == PlaybackCommand::Kind::EndAfterVerse) {
+            std::cout << _(" Ending after this verse") << std::endl;
+        } else if (command->kind == PlaybackCommand::Kind::Tempo) {
+            std::cout << (command->value > 0 ? _(" Faster") : _(" Slower")) << std::endl;
+        }
+    }
+}
+
+void KeyboardControl::restoreTerminal() {
+    if (s_terminalFd >= 0) {
+        ::tcsetattr(s_terminalFd, TCSANOW, &s_savedTerminal);
+        s_terminalFd = -1;
+    }
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <termios.h>
+#include <thread>
+
+#include "playback_command.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Turns keys pressed while a hymn plays into PlaybackCommands
+ *
+ * A reader thread waits on the input and pushes one command per key into
+ * the queue; it is the queue's only producer. On a terminal, line
+ * buffering and echo are switched off while it runs, so a key acts at
+ * once; Ctrl-C still interrupts. The terminal is restored by the
+ * destructor, and at exit if an interrupt ends the process first.
+ *
+ * Keys: + faster, - slower, l last verse, e end after this verse, q stop.
+ */
+class KeyboardControl {
+public:
+    /**
+     * @param queue Queue the orchestrator takes commands from
+     * @param fd Input to read; standard input by default
+     */
+    explicit KeyboardControl(PlaybackCommandQueue& queue, int fd = 0);
+
+    /**
+     * @brief Stops the reader and restores the terminal
+     */
+    ~KeyboardControl();
+
+    // Disable copy/move
+    KeyboardControl(const KeyboardControl&) = delete;
+    KeyboardControl& operator=(const KeyboardControl&) = delete;
+
+    /**
+     * @brief Run after each command is queued, on the reader thread; set before start()
+     * 
+     * For a tickless player, which only looks at the queue when asked.
+     */
+    void setCommandCallback(const std::function<void()>& callback) { commandCallback_ = callback; }
+
+    /**
+     * @brief Start reading keys
+     * @return false if the reader could not be started
+     */
+    bool start();
+
+    /**
+     * @brief Command for a key
+     * @return std::nullopt for keys without a command
+     */
+    static std::optional<PlaybackCommand> commandForKey(char key);
+
+    /**
+     * @brief One line listing the keys, for display before playing
+     */
+    static const char* keyHelp();
+
+    static constexpr int8_t TEMPO_STEP_PERCENT = 2;
+
+private:
+    void run();
+    static void restoreTerminal();
+
+    PlaybackCommandQueue& queue_;
+    int fd_;
+    int wake_[2] = {-1, -1};
+    std::function<void()> commandCallback_;
+    std::thread thread_;
+
+    // One terminal per process; kept static so the exit handler can restore it
+    inline static termios s_savedTerminal{};
+    inline static int s_terminalFd = -1;
+};
+
+} // namespace MidiPlay
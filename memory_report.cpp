@@ -0,0 +1,62 @@
+#include "memory_report.hpp"
+
+#include <cxxmidi/event.hpp>
+
+#include <iomanip>
+#include <malloc.h>
+
+#include "i18n.hpp"
+#include "playback_timeline.hpp"
+
+namespace MidiPlay {
+
+namespace {
+
+// glibc keeps one size word in front of every chunk
+constexpr size_t CHUNK_HEADER_BYTES = sizeof(size_t);
+
+size_t heapBytes(const void* block) {
+    return block ? malloc_usable_size(const_cast<void*>(block)) + CHUNK_HEADER_BYTES : 0;
+}
+
+} // namespace
+
+MemoryReport::Footprint MemoryReport::measure(const MidiLoader& midiLoader) {
+    Footprint footprint;
+
+    const cxxmidi::File& file = midiLoader.getFile();
+    footprint.fileBytes = sizeof(cxxmidi::File) + heapBytes(file.data());
+    for (const cxxmidi::Track& track : file) {
+        footprint.fileBytes += heapBytes(track.data());
+        for (const cxxmidi::Event& event : track) {
+            footprint.fileBytes += heapBytes(event.data());
+        }
+        footprint.events += track.size();
+    }
+
+    const EventArena& events = midiLoader.getEvents();
+    footprint.arenaBytes = sizeof(EventArena) + events.getMemoryBytes();
+
+    PlaybackTimeline timeline(events);
+    footprint.timelineBytes = sizeof(PlaybackTimeline) + timeline.getMemoryBytes();
+    return footprint;
+}
+
+void MemoryReport::print(const Footprint& footprint, std::ostream& out) {
+    auto line = [&out, &footprint](const char* name, size_t bytes) {
+        out << "  " << std::left << std::setw(20) << name << std::right << std::setw(10) << bytes;
+        if (footprint.events > 0) {
+            out << std::setw(10) << std::fixed << std::setprecision(1)
+                << static_cast<double>(bytes) / footprint.events;
+        }
+        out << std::endl;
+    };
+
+    out << _("Memory (bytes):") << std::string(12, ' ') << _("total") << " " << _("per event") << std::endl;
+    line(_("cxxmidi::File"), footprint.fileBytes);
+    line(_("Packed tracks"), footprint.arenaBytes);
+    line(_("Packed timeline"), footprint.timelineBytes);
+    out << "  " << footprint.events << _(" events") << std::endl;
+}
+
+} // namespace MidiPlay
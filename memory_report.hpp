@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+#include "midi_loader.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Memory a loaded hymn takes in each of its event formats (--mem-report)
+ *
+ * The cxxmidi::File is what PlayerSync plays: a vector per track and a heap
+ * block per event, measured with malloc_usable_size() plus the allocator's
+ * chunk header. The packed formats are the EventArena the loader keeps and
+ * the PlaybackTimeline the timeline player builds from it. Enough to tell
+ * how many hymns a daemon or setlist can keep resident.
+ */
+class MemoryReport {
+public:
+    struct Footprint {
+        size_t events = 0;
+        size_t fileBytes = 0;       // cxxmidi::File, tracks and event storage
+        size_t arenaBytes = 0;      // MidiLoader::getEvents()
+        size_t timelineBytes = 0;   // PlaybackTimeline built from the arena
+    };
+
+    /**
+     * @brief Measure a loaded hymn; a streaming load must be finished first
+     */
+    static Footprint measure(const MidiLoader& midiLoader);
+
+    static void print(const Footprint& footprint, std::ostream& out);
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "event_view.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Messages due at the same instant, gathered for one write
+ * 
+ * Messages are kept back to back as received. stream() encodes them as one
+ * MIDI byte stream with running status: a channel voice status byte is
+ * left out when it repeats the previous one, system common messages
+ * (including SysEx) cancel running status and real-time messages leave it
+ * alone. A four-voice chord on one channel goes from 12 bytes to 9 on
+ * the wire.
+ * 
+ * Buffers keep their capacity across clear(), so a reused batch stops
+ * allocating once it has seen the largest chord of the piece.
+ */
+class MidiBatch {
+public:
+    MidiBatch() = default;
+    
+    void reserve(size_t messages, size_t bytes) {
+        offsets_.reserve(messages + 1);
+        bytes_.reserve(bytes);
+        stream_.reserve(bytes);
+    }
+    
+    void clear() {
+        offsets_.clear();
+        bytes_.clear();
+    }
+    
+    /**
+     * @brief Append one complete message (status byte first)
+     */
+    void add(const EventView& message) {
+        if (message.empty()) {
+            return;
+        }
+        offsets_.push_back(static_cast<uint32_t>(bytes_.size()));
+        bytes_.insert(bytes_.end(), message.data(), message.data() + message.size());
+    }
+    
+    size_t size() const { return offsets_.size(); }
+    bool empty() const { return offsets_.empty(); }
+    
+    /**
+     * @brief One message as added
+     */
+    EventView message(size_t index) const {
+        size_t begin = offsets_[index];
+        size_t end = index + 1 < offsets_.size() ? offsets_[index + 1] : bytes_.size();
+        return EventView(bytes_.data() + begin, end - begin, 0);
+    }
+    
+    /**
+     * @brief All messages as one byte stream with running status
+     * @return Reference valid until the next add() or stream()
+     */
+    const std::vector<uint8_t>& stream() {
+        stream_.clear();
+        uint8_t runningStatus = 0;
+        
+        for (size_t i = 0; i < offsets_.size(); i++) {
+            EventView msg = message(i);
+            uint8_t status = msg[0];
+            
+            if (status < SYSTEM_COMMON) {
+                // Channel voice: the status byte may be implied by the previous one
+                bool repeat = status == runningStatus;
+                runningStatus = status;
+                stream_.insert(stream_.end(), msg.data() + (repeat ? 1 : 0), msg.data() + msg.size());
+            } else {
+                if (status < SYSTEM_REALTIME) {
+                    runningStatus = 0;
+                }
+                stream_.insert(stream_.end(), msg.data(), msg.data() + msg.size());
+            }
+        }
+        return stream_;
+    }
+    
+private:
+    static constexpr uint8_t SYSTEM_COMMON = 0xF0;      // 0xF0..0xF7 cancel running status
+    static constexpr uint8_t SYSTEM_REALTIME = 0xF8;    // 0xF8..0xFF do not affect it
+    
+    std::vector<uint32_t> offsets_;
+    std::vector<uint8_t> bytes_;
+    std::vector<uint8_t> stream_;
+};
+
+} // namespace MidiPlay
@@ -8,6 +8,12 @@ namespace MidiPlay {
         constexpr std::uint8_t CC_BANK_SELECT_MSB = 0;
         constexpr std::uint8_t CC_BANK_SELECT_LSB = 32;
         constexpr std::uint8_t CC_VOLUME = 7;
+        constexpr std::uint8_t CC_DATA_ENTRY_MSB = 6;
+        constexpr std::uint8_t CC_DATA_ENTRY_LSB = 38;
+        constexpr std::uint8_t CC_NRPN_LSB = 98;
+        constexpr std::uint8_t CC_NRPN_MSB = 99;
+        constexpr std::uint8_t CC_ALL_SOUND_OFF = 120;
+        constexpr std::uint8_t CC_ALL_NOTES_OFF = 123;
         
         // Standard MIDI Values
         constexpr std::uint8_t VOLUME_FULL = 127;
@@ -15,5 +21,25 @@ namespace MidiPlay {
         constexpr std::uint8_t BANK_SELECT_OFF = 0;
         constexpr std::uint8_t DEFAULT_TEMPO_BPM = 120;
         constexpr int DEFAULT_TEMPO_USEC_PER_QUARTER = 500000; // 120 BPM
+        
+        // Meta event bytes as stored in cxxmidi messages: status, type, data...
+        constexpr std::uint8_t META_STATUS = 0xFF;
+        constexpr std::uint8_t META_LYRICS = 0x05;
+        constexpr std::uint8_t META_MARKER = 0x06;
+        constexpr std::uint8_t META_KEY_SIGNATURE = 0x59;
+        
+        // Status byte values
+        constexpr std::uint8_t STATUS_TYPE_MASK = 0xF0;    // Message type without the channel
+        constexpr std::uint8_t CHANNEL_MASK = 0x0F;
+        constexpr std::uint8_t NOTE_OFF = 0x80;
+        constexpr std::uint8_t NOTE_ON = 0x90;
+        constexpr std::uint8_t POLY_AFTERTOUCH = 0xA0;
+        constexpr std::uint8_t CONTROL_CHANGE = 0xB0;
+        constexpr std::uint8_t PROGRAM_CHANGE = 0xC0;
+        constexpr std::uint8_t SYSEX_BEGIN = 0xF0;
+        constexpr std::uint8_t SYSEX_END = 0xF7;
+        
+        constexpr std::uint8_t NOTE_MAX = 127;
+        constexpr std::uint8_t PERCUSSION_CHANNEL = 9;     // Channel 10; its notes are instruments, not pitches
     }
 }
\ No newline at end of file
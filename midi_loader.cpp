@@ -3,9 +3,13 @@
 #include "i18n.hpp"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 #include "midi_constants.hpp"
 #include "event_preprocessor.hpp"
+#include "streaming_loader.hpp"
+#include "registration_scheduler.hpp"
+#include "smf_reader.hpp"
 
 using cxxmidi::Event;
 using cxxmidi::Message;
@@ -20,22 +24,29 @@ MidiLoader::MidiLoader() {
 
 // Destructor - defined here for pimpl pattern
 MidiLoader::~MidiLoader() {
+    streamingLoader_.reset();   // Joins the producer
     // Clear callback to prevent any potential dangling reference issues
     midiFile_.SetCallbackLoad(nullptr);
 }
 
 // Reset all state variables to initial values
 void MidiLoader::resetState() {
+    streamingLoader_.reset();   // A previous streaming load may still be filling in the previous file
+    midiFile_.clear();
+    events_.clear();
     eventProcessor_->reset();
     
     // Clear the load callback to prevent dangling references
     midiFile_.SetCallbackLoad(nullptr);
     
     uSecPerTick_ = 0;
+    tempoMap_ = TempoMap();
     speed_ = 0.0f;
+    totalTicks_ = 0;
     
     playIntro_ = false;
     isVerbose_ = false;
+    loadedFromCache_ = false;
 }
 
 // Static utility method for file existence checking (extracted from play.cpp lines 91-94)
@@ -74,19 +85,30 @@ bool MidiLoader::loadFile(const std::string& path, const Options& options) {
         return false;
     }
     
-    // Initialize load callback only after confirming file exists
-    initializeLoadCallback(options);
+    // The cache holds the events as the file has them; transposed or remapped ones are not kept
+    bool useCache = options.isCacheEnabled() && !options.isRewritingEvents();
     
     try {
-        // Load the MIDI file (extracted from play.cpp line 381)
-        midiFile_.Load(path.c_str());
-        
-        // Clear the callback immediately after loading to prevent dangling references
-        midiFile_.SetCallbackLoad(nullptr);
+        // A warm start restores events and metadata without parsing the file
+        if (useCache && loadFromCache(path, options)) {
+            loadedFromCache_ = true;
+        } else if (options.isStreamingLoad()) {
+            streamFile(path, options);  // Stores the cache itself once complete
+        } else {
+            parseFile(path, options);
+            scheduleRegistration();
+            
+            if (useCache && !cache_.store(path, midiFile_, eventProcessor_->getMetadata())) {
+                if (isVerbose_) {
+                    std::cout << _("Unable to write hymn cache in ") << cache_.getDirectory() << std::endl;
+                }
+            }
+        }
         
         // Calculate timing values (extracted from play.cpp lines 383-390)
         uint16_t ppq = midiFile_.TimeDivision();
         uSecPerTick_ = eventProcessor_->getUSecPerQuarter() / ppq;
+        tempoMap_ = TempoMap(ppq, eventProcessor_->getTempoChanges());
         
         if (eventProcessor_->getPauseTicks().isNull()) {
             // Set default pause in EventPreProcessor
@@ -99,9 +121,16 @@ bool MidiLoader::loadFile(const std::string& path, const Options& options) {
         // Finalize loading process (extracted from play.cpp lines 415-423)
         finalizeLoading();
         
+        if (streamingLoader_) {
+            // Metadata is complete; the producer takes it from here
+            streamingLoader_->start(useCache ? cache_ : HymnCache(""),
+                                    eventProcessor_->getMetadata());
+        }
+        
         return true;
     }
     catch (const std::exception& e) {
+        streamingLoader_.reset();
         std::cerr << _("Error loading MIDI file: ") << e.what() << std::endl;
         // Clear callback before returning to prevent dangling reference
         midiFile_.SetCallbackLoad(nullptr);
@@ -109,6 +138,106 @@ bool MidiLoader::loadFile(const std::string& path, const Options& options) {
     }
 }
 
+// Restore events and metadata from the published library, else from the hymn cache
+bool MidiLoader::loadFromCache(const std::string& path, const Options& options) {
+    PreprocessedMetadata metadata;
+    bool inLibrary = library_.attach(HymnLibrary::pathIn(cache_.getDirectory(), options.isStaging()))
+                     && library_.load(path, midiFile_, metadata);
+    if (!inLibrary && !cache_.load(path, midiFile_, metadata)) {
+        return false;
+    }
+    
+    eventProcessor_->restoreMetadata(metadata, options);
+    return true;
+}
+
+// Decode the MIDI file from its raw bytes, handing the EventPreProcessor only what it may keep
+void MidiLoader::parseFile(const std::string& path, const Options& options) {
+    SmfReader reader;
+    if (!reader.open(path)) {
+        loadWithCallback(path, options);   // cxxmidi reads what SmfReader does not, or reports why not
+        return;
+    }
+    
+    cxxmidi::File file;
+    file.SetTimeDivision(reader.getTimeDivision());
+    
+    Event event;    // Storage reused for every event
+    for (size_t t = 0; t < reader.getTrackCount(); t++) {
+        SmfReader::Track cursor = reader.track(t);
+        cxxmidi::Track& track = file.AddTrack();
+        
+        // Events the preprocessor discards pass their delta time on, as with the load callback
+        uint32_t carriedDt = 0;
+        while (cursor.nextLoadable(event)) {
+            if (!eventProcessor_->processEvent(event, options)) {
+                carriedDt += event.Dt();
+                continue;
+            }
+            event.SetDt(event.Dt() + carriedDt);
+            carriedDt = 0;
+            track.push_back(event);
+        }
+    }
+    
+    midiFile_ = std::move(file);
+}
+
+// Send stop changes in the rest before the notes they are for, not with them
+void MidiLoader::scheduleRegistration() {
+    RegistrationScheduler::Result result =
+        RegistrationScheduler::schedule(midiFile_, eventProcessor_->getDirectives());
+    
+    if (isVerbose_ && (result.moved > 0 || result.dropped > 0)) {
+        std::cout << _("Registration changes moved ahead of the notes: ") << result.moved
+                  << _(", repeated ones left out: ") << result.dropped << std::endl;
+    }
+}
+
+// Parse the MIDI file with cxxmidi through the EventPreProcessor load callback
+void MidiLoader::loadWithCallback(const std::string& path, const Options& options) {
+    // Initialize load callback only after confirming file exists
+    initializeLoadCallback(options);
+    
+    // Load the MIDI file (extracted from play.cpp line 381)
+    midiFile_.Load(path.c_str());
+    
+    // Clear the callback immediately after loading to prevent dangling references
+    midiFile_.SetCallbackLoad(nullptr);
+}
+
+// Scan the file and publish its first measures; StreamingLoader reads the rest when started
+void MidiLoader::streamFile(const std::string& path, const Options& options) {
+    streamingLoader_ = std::make_unique<StreamingLoader>(path, options, *eventProcessor_);
+    midiFile_.SetTimeDivision(streamingLoader_->getTimeDivision());
+}
+
+const PlaybackTimeline* MidiLoader::getStreamingTimeline() const {
+    return streamingLoader_ ? &streamingLoader_->getTimeline() : nullptr;
+}
+
+const SeekIndex* MidiLoader::getStreamingSeekIndex() const {
+    return streamingLoader_ ? streamingLoader_->getSeekIndex() : nullptr;
+}
+
+void MidiLoader::finishStreaming() {
+    if (streamingLoader_ && midiFile_.empty()) {
+        midiFile_ = streamingLoader_->takeFile();
+        events_.assign(midiFile_);
+    }
+}
+
+size_t MidiLoader::getEventCount() const {
+    if (streamingLoader_ && midiFile_.empty()) {
+        return streamingLoader_->getEventCount();
+    }
+    size_t count = 0;
+    for (const cxxmidi::Track& track : midiFile_) {
+        count += track.size();
+    }
+    return count;
+}
+
 // Initialize the load callback (extracted and refactored from play.cpp lines 157-366)
 void MidiLoader::initializeLoadCallback(const Options& options) {
     midiFile_.SetCallbackLoad(
@@ -131,6 +260,50 @@ void MidiLoader::finalizeLoading() {
     if (eventProcessor_->getIntroSegments().size() == 0) { 
         playIntro_ = false;      // Override command line option if no markers
     }
+    
+    if (streamingLoader_) {
+        totalTicks_ = streamingLoader_->getTotalTicks();   // The tracks are still being filled
+        return;
+    }
+    
+    events_.assign(midiFile_);
+    
+    // Track length in ticks is the sum of its delta times
+    totalTicks_ = 0;
+    for (const cxxmidi::Track& track : midiFile_) {
+        uint32_t trackTicks = 0;
+        for (const Event& event : track) {
+            trackTicks += event.Dt();
+        }
+        totalTicks_ = std::max(totalTicks_, trackTicks);
+    }
+}
+
+// Pauses are rests at the opening tempo, whatever tempo the music ends in
+uint64_t MidiLoader::getPauseMicroseconds() const {
+    uint32_t pause = static_cast<uint32_t>(getPauseTicks().getTicks().value_or(0));
+    return static_cast<uint64_t>(pause) * tempoMap_.uSecPerQuarterAt(0) / tempoMap_.getPpq();
+}
+
+// Projected playing time, mirroring the sequence PlaybackOrchestrator plays
+double MidiLoader::getProjectedDurationSeconds() const {
+    uint64_t microseconds = 0;
+    uint64_t pause = getPauseMicroseconds();
+    
+    if (playIntro_) {
+        for (const IntroductionSegment& segment : getIntroSegments()) {
+            microseconds += tempoMap_.durationUs(segment.start, segment.end);
+        }
+        microseconds += pause;
+    }
+    
+    int verses = getVerses();
+    if (verses > 0) {
+        microseconds += static_cast<uint64_t>(verses) * tempoMap_.timeAt(totalTicks_);
+        microseconds += static_cast<uint64_t>(verses - 1) * pause;
+    }
+    
+    return static_cast<double>(microseconds) / MidiPlay::MICROSECONDS_PER_SECOND;
 }
 
 // Forwarding getter implementations
@@ -150,6 +323,10 @@ const std::vector<IntroductionSegment>& MidiLoader::getIntroSegments() const {
     return eventProcessor_->getIntroSegments();
 }
 
+const std::vector<Directive>& MidiLoader::getDirectives() const {
+    return eventProcessor_->getDirectives();
+}
+
 int MidiLoader::getVerses() const {
     return eventProcessor_->getVerses();
 }
@@ -12,7 +12,11 @@
 #include "ticks.hpp"
 #include "custommessage.hpp"
 #include "constants.hpp"
+#include "event_arena.hpp"
 #include "event_preprocessor.hpp"
+#include "hymn_cache.hpp"
+#include "hymn_library.hpp"
+#include "playback_timeline.hpp"
 
 // Forward declaration
 class Options;
@@ -31,7 +35,12 @@ namespace MidiPlay {
  * - Custom event handling (verses, introduction segments)
  * - File path resolution and existence checking
  * - Post-load data extraction and validation
+ * - Warm starts from the preprocessed hymn cache (see HymnCache)
+ * - Streaming loads that play while the file is still being read (see StreamingLoader)
  */
+class StreamingLoader;
+class SeekIndex;
+
 class MidiLoader {
 public:
     /**
@@ -50,6 +59,11 @@ public:
     
     /**
      * Main loading interface - loads and parses MIDI file
+     * 
+     * With --stream and no cached copy, returns once the metadata and the
+     * first measures are ready; getStreamingTimeline() then holds the
+     * timeline the rest is being filled into.
+     * 
      * @param path Full path to MIDI file
      * @param options Command line options affecting loading behavior
      * @return true if loading successful, false otherwise
@@ -57,29 +71,89 @@ public:
     bool loadFile(const std::string& path, const Options& options);
     
     // Getters for extracted MIDI file data
+    // After a streaming load the tracks are empty until finishStreaming()
     cxxmidi::File& getFile() { return midiFile_; }
     const cxxmidi::File& getFile() const { return midiFile_; }
     
+    /**
+     * The loaded events again, packed into one arena; what timelines are built from
+     * Empty while a streaming load is still filling the file
+     */
+    const EventArena& getEvents() const { return events_; }
+    
+    /**
+     * Timeline of a streaming load, growing while the rest of the file is read
+     * @return nullptr unless the last load was streamed
+     */
+    const PlaybackTimeline* getStreamingTimeline() const;
+    
+    /**
+     * Controller index of a streaming load, built once the whole file is read
+     * @return nullptr until then, or unless the last load was streamed
+     */
+    const SeekIndex* getStreamingSeekIndex() const;
+    
+    /**
+     * Wait for a streaming load to finish and move its events into getFile()
+     */
+    void finishStreaming();
+    
+    /**
+     * Number of events loaded, also while a streaming load is still filling the file
+     */
+    size_t getEventCount() const;
+    
     // Forwarding getters to EventPreProcessor
     const std::string& getTitle() const;
     const std::string& getKeySignature() const;
     const MidiPlay::TimeSignature& getTimeSignature() const;
     const std::vector<MidiPlay::IntroductionSegment>& getIntroSegments() const;
+    const std::vector<MidiPlay::Directive>& getDirectives() const;
     
     // Calculated values from MIDI processing
     int getVerses() const;
     int getUSecPerQuarter() const;
-    int getUSecPerTick() const { return uSecPerTick_; }
+    int getUSecPerTick() const { return uSecPerTick_; }   // Truncated; use getTempoMap() for timing
     int getFileTempo() const;
     int getBpm() const;
     MidiTicks getPauseTicks() const;
     float getSpeed() const { return speed_; }
+    uint32_t getTotalTicks() const { return totalTicks_; }
+    
+    /**
+     * Every tempo of the file with its start time, built at load time
+     */
+    const TempoMap& getTempoMap() const { return tempoMap_; }
+    
+    /**
+     * Pause between sections at the tempo the hymn starts in, without
+     * per-tick truncation
+     * @return Pause in microseconds, 0 if the file has none
+     */
+    uint64_t getPauseMicroseconds() const;
+    
+    /**
+     * Projected playing time for the loaded options: introduction (if it
+     * will be played), every verse and the pauses in between, timed with
+     * the tempo map.
+     * Ritardandos and the speed set with -t are not modelled.
+     * @return Duration in seconds
+     */
+    double getProjectedDurationSeconds() const;
     
     // State flags
     bool shouldPlayIntro() const { return playIntro_; }
     bool hasPotentialStuckNote() const;
     bool isFirstTempo() const;
     bool isVerbose() const { return isVerbose_; }
+    bool isLoadedFromCache() const { return loadedFromCache_; }
+    bool isStreaming() const { return streamingLoader_ != nullptr; }
+    
+    /**
+     * Override the hymn cache location (default: HymnCache::defaultDirectory())
+     * @param directory Cache directory; empty disables caching
+     */
+    void setCacheDirectory(const std::string& directory) { cache_ = HymnCache(directory); }
     
     /**
      * Static utility method for file existence checking
@@ -91,6 +165,11 @@ public:
 private:
     // Internal loading methods
     void initializeLoadCallback(const Options& options);
+    bool loadFromCache(const std::string& path, const Options& options);
+    void parseFile(const std::string& path, const Options& options);
+    void loadWithCallback(const std::string& path, const Options& options);
+    void scheduleRegistration();
+    void streamFile(const std::string& path, const Options& options);
     void scanTrackZeroMetaEvents();
     void finalizeLoading();
     void resetState();
@@ -100,15 +179,24 @@ private:
     
     // Member variables
     cxxmidi::File midiFile_;
+    EventArena events_;
     std::unique_ptr<EventPreProcessor> eventProcessor_;
+    HymnCache cache_;
+    HymnLibrary library_;               // Mapped while the loader lives; shared with other processes
     
     // Calculated timing values
     int uSecPerTick_;
+    TempoMap tempoMap_;
     float speed_;
+    uint32_t totalTicks_;   // Length of the longest track
     
     // State flags
     bool playIntro_;
     bool isVerbose_; // For debug output
+    bool loadedFromCache_;
+    
+    // Streaming load in progress or finished (last member: its producer is joined first)
+    std::unique_ptr<StreamingLoader> streamingLoader_;
 };
 
 } // namespace MidiPlay
\ No newline at end of file
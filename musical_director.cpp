@@ -1,20 +1,19 @@
 #include "musical_director.hpp"
-#include "i18n.hpp"
+#include "midi_constants.hpp"
 
-#include <iostream>
-
-using cxxmidi::Event;
-using cxxmidi::Message;
+#include <algorithm>
 
 namespace MidiPlay {
 
-MusicalDirector::MusicalDirector(cxxmidi::player::PlayerSync& player,
+MusicalDirector::MusicalDirector(PlaybackEngine& player,
                                  PlaybackStateMachine& stateMachine,
                                  const MidiLoader& midiLoader)
     : player_(player)
     , stateMachine_(stateMachine)
     , midiLoader_(midiLoader)
+    , log_(&ConsoleLog::immediate())
     , currentIntroSegment_()
+    , nextDirective_(0)
 {
 }
 
@@ -25,88 +24,120 @@ void MusicalDirector::initializeIntroSegments() {
     }
 }
 
-bool MusicalDirector::handleEvent(Event& event) {
-    Message message = event;
-    
+void MusicalDirector::seekDirectives(uint32_t tick) {
+    const std::vector<Directive>& directives = midiLoader_.getDirectives();
+    auto next = std::lower_bound(directives.begin(), directives.end(), tick,
+                                 [](const Directive& directive, uint32_t t) { return directive.tick < t; });
+    nextDirective_ = static_cast<size_t>(next - directives.begin());
+}
+
+bool MusicalDirector::handleEvent(const EventView& event) {
 #ifdef DEBUG
     if (midiLoader_.isVerbose()) {
-        dumpEvent(event);
+        log_->postEvent(event);
     }
 #endif
 
-    // Process introduction markers if playing intro
-    if (stateMachine_.isPlayingIntro() && midiLoader_.getIntroSegments().size() > 0 && message.IsMeta()) {
-        if (message.IsMeta(Message::MetaType::Marker) && message.GetText() == MidiMarkers::INTRO_END) {
-            processIntroMarker(message);
-        }
+    // Only marker meta events carry musical directions
+    if (event.size() < 2 || event[0] != Midi::META_STATUS || event[1] != Midi::META_MARKER) {
+        return true;  // Send event to output device
     }
     
-    // Process ritardando markers (intro or last verse)
-    if ((stateMachine_.isPlayingIntro() || stateMachine_.isLastVerse()) && message.IsMeta(Message::MetaType::Marker)
-        && message.GetText() == MidiMarkers::RITARDANDO_INDICATOR) {
-        processRitardandoMarker(message);
+    const std::vector<Directive>& directives = midiLoader_.getDirectives();
+    if (nextDirective_ >= directives.size()) {
+        return true;
     }
     
-    // Process D.C. al Fine marker (last verse only)
-    if (stateMachine_.isLastVerse()) {
-        if (message.IsMeta(Message::MetaType::Marker) && message.GetText() == MidiMarkers::D_C_AL_FINE) {
-            return processDCAlFineMarker(message);
-        }
-    }
+    const Directive& directive = directives[nextDirective_++];
     
-    // Process Fine marker (when in al Fine mode)
-    if (stateMachine_.isAlFine() && message.IsMeta(Message::MetaType::Marker)
-        && message.GetText() == MidiMarkers::FINE_INDICATOR) {
-        return processFineMarker(message);
+    switch (directive.kind) {
+    case DirectiveKind::IntroEnd:
+        // Process introduction markers if playing intro
+        if (stateMachine_.isPlayingIntro() && midiLoader_.getIntroSegments().size() > 0) {
+            processIntroMarker();
+        }
+        break;
+        
+    case DirectiveKind::Ritardando:
+        // Process ritardando markers (intro or last verse)
+        if (stateMachine_.startRitardando()) {
+            processRitardandoMarker(directive.tick);
+        }
+        break;
+        
+    case DirectiveKind::DaCapoAlFine:
+        // Process D.C. al Fine marker (last verse only)
+        if (stateMachine_.isLastVerse()) {
+            return processDCAlFineMarker();
+        }
+        break;
+        
+    case DirectiveKind::Fine:
+        // Process Fine marker (when in al Fine mode)
+        if (stateMachine_.isAlFine()) {
+            return processFineMarker();
+        }
+        break;
+        
+    case DirectiveKind::IntroBegin:
+    case DirectiveKind::Other:
+        break;
     }
     
     return true;  // Send event to output device
 }
 
-void MusicalDirector::processIntroMarker(const Message& message) {
+void MusicalDirector::processIntroMarker() {
     const std::vector<IntroductionSegment>& introSegments = midiLoader_.getIntroSegments();
     
     currentIntroSegment_++;
     
     if (currentIntroSegment_ < introSegments.end()) {
         uint32_t start = currentIntroSegment_->start;
-        player_.Stop();
-        player_.GoToTick(start);
-        player_.Play();
+        player_.stop();
+        player_.releaseHeldNotes();     // Notes whose NoteOff the jump skips
+        player_.goToTick(start);
+        seekDirectives(start);
+        player_.play();
     }
     
     if (currentIntroSegment_ >= introSegments.end()) {
         // Stop the introduction. In some hymns, this is not at the end
-        player_.Stop();
-        player_.Finish();
+        player_.stop();
+        player_.finish();
         
         if (midiLoader_.hasPotentialStuckNote()) {
-            player_.NotesOff();
+            player_.notesOff();
             
             if (stateMachine_.shouldDisplayWarnings()) {
-                std::cout << _("   Warning: Final intro marker not past last NoteOff event") << std::endl;
+                log_->post(ConsoleMessage::IntroMarkerWarning);
             }
         }
     }
 }
 
-void MusicalDirector::processRitardandoMarker(const Message& message) {
-    stateMachine_.setRitardando(true);
-    std::cout << _("  Ritardando") << std::endl;
+void MusicalDirector::processRitardandoMarker(uint32_t tick) {
+    log_->post(ConsoleMessage::Ritardando);
+    
+    // The curve starts at the marker itself, whenever the next heartbeat comes
+    if (ritardando_) {
+        ritardando_->start(std::chrono::microseconds(midiLoader_.getTempoMap().timeAt(tick)));
+    }
 }
 
-bool MusicalDirector::processDCAlFineMarker(const Message& message) {
-    std::cout << message.GetText() << std::endl;
+bool MusicalDirector::processDCAlFineMarker() {
+    log_->post(ConsoleMessage::DaCapoAlFine);
     stateMachine_.setAlFine(true);
-    player_.Stop();
-    player_.Finish();
+    player_.stop();
+    player_.finish();
+    player_.releaseHeldNotes();
     return false;  // Don't send event to output device
 }
 
-bool MusicalDirector::processFineMarker(const Message& message) {
-    player_.Stop();
-    player_.Finish();
+bool MusicalDirector::processFineMarker() {
+    player_.stop();
+    player_.finish();
     return false;  // Don't send event to output device
 }
 
-} // namespace MidiPlay
\ No newline at end of file
+} // namespace MidiPlay
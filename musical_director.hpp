@@ -1,13 +1,15 @@
 #pragma once
 
-#include <cxxmidi/player/player_sync.hpp>
-#include <cxxmidi/event.hpp>
 #include <cxxmidi/message.hpp>
 #include <vector>
 
+#include "console_log.hpp"
+#include "event_view.hpp"
 #include "midi_loader.hpp"
+#include "playback_engine.hpp"
 #include "playback_state_machine.hpp"
 #include "midi_markers.hpp"
+#include "ritardando_effector.hpp"
 
 namespace MidiPlay {
 
@@ -19,16 +21,20 @@ namespace MidiPlay {
  * - Ritardando markers for gradual slowdown
  * - D.C. al Fine (Da Capo al Fine) for repeat-to-fine
  * - Fine markers for early termination
+ * 
+ * Markers are resolved into MidiLoader's directive table at load time. During
+ * playback a marker event only advances a cursor through that table, so the
+ * player thread does no string work or allocation per event.
  */
 class MusicalDirector {
 public:
     /**
      * @brief Constructor with dependency injection
-     * @param player Reference to player for playback control
+     * @param player Reference to playback engine for transport control
      * @param stateMachine Reference to state machine for state updates
      * @param midiLoader Reference to MIDI loader for file metadata
      */
-    MusicalDirector(cxxmidi::player::PlayerSync& player,
+    MusicalDirector(PlaybackEngine& player,
                     PlaybackStateMachine& stateMachine,
                     const MidiLoader& midiLoader);
     
@@ -43,7 +49,7 @@ public:
      * @param event MIDI event being processed
      * @return true to send event to output device, false to suppress
      */
-    bool handleEvent(cxxmidi::Event& event);
+    bool handleEvent(const EventView& event);
     
     /**
      * @brief Initialize intro segment iterator
@@ -53,41 +59,61 @@ public:
      */
     void initializeIntroSegments();
     
+    /**
+     * @brief Reposition the directive cursor after the player has moved
+     * 
+     * Must be called whenever playback is repositioned outside this class
+     * (rewind, goToTick) so the next marker matches the next directive.
+     * @param tick Tick playback resumes from
+     */
+    void seekDirectives(uint32_t tick);
+    
+    /**
+     * @brief Print through a log whose drain thread writes for the player thread
+     * @param log Log that outlives playback; by default lines are written at once
+     */
+    void setConsoleLog(ConsoleLog& log) { log_ = &log; }
+    
+    /**
+     * @brief Start this effector's curve at each ritardando marker played
+     * @param effector Effector that outlives playback, or nullptr
+     */
+    void setRitardandoEffector(RitardandoEffector* effector) { ritardando_ = effector; }
+    
 private:
     // === Dependencies ===
-    cxxmidi::player::PlayerSync& player_;
+    PlaybackEngine& player_;
     PlaybackStateMachine& stateMachine_;
     const MidiLoader& midiLoader_;
+    ConsoleLog* log_;
+    RitardandoEffector* ritardando_ = nullptr;
     
     // === State ===
     std::vector<IntroductionSegment>::const_iterator currentIntroSegment_;
+    size_t nextDirective_;      // Index of the next pending entry in the directive table
     
     // === Event Processing Helpers ===
     /**
      * @brief Process introduction end marker (jumping logic)
-     * @param message MIDI meta message containing marker
      */
-    void processIntroMarker(const cxxmidi::Message& message);
+    void processIntroMarker();
     
     /**
-     * @brief Process ritardando marker
-     * @param message MIDI meta message containing marker
+     * @brief Process ritardando marker, once the state machine has started the ritardando
      */
-    void processRitardandoMarker(const cxxmidi::Message& message);
+    void processRitardandoMarker(uint32_t tick);
     
     /**
      * @brief Process D.C. al Fine marker
-     * @param message MIDI meta message containing marker
      * @return false to suppress event output
      */
-    bool processDCAlFineMarker(const cxxmidi::Message& message);
+    bool processDCAlFineMarker();
     
     /**
      * @brief Process Fine marker (when in al Fine mode)
-     * @param message MIDI meta message containing marker
      * @return false to suppress event output
      */
-    bool processFineMarker(const cxxmidi::Message& message);
+    bool processFineMarker();
     
     // Note: Musical direction markers now in midi_markers.hpp
 };
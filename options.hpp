@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <cstdlib>
 #include <regex>
 #include <string>
 #include <unistd.h>
@@ -16,6 +19,40 @@ constexpr float PRELUDE_MIN_SPEED = 0.5;
 constexpr float PRELUDE_MAX_SPEED = 2.0;
 constexpr float PRELUDE_SPEED_DIVISOR = 10.0;   // Divide command line prelude speed by this to get float.
 
+constexpr int REALTIME_DEFAULT_PRIORITY = 70;   // SCHED_FIFO priority for --realtime without a value
+constexpr int REALTIME_LAST_CPU = -1;           // --cpu default: highest-numbered online core
+
+constexpr int TRANSPOSE_MAX_SEMITONES = 12;     // --transpose range, either way
+constexpr int CHANNEL_COUNT = 16;               // --remap channels are 1 to this
+
+// Identifiers for long options that have no short form.
+// Values start above the range of option characters returned by getopt_long.
+namespace LongOption {
+    constexpr int NO_CACHE = 256;
+    constexpr int LIST = 257;
+    constexpr int TIMELINE = 258;
+    constexpr int REALTIME = 259;
+    constexpr int CPU = 260;
+    constexpr int JITTER = 261;
+    constexpr int BATCH_OUTPUT = 262;
+    constexpr int DAEMON = 263;
+    constexpr int NO_DAEMON = 264;
+    constexpr int SETLIST = 265;
+    constexpr int STREAM = 266;
+    constexpr int PROFILE_STARTUP = 267;
+    constexpr int DRY_RUN = 268;
+    constexpr int LINT = 269;
+    constexpr int LINT_JSON = 270;
+    constexpr int MEM_REPORT = 271;
+    constexpr int PRECISE_TIMING = 272;
+    constexpr int TICKLESS = 273;
+    constexpr int TELEMETRY = 274;
+    constexpr int RECONNECT = 275;
+    constexpr int TRANSPOSE = 276;
+    constexpr int REMAP = 277;
+    constexpr int PUBLISH_LIBRARY = 278;
+}
+
 // Define the "long" command line options
 static struct option long_options[] = {
     {"help", no_argument, NULL, 'h'},
@@ -29,6 +66,29 @@ static struct option long_options[] = {
     {"title", required_argument, NULL, 'T'},
     {"verbose", no_argument, NULL, 'V'},    // Verbose output
     {"warnings", no_argument, NULL, 'W'},   // Display warnings
+    {"no-cache", no_argument, NULL, LongOption::NO_CACHE},  // Bypass the preprocessed hymn cache
+    {"list", optional_argument, NULL, LongOption::LIST},    // --list[=<search>]  List hymns from the index
+    {"timeline", no_argument, NULL, LongOption::TIMELINE},  // Play from the merged, pre-timed event timeline
+    {"realtime", optional_argument, NULL, LongOption::REALTIME},    // --realtime[=<priority>]  SCHED_FIFO, CPU pinning, locked memory
+    {"cpu", required_argument, NULL, LongOption::CPU},      // --cpu=<core>  Core for --realtime
+    {"jitter", optional_argument, NULL, LongOption::JITTER},    // --jitter[=<csv file>]  Report send lateness
+    {"batch-output", no_argument, NULL, LongOption::BATCH_OUTPUT},  // With --timeline, one port write per chord
+    {"daemon", no_argument, NULL, LongOption::DAEMON},      // Keep the port open and serve play clients over a Unix socket
+    {"no-daemon", no_argument, NULL, LongOption::NO_DAEMON},    // Play in this process even if a daemon is running
+    {"setlist", required_argument, NULL, LongOption::SETLIST},  // --setlist=<file>  Play a service's hymns in order
+    {"stream", no_argument, NULL, LongOption::STREAM},      // Start playing while the file is still being read (implies --timeline)
+    {"profile-startup", optional_argument, NULL, LongOption::PROFILE_STARTUP},  // --profile-startup[=<json file>]  Time the startup phases
+    {"dry-run", no_argument, NULL, LongOption::DRY_RUN},    // Play on a virtual clock without a device and report the timings
+    {"lint", optional_argument, NULL, LongOption::LINT},    // --lint[=<directory>]  Check every hymn under a directory
+    {"lint-json", required_argument, NULL, LongOption::LINT_JSON},  // --lint-json=<file>  Also write the --lint report as JSON
+    {"mem-report", no_argument, NULL, LongOption::MEM_REPORT},  // Show the memory the loaded hymn takes in each event format
+    {"precise-timing", no_argument, NULL, LongOption::PRECISE_TIMING},  // Absolute clock_nanosleep and a spin to each event (implies --timeline)
+    {"tickless", no_argument, NULL, LongOption::TICKLESS},  // Sleep from event to event; heartbeats only for ritardando and keys (implies --timeline)
+    {"telemetry", required_argument, NULL, LongOption::TELEMETRY},  // --telemetry=<file>  Append a session record as JSON, or write a Prometheus textfile (.prom)
+    {"reconnect", no_argument, NULL, LongOption::RECONNECT},    // Wait for a device that goes away mid-hymn and resume at the bar (implies --timeline)
+    {"transpose", required_argument, NULL, LongOption::TRANSPOSE},  // --transpose=<semitones>  Shift every note when the file is loaded
+    {"remap", required_argument, NULL, LongOption::REMAP},  // --remap=<from>:<to>[,...]  Move notes to other channels when the file is loaded
+    {"publish-library", no_argument, NULL, LongOption::PUBLISH_LIBRARY},  // Publish every hymn as one read-only library for all processes
     {NULL, 0, NULL, 0}};
 
 
@@ -48,6 +108,34 @@ private:
     bool play_intro_ = true;
     bool verbose_ = false;
     bool display_warnings_ = false;
+    bool cache_enabled_ = true;
+    bool list_mode_ = false;
+    std::string list_query_;    // Search text for --list
+    bool timeline_engine_ = false;
+    bool batch_output_ = false;
+    bool streaming_load_ = false;
+    bool daemon_mode_ = false;
+    bool use_daemon_ = true;
+    std::string setlist_path_;  // Setlist file for --setlist
+    bool realtime_ = false;
+    int realtime_priority_ = REALTIME_DEFAULT_PRIORITY;
+    int realtime_cpu_ = REALTIME_LAST_CPU;
+    bool jitter_report_ = false;
+    std::string jitter_csv_path_;   // Optional dump for --jitter
+    bool profile_startup_ = false;
+    std::string profile_json_path_; // Optional dump for --profile-startup
+    bool dry_run_ = false;
+    bool lint_mode_ = false;
+    bool publish_library_ = false;
+    std::string lint_directory_;    // Directory for --lint; empty for the hymn directory
+    std::string lint_json_path_;    // Optional dump for --lint
+    bool mem_report_ = false;
+    bool precise_timing_ = false;
+    bool tickless_ = false;
+    std::string telemetry_path_;    // Empty: no telemetry
+    bool reconnect_ = false;
+    int transpose_ = 0;     // Semitones
+    std::array<uint8_t, CHANNEL_COUNT> channel_map_ = identityChannelMap();    // 0-based; channel_map_[from] = to
     std::string filename_;  // Provided as a command line argument
     std::string url_name_;    // Second command line argument
     std::string title_;      // Hymn title
@@ -65,11 +153,34 @@ private:
         std::cout << _("Usage:\n") << std::endl;
         std::cout << "play <filename> options\n" << std::endl;
         std::cout << "  --goto=<marker | measure>  -g<marker | measure>   " << _("If argument is numeric, start at the measure number; if has alpha, start at marker. (not yet implemented)") << std::endl;
+        std::cout << "  --batch-output  " << _("With --timeline, write all events due at the same moment to the port in one call, using running status.  Only for ports that accept a MIDI byte stream.") << std::endl;
+        std::cout << "  --daemon  " << _("Stay running with the MIDI port open and the organ set up, and play the hymns requested by later play commands.") << std::endl;
+        std::cout << "  --cpu=<core>  " << _("With --realtime, run playback on this CPU core.  Default is the last core.") << std::endl;
+        std::cout << "  --dry-run  " << _("Play the hymn without an organ, as fast as possible, and show how long each section and the whole hymn will take.") << std::endl;
         std::cout << "  --help -h -? " << _("This text.") << std::endl;
+        std::cout << "  --jitter[=<file>]  " << _("After playing, report how late events were sent.  With <file>, also write every event's timing there as CSV.") << std::endl;
+        std::cout << "  --lint[=<directory>]  " << _("Check every hymn under <directory>, default the hymn directory, for problems such as deprecated meta events, missing tempo or unbalanced introduction markers.") << std::endl;
+        std::cout << "  --lint-json=<file>  " << _("With --lint, also write the report to <file> as JSON.  Implies --lint.") << std::endl;
+        std::cout << "  --list[=<search>]  " << _("List the hymns in the hymn directory, optionally only those whose title or file name contains <search>.") << std::endl;
+        std::cout << "  --mem-report  " << _("After loading, show how many bytes the hymn's events take as loaded for playback and in the packed formats.") << std::endl;
+        std::cout << "  --no-cache  " << _("Parse the MIDI file and device configuration even if a cached copy exists.") << std::endl;
+        std::cout << "  --no-daemon  " << _("Play in this process even if a daemon is running.") << std::endl;
         std::cout << "  -n<verses> " << _("Play the introduction followed by the specified number of verses.") << std::endl;
+        std::cout << "  --precise-timing  " << _("Wait for each event with an absolute sleep and a short spin, for the most exact timing at the cost of some CPU.  Implies --timeline.") << std::endl;
         std::cout << "  --prelude=<speed> -p<speed> " << _("Prelude/postlude.  <speed> is optional, default is 9, which is 90%.  10 is 100%.  Plays 2 verses by default; can be modified by -x<verses>") << std::endl;
+        std::cout << "  --profile-startup[=<file>]  " << _("Before playing, show how long each step of starting up took.  With <file>, also write the times there as JSON.") << std::endl;
+        std::cout << "  --publish-library  " << _("Load every hymn in the hymn directory and publish them as one read-only library that the player and other programs read directly, without loading the files.") << std::endl;
+        std::cout << "  --realtime[=<priority>]  " << _("Play under real-time scheduling with locked memory.  <priority> is optional, default is 70.") << std::endl;
+        std::cout << "  --reconnect  " << _("If the device goes away while playing, as a USB-MIDI adapter may for a moment, wait for it to come back, set it up again and resume at the start of the measure.  Implies --timeline.") << std::endl;
+        std::cout << "  --remap=<from>:<to>[,<from>:<to>...]  " << _("Play the notes of channel <from> on channel <to>, for example --remap=1:2 to move the melody from the Swell to the Great.  Pairs apply together, so --remap=1:2,2:1 swaps two manuals.") << std::endl;
+        std::cout << "  --setlist=<file>  " << _("Play the hymns listed in <file> in order, one per line with its own options.  The next hymn is loaded while the current one plays.") << std::endl;
         std::cout << "  --staging   " << _("Play the file from the staging directory, if present.") << std::endl;
+        std::cout << "  --stream  " << _("Start playing as soon as the first measures are read, and read the rest of the file while playing.  Implies --timeline.  Stop changes are sent as written until the hymn is played from the cache.") << std::endl;
+        std::cout << "  --telemetry=<file>  " << _("After each hymn, add a line to <file> with the load, startup and device connect times, the number of events and how many were late, and the actual and expected duration, as JSON.  If <file> ends in .prom, write it as a Prometheus textfile instead.") << std::endl;
         std::cout << "  --tempo=<bpm> -t<bpm>  " << _("Force tempo to the specified number of beats per minute.") << std::endl;
+        std::cout << "  --tickless  " << _("Let the player sleep from one event to the next, waking in between only during a ritardando or for a key.  Less CPU and heat on a fanless Pi.  Implies --timeline.") << std::endl;
+        std::cout << "  --timeline  " << _("Play from a merged, pre-timed event timeline instead of the track-by-track player.") << std::endl;
+        std::cout << "  --transpose=<semitones>  " << _("Play every note <semitones> higher, or lower if negative, from -12 to 12.  The key shown is changed to match.") << std::endl;
         std::cout << "  --version -v  " << _("Version of this command") << std::endl;
         std::cout << "  -x<verses> " << _("Number of verses to play without introduction.\n") << std::endl;
     }
@@ -108,6 +219,75 @@ private:
         }
     }
     
+    int handleRealtimeOption(const char* optarg) {
+        realtime_ = true;
+        if (optarg) {
+            if (!isNumeric(optarg)) {
+                std::cerr << _("Real-time priority must be numeric.") << std::endl;
+                return MidiPlay::OptionsParseResult::INVALID_OPTION;
+            }
+            realtime_priority_ = std::stoi(optarg);
+        }
+        return MidiPlay::OptionsParseResult::SUCCESS;
+    }
+    
+    int handleCpuOption(const char* optarg) {
+        if (!isNumeric(optarg)) {
+            std::cerr << _("CPU core must be numeric.") << std::endl;
+            return MidiPlay::OptionsParseResult::INVALID_OPTION;
+        }
+        realtime_cpu_ = std::stoi(optarg);
+        return MidiPlay::OptionsParseResult::SUCCESS;
+    }
+    
+    int handleTransposeOption(const char* optarg) {
+        char* end = nullptr;
+        long semitones = std::strtol(optarg, &end, 10);
+        if (end == optarg || *end != '\0'
+            || semitones < -TRANSPOSE_MAX_SEMITONES || semitones > TRANSPOSE_MAX_SEMITONES) {
+            std::cerr << _("Transposition must be a number of semitones from -12 to 12.") << std::endl;
+            return MidiPlay::OptionsParseResult::INVALID_OPTION;
+        }
+        transpose_ = static_cast<int>(semitones);
+        return MidiPlay::OptionsParseResult::SUCCESS;
+    }
+    
+    // remap=<from>:<to>[,<from>:<to>...], channels numbered from 1
+    int handleRemapOption(const char* optarg) {
+        std::array<uint8_t, CHANNEL_COUNT> map = identityChannelMap();
+        const char* p = optarg;
+        while (true) {
+            char* end = nullptr;
+            long from = std::strtol(p, &end, 10);
+            bool valid = end != p && *end == ':';
+            long to = 0;
+            if (valid) {
+                p = end + 1;
+                to = std::strtol(p, &end, 10);
+                valid = end != p && (*end == ',' || *end == '\0');
+            }
+            if (!valid || from < 1 || from > CHANNEL_COUNT || to < 1 || to > CHANNEL_COUNT) {
+                std::cerr << _("Channel remapping must be pairs <from>:<to> of channels 1 to 16, separated by commas.") << std::endl;
+                return MidiPlay::OptionsParseResult::INVALID_OPTION;
+            }
+            map[from - 1] = static_cast<uint8_t>(to - 1);
+            if (*end == '\0') {
+                break;
+            }
+            p = end + 1;
+        }
+        channel_map_ = map;
+        return MidiPlay::OptionsParseResult::SUCCESS;
+    }
+    
+    static constexpr std::array<uint8_t, CHANNEL_COUNT> identityChannelMap() {
+        std::array<uint8_t, CHANNEL_COUNT> map{};
+        for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+            map[channel] = static_cast<uint8_t>(channel);
+        }
+        return map;
+    }
+    
     void handleVersesOption(const char* optarg, bool playIntro) {
         if (isNumeric(optarg)) {
             verses_ = std::stoi(std::string(optarg));
@@ -170,6 +350,136 @@ public:
         return display_warnings_;
     }
 
+    bool isCacheEnabled() const {
+        return cache_enabled_;
+    }
+
+    int getTranspose() const {
+        return transpose_;
+    }
+
+    // New channel, 0-based, for the notes of each channel
+    const std::array<uint8_t, CHANNEL_COUNT>& getChannelMap() const {
+        return channel_map_;
+    }
+
+    bool isRemapping() const {
+        return channel_map_ != identityChannelMap();
+    }
+
+    // The loaded events differ from the file's, so the hymn cache is not used
+    bool isRewritingEvents() const {
+        return transpose_ != 0 || isRemapping();
+    }
+
+    bool isListMode() const {
+        return list_mode_;
+    }
+
+    std::string getListQuery() const {
+        return list_query_;
+    }
+
+    bool isTimelineEngine() const {
+        return timeline_engine_;
+    }
+
+    bool isBatchOutput() const {
+        return batch_output_;
+    }
+
+    bool isStreamingLoad() const {
+        return streaming_load_;
+    }
+
+    bool isDaemonMode() const {
+        return daemon_mode_;
+    }
+
+    bool isDaemonAllowed() const {
+        return use_daemon_;
+    }
+
+    bool isSetlistMode() const {
+        return !setlist_path_.empty();
+    }
+
+    std::string getSetlistPath() const {
+        return setlist_path_;
+    }
+
+    bool isRealtime() const {
+        return realtime_;
+    }
+
+    int getRealtimePriority() const {
+        return realtime_priority_;
+    }
+
+    int getRealtimeCpu() const {
+        return realtime_cpu_;
+    }
+
+    bool isJitterReport() const {
+        return jitter_report_;
+    }
+
+    std::string getJitterCsvPath() const {
+        return jitter_csv_path_;
+    }
+
+    bool isProfileStartup() const {
+        return profile_startup_;
+    }
+
+    std::string getProfileJsonPath() const {
+        return profile_json_path_;
+    }
+
+    bool isDryRun() const {
+        return dry_run_;
+    }
+
+    bool isLintMode() const {
+        return lint_mode_;
+    }
+
+    bool isPublishLibrary() const {
+        return publish_library_;
+    }
+
+    std::string getLintDirectory() const {
+        return lint_directory_;
+    }
+
+    std::string getLintJsonPath() const {
+        return lint_json_path_;
+    }
+
+    bool isMemReport() const {
+        return mem_report_;
+    }
+
+    bool isPreciseTiming() const {
+        return precise_timing_;
+    }
+
+    bool isTickless() const {
+        return tickless_;
+    }
+
+    bool isTelemetry() const {
+        return !telemetry_path_.empty();
+    }
+
+    std::string getTelemetryPath() const {
+        return telemetry_path_;
+    }
+
+    bool isReconnect() const {
+        return reconnect_;
+    }
+
     std::string getFileName() const {
         return filename_;
     }
@@ -264,6 +574,121 @@ public:
                 display_warnings_ = true;
                 break;
                 
+            case LongOption::NO_CACHE:
+                cache_enabled_ = false;
+                break;
+                
+            case LongOption::LIST:  // list[=<search>]
+                list_mode_ = true;
+                if (optarg) {
+                    list_query_ = optarg;
+                }
+                break;
+                
+            case LongOption::TIMELINE:
+                timeline_engine_ = true;
+                break;
+                
+            case LongOption::BATCH_OUTPUT:
+                batch_output_ = true;
+                break;
+                
+            case LongOption::STREAM:    // Only the timeline player can play a file still being read
+                streaming_load_ = true;
+                timeline_engine_ = true;
+                break;
+                
+            case LongOption::DAEMON:
+                daemon_mode_ = true;
+                break;
+                
+            case LongOption::NO_DAEMON:
+                use_daemon_ = false;
+                break;
+                
+            case LongOption::SETLIST:   // setlist=<file>
+                setlist_path_ = optarg;
+                break;
+                
+            case LongOption::REALTIME:  // realtime[=<priority>]
+            case LongOption::CPU:       // cpu=<core>
+                {
+                    int realtimeResult = opt == LongOption::REALTIME ? handleRealtimeOption(optarg)
+                                                                     : handleCpuOption(optarg);
+                    if (realtimeResult != MidiPlay::OptionsParseResult::SUCCESS) {
+                        return realtimeResult;
+                    }
+                }
+                break;
+                
+            case LongOption::JITTER:    // jitter[=<csv file>]
+                jitter_report_ = true;
+                if (optarg) {
+                    jitter_csv_path_ = optarg;
+                }
+                break;
+                
+            case LongOption::PROFILE_STARTUP:   // profile-startup[=<json file>]
+                profile_startup_ = true;
+                if (optarg) {
+                    profile_json_path_ = optarg;
+                }
+                break;
+                
+            case LongOption::DRY_RUN:
+                dry_run_ = true;
+                break;
+                
+            case LongOption::LINT:  // lint[=<directory>]
+                lint_mode_ = true;
+                if (optarg) {
+                    lint_directory_ = optarg;
+                }
+                break;
+                
+            case LongOption::LINT_JSON: // lint-json=<file>
+                lint_mode_ = true;
+                lint_json_path_ = optarg;
+                break;
+                
+            case LongOption::PUBLISH_LIBRARY:
+                publish_library_ = true;
+                break;
+                
+            case LongOption::MEM_REPORT:
+                mem_report_ = true;
+                break;
+                
+            case LongOption::PRECISE_TIMING:    // Only the timeline player sleeps to absolute deadlines
+                precise_timing_ = true;
+                timeline_engine_ = true;
+                break;
+                
+            case LongOption::TELEMETRY: // telemetry=<file>
+                telemetry_path_ = optarg;
+                break;
+                
+            case LongOption::RECONNECT: // Only the timeline player can pause itself and resume at a bar
+                reconnect_ = true;
+                timeline_engine_ = true;
+                break;
+                
+            case LongOption::TRANSPOSE: // transpose=<semitones>
+            case LongOption::REMAP:     // remap=<from>:<to>[,...]
+                {
+                    int rewriteResult = opt == LongOption::TRANSPOSE ? handleTransposeOption(optarg)
+                                                                     : handleRemapOption(optarg);
+                    if (rewriteResult != MidiPlay::OptionsParseResult::SUCCESS) {
+                        return rewriteResult;
+                    }
+                }
+                break;
+                
+            case LongOption::TICKLESS:  // PlayerSync's heartbeat is fixed
+                tickless_ = true;
+                timeline_engine_ = true;
+                break;
+                
             case 'h':   // Help
             case '?':
                 displayHelp();
@@ -283,6 +708,8 @@ public:
             std::cout << "Filename: " << argv_[optind] << std::endl;
 #endif
             optind++;
+        } else if (list_mode_ || daemon_mode_ || isSetlistMode() || lint_mode_ || publish_library_) {
+            return MidiPlay::OptionsParseResult::SUCCESS;   // Listing, the daemon, setlists, linting and publishing need no file name
         } else {
             std::cerr << _("No filename provided. You must pass a file name to play.") << std::endl;
             return MidiPlay::OptionsParseResult::MISSING_FILENAME;
@@ -0,0 +1,137 @@
+#include "output_fan_out.hpp"
+#include "realtime_scheduler.hpp"
+
+#include <cxxmidi/message.hpp>
+
+#include <exception>
+#include <functional>
+#include <optional>
+
+namespace MidiPlay {
+
+OutputFanOut::OutputFanOut(cxxmidi::output::Abstract& primary)
+    : primary_(&primary)
+{
+}
+
+OutputFanOut::~OutputFanOut() {
+    for (std::unique_ptr<Port>& port : ports_) {
+        port->stop.store(true, std::memory_order_release);
+        port->queued.fetch_add(1, std::memory_order_release);
+        port->queued.notify_one();
+    }
+    for (std::unique_ptr<Port>& port : ports_) {
+        if (port->writer.joinable()) {
+            port->writer.join();
+        }
+    }
+}
+
+void OutputFanOut::setPrimary(std::unique_ptr<cxxmidi::output::Abstract> port, bool byteStream) {
+    ownedPrimary_ = std::move(port);
+    primary_ = ownedPrimary_.get();
+    byteStream_ = byteStream;
+}
+
+void OutputFanOut::addPort(std::unique_ptr<cxxmidi::output::Abstract> output, const std::string& name) {
+    auto port = std::make_unique<Port>();
+    port->output = std::move(output);
+    port->name = name;
+    port->writer = std::thread(drain, std::ref(*port));
+    ports_.push_back(std::move(port));
+}
+
+void OutputFanOut::SendMessage(const cxxmidi::Message* msg) {
+    // The organ first, on this thread, exactly as without fan-out
+    primary_->SendMessage(msg);
+
+    if (ports_.empty() || msg->size() > Slot::MAX_BYTES) {
+        return;
+    }
+
+    Slot slot;
+    slot.size = static_cast<uint8_t>(msg->size());
+    for (size_t i = 0; i < slot.size; i++) {
+        slot.bytes[i] = (*msg)[i];
+    }
+
+    // A copy per ring, and a wake-up only for a writer that has gone to sleep; never a wait
+    for (std::unique_ptr<Port>& port : ports_) {
+        if (port->failed.load(std::memory_order_relaxed) || !port->ring.push(slot)) {
+            port->dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        port->queued.fetch_add(1, std::memory_order_seq_cst);
+        if (port->sleeping.load(std::memory_order_seq_cst) && port->sleeping.exchange(false)) {
+            port->queued.notify_one();
+        }
+    }
+}
+
+void OutputFanOut::drain(Port& port) {
+    RealtimeScheduler::releaseCurrentThread();  // A secondary port never takes the player's core
+    cxxmidi::Message message;
+    while (true) {
+        // Read before draining, so a push after the last pop ends the wait at once
+        uint32_t seen = port.queued.load(std::memory_order_acquire);
+
+        while (std::optional<Slot> slot = port.ring.pop()) {
+            if (port.failed.load(std::memory_order_relaxed)) {
+                port.dropped.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                message.assign(slot->bytes, slot->bytes + slot->size);
+                try {
+                    port.output->SendMessage(&message);
+                    port.sent.fetch_add(1, std::memory_order_relaxed);
+                }
+                catch (const std::exception&) {
+                    // Unplugged or refused; stop queueing for it
+                    port.failed.store(true, std::memory_order_relaxed);
+                    port.dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            port.handled.fetch_add(1, std::memory_order_release);
+        }
+
+        if (port.stop.load(std::memory_order_acquire) && port.ring.empty()) {
+            return;
+        }
+
+        // Announce the sleep, then look again: a push either sees the flag or is seen here
+        port.sleeping.store(true, std::memory_order_seq_cst);
+        if (port.queued.load(std::memory_order_seq_cst) == seen) {
+            port.queued.wait(seen, std::memory_order_acquire);
+        }
+        port.sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+std::vector<OutputFanOut::PortStats> OutputFanOut::getStats() const {
+    std::vector<PortStats> stats;
+    stats.reserve(ports_.size());
+    for (const std::unique_ptr<Port>& port : ports_) {
+        PortStats portStats;
+        portStats.name = port->name;
+        portStats.sent = port->sent.load(std::memory_order_relaxed);
+        portStats.dropped = port->dropped.load(std::memory_order_relaxed);
+        portStats.failed = port->failed.load(std::memory_order_relaxed);
+        stats.push_back(std::move(portStats));
+    }
+    return stats;
+}
+
+bool OutputFanOut::flush(std::chrono::milliseconds timeout) const {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (const std::unique_ptr<Port>& port : ports_) {
+        // Every push bumps queued once; stop bumps it too, but only in the destructor
+        while (port->handled.load(std::memory_order_acquire) != port->queued.load(std::memory_order_acquire)) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+} // namespace MidiPlay
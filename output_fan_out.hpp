@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cxxmidi/output/abstract.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Sends every message to the primary port and copies it to secondary ones
+ *
+ * The organ is the primary port and is written on the calling (player)
+ * thread exactly as without fan-out. Every secondary port, a USB recorder or
+ * a second keyboard for the choir room, has a lock-free ring and a writer
+ * thread of its own that drains it. SendMessage() only copies the bytes into
+ * each ring, so a secondary port that stalls, or is unplugged, costs the
+ * player thread nothing: its ring fills and further messages for that port
+ * are dropped and counted, never waited for. A writer is woken only after it
+ * has emptied its ring and said it is going to sleep, so a busy port costs no
+ * system call per message.
+ *
+ * Messages longer than Slot::MAX_BYTES are sent to the primary port only.
+ * Secondary ports are added before playback and live as long as the fan-out.
+ *
+ * The primary port can be replaced before playback, by one the fan-out then
+ * owns: DeviceManager swaps the sequencer port for a RawMidiOutput when the
+ * device is configured for it.
+ */
+class OutputFanOut : public cxxmidi::output::Abstract {
+public:
+    /**
+     * @brief One message as it travels through a ring
+     */
+    struct Slot {
+        static constexpr size_t MAX_BYTES = 15;
+        uint8_t size = 0;
+        uint8_t bytes[MAX_BYTES] = {};
+    };
+
+    static constexpr size_t RING_CAPACITY = 1024;     // About a second of dense playing
+
+    /**
+     * @brief What one secondary port was given
+     */
+    struct PortStats {
+        std::string name;
+        uint64_t sent = 0;      // Written to the port by its writer thread
+        uint64_t dropped = 0;   // Refused by a full ring or a failed port
+        bool failed = false;    // The port threw; nothing more is queued for it
+    };
+
+    /**
+     * @param primary Port written on the player thread; not owned
+     */
+    explicit OutputFanOut(cxxmidi::output::Abstract& primary);
+
+    /**
+     * @brief Stop the writer threads after they have drained their rings
+     */
+    ~OutputFanOut() override;
+
+    // Disable copy/move
+    OutputFanOut(const OutputFanOut&) = delete;
+    OutputFanOut& operator=(const OutputFanOut&) = delete;
+
+    /**
+     * @brief Replace the primary port before playback
+     * @param port Opened port; owned from now on
+     * @param byteStream The port takes several messages, with running status, per SendMessage()
+     */
+    void setPrimary(std::unique_ptr<cxxmidi::output::Abstract> port, bool byteStream);
+
+    /**
+     * @brief Port written on the player thread, for senders that must bypass the rings
+     */
+    cxxmidi::output::Abstract& getPrimary() const { return *primary_; }
+
+    /**
+     * @brief Whether one SendMessage() may carry several messages
+     *
+     * Only if the primary port takes a byte stream and no secondary port,
+     * which takes a message at a time, shares it.
+     */
+    bool isByteStream() const { return byteStream_ && ports_.empty(); }
+
+    /**
+     * @brief Add an open secondary port and start its writer thread
+     * @param port Opened port; owned from now on
+     * @param name For the statistics
+     */
+    void addPort(std::unique_ptr<cxxmidi::output::Abstract> port, const std::string& name);
+
+    size_t getSecondaryCount() const { return ports_.size(); }
+
+    /**
+     * @brief Counters of every secondary port, in the order they were added
+     */
+    std::vector<PortStats> getStats() const;
+
+    /**
+     * @brief Wait until every secondary port has handled what was queued
+     * @return false if a port is still busy after @p timeout
+     */
+    bool flush(std::chrono::milliseconds timeout) const;
+
+    // cxxmidi::output::Abstract; everything but SendMessage() is the primary port's
+    void OpenPort(unsigned int num = 0) override { primary_->OpenPort(num); }
+    void ClosePort() override { primary_->ClosePort(); }
+    void OpenVirtualPort(const std::string& name = "") override { primary_->OpenVirtualPort(name); }
+    size_t GetPortCount() override { return primary_->GetPortCount(); }
+    std::string GetPortName(unsigned int num = 0) override { return primary_->GetPortName(num); }
+
+    /**
+     * @brief Send to the primary port, then queue for each secondary one
+     */
+    void SendMessage(const cxxmidi::Message* msg) override;
+
+private:
+    struct Port {
+        std::unique_ptr<cxxmidi::output::Abstract> output;
+        std::string name;
+        SpscQueue<Slot, RING_CAPACITY> ring;
+        std::atomic<uint32_t> queued{0};      // Bumped per push; the writer sleeps on it
+        std::atomic<bool> sleeping{false};    // Set by the writer before it sleeps; only then is it woken
+        std::atomic<uint32_t> handled{0};     // Bumped per pop, written or not
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> failed{false};
+        std::atomic<bool> stop{false};
+        std::thread writer;
+    };
+
+    static void drain(Port& port);
+
+    cxxmidi::output::Abstract* primary_;
+    std::unique_ptr<cxxmidi::output::Abstract> ownedPrimary_;  // Set by setPrimary()
+    bool byteStream_ = false;
+    std::vector<std::unique_ptr<Port>> ports_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,76 @@
+#include "packed_events.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace MidiPlay {
+
+namespace {
+
+size_t sideBytesOf(size_t size) {
+    if (size <= PackedEvent::INLINE_BYTES) {
+        return 0;
+    }
+    return size < PackedEvent::SIZE_IN_SIDE_TABLE ? size : size + 4;
+}
+
+} // namespace
+
+size_t PackedEvents::sideBytesFor(size_t messageBytes) {
+    // Every message of SIZE_IN_SIDE_TABLE bytes or more carries a 4-byte length
+    return messageBytes + 4 * (messageBytes / PackedEvent::SIZE_IN_SIDE_TABLE);
+}
+
+void PackedEvents::reserve(size_t events, size_t sideBytes) {
+    events_.reserve(events);
+    sideBytes_.reserve(sideBytes);
+}
+
+bool PackedEvents::fits(size_t size) const {
+    return events_.size() < events_.capacity() && sideBytes_.size() + sideBytesOf(size) <= sideBytes_.capacity();
+}
+
+void PackedEvents::append(uint32_t tick, const uint8_t* data, size_t size) {
+    PackedEvent event;
+    event.tick = tick;
+    std::memset(event.bytes, 0, sizeof(event.bytes));
+
+    if (size <= PackedEvent::INLINE_BYTES) {
+        event.size = static_cast<uint8_t>(size);
+        if (size > 0) {
+            std::memcpy(event.bytes, data, size);
+        }
+    } else {
+        size_t offset = sideBytes_.size();
+        if (offset + sideBytesOf(size) > MAX_SIDE_BYTES) {
+            throw std::length_error("PackedEvents side table full");
+        }
+        event.bytes[0] = static_cast<uint8_t>(offset);
+        event.bytes[1] = static_cast<uint8_t>(offset >> 8);
+        event.bytes[2] = static_cast<uint8_t>(offset >> 16);
+
+        if (size < PackedEvent::SIZE_IN_SIDE_TABLE) {
+            event.size = static_cast<uint8_t>(size);
+        } else {
+            event.size = PackedEvent::SIZE_IN_SIDE_TABLE;
+            uint32_t length = static_cast<uint32_t>(size);
+            for (int shift = 0; shift < 32; shift += 8) {
+                sideBytes_.push_back(static_cast<uint8_t>(length >> shift));
+            }
+        }
+        sideBytes_.insert(sideBytes_.end(), data, data + size);
+    }
+    events_.push_back(event);
+}
+
+void PackedEvents::clear() {
+    // Swapping with empty vectors releases the capacity too
+    std::vector<PackedEvent>().swap(events_);
+    std::vector<uint8_t>().swap(sideBytes_);
+}
+
+size_t PackedEvents::getMemoryBytes() const {
+    return events_.capacity() * sizeof(PackedEvent) + sideBytes_.capacity();
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "event_view.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief One event in 8 bytes: a tick and up to three message bytes
+ *
+ * What the tick means is up to the container: a delta time in an
+ * EventArena track, an absolute tick in a PlaybackTimeline. Messages of up
+ * to three bytes (every channel message) are held in place; for longer
+ * ones (meta events, SysEx) the three bytes hold an offset into the side
+ * table of the PackedEvents they belong to.
+ */
+struct PackedEvent {
+    static constexpr size_t INLINE_BYTES = 3;
+    static constexpr uint8_t SIZE_IN_SIDE_TABLE = 0xFF;    // Longer than 254 bytes: 32-bit length before the bytes
+
+    uint32_t tick;
+    uint8_t bytes[INLINE_BYTES];
+    uint8_t size;       // Message length; above INLINE_BYTES, bytes[] is a side-table offset
+};
+
+static_assert(sizeof(PackedEvent) == 8, "PackedEvent must stay 8 bytes");
+
+/**
+ * @brief Array of PackedEvent with the side table for the long messages
+ *
+ * Two blocks in all, however many events. The side table is addressed with
+ * 24 bits, which allows 16 MB of meta and SysEx data, far beyond any hymn.
+ *
+ * Growing within reserve()d capacity never moves anything, so events may be
+ * read by other threads while more are appended, as a streaming
+ * PlaybackTimeline does.
+ */
+class PackedEvents {
+public:
+    static constexpr size_t MAX_SIDE_BYTES = size_t(1) << 24;
+
+    /**
+     * @brief Side-table bytes needed for @p messageBytes bytes of long messages, worst case
+     */
+    static size_t sideBytesFor(size_t messageBytes);
+
+    /**
+     * @brief Make room; see sideBytesFor() for the side table
+     */
+    void reserve(size_t events, size_t sideBytes);
+
+    /**
+     * @brief Append an event
+     * @throws std::length_error when the side table is full
+     */
+    void append(uint32_t tick, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Whether an append stays within the reserved capacity
+     */
+    bool fits(size_t size) const;
+
+    size_t size() const { return events_.size(); }
+    bool empty() const { return events_.empty(); }
+
+    uint32_t tickAt(size_t index) const { return events_[index].tick; }
+    const PackedEvent* data() const { return events_.data(); }
+
+    /**
+     * @brief Message of one event
+     * @param dt Delta time to give the view
+     */
+    EventView viewAt(size_t index, uint32_t dt) const {
+        const PackedEvent& event = events_[index];
+        if (event.size <= PackedEvent::INLINE_BYTES) {
+            return EventView(event.bytes, event.size, dt);
+        }
+        const uint8_t* side = sideBytes_.data() + offsetOf(event);
+        if (event.size == PackedEvent::SIZE_IN_SIDE_TABLE) {
+            uint32_t length = static_cast<uint32_t>(side[0]) | static_cast<uint32_t>(side[1]) << 8
+                            | static_cast<uint32_t>(side[2]) << 16 | static_cast<uint32_t>(side[3]) << 24;
+            return EventView(side + 4, length, dt);
+        }
+        return EventView(side, event.size, dt);
+    }
+
+    /**
+     * @brief Free all storage
+     */
+    void clear();
+
+    /**
+     * @brief Bytes held, including unused capacity
+     */
+    size_t getMemoryBytes() const;
+
+private:
+    static uint32_t offsetOf(const PackedEvent& event) {
+        return static_cast<uint32_t>(event.bytes[0]) | static_cast<uint32_t>(event.bytes[1]) << 8
+             | static_cast<uint32_t>(event.bytes[2]) << 16;
+    }
+
+    std::vector<PackedEvent> events_;
+    std::vector<uint8_t> sideBytes_;
+};
+
+} // namespace MidiPlay
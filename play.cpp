@@ -12,6 +12,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <memory>
 
 #include <ecocommon/timer.hpp>
 
@@ -26,9 +27,29 @@
 #include "midi_loader.hpp"
 #include "timing_manager.hpp"
 #include "playback_orchestrator.hpp"
+#include "player_sync_engine.hpp"
+#include "timeline_player.hpp"
 #include "playback_synchronizer.hpp"
+#include "hymnal_index.hpp"
+#include "realtime_scheduler.hpp"
+#include "jitter_recorder.hpp"
+#include "active_notes.hpp"
+#include "daemon_server.hpp"
+#include "daemon_client.hpp"
+#include "setlist.hpp"
+#include "hymn_library.hpp"
+#include "hymn_preloader.hpp"
+#include "startup_profiler.hpp"
+#include "keyboard_control.hpp"
+#include "dry_run.hpp"
+#include "hymnal_linter.hpp"
+#include "memory_report.hpp"
+#include "output_fan_out.hpp"
+#include "session_telemetry.hpp"
+#include "device_reconnector.hpp"
 
 #include <cmath>
+#include <filesystem>
 
 
 namespace fs = std::filesystem;
@@ -38,50 +59,171 @@ namespace fs = std::filesystem;
 
 using cxxmidi::output::Default;
 using cxxmidi::player::PlayerSync;
+using Phase = MidiPlay::StartupProfiler::Phase;
 
 // Version is established from the latest git tag at build time
 // The git tag takes the form "Version x.y.z"
 
+// --list: refresh the hymnal index and print the matching hymns
+static int listHymns(const Options& options)
+{
+     std::string directory;
+     try {
+         // getFullPath knows where hymns live; the directory is the parent of any resolved name
+         directory = fs::path(getFullPath("index", options.isStaging())).parent_path().string();
+     }
+     catch (const std::runtime_error& e) {
+         std::cout << _("Error: ") << e.what() << std::endl;
+         return MidiPlay::EXIT_ENVIRONMENT_ERROR;
+     }
 
-int main(int argc, char **argv)
+     MidiPlay::HymnalIndex index(MidiPlay::HymnalIndex::defaultIndexPath(options.isStaging()));
+     index.load();
+
+     MidiPlay::HymnalIndex::UpdateStats stats = index.update(directory);
+     if (stats.indexed > 0 || stats.removed > 0) {
+         if (!index.save() && options.isVerbose()) {
+             std::cout << _("Unable to write hymnal index ") << index.getIndexPath() << std::endl;
+         }
+     }
+
+     if (options.isVerbose()) {
+         std::cout << _("Indexed ") << stats.indexed << _(", unchanged ") << stats.reused
+                   << _(", removed ") << stats.removed << _(", failed ") << stats.failed << "\n" << std::endl;
+     }
+
+     std::vector<MidiPlay::HymnalEntry> matches = index.search(options.getListQuery());
+     for (const MidiPlay::HymnalEntry& entry : matches) {
+         std::cout << std::left << std::setw(12) << entry.fileName << " "
+                   << std::setw(40) << entry.title << " "
+                   << std::setw(4) << entry.keySignature << " "
+                   << std::right << std::setw(2) << entry.verses << " "
+                   << std::setw(3) << entry.bpm << " "
+                   << (entry.hasIntro ? "I" : " ") << " "
+                   << std::setw(6) << MidiPlay::TimingManager::formatTime(static_cast<int>(entry.durationSeconds))
+                   << std::endl;
+     }
+
+     std::cout << std::endl << matches.size() << _(" of ") << index.entries().size() << _(" hymns") << std::endl;
+     return EXIT_SUCCESS;
+}
+
+// --lint[=<directory>]: check every hymn under a directory on all cores
+static int lintHymnal(const Options& options)
 {
-     // Initialize i18n
-     MidiPlay::initializeI18n();
+     std::string directory = options.getLintDirectory();
+     try {
+         if (directory.empty()) {
+             directory = fs::path(getFullPath("index", options.isStaging())).parent_path().string();
+         }
 
-     // Get command line arguments
-     //
-     Options options(argc, argv);
-     int rc = options.parse();
-     if (rc != 0) {
-         if (rc < 0) {
-             exit(0);
-         } else {
-             exit(rc);
+         MidiPlay::HymnalLinter linter;
+         std::vector<MidiPlay::LintResult> results = linter.lintDirectory(directory);
+         linter.printReport(results, std::cout, options.isVerbose());
+
+         std::string jsonPath = options.getLintJsonPath();
+         if (!jsonPath.empty() && !linter.writeJson(results, jsonPath)) {
+             std::cout << _("Unable to write ") << jsonPath << std::endl;
+             return MidiPlay::EXIT_ENVIRONMENT_ERROR;
          }
+         return linter.getSummary().issues > 0 ? MidiPlay::EXIT_LINT_ISSUES : EXIT_SUCCESS;
+     }
+     catch (const std::runtime_error& e) {
+         std::cout << _("Error: ") << e.what() << std::endl;
+         return MidiPlay::EXIT_ENVIRONMENT_ERROR;
      }
+}
 
-     // Extract initial option values
-     std::string filename = options.getFileName();
-     
+// --publish-library: one read-only library of every hymn, mapped by any process that loads hymns
+static int publishLibrary(const Options& options)
+{
+     std::string directory;
+     try {
+         directory = fs::path(getFullPath("index", options.isStaging())).parent_path().string();
+     }
+     catch (const std::runtime_error& e) {
+         std::cout << _("Error: ") << e.what() << std::endl;
+         return MidiPlay::EXIT_ENVIRONMENT_ERROR;
+     }
+
+     MidiPlay::HymnCache cache;
+     std::string libraryPath = MidiPlay::HymnLibrary::pathIn(cache.getDirectory(), options.isStaging());
+     if (libraryPath.empty()) {
+         std::cout << _("No cache directory for the hymn library.") << std::endl;
+         return MidiPlay::EXIT_ENVIRONMENT_ERROR;
+     }
+
+     MidiPlay::HymnLibrary::PublishStats stats = MidiPlay::HymnLibrary::publish(directory, cache, libraryPath);
+     if (stats.bytes == 0) {     // Not written
+         std::cout << _("Unable to write hymn library ") << libraryPath << std::endl;
+         return MidiPlay::EXIT_ENVIRONMENT_ERROR;
+     }
+
+     std::cout << stats.published << _(" hymns published to ") << libraryPath
+               << " (" << stats.bytes / 1024 << " KB)" << std::endl;
+     if (options.isVerbose()) {
+         std::cout << _("Loaded ") << stats.loaded << _(", unchanged ") << stats.published - stats.loaded
+                   << _(", failed ") << stats.failed << std::endl;
+     }
+     return EXIT_SUCCESS;
+}
+
+// Resolve the hymn's path and load it
+static int loadHymn(const Options& options, MidiPlay::MidiLoader& midiLoader, MidiPlay::StartupProfiler& profiler)
+{
      std::string path;
      try {
-         path = getFullPath(filename, options.isStaging());
+         profiler.begin(Phase::ResolvePath);
+         path = getFullPath(options.getFileName(), options.isStaging());
+         profiler.end(Phase::ResolvePath);
      }
      catch (const std::runtime_error& e) {
          std::cout << _("Error: ") << e.what() << std::endl;
-         exit(MidiPlay::EXIT_ENVIRONMENT_ERROR);
+         return MidiPlay::EXIT_ENVIRONMENT_ERROR;
      }
 
-     // Use MidiLoader to handle all MIDI file loading and parsing
+     profiler.begin(Phase::LoadFile);
+     bool loaded = midiLoader.loadFile(path, options);
+     profiler.end(Phase::LoadFile);
+     if (!loaded) {
+         return MidiPlay::EXIT_FILE_NOT_FOUND;
+     }
+
+     if (options.isMemReport()) {
+         if (midiLoader.isStreaming()) {
+             std::cout << _("No memory report while the file is still being read (--stream)") << std::endl;
+         } else {
+             MidiPlay::MemoryReport::print(MidiPlay::MemoryReport::measure(midiLoader), std::cout);
+         }
+         std::cout << std::endl;
+     }
+     return EXIT_SUCCESS;
+}
+
+// --dry-run: play the hymn on a virtual clock, without a device, and report the timings
+static int dryRun(const Options& options, MidiPlay::StartupProfiler& profiler)
+{
      MidiPlay::MidiLoader midiLoader;
-     
-     if (!midiLoader.loadFile(path, options)) {
-         exit(MidiPlay::EXIT_FILE_NOT_FOUND);
+     int rc = loadHymn(options, midiLoader, profiler);
+     if (rc != EXIT_SUCCESS) {
+         return rc;
      }
 
-     Default outport;
+     MidiPlay::DryRun dryRun(midiLoader);
+     MidiPlay::DryRun::Report report = dryRun.run(options.isDisplayWarnings());
+     MidiPlay::DryRun::print(report, std::cout);
+     return EXIT_SUCCESS;
+}
 
+// Find the organ among the output ports, connect and send its setup, then
+// open the secondary ports that get a copy of the performance
+static int setUpDevice(const Options& options, Default& outport, MidiPlay::OutputFanOut& output,
+                       MidiPlay::DeviceManager& deviceManager, MidiPlay::DeviceInfo& deviceInfo,
+                       MidiPlay::StartupProfiler& profiler)
+{
+     profiler.begin(Phase::PortCount);
      size_t portCount = outport.GetPortCount();
+     profiler.end(Phase::PortCount);
 
      if (options.isVerbose()) {
         std::cout << _("Detected ") << portCount << _(" MIDI output ports:") << std::endl;
@@ -94,18 +236,21 @@ int main(int argc, char **argv)
         std::cout << std::endl;
      }
 
-   // Use DeviceManager to handle device connection and setup
-   MidiPlay::DeviceManager deviceManager(options);
-   
    try {
        // Load YAML configuration (mandatory)
+       profiler.begin(Phase::LoadDevicePresets);
        deviceManager.loadDevicePresets();
+       profiler.end(Phase::LoadDevicePresets);
        
        // Connect to device and detect its type
-       MidiPlay::DeviceInfo deviceInfo = deviceManager.connectAndDetectDevice(outport);
+       profiler.begin(Phase::ConnectDevice);
+       deviceInfo = deviceManager.connectAndDetectDevice(outport);
+       profiler.end(Phase::ConnectDevice);
        
        // Create and configure device using factory pattern
+       profiler.begin(Phase::ConfigureDevice);
        deviceManager.createAndConfigureDevice(deviceInfo.type, outport);
+       profiler.end(Phase::ConfigureDevice);
        
        if (options.isVerbose()) {
             // Display device information
@@ -113,14 +258,108 @@ int main(int argc, char **argv)
                         << " (" << deviceInfo.portName << ")" << std::endl;
         }
 
+       deviceManager.connectRawMidi(deviceInfo.type, deviceInfo, outport, output);
+       deviceManager.connectSecondaryOutputs(output, deviceInfo.portName);
    }
    catch (const std::exception& e) {
        std::cout << e.what() << std::endl;
-       exit(MidiPlay::EXIT_DEVICE_NOT_FOUND);
+       return MidiPlay::EXIT_DEVICE_NOT_FOUND;
    }
+   return EXIT_SUCCESS;
+}
 
-   PlayerSync player(&outport);
-   player.SetFile(&midiLoader.getFile());
+// --profile-startup: show where startup went, and write it as JSON if asked
+static void reportStartup(const Options& options, const MidiPlay::StartupProfiler& profiler)
+{
+     if (!options.isProfileStartup() || !profiler.isEnabled()) {
+         return;
+     }
+     profiler.print(std::cout);
+     std::cout << std::endl;
+
+     std::string jsonPath = options.getProfileJsonPath();
+     if (!jsonPath.empty() && !profiler.writeJson(jsonPath)) {
+         std::cout << _("Unable to write ") << jsonPath << std::endl;
+     }
+}
+
+// Play a loaded hymn on a connected, configured port. Standalone, SIGINT is
+// handled here; under the daemon, a client hangup cancels playback instead.
+static int playHymn(const Options& options, MidiPlay::MidiLoader& midiLoader,
+                    MidiPlay::OutputFanOut& output, MidiPlay::ActiveNotes& activeNotes,
+                    const MidiPlay::StartupProfiler& profiler, MidiPlay::DeviceReconnector& reconnector,
+                    MidiPlay::DaemonServer* daemon)
+{
+   // Send timing instrumentation; sized for every event in the intro, each verse and a D.C.
+   std::unique_ptr<MidiPlay::JitterRecorder> jitterRecorder;
+   if (options.isJitterReport() || options.isTelemetry()) {
+       size_t eventCount = midiLoader.getEventCount();
+       jitterRecorder = std::make_unique<MidiPlay::JitterRecorder>(eventCount * (midiLoader.getVerses() + 2));
+   }
+
+   // Real-time scheduling before the engine exists, so its thread inherits it
+   std::unique_ptr<MidiPlay::RealtimeScheduler> realtime;
+   if (options.isRealtime()) {
+       realtime = std::make_unique<MidiPlay::RealtimeScheduler>(options.getRealtimePriority(), options.getRealtimeCpu());
+       if (!realtime->apply(midiLoader.getFile()) && options.isDisplayWarnings()) {
+           for (const std::string& warning : realtime->getWarnings()) {
+               std::cout << _("   Warning: ") << warning << std::endl;
+           }
+       }
+   }
+
+   // Track-by-track PlayerSync by default; merged pre-timed timeline with --timeline
+   PlayerSync player(&output);
+   std::unique_ptr<MidiPlay::PlaybackEngine> engine;
+   MidiPlay::TimelinePlayer* timeline = nullptr;
+   if (options.isTimelineEngine()) {
+       // A streaming load plays the timeline it is still filling
+       const MidiPlay::PlaybackTimeline* streamed = midiLoader.getStreamingTimeline();
+       auto timelinePlayer = streamed ? std::make_unique<MidiPlay::TimelinePlayer>(output, *streamed)
+                                      : std::make_unique<MidiPlay::TimelinePlayer>(output, midiLoader.getEvents());
+       // Its seeks chase the stops once the producer has indexed the whole file
+       if (streamed) {
+           timelinePlayer->setSeekIndexSource([&midiLoader]() { return midiLoader.getStreamingSeekIndex(); });
+       }
+       // A rawmidi port takes a whole tick per write, encoded before the hymn starts
+       if (options.isBatchOutput()) {
+           timelinePlayer->setOutputMode(MidiPlay::TimelinePlayer::OutputMode::Stream);
+       } else if (output.isByteStream()) {
+           timelinePlayer->setOutputMode(MidiPlay::TimelinePlayer::OutputMode::Wire);
+       }
+       timelinePlayer->setPreciseTiming(options.isPreciseTiming());
+       timelinePlayer->setTickless(options.isTickless());
+       // --reconnect: a device that goes away pauses the hymn on the player thread instead of ending it
+       if (options.isReconnect()) {
+           timelinePlayer->setCallbackReconnect([&options, &reconnector]() {
+               std::cout << _("Device disconnected.  Waiting for it to come back...") << std::endl;
+               bool reconnected = reconnector.reconnect();
+               if (!reconnected) {
+                   std::cout << _("Error: ") << _("the device did not come back.") << std::endl;
+               } else if (options.isVerbose()) {
+                   std::cout << _("Reconnected to: ") << reconnector.getDevice().portName << std::endl;
+               }
+               return reconnected;
+           });
+       }
+       timeline = timelinePlayer.get();
+       engine = std::move(timelinePlayer);
+   } else {
+       if (options.isBatchOutput() && options.isDisplayWarnings()) {
+           std::cout << _("   Warning: ") << _("--batch-output needs --timeline; sending events one at a time.") << std::endl;
+       }
+       player.SetFile(&midiLoader.getFile());
+       engine = std::make_unique<MidiPlay::PlayerSyncEngine>(player, &output);
+   }
+
+   // The timeline player's thread has the settings; the main thread and the helpers it starts need not
+   if (realtime && options.isTimelineEngine()) {
+       realtime->restore();
+   }
+
+   // Held notes, so jumps and interrupts release only what is sounding
+   activeNotes.clear();
+   engine->setActiveNotes(&activeNotes);
 
      // Create timing manager
      MidiPlay::TimingManager timingManager;
@@ -129,25 +368,368 @@ int main(int argc, char **argv)
      // Create modern C++ synchronization primitive (replaces POSIX semaphore)
      MidiPlay::PlaybackSynchronizer synchronizer;
      
+     // Keys pressed while playing; declared before the orchestrator that consumes them
+     MidiPlay::PlaybackCommandQueue commands;
+     
      // Create playback orchestrator with dependencies
-     MidiPlay::PlaybackOrchestrator playbackOrchestrator(player, synchronizer, midiLoader);
+     MidiPlay::PlaybackOrchestrator playbackOrchestrator(*engine, synchronizer, midiLoader);
      playbackOrchestrator.initialize();
      playbackOrchestrator.setDisplayWarnings(options.isDisplayWarnings());
+     playbackOrchestrator.setJitterRecorder(jitterRecorder.get());
+     
+     // Live control from the keyboard when someone is at the terminal; a daemon's input is not the organist's
+     std::unique_ptr<MidiPlay::KeyboardControl> keyboard;
+     if (!daemon && isatty(STDIN_FILENO)) {
+         keyboard = std::make_unique<MidiPlay::KeyboardControl>(commands);
+         keyboard->setCommandCallback([&engine]() { engine->requestHeartbeat(); });
+         if (keyboard->start()) {
+             playbackOrchestrator.setCommandQueue(&commands);
+             if (options.isVerbose()) {
+                 std::cout << MidiPlay::KeyboardControl::keyHelp() << std::endl;
+             }
+         }
+     }
      
      // Display what we're about to play
      playbackOrchestrator.displayPlaybackInfo();
      
      // Set up signal handler now that all dependencies are available
-     MidiPlay::SignalHandler signalHandler(outport, synchronizer, timingManager.getStartTime());
-     signalHandler.setupSignalHandler();
+     std::unique_ptr<MidiPlay::SignalHandler> signalHandler;
+     if (daemon) {
+         // The player thread stops and silences the notes itself: no other thread writes to the port meanwhile
+         playbackOrchestrator.setCommandQueue(&commands);
+         daemon->setHangupCallback([&commands, &engine]() {
+             commands.push({MidiPlay::PlaybackCommand::Kind::Stop});
+             engine->requestHeartbeat();
+         });
+     } else {
+         signalHandler = std::make_unique<MidiPlay::SignalHandler>(output.getPrimary(), synchronizer, timingManager.getStartTime());
+         signalHandler->setActiveNotes(&activeNotes);
+         signalHandler->setupSignalHandler();
+     }
+
+     if (timeline && options.isReconnect()) {
+         reconnector.watch([timeline]() { timeline->deviceLost(); });
+     }
 
      // Execute complete playback sequence (intro + verses)
      playbackOrchestrator.executePlayback();
+     if (realtime) {
+         realtime->restore();   // PlayerSync: done with the main thread
+     }
+     
+     timingManager.endTimer();
+     reconnector.unwatch();
+     
+     // A streamed hymn's producer may still be reading; join it and keep the whole file
+     midiLoader.finishStreaming();
+
+     // The player thread has stopped; a cancelled session is still worth a record
+     if (options.isTelemetry()) {
+         MidiPlay::SessionTelemetry::Record record = MidiPlay::SessionTelemetry::collect(
+             options, midiLoader, profiler, timingManager, jitterRecorder.get(), playbackOrchestrator.isCancelled());
+         if (!MidiPlay::SessionTelemetry::write(record, options.getTelemetryPath())) {
+             std::cout << _("Error: could not write ") << options.getTelemetryPath() << std::endl;
+         }
+     }
+
+     if (daemon) {
+         daemon->setHangupCallback(nullptr);
+         if (playbackOrchestrator.isCancelled()) {
+             return EXIT_SUCCESS;   // Nobody is left to read the report
+         }
+     }
 
      // Display elapsed time
-     timingManager.endTimer();
      timingManager.displayElapsedTime();
      
+     if (timeline && options.isVerbose()) {
+         timingManager.displayLoadReport(timeline->getWakeups(), timeline->getHeartbeats());
+     }
+     
+     if (options.isJitterReport()) {
+         timingManager.displayJitterReport(*jitterRecorder);
+         std::string csvPath = options.getJitterCsvPath();
+         if (!csvPath.empty() && !jitterRecorder->writeCsv(csvPath)) {
+             std::cout << _("Error: could not write ") << csvPath << std::endl;
+         }
+     }
+
+     // A secondary port that fell behind or went away lost part of the performance
+     if (options.isDisplayWarnings()) {
+         for (const MidiPlay::OutputFanOut::PortStats& port : output.getStats()) {
+             if (port.failed || port.dropped > 0) {
+                 std::cout << _("   Warning: ") << port.name << _(": ") << port.dropped
+                           << _(" messages not delivered") << (port.failed ? _(" (port failed)") : "") << std::endl;
+             }
+         }
+     }
+     
      // Note: synchronizer cleanup happens automatically via RAII
      return EXIT_SUCCESS;
 }
+
+// --daemon: set up the organ once, then play the hymns clients ask for
+static int runDaemon(const Options& options, MidiPlay::StartupProfiler& profiler)
+{
+     MidiPlay::DaemonServer server(MidiPlay::DaemonServer::defaultSocketPath());
+     if (!server.listen()) {
+         std::cout << _("Error: ") << server.getError() << std::endl;
+         return MidiPlay::EXIT_ENVIRONMENT_ERROR;
+     }
+
+     Default outport;
+     MidiPlay::OutputFanOut output(outport);
+     MidiPlay::DeviceManager deviceManager(options);
+     MidiPlay::DeviceInfo deviceInfo;
+     int rc = setUpDevice(options, outport, output, deviceManager, deviceInfo, profiler);
+     if (rc != EXIT_SUCCESS) {
+         return rc;
+     }
+     reportStartup(options, profiler);
+     MidiPlay::DeviceReconnector reconnector(deviceManager, deviceInfo, outport, output);
+
+     // SIGINT/SIGTERM on the daemon itself silences the organ and exits
+     MidiPlay::ActiveNotes activeNotes;
+     MidiPlay::PlaybackSynchronizer synchronizer;
+     MidiPlay::TimingManager timingManager;
+     timingManager.startTimer();
+     MidiPlay::SignalHandler signalHandler(output.getPrimary(), synchronizer, timingManager.getStartTime());
+     signalHandler.setActiveNotes(&activeNotes);
+     signalHandler.setupSignalHandler();
+
+     std::cout << _("Listening on ") << server.getSocketPath() << std::endl;
+
+     server.serve([&](const MidiPlay::DaemonRequest& request) -> int {
+         std::vector<char*> argv;
+         for (const std::string& arg : request.args) {
+             argv.push_back(const_cast<char*>(arg.c_str()));
+         }
+         argv.push_back(nullptr);
+
+         optind = 0;  // Reset getopt for every request
+         Options requestOptions(static_cast<int>(request.args.size()), argv.data());
+         int parsed = requestOptions.parse();
+         if (parsed != 0) {
+             return parsed < 0 ? EXIT_SUCCESS : parsed;
+         }
+         if (requestOptions.isListMode()) {
+             return listHymns(requestOptions);
+         }
+         if (requestOptions.isDaemonMode()) {
+             std::cout << _("Error: ") << _("a daemon is already running") << std::endl;
+             return MidiPlay::EXIT_ENVIRONMENT_ERROR;
+         }
+
+         // The port and the organ are set up already; only the load is left to time
+         MidiPlay::StartupProfiler requestProfiler(requestOptions.isProfileStartup() || requestOptions.isTelemetry());
+         MidiPlay::MidiLoader midiLoader;
+         int loaded = loadHymn(requestOptions, midiLoader, requestProfiler);
+         if (loaded != EXIT_SUCCESS) {
+             return loaded;
+         }
+         reportStartup(requestOptions, requestProfiler);
+         return playHymn(requestOptions, midiLoader, output, activeNotes, requestProfiler, reconnector, &server);
+     });
+
+     return EXIT_SUCCESS;
+}
+
+// One hymn of --setlist, parsed with its own options
+struct SetlistHymn {
+     std::vector<std::string> args;
+     std::vector<char*> argv;       // Points into args; Options keeps it
+     std::unique_ptr<Options> options;
+     std::string path;
+};
+
+// --setlist: play a service's hymns in order. Every hymn is loaded on a
+// HymnPreloader thread while the one before it plays, so the next hymn
+// starts the moment the organist presses Enter.
+static int runSetlist(const Options& options, int argc, char** argv, MidiPlay::StartupProfiler& profiler)
+{
+     MidiPlay::Setlist setlist;
+     if (!setlist.load(options.getSetlistPath())) {
+         std::cout << _("Error: ") << setlist.getError() << std::endl;
+         return MidiPlay::EXIT_FILE_NOT_FOUND;
+     }
+
+     // The options on this command line apply to every hymn; each line may override them
+     std::vector<std::string> common{argv[0]};
+     for (int i = 1; i < argc; i++) {
+         std::string arg = argv[i];
+         if (arg == "--setlist") {
+             i++;   // Skip its value
+         } else if (arg.rfind("--setlist=", 0) != 0) {
+             common.push_back(arg);
+         }
+     }
+
+     // Parse and resolve every hymn up front: getopt is not reentrant, and a typo is found before the service
+     std::vector<SetlistHymn> hymns(setlist.size());
+     for (size_t i = 0; i < hymns.size(); i++) {
+         const MidiPlay::SetlistEntry& entry = setlist.entries()[i];
+         SetlistHymn& hymn = hymns[i];
+         hymn.args = common;
+         hymn.args.insert(hymn.args.end(), entry.args.begin(), entry.args.end());
+         for (std::string& arg : hymn.args) {
+             hymn.argv.push_back(arg.data());
+         }
+         hymn.argv.push_back(nullptr);
+
+         optind = 0;
+         hymn.options = std::make_unique<Options>(static_cast<int>(hymn.args.size()), hymn.argv.data());
+         int parsed = hymn.options->parse();
+         if (parsed == 0 && (hymn.options->isSetlistMode() || hymn.options->isListMode() || hymn.options->isDaemonMode())) {
+             parsed = MidiPlay::OptionsParseResult::INVALID_OPTION;
+         }
+         if (parsed != 0) {
+             std::cout << _("Error in setlist line ") << entry.lineNumber << ": " << entry.args[0] << std::endl;
+             return parsed < 0 ? MidiPlay::OptionsParseResult::INVALID_OPTION : parsed;
+         }
+
+         try {
+             hymn.path = getFullPath(hymn.options->getFileName(), hymn.options->isStaging());
+         }
+         catch (const std::runtime_error& e) {
+             std::cout << _("Error: ") << e.what() << std::endl;
+             return MidiPlay::EXIT_ENVIRONMENT_ERROR;
+         }
+         if (!MidiPlay::MidiLoader::fileExists(hymn.path)) {
+             std::cout << _("Hymn ") << hymn.options->getFileName() << _(" was not found")
+                       << _(" (setlist line ") << entry.lineNumber << ")" << std::endl;
+             return MidiPlay::EXIT_FILE_NOT_FOUND;
+         }
+     }
+
+     // The first hymn loads while the organ is being set up
+     int playbackCpu = options.isRealtime()
+         ? MidiPlay::RealtimeScheduler(options.getRealtimePriority(), options.getRealtimeCpu()).getCpu() : -1;
+     MidiPlay::HymnPreloader preloader(playbackCpu);
+     preloader.start(std::make_unique<MidiPlay::MidiLoader>(), hymns[0].path, *hymns[0].options);
+
+     Default outport;
+     MidiPlay::OutputFanOut output(outport);
+     MidiPlay::DeviceManager deviceManager(options);
+     MidiPlay::DeviceInfo deviceInfo;
+     int rc = setUpDevice(options, outport, output, deviceManager, deviceInfo, profiler);
+     if (rc != EXIT_SUCCESS) {
+         return rc;
+     }
+     reportStartup(options, profiler);
+     MidiPlay::DeviceReconnector reconnector(deviceManager, deviceInfo, outport, output);
+
+     MidiPlay::ActiveNotes activeNotes;
+     bool cued = isatty(STDIN_FILENO);  // Wait for Enter between hymns only when someone can press it
+     rc = EXIT_SUCCESS;
+
+     for (size_t i = 0; i < hymns.size(); i++) {
+         if (i > 0 && cued) {
+             std::cout << _("Next: ") << hymns[i].options->getFileName()
+                       << _(".  Press Enter to play, q to stop: ") << std::flush;
+             std::string answer;
+             if (!std::getline(std::cin, answer) || answer == "q") {
+                 break;
+             }
+         }
+
+         std::unique_ptr<MidiPlay::MidiLoader> midiLoader = preloader.take();
+         if (i + 1 < hymns.size()) {
+             preloader.start(std::make_unique<MidiPlay::MidiLoader>(), hymns[i + 1].path, *hymns[i + 1].options);
+         }
+
+         if (!midiLoader) {
+             std::cout << _("Skipping ") << hymns[i].options->getFileName() << _(": it could not be loaded.") << std::endl;
+             rc = MidiPlay::EXIT_FILE_NOT_FOUND;
+             continue;
+         }
+
+         playHymn(*hymns[i].options, *midiLoader, output, activeNotes, profiler, reconnector, nullptr);
+     }
+
+     return rc;
+}
+
+
+int main(int argc, char **argv)
+{
+     // Off unless asked for; the first phases run before Options knows
+     MidiPlay::StartupProfiler profiler(MidiPlay::StartupProfiler::isRequested(argc, argv));
+
+     // Initialize i18n
+     profiler.begin(Phase::InitializeI18n);
+     MidiPlay::initializeI18n();
+     profiler.end(Phase::InitializeI18n);
+
+     // Get command line arguments
+     //
+     profiler.begin(Phase::ParseOptions);
+     Options options(argc, argv);
+     int rc = options.parse();
+     profiler.end(Phase::ParseOptions);
+     if (rc != 0) {
+         if (rc < 0) {
+             exit(0);
+         } else {
+             exit(rc);
+         }
+     }
+
+     if (options.isListMode()) {
+         exit(listHymns(options));
+     }
+
+     if (options.isLintMode()) {
+         exit(lintHymnal(options));
+     }
+
+     if (options.isPublishLibrary()) {
+         exit(publishLibrary(options));
+     }
+
+     if (options.isDaemonMode()) {
+         exit(runDaemon(options, profiler));
+     }
+
+     if (options.isSetlistMode()) {
+         exit(runSetlist(options, argc, argv, profiler));
+     }
+
+     if (options.isDryRun()) {
+         exit(dryRun(options, profiler));
+     }
+
+     // A running daemon already has the port open and the organ set up
+     if (options.isDaemonAllowed()) {
+         MidiPlay::DaemonClient client(MidiPlay::DaemonServer::defaultSocketPath());
+         profiler.begin(Phase::DaemonConnect);
+         bool connected = client.connect();
+         profiler.end(Phase::DaemonConnect);
+         if (connected) {
+             exit(client.run(argc, argv));
+         }
+     }
+
+     // Use MidiLoader to handle all MIDI file loading and parsing
+     MidiPlay::MidiLoader midiLoader;
+     rc = loadHymn(options, midiLoader, profiler);
+     if (rc != EXIT_SUCCESS) {
+         exit(rc);
+     }
+
+     Default outport;
+     MidiPlay::OutputFanOut output(outport);
+
+     // Use DeviceManager to handle device connection and setup
+     MidiPlay::DeviceManager deviceManager(options);
+     MidiPlay::DeviceInfo deviceInfo;
+     rc = setUpDevice(options, outport, output, deviceManager, deviceInfo, profiler);
+     if (rc != EXIT_SUCCESS) {
+         exit(rc);
+     }
+     reportStartup(options, profiler);
+
+     MidiPlay::ActiveNotes activeNotes;
+     MidiPlay::DeviceReconnector reconnector(deviceManager, deviceInfo, outport, output);
+     return playHymn(options, midiLoader, output, activeNotes, profiler, reconnector, nullptr);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "spsc_queue.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Request to change playback while a hymn plays
+ *
+ * Sent through a PlaybackCommandQueue to the PlaybackOrchestrator, which
+ * carries it out on the next heartbeat of the player thread.
+ */
+struct PlaybackCommand {
+    enum class Kind : uint8_t {
+        Tempo,          // Change the speed by value percent of the starting tempo (+/-)
+        LastVerse,      // End the current section and go on with the last verse
+        EndAfterVerse,  // Make the current verse the last one (ritardando, D.C. al Fine and all)
+        Stop            // Stop now
+    };
+
+    Kind kind;
+    int8_t value = 0;
+};
+
+/**
+ * @brief Commands from one input thread to the player thread
+ */
+using PlaybackCommandQueue = SpscQueue<PlaybackCommand, 16>;
+
+} // namespace MidiPlay
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "event_view.hpp"
+#include "playback_schedule.hpp"
+
+namespace MidiPlay {
+
+class ActiveNotes;
+class JitterRecorder;
+
+/**
+ * @brief Transport interface the playback components drive
+ *
+ * PlaybackOrchestrator, MusicalDirector and RitardandoEffector only need
+ * transport control, speed and three callbacks, so they are written against
+ * this interface rather than a concrete player. Two engines implement it:
+ * - PlayerSyncEngine: adapter over cxxmidi::player::PlayerSync (default)
+ * - TimelinePlayer: plays a pre-merged, pre-timed PlaybackTimeline
+ *
+ * Semantics follow PlayerSync: play() starts or resumes from the current
+ * position, stop() pauses in place, finish() ends the current pass and fires
+ * the finished callback. Transport calls are allowed from inside callbacks.
+ */
+class PlaybackEngine {
+public:
+    /**
+     * @brief Event callback
+     * @return true to send the event to the output device, false to suppress it
+     */
+    using EventCallback = std::function<bool(const EventView&)>;
+    using Callback = std::function<void()>;
+
+    virtual ~PlaybackEngine() = default;
+
+    virtual void play() = 0;
+    virtual void stop() = 0;
+    virtual void finish() = 0;
+    virtual void rewind() = 0;
+    virtual void goToTick(uint32_t tick) = 0;
+
+    /**
+     * @brief Silence every note the engine may have left sounding
+     * 
+     * With active notes tracked (setActiveNotes), only the held notes are
+     * released, followed by All Notes Off on each channel used.
+     */
+    virtual void notesOff() = 0;
+    
+    /**
+     * @brief Release the notes known to be held; no-op unless active notes are tracked
+     */
+    virtual void releaseHeldNotes() = 0;
+
+    virtual void setSpeed(float speed) = 0;
+    virtual float getSpeed() const = 0;
+
+    /**
+     * @brief Current position in the piece at normal speed
+     */
+    virtual std::chrono::microseconds currentTimePos() const = 0;
+
+    virtual void setCallbackHeartbeat(const Callback& callback) = 0;
+    
+    /**
+     * @brief Say whether heartbeats are needed from here on (player thread)
+     * 
+     * A tickless engine runs the heartbeat callback only while it is needed
+     * or when one is requested, and otherwise sleeps from event to event.
+     * Engines with a fixed heartbeat ignore it.
+     */
+    virtual void setHeartbeatNeeded(bool) {}
+    
+    /**
+     * @brief Run the heartbeat callback on the player thread soon; any thread may ask
+     */
+    virtual void requestHeartbeat() {}
+    virtual void setCallbackFinished(const Callback& callback) = 0;
+    virtual void setCallbackEvent(const EventCallback& callback) = 0;
+    
+    /**
+     * @brief Record scheduled and actual time of every message sent
+     * @param recorder Recorder that outlives playback, or nullptr to stop recording
+     */
+    virtual void setJitterRecorder(JitterRecorder* recorder) = 0;
+    
+    /**
+     * @brief Keep a bitmap of sounding notes up to date from every message sent
+     * @param notes Bitmap that outlives playback, or nullptr
+     */
+    virtual void setActiveNotes(ActiveNotes* notes) = 0;
+    
+    /**
+     * @brief Run every section of a schedule back to back on the player thread
+     * 
+     * Once set, the end of a section (reaching the end of the piece or
+     * finish()) starts the next one at the scheduled end plus its pause,
+     * after the section callback has prepared it; the finished callback fires
+     * only after the last section. The caller starts the first section
+     * itself with goToTick() and play(). Set before the first play().
+     * @return false if the engine cannot run schedules; the caller then
+     *         sequences the sections itself
+     */
+    virtual bool setSchedule(const PlaybackSchedule& schedule,
+                             const PlaybackSchedule::SectionCallback& callback) = 0;
+};
+
+} // namespace MidiPlay
@@ -1,7 +1,9 @@
 #include "playback_orchestrator.hpp"
 #include "constants.hpp"
+#include "playback_schedule.hpp"
 #include "i18n.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <thread>
@@ -9,23 +11,44 @@
 
 #include <ecocommon/utility.hpp>
 
-using cxxmidi::Event;
 using cxxmidi::player::PlayerSync;
 
 namespace MidiPlay {
 
+PlaybackOrchestrator::PlaybackOrchestrator(PlaybackEngine& engine,
+                                           PlaybackSynchronizer& synchronizer,
+                                           const MidiLoader& midiLoader)
+    : ownedEngine_()
+    , player_(engine)
+    , synchronizer_(synchronizer)
+    , midiLoader_(midiLoader)
+    , console_(std::cout)
+    , stateMachine_()
+    , musicalDirector_(engine, stateMachine_, midiLoader)
+    , ritardandoEffector_(engine, stateMachine_)
+    , baseSpeed_(1.0f)
+    , baseTempo_(1.0f)
+{
+    musicalDirector_.setConsoleLog(console_);
+    musicalDirector_.setRitardandoEffector(&ritardandoEffector_);
+}
+
 PlaybackOrchestrator::PlaybackOrchestrator(PlayerSync& player,
                                            PlaybackSynchronizer& synchronizer,
                                            const MidiLoader& midiLoader)
-    : player_(player)
+    : ownedEngine_(std::make_unique<PlayerSyncEngine>(player))
+    , player_(*ownedEngine_)
     , synchronizer_(synchronizer)
     , midiLoader_(midiLoader)
+    , console_(std::cout)
     , stateMachine_()
-    , musicalDirector_(player, stateMachine_, midiLoader)
-    , ritardandoEffector_(player, stateMachine_)
+    , musicalDirector_(*ownedEngine_, stateMachine_, midiLoader)
+    , ritardandoEffector_(*ownedEngine_, stateMachine_)
     , baseSpeed_(1.0f)
     , baseTempo_(1.0f)
 {
+    musicalDirector_.setConsoleLog(console_);
+    musicalDirector_.setRitardandoEffector(&ritardandoEffector_);
 }
 
 void PlaybackOrchestrator::initialize() {
@@ -33,20 +56,33 @@ void PlaybackOrchestrator::initialize() {
     baseTempo_ = static_cast<float>(midiLoader_.getBpm() / static_cast<float>(midiLoader_.getFileTempo()));
     
     // Set initial speed
-    player_.SetSpeed(baseTempo_ * baseSpeed_);
+    player_.setSpeed(baseTempo_ * baseSpeed_);
+    
+    currentVerse_ = 0;
+    lastVerse_ = midiLoader_.getVerses();
+    skipToVerse_ = 0;
+    tempoPercent_ = 0;
+    
+    // Ritardando curves are measured in beats of the file's tempo
+    int fileTempo = midiLoader_.getFileTempo();
+    if (fileTempo > 0) {
+        ritardandoEffector_.setBeatDuration(std::chrono::microseconds(MidiPlay::MICROSECONDS_PER_MINUTE / fileTempo));
+    }
     
     // Setup heartbeat callback - delegates to ritardandoEffector_
-    player_.SetCallbackHeartbeat([this]() {
+    player_.setCallbackHeartbeat([this]() {
         heartbeatCallback();
     });
+    heartbeatNeeded_ = false;
+    player_.setHeartbeatNeeded(false);
     
     // Setup event callback - delegates to musicalDirector_
-    player_.SetCallbackEvent([this](Event& event) -> bool {
+    player_.setCallbackEvent([this](const EventView& event) -> bool {
         return eventCallback(event);
     });
     
     // Setup finished callback
-    player_.SetCallbackFinished([this]() {
+    player_.setCallbackFinished([this]() {
         finishedCallback();
     });
 }
@@ -61,103 +97,289 @@ void PlaybackOrchestrator::displayPlaybackInfo() const {
 }
 
 void PlaybackOrchestrator::executePlayback() {
+    if (cancelled_) {
+        return;
+    }
+    
+    console_.start();
+    playSections();
+    console_.stop();    // Everything printed before the caller goes on
+}
+
+void PlaybackOrchestrator::playSections() {
+    if (playSchedule()) {
+        return;
+    }
+    
     // Play introduction if available
     if (midiLoader_.shouldPlayIntro()) {
         playIntroduction();
+        if (cancelled_) {
+            return;
+        }
     }
     
     // Play all verses
     playVerses();
 }
 
+void PlaybackOrchestrator::setJitterRecorder(JitterRecorder* recorder) {
+    jitterRecorder_ = recorder;
+    player_.setJitterRecorder(recorder);
+}
+
+void PlaybackOrchestrator::cancel() {
+    cancelled_ = true;
+    player_.stop();
+    player_.notesOff();
+    synchronizer_.notify();
+}
+
 // === Callback Handlers (delegate to components) ===
 
 void PlaybackOrchestrator::heartbeatCallback() {
+    if (commands_) {
+        applyCommands();
+    }
     ritardandoEffector_.handleHeartbeat();
+    updateHeartbeatNeed();
+    publishPosition(true);
+}
+
+void PlaybackOrchestrator::updateHeartbeatNeed() {
+    bool needed = ritardandoEffector_.checkHeartbeatNeeded();
+    if (needed != heartbeatNeeded_) {
+        heartbeatNeeded_ = needed;
+        player_.setHeartbeatNeeded(needed);
+    }
 }
 
-bool PlaybackOrchestrator::eventCallback(Event& event) {
-    return musicalDirector_.handleEvent(event);
+void PlaybackOrchestrator::applyCommands() {
+    while (std::optional<PlaybackCommand> command = commands_->pop()) {
+        switch (command->kind) {
+        case PlaybackCommand::Kind::Tempo:
+            tempoPercent_ = std::clamp(tempoPercent_ + command->value, -MAX_TEMPO_PERCENT, MAX_TEMPO_PERCENT);
+            baseSpeed_ = midiLoader_.getSpeed() * (100 + tempoPercent_) / 100.0f;
+            // A ritardando keeps its curve; the new tempo applies from the next section
+            if (!stateMachine_.isRitardando()) {
+                setPlayerSpeed(baseSpeed_);
+            }
+            break;
+            
+        case PlaybackCommand::Kind::LastVerse:
+            if (currentVerse_ < lastVerse_) {
+                skipToVerse_ = lastVerse_.load();
+                player_.releaseHeldNotes();
+                player_.finish();   // Ends this section; the skipped ones are left out
+            }
+            break;
+            
+        case PlaybackCommand::Kind::EndAfterVerse:
+            lastVerse_ = std::max(currentVerse_, 1);    // From the introduction: after verse 1
+            if (currentVerse_ == lastVerse_) {
+                stateMachine_.setLastVerse(true);
+            }
+            break;
+            
+        case PlaybackCommand::Kind::Stop:
+            cancel();
+            return;
+        }
+    }
+}
+
+bool PlaybackOrchestrator::isVerseSkipped(int verse) const {
+    return verse < skipToVerse_ || verse > lastVerse_;
+}
+
+void PlaybackOrchestrator::publishPosition(bool playing) {
+    if (!positionObserver_) {
+        return;
+    }
+    
+    const TempoMap& tempoMap = midiLoader_.getTempoMap();
+    const TimeSignature& timeSignature = midiLoader_.getTimeSignature();
+    int64_t timeUs = player_.currentTimePos().count();
+    uint32_t tick = tempoMap.tickAt(static_cast<uint64_t>(std::max<int64_t>(timeUs, 0)));
+    
+    PlaybackPosition position;
+    position.timeUs = timeUs;
+    position.setTick(tick, tempoMap.getPpq(), timeSignature.beatsPerMeasure, timeSignature.denominator);
+    position.bpm = static_cast<float>(MidiPlay::MICROSECONDS_PER_MINUTE) / tempoMap.uSecPerQuarterAt(tick)
+                 * player_.getSpeed();
+    position.verse = static_cast<int16_t>(currentVerse_);
+    position.playing = playing;
+    uint8_t state = stateMachine_.snapshot();
+    position.introduction = state & PlaybackStateMachine::PLAYING_INTRO;
+    position.ritardando = state & PlaybackStateMachine::RITARDANDO;
+    position.lastVerse = state & PlaybackStateMachine::LAST_VERSE;
+    positionObserver_->publish(position);
+}
+
+bool PlaybackOrchestrator::eventCallback(const EventView& event) {
+    bool send = musicalDirector_.handleEvent(event);
+    updateHeartbeatNeed();  // A ritardando marker starts the curve's heartbeats
+    publishPosition(true);
+    return send;
 }
 
 void PlaybackOrchestrator::finishedCallback() {
+    publishPosition(false);
     synchronizer_.notify();
 }
 
+bool PlaybackOrchestrator::startSection(const ScheduledSection& section) {
+    switch (section.kind) {
+    case ScheduledSection::Kind::Introduction:
+        currentVerse_ = 0;
+        stateMachine_.startSection(true);
+        if (midiLoader_.getIntroSegments().size() > 0) {
+            musicalDirector_.initializeIntroSegments();
+        }
+        musicalDirector_.seekDirectives(section.startTick);
+        console_.post(ConsoleMessage::PlayingIntroduction);
+        break;
+        
+    case ScheduledSection::Kind::Verse:
+        if (isVerseSkipped(section.number)) {
+            return false;
+        }
+        currentVerse_ = section.number;
+        stateMachine_.startSection(false);
+        setPlayerSpeed(baseSpeed_);
+        musicalDirector_.seekDirectives(section.startTick);
+        
+        if (section.number == lastVerse_) {
+            stateMachine_.setLastVerse(true);
+            console_.post(ConsoleMessage::PlayingLastVerse, section.number);
+        } else {
+            console_.post(ConsoleMessage::PlayingVerse, section.number);
+        }
+        break;
+        
+    case ScheduledSection::Kind::AlFine:
+        if (!stateMachine_.isAlFine()) {
+            return false;
+        }
+        musicalDirector_.seekDirectives(section.startTick);
+        break;
+    }
+    
+    if (jitterRecorder_) {
+        jitterRecorder_->beginSection(section.number);
+    }
+    publishPosition(true);
+    return true;
+}
+
 // === Playback Flow Methods ===
 
+bool PlaybackOrchestrator::playSchedule() {
+    PlaybackSchedule schedule(midiLoader_);
+    if (schedule.empty()
+        || !player_.setSchedule(schedule, [this](const ScheduledSection& section) { return startSection(section); })) {
+        return false;
+    }
+    
+    startSection(schedule[0]);
+    player_.goToTick(schedule[0].startTick);
+    player_.play();
+    synchronizer_.wait();  // Wait for the last section to finish
+    return true;
+}
+
 void PlaybackOrchestrator::playIntroduction() {
-    stateMachine_.setPlayingIntro(true);
-    stateMachine_.setRitardando(false);
+    currentVerse_ = 0;
+    stateMachine_.startSection(true);
     
     const std::vector<IntroductionSegment>& introSegments = midiLoader_.getIntroSegments();
     
     if (introSegments.size() > 0) {
         musicalDirector_.initializeIntroSegments();
-        player_.GoToTick(introSegments.begin()->start);
+        player_.goToTick(introSegments.begin()->start);
+        musicalDirector_.seekDirectives(introSegments.begin()->start);
     }
     
-    std::cout << _(" Playing introduction") << std::endl;
+    console_.post(ConsoleMessage::PlayingIntroduction);
     
-    player_.Play();
+    if (jitterRecorder_) {
+        jitterRecorder_->beginSection(0);
+    }
+    publishPosition(true);
+    player_.play();
     synchronizer_.wait();  // Wait for playback to finish
+    if (cancelled_) {
+        return;
+    }
     
     // Reset state after introduction
-    stateMachine_.setRitardando(false);
-    stateMachine_.setPlayingIntro(false);
+    stateMachine_.startSection(false);
     setPlayerSpeed(baseSpeed_);  // Reset speed to starting speed
     
-    player_.Rewind();
+    rewindPlayer();
     
     // Pause between intro and verses if specified
     MidiTicks pauseTicks = midiLoader_.getPauseTicks();
     if (pauseTicks.has_value()) {
-        int uSecPerTick = midiLoader_.getUSecPerTick();
-        std::this_thread::sleep_for(std::chrono::microseconds(pauseTicks.getTicks().value() * uSecPerTick));
+        std::this_thread::sleep_for(std::chrono::microseconds(midiLoader_.getPauseMicroseconds()));
     }
 }
 
 void PlaybackOrchestrator::playVerses() {
-    int verses = midiLoader_.getVerses();
     MidiTicks pauseTicks = midiLoader_.getPauseTicks();
-    int uSecPerTick = midiLoader_.getUSecPerTick();
+    uint64_t pauseUs = midiLoader_.getPauseMicroseconds();
     
-    for (int verse = 0; verse < verses; verse++) {
-        stateMachine_.setRitardando(false);
+    // The last verse may be lowered by a command while playing
+    for (int verse = 0; verse < lastVerse_ && !cancelled_; verse++) {
+        if (isVerseSkipped(verse + VERSE_DISPLAY_OFFSET)) {
+            continue;
+        }
+        currentVerse_ = verse + VERSE_DISPLAY_OFFSET;
+        stateMachine_.startSection(false);
         setPlayerSpeed(baseSpeed_);
         
-        std::cout << _(" Playing verse ") << verse + VERSE_DISPLAY_OFFSET;
-        
-        if (verse == verses - VERSE_DISPLAY_OFFSET) {
+        if (verse == lastVerse_ - VERSE_DISPLAY_OFFSET) {
             stateMachine_.setLastVerse(true);
-            std::cout << _(", last verse");
+            console_.post(ConsoleMessage::PlayingLastVerse, verse + VERSE_DISPLAY_OFFSET);
+        } else {
+            console_.post(ConsoleMessage::PlayingVerse, verse + VERSE_DISPLAY_OFFSET);
         }
         
-        std::cout << std::endl;
-        
-        player_.Play();
+        if (jitterRecorder_) {
+            jitterRecorder_->beginSection(static_cast<uint16_t>(verse + VERSE_DISPLAY_OFFSET));
+        }
+        publishPosition(true);
+        player_.play();
         synchronizer_.wait();  // Wait for playback to finish
+        if (cancelled_) {
+            break;
+        }
         
         if (!stateMachine_.isLastVerse()) {
-            player_.Rewind();
+            rewindPlayer();
             
             // Pause before starting next verse
             if (pauseTicks.has_value()) {
-                std::this_thread::sleep_for(std::chrono::microseconds(pauseTicks.getTicks().value() * uSecPerTick));
+                std::this_thread::sleep_for(std::chrono::microseconds(pauseUs));
             }
         }
         
         // Handle D.C. al Fine (Da Capo al Fine - return to beginning until Fine)
         if (stateMachine_.isAlFine()) {
-            player_.Rewind();
-            player_.Play();
+            rewindPlayer();
+            player_.play();
             synchronizer_.wait();
         }
     }
 }
 
+void PlaybackOrchestrator::rewindPlayer() {
+    player_.rewind();
+    musicalDirector_.seekDirectives(0);
+}
+
 void PlaybackOrchestrator::setPlayerSpeed(float speedMultiplier) {
-    player_.SetSpeed(baseTempo_ * speedMultiplier);
+    player_.setSpeed(baseTempo_ * speedMultiplier);
 }
 
 } // namespace MidiPlay
\ No newline at end of file
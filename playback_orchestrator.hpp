@@ -1,11 +1,21 @@
 #pragma once
 
 #include <cxxmidi/player/player_sync.hpp>
-#include <cxxmidi/event.hpp>
 
+#include <atomic>
+#include <memory>
+
+#include "console_log.hpp"
+#include "event_view.hpp"
+#include "jitter_recorder.hpp"
 #include "midi_loader.hpp"
+#include "playback_command.hpp"
+#include "playback_engine.hpp"
+#include "playback_schedule.hpp"
+#include "player_sync_engine.hpp"
 #include "playback_synchronizer.hpp"
 #include "playback_state_machine.hpp"
+#include "position_observer.hpp"
 #include "musical_director.hpp"
 #include "ritardando_effector.hpp"
 
@@ -21,11 +31,36 @@ namespace MidiPlay {
  * 
  * The orchestrator sets up player callbacks that delegate to these
  * components and manages the high-level playback flow (intro → verses).
+ * 
+ * Engines that run a PlaybackSchedule get the whole plan at once and move
+ * between sections on their own thread; for the others the orchestrator
+ * rewinds, pauses and restarts the player after each section.
+ *
+ * Commands from a PlaybackCommandQueue (tempo, last verse, end after this
+ * verse, stop) are carried out on the player thread at the next heartbeat;
+ * taking them from the queue never blocks.
+ *
+ * Lines printed during playback (verse, ritardando, D.C. al Fine) go
+ * through a ConsoleLog, so a slow terminal never holds up the player thread.
+ *
+ * With a PositionObserver set, the position (verse, measure and beat, tick,
+ * tempo, ritardando) is published at every event and heartbeat for UIs to
+ * read on their own threads.
  */
 class PlaybackOrchestrator {
 public:
     /**
      * @brief Constructor with dependency injection
+     * @param engine Playback engine (already contains outport and file)
+     * @param synchronizer Reference to PlaybackSynchronizer for synchronization
+     * @param midiLoader Reference to MidiLoader for file metadata
+     */
+    PlaybackOrchestrator(PlaybackEngine& engine,
+                         PlaybackSynchronizer& synchronizer,
+                         const MidiLoader& midiLoader);
+    
+    /**
+     * @brief Constructor for a cxxmidi PlayerSync, wrapped in an owned PlayerSyncEngine
      * @param player Reference to cxxmidi PlayerSync instance (already contains outport)
      * @param synchronizer Reference to PlaybackSynchronizer for synchronization
      * @param midiLoader Reference to MidiLoader for file metadata
@@ -63,6 +98,7 @@ public:
      * - State management across playback sections
      */
     void executePlayback();
+
     
     /**
      * @brief Set whether warnings should be displayed
@@ -70,18 +106,61 @@ public:
     void setDisplayWarnings(bool display) { 
         stateMachine_.setDisplayWarnings(display); 
     }
+    
+    /**
+     * @brief Record send timing of every event, grouped by introduction and verse
+     * @param recorder Recorder that outlives playback, or nullptr
+     */
+    void setJitterRecorder(JitterRecorder* recorder);
+    
+    /**
+     * @brief Take live commands from a queue while playing
+     * @param queue Queue that outlives playback, or nullptr; this is its only consumer
+     */
+    void setCommandQueue(PlaybackCommandQueue* queue) { commands_ = queue; }
+    
+    /**
+     * @brief Publish the playback position while playing
+     * @param observer Observer that outlives playback, or nullptr; this is its only writer
+     */
+    void setPositionObserver(PositionObserver* observer) { positionObserver_ = observer; }
+    
+    /**
+     * @brief Stop playback and make executePlayback() return
+     * Silences the notes left sounding; the remaining sections are not played.
+     * Sends to the port, so call it where nothing else sends: on the player
+     * thread (a Stop command does), or while the player is stopped. Other
+     * threads post a Stop command instead.
+     */
+    void cancel();
+    
+    bool isCancelled() const { return cancelled_.load(); }
 
 private:
     // === Dependency References ===
-    cxxmidi::player::PlayerSync& player_;  // Contains outport internally
+    std::unique_ptr<PlayerSyncEngine> ownedEngine_;  // Only set by the PlayerSync constructor; declared before player_
+    PlaybackEngine& player_;  // Contains outport internally
     PlaybackSynchronizer& synchronizer_;
     const MidiLoader& midiLoader_;
     
     // === Owned Components ===
+    ConsoleLog console_;            // Written by a drain thread while executePlayback() runs
     PlaybackStateMachine stateMachine_;
     MusicalDirector musicalDirector_;
     RitardandoEffector ritardandoEffector_;
     
+    JitterRecorder* jitterRecorder_{nullptr};
+    PlaybackCommandQueue* commands_{nullptr};
+    PositionObserver* positionObserver_{nullptr};
+    std::atomic<bool> cancelled_{false};
+    
+    // === Verse State (player thread) ===
+    int currentVerse_{0};                   // 0 during the introduction
+    std::atomic<int> lastVerse_{0};         // Number of the verse that ends the hymn; lowered by EndAfterVerse
+    std::atomic<int> skipToVerse_{0};       // Verses before this one are skipped (LastVerse)
+    int tempoPercent_{0};                   // Sum of Tempo commands
+    bool heartbeatNeeded_{false};           // Last told to a tickless engine
+    
     // === Timing State ===
     float baseSpeed_{1.0f};       // Base tempo multiplier
     float baseTempo_{1.0f};       // Original player tempo
@@ -92,12 +171,33 @@ private:
      */
     void heartbeatCallback();
     
+    /**
+     * @brief Tell the engine whether the ritardando needs heartbeats, when that changes
+     */
+    void updateHeartbeatNeed();
+    
+    /**
+     * @brief Publish where playback is, if a position observer is set
+     * @param playing false once a section has finished
+     */
+    void publishPosition(bool playing);
+    
+    /**
+     * @brief Carry out every queued command
+     */
+    void applyCommands();
+    
+    /**
+     * @brief Whether a verse is left out after LastVerse or EndAfterVerse
+     */
+    bool isVerseSkipped(int verse) const;
+    
     /**
      * @brief Event callback - delegates to musicalDirector_
      * @param event MIDI event being processed
      * @return true to send event to device, false to suppress
      */
-    bool eventCallback(cxxmidi::Event& event);
+    bool eventCallback(const EventView& event);
     
     /**
      * @brief Finished callback - signals playback completion
@@ -105,6 +205,24 @@ private:
     void finishedCallback();
     
     // === Playback Flow Methods ===
+    /**
+     * @brief Play every section of the schedule on the engine's thread
+     * @return false if the engine cannot run schedules
+     */
+    bool playSchedule();
+    
+    /**
+     * @brief Prepare state for a section about to start
+     * Runs on the player thread when the engine runs the schedule
+     * @return false to skip the section (D.C. al Fine marker not reached)
+     */
+    bool startSection(const ScheduledSection& section);
+    
+    /**
+     * @brief Play the schedule, or the introduction and verses one by one
+     */
+    void playSections();
+    
     /**
      * @brief Play introduction section with marker-based jumping
      */
@@ -115,6 +233,11 @@ private:
      */
     void playVerses();
     
+    /**
+     * @brief Rewind the player and the musical director's directive cursor
+     */
+    void rewindPlayer();
+    
     /**
      * @brief Set player speed (combines base tempo and speed multiplier)
      */
@@ -122,6 +245,7 @@ private:
     
     // === Constants ===
     static constexpr int VERSE_DISPLAY_OFFSET = 1;
+    static constexpr int MAX_TEMPO_PERCENT = 25;    // Limit of Tempo commands, up or down
 };
 
 } // namespace MidiPlay
\ No newline at end of file
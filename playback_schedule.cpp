@@ -0,0 +1,39 @@
+#include "playback_schedule.hpp"
+#include "midi_loader.hpp"
+
+#include <algorithm>
+
+namespace MidiPlay {
+
+PlaybackSchedule::PlaybackSchedule(const MidiLoader& midiLoader) {
+    uint64_t pauseUs = midiLoader.getPauseMicroseconds();
+    
+    if (midiLoader.shouldPlayIntro()) {
+        const std::vector<IntroductionSegment>& introSegments = midiLoader.getIntroSegments();
+        uint32_t start = introSegments.empty() ? 0 : introSegments.front().start;
+        sections_.push_back({ScheduledSection::Kind::Introduction, 0, start, pauseUs});
+    }
+    
+    int verses = midiLoader.getVerses();
+    for (int verse = 1; verse <= verses; verse++) {
+        sections_.push_back({ScheduledSection::Kind::Verse, static_cast<uint16_t>(verse), 0,
+                             verse < verses ? pauseUs : 0});
+    }
+    
+    // D.C. al Fine goes straight back to the beginning, without a pause
+    const std::vector<Directive>& directives = midiLoader.getDirectives();
+    bool daCapo = std::any_of(directives.begin(), directives.end(),
+                              [](const Directive& directive) { return directive.kind == DirectiveKind::DaCapoAlFine; });
+    if (daCapo && verses > 0) {
+        sections_.push_back({ScheduledSection::Kind::AlFine, static_cast<uint16_t>(verses), 0, 0});
+    }
+}
+
+uint64_t PlaybackSchedule::pauseMicroseconds(uint32_t ticks, uint32_t uSecPerQuarter, uint16_t ppq) {
+    if (ppq == 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ticks) * uSecPerQuarter / ppq;
+}
+
+} // namespace MidiPlay
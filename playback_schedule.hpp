@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace MidiPlay {
+
+class MidiLoader;
+
+/**
+ * @brief One pass through the piece within a PlaybackSchedule
+ */
+struct ScheduledSection {
+    enum class Kind : uint8_t {
+        Introduction,
+        Verse,
+        AlFine          // Return to the beginning after D.C. al Fine, played only if the marker was reached
+    };
+    
+    Kind kind;
+    uint16_t number;        // Section number for display and jitter reports: 0 for the introduction, verse from 1
+    uint32_t startTick;
+    uint64_t pauseAfterUs;  // Wall clock silence between the end of this section and the start of the next
+};
+
+/**
+ * @brief The whole intro → pause → verse → pause → verse plan of a loaded file
+ * 
+ * Compiled once before playback so an engine can run every section back to
+ * back on its own thread, starting each one at an absolute deadline: the
+ * scheduled end of the previous section plus its pause. Pauses are computed
+ * from the pause ticks at the file's tempo in one step, not from the
+ * truncated microseconds per tick.
+ */
+class PlaybackSchedule {
+public:
+    /**
+     * @brief Called on the player thread when a section is about to start
+     * 
+     * Runs as soon as the previous section ends, before the pause, so it never
+     * delays the first event of the section.
+     * @return false to skip the section
+     */
+    using SectionCallback = std::function<bool(const ScheduledSection&)>;
+    
+    PlaybackSchedule() = default;
+    
+    /**
+     * @brief Compile the plan for the options the file was loaded with
+     */
+    explicit PlaybackSchedule(const MidiLoader& midiLoader);
+    
+    size_t size() const { return sections_.size(); }
+    bool empty() const { return sections_.empty(); }
+    const ScheduledSection& operator[](size_t index) const { return sections_[index]; }
+    
+    std::vector<ScheduledSection>::const_iterator begin() const { return sections_.begin(); }
+    std::vector<ScheduledSection>::const_iterator end() const { return sections_.end(); }
+    
+    void add(const ScheduledSection& section) { sections_.push_back(section); }
+    
+    /**
+     * @brief Duration of a pause in microseconds
+     */
+    static uint64_t pauseMicroseconds(uint32_t ticks, uint32_t uSecPerQuarter, uint16_t ppq);
+
+private:
+    std::vector<ScheduledSection> sections_;
+};
+
+} // namespace MidiPlay
@@ -1,54 +1,119 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 namespace MidiPlay {
 
 /**
  * @brief Centralized playback state management
- * 
+ *
  * Manages all boolean state flags for playback control.
  * Provides single source of truth for playback state with
  * clear getters and setters for each state variable.
+ *
+ * The flags are bits of one atomic word: the orchestrator sets them up on
+ * the main thread while the musical director and the ritardando effector
+ * read and change them from player callbacks, and UIs may look at them
+ * from anywhere. Each setter is a single read-modify-write that leaves the
+ * other bits alone; changes that depend on the current state
+ * (startSection(), startRitardando()) are one compare-and-swap, so no
+ * thread can slip a change in between the test and the update. Writes are
+ * release and reads acquire, so whatever a thread did before changing a
+ * flag is visible to the thread that sees the change. No lock is taken.
  */
 class PlaybackStateMachine {
 public:
+    /**
+     * @brief Bits of the state word
+     */
+    enum Flag : uint8_t {
+        PLAYING_INTRO = 1 << 0,     // Currently playing introduction section
+        RITARDANDO = 1 << 1,        // Ritardando (gradual slowdown) is active
+        LAST_VERSE = 1 << 2,        // Currently playing the last verse
+        AL_FINE = 1 << 3,           // D.C. al Fine (Da Capo al Fine) mode active
+        DISPLAY_WARNINGS = 1 << 4,  // Whether to display warnings
+    };
+
     PlaybackStateMachine() = default;
     ~PlaybackStateMachine() = default;
-    
+
     // Disable copy/move
     PlaybackStateMachine(const PlaybackStateMachine&) = delete;
     PlaybackStateMachine& operator=(const PlaybackStateMachine&) = delete;
-    
+
     // === State Getters ===
-    bool isPlayingIntro() const { return playingIntro_; }
-    bool isRitardando() const { return ritardando_; }
-    bool isLastVerse() const { return lastVerse_; }
-    bool isAlFine() const { return alFine_; }
-    bool shouldDisplayWarnings() const { return displayWarnings_; }
-    
+    bool isPlayingIntro() const { return has(PLAYING_INTRO); }
+    bool isRitardando() const { return has(RITARDANDO); }
+    bool isLastVerse() const { return has(LAST_VERSE); }
+    bool isAlFine() const { return has(AL_FINE); }
+    bool shouldDisplayWarnings() const { return has(DISPLAY_WARNINGS); }
+
+    /**
+     * @brief Every flag at once, for reading several consistently
+     */
+    uint8_t snapshot() const { return state_.load(std::memory_order_acquire); }
+
     // === State Setters ===
-    void setPlayingIntro(bool playing) { playingIntro_ = playing; }
-    void setRitardando(bool active) { ritardando_ = active; }
-    void setLastVerse(bool isLast) { lastVerse_ = isLast; }
-    void setAlFine(bool active) { alFine_ = active; }
-    void setDisplayWarnings(bool display) { displayWarnings_ = display; }
-    
+    void setPlayingIntro(bool playing) { set(PLAYING_INTRO, playing); }
+    void setRitardando(bool active) { set(RITARDANDO, active); }
+    void setLastVerse(bool isLast) { set(LAST_VERSE, isLast); }
+    void setAlFine(bool active) { set(AL_FINE, active); }
+    void setDisplayWarnings(bool display) { set(DISPLAY_WARNINGS, display); }
+
     // === Composite Operations ===
+    /**
+     * @brief Enter the introduction or a verse: intro flag set accordingly, no ritardando
+     */
+    void startSection(bool intro) {
+        update([intro](uint8_t state) -> uint8_t {
+            state &= static_cast<uint8_t>(~(PLAYING_INTRO | RITARDANDO));
+            return intro ? state | PLAYING_INTRO : state;
+        });
+    }
+
+    /**
+     * @brief Start a ritardando if the introduction or the last verse is playing
+     * @return false if neither is, leaving the state unchanged
+     */
+    bool startRitardando() {
+        uint8_t state = state_.load(std::memory_order_relaxed);
+        do {
+            if (!(state & (PLAYING_INTRO | LAST_VERSE))) {
+                return false;
+            }
+        } while (!state_.compare_exchange_weak(state, state | RITARDANDO,
+                                               std::memory_order_acq_rel, std::memory_order_relaxed));
+        return true;
+    }
+
     /**
      * @brief Reset all state flags to initial values
      */
     void reset() {
-        playingIntro_ = false;
-        ritardando_ = false;
-        lastVerse_ = false;
-        alFine_ = false;
+        state_.fetch_and(DISPLAY_WARNINGS, std::memory_order_acq_rel);
     }
-    
+
 private:
-    bool playingIntro_{false};      // Currently playing introduction section
-    bool ritardando_{false};        // Ritardando (gradual slowdown) is active
-    bool lastVerse_{false};         // Currently playing the last verse
-    bool alFine_{false};            // D.C. al Fine (Da Capo al Fine) mode active
-    bool displayWarnings_{false};   // Whether to display warnings
+    bool has(Flag flag) const { return (state_.load(std::memory_order_acquire) & flag) != 0; }
+
+    void set(Flag flag, bool value) {
+        if (value) {
+            state_.fetch_or(flag, std::memory_order_acq_rel);
+        } else {
+            state_.fetch_and(static_cast<uint8_t>(~flag), std::memory_order_acq_rel);
+        }
+    }
+
+    template<typename Transition>
+    void update(Transition transition) {
+        uint8_t state = state_.load(std::memory_order_relaxed);
+        while (!state_.compare_exchange_weak(state, transition(state),
+                                             std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::atomic<uint8_t> state_{0};
 };
 
-} // namespace MidiPlay
\ No newline at end of file
+} // namespace MidiPlay
@@ -2,7 +2,7 @@
 
 namespace MidiPlay {
 
-void PlaybackSynchronizer::wait() {
+void MutexPlaybackSynchronizer::wait() {
     std::unique_lock<std::mutex> lock(mutex_);
     
     // Wait until finished_ becomes true
@@ -14,7 +14,7 @@ void PlaybackSynchronizer::wait() {
     finished_ = false;
 }
 
-void PlaybackSynchronizer::notify() {
+void MutexPlaybackSynchronizer::notify() {
     {
         // Acquire lock, set flag, release lock
         std::lock_guard<std::mutex> lock(mutex_);
@@ -25,9 +25,25 @@ void PlaybackSynchronizer::notify() {
     cv_.notify_one();
 }
 
-void PlaybackSynchronizer::reset() {
+void MutexPlaybackSynchronizer::reset() {
     std::lock_guard<std::mutex> lock(mutex_);
     finished_ = false;
 }
 
+void AtomicPlaybackSynchronizer::wait() {
+    // Consume the flag; sleep while it is 0 (a spurious return just loops)
+    while (finished_.exchange(0, std::memory_order_acquire) == 0) {
+        finished_.wait(0, std::memory_order_acquire);
+    }
+}
+
+void AtomicPlaybackSynchronizer::notify() {
+    finished_.store(1, std::memory_order_release);
+    finished_.notify_one();
+}
+
+void AtomicPlaybackSynchronizer::reset() {
+    finished_.store(0, std::memory_order_relaxed);
+}
+
 } // namespace MidiPlay
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 
@@ -22,8 +23,12 @@ namespace MidiPlay {
  * 
  * Thread-safe: All methods can be called from multiple threads safely.
  * Exception-safe: Uses RAII lock guards, no manual cleanup required.
+ * 
+ * notify() takes the mutex, so it must not be called from a signal handler;
+ * PlaybackSynchronizer is AtomicPlaybackSynchronizer for that reason. Kept
+ * for comparison (see the latency benchmark in test_playback_synchronizer.cpp).
  */
-class PlaybackSynchronizer {
+class MutexPlaybackSynchronizer {
 public:
     /**
      * @brief Constructor - initializes synchronization state
@@ -31,7 +36,7 @@ public:
      * Creates a new synchronizer with finished_ = false.
      * No manual initialization required (unlike sem_init).
      */
-    PlaybackSynchronizer() = default;
+    MutexPlaybackSynchronizer() = default;
     
     /**
      * @brief Destructor - automatic cleanup
@@ -39,13 +44,13 @@ public:
      * RAII ensures proper cleanup with no manual destruction needed
      * (unlike sem_destroy).
      */
-    ~PlaybackSynchronizer() = default;
+    ~MutexPlaybackSynchronizer() = default;
     
     // Delete copy/move to prevent synchronization issues
-    PlaybackSynchronizer(const PlaybackSynchronizer&) = delete;
-    PlaybackSynchronizer& operator=(const PlaybackSynchronizer&) = delete;
-    PlaybackSynchronizer(PlaybackSynchronizer&&) = delete;
-    PlaybackSynchronizer& operator=(PlaybackSynchronizer&&) = delete;
+    MutexPlaybackSynchronizer(const MutexPlaybackSynchronizer&) = delete;
+    MutexPlaybackSynchronizer& operator=(const MutexPlaybackSynchronizer&) = delete;
+    MutexPlaybackSynchronizer(MutexPlaybackSynchronizer&&) = delete;
+    MutexPlaybackSynchronizer& operator=(MutexPlaybackSynchronizer&&) = delete;
     
     /**
      * @brief Wait for playback completion or interruption
@@ -66,7 +71,7 @@ public:
      * @brief Signal playback completion or interruption
      * 
      * Wakes up one thread waiting in wait().
-     * Can be safely called from signal handlers or callbacks.
+     * Can be called from callbacks; not async-signal-safe.
      * 
      * Thread-safe: Can be called from any thread at any time.
      * Safe to call even if no thread is waiting.
@@ -91,4 +96,53 @@ private:
     bool finished_ = false;             // Playback completion flag
 };
 
+/**
+ * @brief Wait/notify on a single atomic word (C++20 std::atomic::wait)
+ * 
+ * Same contract as MutexPlaybackSynchronizer. notify() is a release store
+ * and std::atomic::notify_one(), which on Linux is a FUTEX_WAKE on the
+ * word itself: no lock is taken, so it is async-signal-safe and can be
+ * called from the SIGINT handler. A waiter sleeps in FUTEX_WAIT and wakes
+ * straight from the kernel, without reacquiring a mutex.
+ * 
+ * The flag is an int, std::atomic's native wait type on Linux, so waiting
+ * and notifying go to the futex directly rather than through a proxy.
+ */
+class AtomicPlaybackSynchronizer {
+public:
+    AtomicPlaybackSynchronizer() = default;
+    ~AtomicPlaybackSynchronizer() = default;
+    
+    // Delete copy/move to prevent synchronization issues
+    AtomicPlaybackSynchronizer(const AtomicPlaybackSynchronizer&) = delete;
+    AtomicPlaybackSynchronizer& operator=(const AtomicPlaybackSynchronizer&) = delete;
+    AtomicPlaybackSynchronizer(AtomicPlaybackSynchronizer&&) = delete;
+    AtomicPlaybackSynchronizer& operator=(AtomicPlaybackSynchronizer&&) = delete;
+    
+    /**
+     * @brief Block until notify(), then reset for the next cycle
+     */
+    void wait();
+    
+    /**
+     * @brief Wake the waiting thread; async-signal-safe
+     */
+    void notify();
+    
+    /**
+     * @brief Forget a notify() that no wait() has consumed yet
+     */
+    void reset();
+    
+private:
+    static_assert(std::atomic<int>::is_always_lock_free, "notify() must not take a lock");
+    
+    std::atomic<int> finished_{0};      // 1 between notify() and the wait() that consumes it
+};
+
+/**
+ * @brief The synchronizer used for playback: signal-safe and lowest latency
+ */
+using PlaybackSynchronizer = AtomicPlaybackSynchronizer;
+
 } // namespace MidiPlay
\ No newline at end of file
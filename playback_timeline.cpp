@@ -0,0 +1,188 @@
+#include "playback_timeline.hpp"
+
+#include <cxxmidi/message.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+using cxxmidi::Message;
+
+namespace MidiPlay {
+
+PlaybackTimeline::PlaybackTimeline() = default;
+
+PlaybackTimeline::PlaybackTimeline(const cxxmidi::File& file)
+    : PlaybackTimeline(EventArena(file))
+{
+}
+
+PlaybackTimeline::PlaybackTimeline(const EventArena& events)
+    : PlaybackTimeline()
+{
+    tempoMap_ = TempoMap(events.getTimeDivision());
+
+    // Position of each track's next event
+    struct Cursor {
+        size_t index = 0;
+        uint32_t nextTick = 0;
+    };
+    size_t trackCount = events.getTrackCount();
+    std::vector<Cursor> cursors(trackCount);
+
+    size_t longMessageBytes = 0;
+    for (size_t t = 0; t < trackCount; t++) {
+        for (size_t i = 0; i < events.getTrackSize(t); i++) {
+            size_t size = events.at(t, i).size();
+            if (size > PackedEvent::INLINE_BYTES) {
+                longMessageBytes += size;
+            }
+        }
+        if (events.getTrackSize(t) > 0) {
+            cursors[t].nextTick = events.at(t, 0).dt();
+        }
+    }
+
+    events_.reserve(events.size(), PackedEvents::sideBytesFor(longMessageBytes));
+
+    while (true) {
+        // Few tracks, so a linear scan for the earliest one is cheapest.
+        // Strict comparison keeps the lower track first on equal ticks.
+        size_t track = trackCount;
+        uint32_t tick = std::numeric_limits<uint32_t>::max();
+        for (size_t t = 0; t < trackCount; t++) {
+            if (cursors[t].index < events.getTrackSize(t) && cursors[t].nextTick < tick) {
+                track = t;
+                tick = cursors[t].nextTick;
+            }
+        }
+        if (track == trackCount) {
+            break;
+        }
+
+        Cursor& cursor = cursors[track];
+        EventView view = events.at(track, cursor.index++);
+        if (cursor.index < events.getTrackSize(track)) {
+            cursor.nextTick += events.at(track, cursor.index).dt();
+        }
+
+        appendedEndTick_ = std::max(appendedEndTick_, tick);
+
+        if (view.isMeta(Message::MetaType::EndOfTrack)) {
+            continue;
+        }
+
+        if (view.isMeta(Message::MetaType::Tempo) && view.size() >= 5) {
+            uint32_t uSecPerQuarter = (static_cast<uint32_t>(view[2]) << 16)
+                                    | (static_cast<uint32_t>(view[3]) << 8)
+                                    | static_cast<uint32_t>(view[4]);
+            tempoMap_.add(tick, uSecPerQuarter);   // Merged in tick order, so appending keeps it sorted
+        }
+
+        if (!view.isMeta() && !view.isSysex() && !view.empty()) {
+            appendedChannels_ |= static_cast<uint16_t>(1u << (view.status() & 0x0F));
+        }
+
+        events_.append(tick, view.data(), view.size());
+    }
+
+    complete();
+}
+
+PlaybackTimeline::PlaybackTimeline(uint16_t ppq, size_t eventCapacity, size_t byteCapacity)
+    : PlaybackTimeline()
+{
+    tempoMap_ = TempoMap(ppq);
+    complete_.store(false, std::memory_order_relaxed);
+
+    // Fixed capacity: published events must never move under a reader
+    events_.reserve(eventCapacity, PackedEvents::sideBytesFor(byteCapacity));
+}
+
+void PlaybackTimeline::setTempoMap(TempoMap tempoMap) {
+    tempoMap_ = std::move(tempoMap);
+}
+
+void PlaybackTimeline::append(uint32_t tick, const uint8_t* data, size_t size) {
+    if (!events_.fits(size)) {
+        throw std::length_error("PlaybackTimeline capacity exceeded");
+    }
+
+    EventView view(data, size, 0);
+    if (!view.isMeta() && !view.isSysex() && !view.empty()) {
+        appendedChannels_ |= static_cast<uint16_t>(1u << (view.status() & 0x0F));
+    }
+    appendedEndTick_ = std::max(appendedEndTick_, tick);
+
+    events_.append(tick, data, size);
+}
+
+void PlaybackTimeline::extendTo(uint32_t tick) {
+    appendedEndTick_ = std::max(appendedEndTick_, tick);
+}
+
+void PlaybackTimeline::publish() {
+    // Written by the producer only, so reading the vectors' sizes here is safe
+    endTick_.store(appendedEndTick_, std::memory_order_release);
+    endUs_.store(timeAtTick(appendedEndTick_), std::memory_order_release);
+    channelMask_.store(appendedChannels_, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(publishMutex_);
+        published_.store(events_.size(), std::memory_order_release);
+    }
+    publishedCv_.notify_all();
+}
+
+void PlaybackTimeline::complete() {
+    publish();
+    {
+        std::lock_guard<std::mutex> lock(publishMutex_);
+        complete_.store(true, std::memory_order_release);
+    }
+    publishedCv_.notify_all();
+}
+
+void PlaybackTimeline::waitForTick(uint32_t tick) const {
+    std::unique_lock<std::mutex> lock(publishMutex_);
+    publishedCv_.wait(lock, [this, tick]() {
+        size_t count = published_.load(std::memory_order_acquire);
+        return complete_.load(std::memory_order_acquire) || (count > 0 && events_.tickAt(count - 1) >= tick);
+    });
+}
+
+void PlaybackTimeline::waitForMore(size_t count, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(publishMutex_);
+    publishedCv_.wait_for(lock, timeout, [this, count]() {
+        return complete_.load(std::memory_order_acquire) || published_.load(std::memory_order_acquire) > count;
+    });
+}
+
+size_t PlaybackTimeline::indexAtTick(uint32_t tick) const {
+    const PackedEvent* first = events_.data();
+    const PackedEvent* last = first + size();
+    auto position = std::lower_bound(first, last, tick,
+                                     [](const PackedEvent& event, uint32_t value) { return event.tick < value; });
+    return static_cast<size_t>(position - first);
+}
+
+uint32_t PlaybackTimeline::barStartAtOrBefore(uint32_t tick) const {
+    uint32_t meterStart = 0;                            // Tick of the time signature in effect
+    uint32_t barTicks = tempoMap_.getPpq() * 4u;        // 4/4 until the file says otherwise
+
+    size_t count = size();
+    for (size_t index = 0; index < count && tickAt(index) <= tick; index++) {
+        EventView event = eventAt(index);
+        // Numerator, then the denominator as a power of two
+        if (event.isMeta(Message::MetaType::TimeSignature) && event.size() >= 4 && event[3] < 8) {
+            meterStart = tickAt(index);
+            barTicks = tempoMap_.getPpq() * 4u * event[2] >> event[3];
+        }
+    }
+    if (barTicks == 0) {
+        return meterStart;
+    }
+    return meterStart + (tick - meterStart) / barTicks * barTicks;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cxxmidi/file.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "event_arena.hpp"
+#include "event_view.hpp"
+#include "packed_events.hpp"
+#include "tempo_map.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief All tracks of a loaded file merged into one pre-timed event list
+ *
+ * Built once after loading. Events are ordered as PlayerSync would emit
+ * them (absolute tick, then track, then position in the track) as
+ * PackedEvent records holding the absolute tick, 8 bytes per channel
+ * message; meta and SysEx bytes go to the side table. Times come from the
+ * file's tempo map, whose last tempo is found without a search, so a player
+ * walks it linearly without any per-event delta arithmetic.
+ *
+ * Tempo meta events stay in the timeline so callbacks see every event,
+ * but their effect is already folded into the timestamps. End-of-track
+ * events are dropped; their position is kept as the end of the piece.
+ *
+ * A streaming load (StreamingLoader) fills a timeline while it plays: the
+ * tempo map and capacity are fixed up front, then one producer thread
+ * append()s events in timeline order and publish()es them in steps.
+ * Readers only ever see published events, which never move, so they need
+ * no lock; size() grows until complete(). A timeline built from a file is
+ * complete from the start.
+ */
+class PlaybackTimeline {
+public:
+    PlaybackTimeline();
+
+    /**
+     * @brief Merge and time every track of a file
+     * @param file Loaded MIDI file (PPQ time division)
+     */
+    explicit PlaybackTimeline(const cxxmidi::File& file);
+
+    /**
+     * @brief Merge and time every track of a loaded file's arena
+     */
+    explicit PlaybackTimeline(const EventArena& events);
+
+    /**
+     * @brief Empty timeline for a streaming load
+     * @param ppq Time division of the file
+     * @param eventCapacity Events that will be appended, end-of-track events excluded
+     * @param byteCapacity Message bytes of those events; only the long messages' are kept apart
+     */
+    PlaybackTimeline(uint16_t ppq, size_t eventCapacity, size_t byteCapacity);
+
+    PlaybackTimeline(const PlaybackTimeline&) = delete;
+    PlaybackTimeline& operator=(const PlaybackTimeline&) = delete;
+
+    /**
+     * @brief Published events
+     */
+    size_t size() const { return published_.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    uint32_t tickAt(size_t index) const { return events_.tickAt(index); }
+    uint64_t timeAt(size_t index) const { return tempoMap_.timeAt(events_.tickAt(index)); }
+
+    /**
+     * @brief Bytes of one event
+     */
+    EventView eventAt(size_t index) const {
+        uint32_t tick = events_.tickAt(index);
+        return events_.viewAt(index, index == 0 ? tick : tick - events_.tickAt(index - 1));
+    }
+
+    /**
+     * @brief Index of the first event at or after a tick
+     * @return size() if no event is that late
+     */
+    size_t indexAtTick(uint32_t tick) const;
+
+    /**
+     * @brief First tick of the bar a tick falls in
+     *
+     * Bars are counted from each time signature event, which is taken to
+     * start a bar, in 4/4 before the first. Reads the events up to @p tick.
+     */
+    uint32_t barStartAtOrBefore(uint32_t tick) const;
+
+    // === Streaming load; producer thread only ===
+
+    /**
+     * @brief Set the file's tempo map; before the first append()
+     */
+    void setTempoMap(TempoMap tempoMap);
+
+    /**
+     * @brief Append an event; ticks must not decrease
+     * @throws std::length_error beyond the capacity given to the constructor
+     */
+    void append(uint32_t tick, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Note the end of a track; the latest one is the end of the piece
+     */
+    void extendTo(uint32_t tick);
+
+    /**
+     * @brief Make everything appended so far visible to readers
+     *
+     * Publish only between ticks: a player takes all published events at a tick as one batch.
+     */
+    void publish();
+
+    /**
+     * @brief Publish the rest and mark the timeline final
+     */
+    void complete();
+
+    // === Streaming load; readers ===
+
+    bool isComplete() const { return complete_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Wait until an event at or after @p tick is published, or the timeline is complete
+     */
+    void waitForTick(uint32_t tick) const;
+
+    /**
+     * @brief Wait until more than @p count events are published, the timeline is complete or time runs out
+     */
+    void waitForMore(size_t count, std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Absolute time of a tick under the tempo map
+     */
+    uint64_t timeAtTick(uint32_t tick) const { return tempoMap_.timeAt(tick); }
+
+    /**
+     * @brief Tempo changes the timestamps were computed from
+     */
+    const TempoMap& getTempoMap() const { return tempoMap_; }
+
+    /**
+     * @brief End of the piece; while streaming, of what is published so far
+     */
+    uint32_t getEndTick() const { return endTick_.load(std::memory_order_acquire); }
+    uint64_t getEndTime() const { return endUs_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Channels used by voice messages, bit n for channel n
+     */
+    uint16_t getChannelMask() const { return channelMask_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Bytes held, including unused capacity
+     */
+    size_t getMemoryBytes() const {
+        return events_.getMemoryBytes() + tempoMap_.size() * (sizeof(TempoChange) + sizeof(uint64_t));
+    }
+
+private:
+    PackedEvents events_;              // Tick field holds the absolute tick
+
+    TempoMap tempoMap_;
+    std::atomic<uint32_t> endTick_{0};
+    std::atomic<uint64_t> endUs_{0};
+    std::atomic<uint16_t> channelMask_{0};
+
+    // Streaming load
+    std::atomic<size_t> published_{0};
+    std::atomic<bool> complete_{true};
+    uint32_t appendedEndTick_ = 0;      // Producer's end tick, published with the events
+    uint16_t appendedChannels_ = 0;
+    mutable std::mutex publishMutex_;
+    mutable std::condition_variable publishedCv_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cxxmidi/player/player_sync.hpp>
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/message.hpp>
+#include <cxxmidi/output/abstract.hpp>
+
+#include "active_notes.hpp"
+#include "jitter_recorder.hpp"
+#include "playback_engine.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief PlaybackEngine adapter over cxxmidi::player::PlayerSync
+ *
+ * Forwarding; the wrapped player keeps walking the per-track event lists
+ * exactly as before. The player must outlive the adapter.
+ * 
+ * Releasing only the held notes needs the output port the player sends
+ * to; without it notesOff() falls back to PlayerSync::NotesOff().
+ * 
+ * PlayerSync does not expose when it meant to send an event, so for jitter
+ * recording the adapter anchors (wall clock, position, speed) at every
+ * play, seek and speed change and derives the scheduled time of each event
+ * from its position. The sample is taken in the event callback, right
+ * before PlayerSync sends.
+ */
+class PlayerSyncEngine : public PlaybackEngine {
+public:
+    /**
+     * @param player Player to drive
+     * @param output Port the player sends to, for releasing held notes (optional)
+     */
+    explicit PlayerSyncEngine(cxxmidi::player::PlayerSync& player,
+                              cxxmidi::output::Abstract* output = nullptr)
+        : player_(player)
+        , output_(output)
+    {
+    }
+
+    void play() override { anchor(); player_.Play(); }
+    void stop() override { player_.Stop(); }
+    void finish() override { player_.Finish(); }
+    void rewind() override { player_.Rewind(); anchor(); }
+    void goToTick(uint32_t tick) override { player_.GoToTick(tick); anchor(); }
+    void notesOff() override {
+        if (notes_ && output_) {
+            notes_->release(*output_, releaseMessage_, true);
+        } else {
+            player_.NotesOff();
+        }
+    }
+
+    void releaseHeldNotes() override {
+        if (notes_ && output_) {
+            notes_->release(*output_, releaseMessage_);
+        }
+    }
+
+    void setSpeed(float speed) override { player_.SetSpeed(speed); anchor(); }
+    float getSpeed() const override { return player_.GetSpeed(); }
+
+    std::chrono::microseconds currentTimePos() const override { return player_.CurrentTimePos(); }
+
+    void setCallbackHeartbeat(const Callback& callback) override {
+        player_.SetCallbackHeartbeat(callback);
+    }
+
+    void setCallbackFinished(const Callback& callback) override {
+        player_.SetCallbackFinished(callback);
+    }
+
+    void setCallbackEvent(const EventCallback& callback) override {
+        if (!callback) {
+            player_.SetCallbackEvent(nullptr);
+            return;
+        }
+        player_.SetCallbackEvent([this, callback](cxxmidi::Event& event) -> bool {
+            EventView view(event);
+            if (!callback(view)) {
+                return false;
+            }
+            if (!view.isMeta()) {
+                if (notes_) {
+                    notes_->observe(view);
+                }
+                if (recorder_) {
+                    recorder_->record(scheduledNs(), JitterRecorder::now());
+                }
+            }
+            return true;
+        });
+    }
+
+    void setJitterRecorder(JitterRecorder* recorder) override {
+        recorder_ = recorder;
+        anchor();
+    }
+
+    void setActiveNotes(ActiveNotes* notes) override { notes_ = notes; }
+
+    // PlayerSync ends every pass through the finished callback; sections are sequenced by the caller
+    bool setSchedule(const PlaybackSchedule&, const PlaybackSchedule::SectionCallback&) override { return false; }
+
+    cxxmidi::player::PlayerSync& getPlayer() { return player_; }
+
+private:
+    void anchor() {
+        if (recorder_) {
+            anchorNs_ = JitterRecorder::now();
+            anchorPos_ = player_.CurrentTimePos();
+            anchorSpeed_ = player_.GetSpeed();
+        }
+    }
+
+    int64_t scheduledNs() const {
+        std::chrono::nanoseconds pieceNs = player_.CurrentTimePos() - anchorPos_;
+        return anchorNs_ + static_cast<int64_t>(pieceNs.count() / anchorSpeed_);
+    }
+
+    cxxmidi::player::PlayerSync& player_;
+    cxxmidi::output::Abstract* output_;
+    ActiveNotes* notes_ = nullptr;
+    cxxmidi::Message releaseMessage_ = cxxmidi::Message(0, 0, 0);  // Preallocated: releasing does not allocate
+
+    // Jitter recording; touched only by the player thread once playing
+    JitterRecorder* recorder_ = nullptr;
+    int64_t anchorNs_ = 0;
+    std::chrono::microseconds anchorPos_{0};
+    float anchorSpeed_ = 1.0f;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,27 @@
+#include "port_recovery.hpp"
+
+#include <algorithm>
+
+namespace MidiPlay {
+
+bool PortRecovery::markLost() {
+    if (!callback_ || lost_) {
+        return false;
+    }
+    lost_ = true;
+    return true;
+}
+
+bool PortRecovery::reconnect() {
+    if (!callback_()) {
+        return false;
+    }
+    reconnects_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t PortRecovery::resumeTick(const PlaybackTimeline& timeline, size_t reached, size_t runStart) {
+    return std::max(timeline.barStartAtOrBefore(timeline.tickAt(reached - 1)), timeline.tickAt(runStart));
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "playback_timeline.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Brings the player back after its port stopped delivering
+ *
+ * Once the port is marked lost the player stops sending and runs the
+ * reconnect callback on its own thread. When the port is back it silences
+ * what was held and plays on from resumeTick(), after sending the
+ * controller state the file has there in full, as the organ may have lost
+ * it with the connection.
+ *
+ * The lost mark is guarded by the player's mutex; reconnect() runs without it.
+ */
+class PortRecovery {
+public:
+    /**
+     * @return true once the device is back; false to give up
+     */
+    using ReconnectCallback = std::function<bool()>;
+
+    void setCallback(const ReconnectCallback& callback) { callback_ = callback; }
+
+    /**
+     * @brief Mark the port lost
+     * @return false without a callback, or if it is already marked
+     */
+    bool markLost();
+    bool isLost() const { return lost_; }
+
+    /**
+     * @brief Clear the mark, so a loss from now on is marked again
+     */
+    void acknowledge() { lost_ = false; }
+
+    /**
+     * @brief Run the reconnect callback, counting a success
+     */
+    bool reconnect();
+
+    /**
+     * @brief Times the port was reopened
+     */
+    uint64_t getReconnects() const { return reconnects_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Where to play on from: the start of the bar of the last event sent
+     * @param reached Event after the last one sent; after @p runStart
+     * @param runStart Event playback last started or seeked to, never gone back past
+     */
+    static uint32_t resumeTick(const PlaybackTimeline& timeline, size_t reached, size_t runStart);
+
+private:
+    ReconnectCallback callback_;
+    bool lost_ = false;
+    std::atomic<uint64_t> reconnects_{0};
+};
+
+} // namespace MidiPlay
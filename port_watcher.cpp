@@ -0,0 +1,89 @@
+#include "port_watcher.hpp"
+
+#include <alsa/asoundlib.h>
+
+#include <cerrno>
+#include <vector>
+
+namespace MidiPlay {
+
+PortWatcher::PortWatcher() {
+    if (snd_seq_open(&seq_, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) {
+        seq_ = nullptr;
+        return;
+    }
+
+    snd_seq_set_client_name(seq_, "midiplay port watcher");
+    int port = snd_seq_create_simple_port(seq_, "announce",
+                                          SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_NO_EXPORT,
+                                          SND_SEQ_PORT_TYPE_APPLICATION);
+    if (port < 0 || snd_seq_connect_from(seq_, port, SND_SEQ_CLIENT_SYSTEM, SND_SEQ_PORT_SYSTEM_ANNOUNCE) < 0) {
+        snd_seq_close(seq_);
+        seq_ = nullptr;
+    }
+}
+
+PortWatcher::~PortWatcher() {
+    if (seq_) {
+        snd_seq_close(seq_);
+    }
+}
+
+bool PortWatcher::waitForChange(std::chrono::milliseconds timeout) {
+    return waitFor(ANY_START, timeout);
+}
+
+bool PortWatcher::waitForExit(int client, std::chrono::milliseconds timeout) {
+    return client >= 0 && waitFor(client, timeout);
+}
+
+bool PortWatcher::waitFor(int exitClient, std::chrono::milliseconds timeout) {
+    if (!seq_) {
+        return false;
+    }
+
+    int count = snd_seq_poll_descriptors_count(seq_, POLLIN);
+    if (count <= 0) {
+        return false;
+    }
+    std::vector<pollfd> fds(static_cast<size_t>(count));
+    snd_seq_poll_descriptors(seq_, fds.data(), fds.size(), POLLIN);
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        if (drainAnnouncements(exitClient)) {
+            return true;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+        int n = ::poll(fds.data(), fds.size(), static_cast<int>(remaining.count()));
+        if (n < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+// Reads every queued event; true if any of them announced a new or changed
+// port, or with exitClient set, that client or one of its ports leaving
+bool PortWatcher::drainAnnouncements(int exitClient) {
+    bool changed = false;
+    snd_seq_event_t* event = nullptr;
+    while (snd_seq_event_input(seq_, &event) >= 0) {
+        if (!event) {
+            continue;
+        }
+        if (exitClient == ANY_START) {
+            changed = changed || event->type == SND_SEQ_EVENT_CLIENT_START
+                              || event->type == SND_SEQ_EVENT_PORT_START
+                              || event->type == SND_SEQ_EVENT_PORT_CHANGE;
+        } else if (event->type == SND_SEQ_EVENT_CLIENT_EXIT || event->type == SND_SEQ_EVENT_PORT_EXIT) {
+            changed = changed || event->data.addr.client == exitClient;
+        }
+    }
+    return changed;
+}
+
+} // namespace MidiPlay
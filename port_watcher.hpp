@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+
+typedef struct _snd_seq snd_seq_t;
+
+namespace MidiPlay {
+
+/**
+ * @brief Wakes when a MIDI port appears, from ALSA sequencer announcements
+ *
+ * Subscribes to the sequencer's System:Announce port, which reports every
+ * client and port that starts or changes, so a device that is switched on
+ * is noticed at once instead of at the next rescan. If the sequencer cannot
+ * be opened, isActive() is false and the caller falls back to polling.
+ * The same announcements tell when a device goes away.
+ */
+class PortWatcher {
+public:
+    PortWatcher();
+    ~PortWatcher();
+
+    PortWatcher(const PortWatcher&) = delete;
+    PortWatcher& operator=(const PortWatcher&) = delete;
+
+    /**
+     * @brief Whether announcements are being received
+     */
+    bool isActive() const { return seq_ != nullptr; }
+
+    /**
+     * @brief Block until a client or port starts or changes, or the timeout passes
+     * @return true if a change was announced; false on timeout or when inactive
+     */
+    bool waitForChange(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Block until a client, or one of its ports, goes away, or the timeout passes
+     * @param client Sequencer client number, e.g. 20 for "... 20:0"
+     * @return true if it was announced gone; false on timeout or when inactive
+     */
+    bool waitForExit(int client, std::chrono::milliseconds timeout);
+
+private:
+    static constexpr int ANY_START = -1;
+
+    bool waitFor(int exitClient, std::chrono::milliseconds timeout);
+    bool drainAnnouncements(int exitClient);
+
+    snd_seq_t* seq_ = nullptr;
+};
+
+} // namespace MidiPlay
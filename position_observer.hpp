@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace MidiPlay {
+
+/**
+ * @brief Where playback is, as published by the player thread
+ */
+struct PlaybackPosition {
+    uint64_t sequence = 0;          // Number of the snapshot, from 1; 0 if nothing was published yet
+    int64_t timeUs = 0;             // Position in the piece at normal speed
+    uint32_t tick = 0;
+    uint32_t measure = 0;           // From 1, in the file's time signature
+    uint16_t beat = 0;              // From 1 within the measure
+    uint16_t beatsPerMeasure = 0;
+    float bpm = 0.0f;               // Quarter notes per minute as played: the file's tempo times the speed
+    int16_t verse = 0;              // 0 during the introduction
+    bool playing = false;
+    bool introduction = false;
+    bool ritardando = false;
+    bool lastVerse = false;
+
+    /**
+     * @brief Set tick, measure and beat
+     * @param position Tick reached
+     * @param ppq Time division of the file
+     * @param numerator Beats per measure of the time signature; 0 for none (4/4)
+     * @param denominator Beat unit as a power of two, as in the meta event
+     */
+    void setTick(uint32_t position, uint16_t ppq, uint8_t numerator, uint8_t denominator) {
+        if (numerator == 0 || denominator > 6) {
+            numerator = 4;
+            denominator = 2;
+        }
+        uint32_t ticksPerBeat = std::max<uint32_t>(1, (static_cast<uint32_t>(ppq) * 4) >> denominator);
+        uint32_t beats = position / ticksPerBeat;
+        tick = position;
+        beatsPerMeasure = numerator;
+        measure = beats / numerator + 1;
+        beat = static_cast<uint16_t>(beats % numerator + 1);
+    }
+};
+
+/**
+ * @brief Latest playback position for any number of readers, without ever blocking the player
+ *
+ * One writer (the player thread) publishes a PlaybackPosition on every
+ * event and heartbeat; UI threads take a consistent copy whenever they
+ * like. Nothing is locked or allocated on either side, and readers never
+ * write to memory the writer touches, so attaching more of them costs the
+ * player nothing.
+ *
+ * Two seqlocked slots are used in turn: publish() fills the slot readers
+ * are not pointed at, then points them at it. A reader copies the slot
+ * published last and retries only if the writer came round to that slot
+ * again meanwhile, i.e. published twice while it copied a few words; so
+ * each reader sees sequences only go up.
+ * The fields are stored as atomic words (release stores and acquire loads,
+ * plain moves on x86), so a torn copy is never a data race, only
+ * discarded, and no standalone fence is needed.
+ *
+ * publish() must not run on two threads at once; the orchestrator calls
+ * it on the player thread, or on the thread sequencing the sections while
+ * the player is stopped.
+ */
+class PositionObserver {
+public:
+    PositionObserver() = default;
+
+    // Disable copy/move
+    PositionObserver(const PositionObserver&) = delete;
+    PositionObserver& operator=(const PositionObserver&) = delete;
+
+    /**
+     * @brief Make a position the latest (single writer); its sequence is set here
+     */
+    void publish(const PlaybackPosition& position) {
+        uint64_t sequence = published_.load(std::memory_order_relaxed) + 1;
+        Slot& slot = slots_[sequence & 1];
+
+        PlaybackPosition copy = position;
+        copy.sequence = sequence;
+        std::array<uint64_t, WORDS> words{};
+        std::memcpy(words.data(), &copy, sizeof(copy));
+
+        uint64_t version = slot.version.load(std::memory_order_relaxed);
+        slot.version.store(version + 1, std::memory_order_relaxed);     // Odd while written
+        for (size_t i = 0; i < WORDS; i++) {
+            slot.words[i].store(words[i], std::memory_order_release);   // Not seen before the odd version
+        }
+        slot.version.store(version + 2, std::memory_order_release);
+        published_.store(sequence, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy of the latest position (any thread)
+     * @return Default position (sequence 0) if nothing was published yet
+     */
+    PlaybackPosition read() const {
+        while (true) {
+            uint64_t sequence = published_.load(std::memory_order_acquire);
+            if (sequence == 0) {
+                return PlaybackPosition();
+            }
+            const Slot& slot = slots_[sequence & 1];
+            uint64_t version = slot.version.load(std::memory_order_acquire);
+            if (version & 1) {
+                continue;   // Being rewritten; a newer one is on its way
+            }
+            std::array<uint64_t, WORDS> words;
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = slot.words[i].load(std::memory_order_acquire);  // Keeps the check below after them
+            }
+            if (slot.version.load(std::memory_order_relaxed) != version) {
+                continue;   // Torn
+            }
+            PlaybackPosition position = std::bit_cast<PlaybackPosition>(words);
+            if (position.sequence == sequence) {
+                return position;
+            }
+            // Lapped: the slot holds a newer position than the one published when we looked
+        }
+    }
+
+    /**
+     * @brief Number of positions published; a reader can poll this to see if anything moved
+     */
+    uint64_t sequence() const { return published_.load(std::memory_order_acquire); }
+
+private:
+    static_assert(std::is_trivially_copyable_v<PlaybackPosition>, "Positions are copied as words");
+    static constexpr size_t WORDS = (sizeof(PlaybackPosition) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    static_assert(sizeof(PlaybackPosition) == WORDS * sizeof(uint64_t), "Positions are read back with bit_cast");
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct alignas(CACHE_LINE) Slot {
+        std::atomic<uint64_t> version{0};
+        std::array<std::atomic<uint64_t>, WORDS> words{};
+    };
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> published_{0};
+    std::array<Slot, 2> slots_{};
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,126 @@
+#include "rawmidi_output.hpp"
+
+#include <alsa/asoundlib.h>
+
+#include <cerrno>
+#include <cstdlib>
+
+#include "i18n.hpp"
+
+namespace MidiPlay {
+
+RawMidiOutput::~RawMidiOutput() {
+    ClosePort();
+}
+
+bool RawMidiOutput::open(const std::string& device) {
+    ClosePort();
+    device_ = device;
+    error_.clear();
+
+    int rc = snd_rawmidi_open(nullptr, &handle_, device.c_str(), 0);
+    if (rc < 0) {
+        handle_ = nullptr;
+        error_ = device + ": " + snd_strerror(rc);
+        return false;
+    }
+    writeErrors_.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void RawMidiOutput::write(const uint8_t* bytes, size_t size) {
+    if (!handle_) {
+        writeErrors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Blocking mode writes everything unless interrupted or the device fails
+    while (size > 0) {
+        ssize_t written = snd_rawmidi_write(handle_, bytes, size);
+        if (written == -EINTR || written == -EAGAIN) {
+            continue;
+        }
+        if (written < 0) {
+            writeErrors_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void RawMidiOutput::OpenPort(unsigned int) {
+    if (!handle_ && !device_.empty()) {
+        open(device_);
+    }
+}
+
+void RawMidiOutput::ClosePort() {
+    if (handle_) {
+        snd_rawmidi_close(handle_);    // Waits for the driver to send what is buffered
+        handle_ = nullptr;
+    }
+}
+
+void RawMidiOutput::OpenVirtualPort(const std::string&) {
+    error_ = _("a rawmidi device cannot be opened as a virtual port");
+}
+
+std::string RawMidiOutput::GetPortName(unsigned int) {
+    return device_;
+}
+
+void RawMidiOutput::SendMessage(const cxxmidi::Message* msg) {
+    if (msg && !msg->empty()) {
+        write(msg->data(), msg->size());
+    }
+}
+
+bool RawMidiOutput::parseSequencerAddress(const std::string& portName, int& client, int& port) {
+    size_t space = portName.rfind(' ');
+    std::string address = portName.substr(space == std::string::npos ? 0 : space + 1);
+    size_t colon = address.find(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+        return false;
+    }
+
+    char* end = nullptr;
+    long clientNumber = std::strtol(address.c_str(), &end, 10);
+    if (end != address.c_str() + colon) {
+        return false;
+    }
+    long portNumber = std::strtol(address.c_str() + colon + 1, &end, 10);
+    if (*end != '\0' || clientNumber < 0 || portNumber < 0) {
+        return false;
+    }
+    client = static_cast<int>(clientNumber);
+    port = static_cast<int>(portNumber);
+    return true;
+}
+
+std::string RawMidiOutput::deviceForPort(const std::string& portName) {
+    int client = 0;
+    int port = 0;
+    if (!parseSequencerAddress(portName, client, port)) {
+        return "";
+    }
+
+    snd_seq_t* seq = nullptr;
+    if (snd_seq_open(&seq, "default", SND_SEQ_OPEN_OUTPUT, 0) < 0) {
+        return "";
+    }
+    snd_seq_client_info_t* info = nullptr;
+    snd_seq_client_info_alloca(&info);
+    int card = -1;
+    if (snd_seq_get_any_client_info(seq, client, info) == 0) {
+        card = snd_seq_client_info_get_card(info);
+    }
+    snd_seq_close(seq);
+
+    if (card < 0) {
+        return "";      // A software client (a synth, another program) has no rawmidi device
+    }
+    return "hw:" + std::to_string(card) + ",0," + std::to_string(port);
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cxxmidi/message.hpp>
+#include <cxxmidi/output/abstract.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Forward declaration; alsa/asoundlib.h stays out of the header
+typedef struct _snd_rawmidi snd_rawmidi_t;
+
+namespace MidiPlay {
+
+/**
+ * @brief Output port that writes straight to an ALSA rawmidi device
+ *
+ * cxxmidi::output::Default goes through the ALSA sequencer: every message
+ * becomes a sequencer event, is routed by the sequencer core and is
+ * encoded again for the device. RawMidiOutput hands the bytes to the
+ * device driver in one write, and SendMessage() accepts any number of
+ * complete messages at once, with running status, so TimelinePlayer's
+ * Stream and Wire output modes can send a whole chord per call.
+ *
+ * The device is opened blocking: a write waits only while the driver's
+ * buffer is full. A device that goes away (unplugged USB adapter) fails
+ * every later write; failures are counted, not thrown, so the player
+ * thread carries on.
+ *
+ * Selected per device in midi_devices.yaml (see DeviceManager).
+ */
+class RawMidiOutput : public cxxmidi::output::Abstract {
+public:
+    RawMidiOutput() = default;
+    ~RawMidiOutput() override;
+
+    // Disable copy/move
+    RawMidiOutput(const RawMidiOutput&) = delete;
+    RawMidiOutput& operator=(const RawMidiOutput&) = delete;
+
+    /**
+     * @brief Open a rawmidi device for output
+     * @param device ALSA name, e.g. "hw:1,0,0"
+     * @return false if it could not be opened; see getError()
+     */
+    bool open(const std::string& device);
+
+    bool isOpen() const { return handle_ != nullptr; }
+    const std::string& getDevice() const { return device_; }
+    const std::string& getError() const { return error_; }
+
+    /**
+     * @brief Write bytes to the device, all of them unless it fails
+     */
+    void write(const uint8_t* bytes, size_t size);
+
+    /**
+     * @brief Writes that failed since the device was opened
+     */
+    uint64_t getWriteErrors() const { return writeErrors_.load(std::memory_order_relaxed); }
+
+    // cxxmidi::output::Abstract; the device is chosen with open(), not by port number
+    void OpenPort(unsigned int num = 0) override;
+    void ClosePort() override;
+    void OpenVirtualPort(const std::string& name = "") override;
+    size_t GetPortCount() override { return isOpen() ? 1 : 0; }
+    std::string GetPortName(unsigned int num = 0) override;
+
+    /**
+     * @brief Write the message's bytes; several messages in one are passed through
+     */
+    void SendMessage(const cxxmidi::Message* msg) override;
+
+    /**
+     * @brief Rawmidi device behind a sequencer port, from the port name cxxmidi reports
+     *
+     * The name ends in the sequencer address, "client:port". A hardware
+     * client belongs to a sound card; its ports are the card's MIDI
+     * outputs in order, which on a USB MIDI adapter are the subdevices of
+     * device 0.
+     * @return e.g. "hw:1,0,0", or empty if the port is not a card's
+     */
+    static std::string deviceForPort(const std::string& portName);
+
+    /**
+     * @brief Sequencer address at the end of a port name
+     * @return false if the name does not end in "client:port"
+     */
+    static bool parseSequencerAddress(const std::string& portName, int& client, int& port);
+
+private:
+    snd_rawmidi_t* handle_ = nullptr;
+    std::string device_;
+    std::string error_;
+    std::atomic<uint64_t> writeErrors_{0};
+};
+
+} // namespace MidiPlay
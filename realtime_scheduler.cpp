@@ -0,0 +1,138 @@
+#include "realtime_scheduler.hpp"
+#include "i18n.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace MidiPlay {
+
+RealtimeScheduler::RealtimeScheduler(int priority, int cpu)
+    : priority_(std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO)))
+    , cpu_(cpu)
+{
+    if (cpu_ == LAST_CPU) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        cpu_ = online > 0 ? static_cast<int>(online - 1) : 0;
+    }
+}
+
+bool RealtimeScheduler::apply(const cxxmidi::File& file) {
+    warnings_.clear();
+    
+    saved_ = pthread_getschedparam(pthread_self(), &savedPolicy_, &savedParam_) == 0
+          && pthread_getaffinity_np(pthread_self(), sizeof(savedCpus_), &savedCpus_) == 0;
+    
+    bool ok = setScheduling();
+    ok = pinToCpu() && ok;
+    ok = lockMemory() && ok;
+    
+    prefaultEvents(file);
+    prefaultStack();
+    
+    return ok;
+}
+
+void RealtimeScheduler::restore() {
+    if (!saved_) {
+        return;
+    }
+    pthread_setschedparam(pthread_self(), savedPolicy_, &savedParam_);
+    pthread_setaffinity_np(pthread_self(), sizeof(savedCpus_), &savedCpus_);
+    saved_ = false;
+}
+
+void RealtimeScheduler::releaseCurrentThread() {
+    int policy = SCHED_OTHER;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0
+        || (policy != SCHED_FIFO && policy != SCHED_RR)) {
+        return;
+    }
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    
+    // Pinned to the player's core: every other one instead
+    cpu_set_t cpus;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0 || CPU_COUNT(&cpus) != 1) {
+        return;
+    }
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t others;
+    CPU_ZERO(&others);
+    for (long cpu = 0; cpu < online && cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &cpus)) {
+            CPU_SET(cpu, &others);
+        }
+    }
+    if (CPU_COUNT(&others) > 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(others), &others);
+    }
+}
+
+bool RealtimeScheduler::setScheduling() {
+    sched_param param{};
+    param.sched_priority = priority_;
+    
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        warnings_.push_back(std::string(_("Real-time scheduling unavailable (")) + strerror(rc)
+                            + _("); playing at normal priority."));
+        return false;
+    }
+    return true;
+}
+
+bool RealtimeScheduler::pinToCpu() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu_, &cpus);
+    
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (rc != 0) {
+        warnings_.push_back(std::string(_("Could not pin playback to CPU ")) + std::to_string(cpu_)
+                            + " (" + strerror(rc) + ").");
+        return false;
+    }
+    return true;
+}
+
+bool RealtimeScheduler::lockMemory() {
+    // Keep freed heap mapped so locked pages are reused rather than refaulted
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        warnings_.push_back(std::string(_("Could not lock memory (")) + strerror(errno)
+                            + _("); playback may page-fault."));
+        return false;
+    }
+    return true;
+}
+
+// Touch a block of stack so its pages are resident before playback
+void RealtimeScheduler::prefaultStack() {
+    unsigned char stack[STACK_PREFAULT_BYTES];
+    memset(stack, 0, sizeof(stack));
+    asm volatile("" : : "r"(stack) : "memory");    // Keep the writes
+}
+
+// Read every event once so its storage is resident before playback
+void RealtimeScheduler::prefaultEvents(const cxxmidi::File& file) {
+    volatile unsigned char sink = 0;
+    for (const cxxmidi::Track& track : file) {
+        for (const cxxmidi::Event& event : track) {
+            if (!event.empty()) {
+                sink = sink ^ event[0];
+            }
+        }
+    }
+    (void)sink;
+}
+
+} // namespace MidiPlay
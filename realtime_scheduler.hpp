@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cxxmidi/file.hpp>
+#include <sched.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace MidiPlay {
+
+/**
+ * @brief Puts playback under real-time scheduling (--realtime)
+ * 
+ * apply() is called on the main thread after the MIDI file is loaded and
+ * the device is set up, before the playback engine is created:
+ * - SCHED_FIFO at the requested priority
+ * - CPU affinity to one core (default: the last, which Organ Pi images isolate)
+ * - mlockall(MCL_CURRENT | MCL_FUTURE), with malloc told not to hand memory back
+ * - Pre-faulting the loaded events and a block of stack
+ * 
+ * Threads created afterwards inherit the policy, priority and affinity.
+ * The timeline player plays on a thread of its own, so once it exists the
+ * main thread is put back with restore(); PlayerSync is driven from the
+ * main thread, which keeps the settings until playback ends. Helper threads
+ * (console, keyboard, reconnect, daemon, secondary ports) that may still
+ * inherit them call releaseCurrentThread() first thing.
+ * 
+ * Each step that lacks privileges is skipped and described in
+ * getWarnings(); playback then continues as it would without --realtime.
+ */
+class RealtimeScheduler {
+public:
+    /**
+     * @brief Constructor
+     * @param priority SCHED_FIFO priority, clamped to the range the system allows
+     * @param cpu Core to pin to; LAST_CPU for the highest-numbered online core
+     */
+    explicit RealtimeScheduler(int priority, int cpu = LAST_CPU);
+    
+    /**
+     * @brief Apply real-time settings to the calling thread and the process
+     * @param file Loaded MIDI file whose event storage is pre-faulted
+     * @return true if every step succeeded
+     */
+    bool apply(const cxxmidi::File& file);
+    
+    /**
+     * @brief Put the thread that called apply() back to its policy and cores from before
+     * 
+     * Call on that thread. Memory stays locked. No-op if apply() was not called.
+     */
+    void restore();
+    
+    /**
+     * @brief Take a helper thread off real-time scheduling it inherited
+     * 
+     * A SCHED_FIFO or SCHED_RR thread goes back to SCHED_OTHER and, if it
+     * is pinned to a single core, moves to every other core, so it never
+     * competes with the player. Threads not under real-time scheduling are
+     * left alone.
+     */
+    static void releaseCurrentThread();
+    
+    int getPriority() const { return priority_; }
+    int getCpu() const { return cpu_; }
+    
+    /**
+     * @brief What fell back, one translated message per failed step
+     */
+    const std::vector<std::string>& getWarnings() const { return warnings_; }
+    
+    static constexpr int LAST_CPU = -1;
+    static constexpr size_t STACK_PREFAULT_BYTES = 256 * 1024;
+    
+private:
+    bool setScheduling();
+    bool pinToCpu();
+    bool lockMemory();
+    static void prefaultStack();
+    static void prefaultEvents(const cxxmidi::File& file);
+    
+    int priority_;
+    int cpu_;
+    std::vector<std::string> warnings_;
+    
+    // The calling thread's scheduling before apply(), for restore()
+    bool saved_ = false;
+    int savedPolicy_ = SCHED_OTHER;
+    sched_param savedParam_{};
+    cpu_set_t savedCpus_{};
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cxxmidi/output/abstract.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "jitter_recorder.hpp"
+#include "virtual_clock.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Port that records every message with the time it was sent
+ *
+ * Stands in for the organ when the timing of a performance is under test.
+ * Each SendMessage() stores the CLOCK_MONOTONIC time (or the VirtualClock's,
+ * when one is given) and the first bytes of the message in a buffer
+ * allocated up front, so recording costs the player thread no allocation.
+ * When the buffer is full further messages are counted as dropped.
+ *
+ * An annotator, if set, runs for each message on the sending thread and may
+ * fill in the rest of the sample, such as the engine's position and speed.
+ * Only one thread may send at a time; read the samples after playback.
+ */
+class RecordingOutput : public cxxmidi::output::Abstract {
+public:
+    static constexpr size_t MAX_BYTES = 3;
+
+    struct Sample {
+        int64_t timeNs = 0;         // When the message was sent
+        int64_t positionUs = 0;     // Annotator: position in the piece at normal speed
+        float speed = 1.0f;         // Annotator: engine speed
+        uint16_t section = 0;       // Annotator: 0 for the introduction, verse from 1
+        uint8_t size = 0;           // Whole message; only MAX_BYTES are kept
+        uint8_t bytes[MAX_BYTES] = {};
+
+        bool isNoteOn() const { return size >= 3 && (bytes[0] & 0xF0) == 0x90 && bytes[2] > 0; }
+    };
+
+    using Annotator = std::function<void(Sample&)>;
+
+    /**
+     * @param capacity Maximum number of messages recorded
+     * @param clock Time source; steady_clock when null
+     */
+    explicit RecordingOutput(size_t capacity, const VirtualClock* clock = nullptr)
+        : samples_(std::make_unique<Sample[]>(capacity))
+        , capacity_(capacity)
+        , clock_(clock)
+    {
+    }
+
+    // Disable copy/move
+    RecordingOutput(const RecordingOutput&) = delete;
+    RecordingOutput& operator=(const RecordingOutput&) = delete;
+
+    /**
+     * @brief Set before playback
+     */
+    void setAnnotator(const Annotator& annotator) { annotator_ = annotator; }
+
+    void OpenPort(unsigned int) override {}
+    void ClosePort() override {}
+    void OpenVirtualPort(const std::string&) override {}
+    size_t GetPortCount() override { return 1; }
+    std::string GetPortName(unsigned int) override { return "recorder"; }
+
+    void SendMessage(const cxxmidi::Message* message) override {
+        int64_t now = clock_ ? clock_->nowNs() : JitterRecorder::now();
+        size_t index = count_.load(std::memory_order_relaxed);
+        if (index >= capacity_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Sample& sample = samples_[index];
+        sample = Sample();
+        sample.timeNs = now;
+        sample.size = static_cast<uint8_t>(std::min<size_t>(message->size(), UINT8_MAX));
+        std::copy_n(message->data(), std::min<size_t>(message->size(), MAX_BYTES), sample.bytes);
+        if (annotator_) {
+            annotator_(sample);
+        }
+        count_.store(index + 1, std::memory_order_release);
+    }
+
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    const Sample& at(size_t index) const { return samples_[index]; }
+
+private:
+    std::unique_ptr<Sample[]> samples_;
+    size_t capacity_;
+    const VirtualClock* clock_;
+    Annotator annotator_;
+    std::atomic<size_t> count_{0};
+    std::atomic<size_t> dropped_{0};
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,254 @@
+#include "registration_scheduler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include "midi_constants.hpp"
+
+namespace MidiPlay {
+
+namespace {
+
+constexpr uint8_t UNSET = 0xFF;     // Data bytes are 0 to 127
+constexpr uint32_t NOT_SILENT = std::numeric_limits<uint32_t>::max();
+
+// A run of registration events of one track at one tick on one channel, or a program change
+struct Change {
+    uint32_t tick;
+    uint16_t track;
+    size_t first;
+    size_t count;
+    uint8_t channel;
+    bool burst;         // false for a program change, which stays where it is
+};
+
+// Notes sounding after all the events of a tick
+struct Sounding {
+    uint32_t tick;
+    uint32_t silentFrom;    // Tick the last note was released, or NOT_SILENT
+};
+
+// What the organ has been sent on one channel: the selected NRPN parameter and each parameter's value
+struct NrpnState {
+    uint8_t selectedMsb = UNSET;
+    uint8_t selectedLsb = UNSET;
+    std::map<uint16_t, std::array<uint8_t, 2>> values;
+
+    // Apply one control change; false if it changed nothing
+    bool apply(uint8_t controller, uint8_t value) {
+        uint8_t* target = nullptr;
+        if (controller == Midi::CC_NRPN_MSB) {
+            target = &selectedMsb;
+        } else if (controller == Midi::CC_NRPN_LSB) {
+            target = &selectedLsb;
+        } else {
+            auto inserted = values.try_emplace(static_cast<uint16_t>(selectedMsb << 8 | selectedLsb),
+                                               std::array<uint8_t, 2>{UNSET, UNSET});
+            target = &inserted.first->second[controller == Midi::CC_DATA_ENTRY_MSB ? 0 : 1];
+        }
+        bool changed = *target != value;
+        *target = value;
+        return changed;
+    }
+};
+
+bool isRegistration(const cxxmidi::Event& event) {
+    if (event.size() < 3 || (event[0] & Midi::STATUS_TYPE_MASK) != Midi::CONTROL_CHANGE) {
+        return false;
+    }
+    uint8_t controller = event[1];
+    return controller == Midi::CC_NRPN_MSB || controller == Midi::CC_NRPN_LSB
+        || controller == Midi::CC_DATA_ENTRY_MSB || controller == Midi::CC_DATA_ENTRY_LSB;
+}
+
+bool isProgramChange(const cxxmidi::Event& event) {
+    return event.size() >= 2 && (event[0] & Midi::STATUS_TYPE_MASK) == Midi::PROGRAM_CHANGE;
+}
+
+// +1 for a note starting, -1 for one released, 0 otherwise
+int noteDelta(const cxxmidi::Event& event) {
+    if (event.size() < 3) {
+        return 0;
+    }
+    uint8_t type = event[0] & Midi::STATUS_TYPE_MASK;
+    if (type == Midi::NOTE_ON) {
+        return event[2] != 0 ? 1 : -1;
+    }
+    return type == Midi::NOTE_OFF ? -1 : 0;
+}
+
+} // namespace
+
+RegistrationScheduler::Result RegistrationScheduler::schedule(cxxmidi::File& file,
+                                                              const std::vector<Directive>& directives) {
+    Result result;
+
+    // Absolute ticks, the notes of all tracks and the registration changes
+    std::vector<std::vector<uint32_t>> ticks(file.size());
+    std::vector<std::pair<uint32_t, int>> notes;
+    std::vector<Change> changes;
+    for (size_t t = 0; t < file.size(); t++) {
+        const cxxmidi::Track& track = file[t];
+        ticks[t].resize(track.size());
+        uint32_t tick = 0;
+        for (size_t e = 0; e < track.size(); e++) {
+            const cxxmidi::Event& event = track[e];
+            tick += event.Dt();
+            ticks[t][e] = tick;
+
+            if (int delta = noteDelta(event)) {
+                notes.emplace_back(tick, delta);
+            } else if (isProgramChange(event)) {
+                changes.push_back({tick, static_cast<uint16_t>(t), e, 1, 0, false});
+            } else if (isRegistration(event)) {
+                uint8_t channel = event[0] & Midi::CHANNEL_MASK;
+                Change* last = changes.empty() ? nullptr : &changes.back();
+                if (last && last->burst && last->track == t && last->tick == tick
+                    && last->channel == channel && last->first + last->count == e) {
+                    last->count++;
+                } else {
+                    changes.push_back({tick, static_cast<uint16_t>(t), e, 1, channel, true});
+                }
+            }
+        }
+    }
+    if (changes.empty()) {
+        return result;
+    }
+
+    // When the organ last fell silent, tick by tick
+    std::sort(notes.begin(), notes.end());
+    std::vector<Sounding> sounding;
+    int held = 0;
+    for (size_t n = 0; n < notes.size(); ) {
+        uint32_t tick = notes[n].first;
+        for (; n < notes.size() && notes[n].first == tick; n++) {
+            held = std::max(0, held + notes[n].second);    // A stray release does not count
+        }
+        uint32_t silentFrom = NOT_SILENT;
+        if (held == 0) {
+            silentFrom = !sounding.empty() && sounding.back().silentFrom != NOT_SILENT
+                ? sounding.back().silentFrom : tick;
+        }
+        sounding.push_back({tick, silentFrom});
+    }
+
+    std::vector<uint32_t> barriers;
+    barriers.reserve(directives.size());
+    for (const Directive& directive : directives) {
+        barriers.push_back(directive.tick);
+    }
+    std::sort(barriers.begin(), barriers.end());
+
+    // In playback order: by tick, then by track
+    std::stable_sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) {
+        return std::tie(a.tick, a.track) < std::tie(b.tick, b.track);
+    });
+
+    std::vector<std::vector<bool>> dropped(file.size());
+    std::vector<bool> changedTrack(file.size(), false);
+    std::array<NrpnState, 16> organ;
+    size_t nextBarrier = 0;
+    uint32_t lastTick = 0;          // Where the last registration change kept went
+    uint16_t lastTrack = 0;
+
+    for (const Change& change : changes) {
+        // Past a marker, playback may have arrived from anywhere
+        bool atBarrier = false;
+        for (; nextBarrier < barriers.size() && barriers[nextBarrier] <= change.tick; nextBarrier++) {
+            atBarrier = true;
+        }
+        if (atBarrier) {
+            organ.fill(NrpnState());
+        }
+
+        cxxmidi::Track& track = file[change.track];
+        if (!change.burst) {
+            organ[track[change.first][0] & Midi::CHANNEL_MASK] = NrpnState();  // A piston may have changed any stop
+            lastTick = change.tick;
+            lastTrack = change.track;
+            continue;
+        }
+
+        bool changesOrgan = false;
+        for (size_t e = change.first; e < change.first + change.count; e++) {
+            changesOrgan |= organ[change.channel].apply(track[e][1], track[e][2]);
+        }
+        if (!changesOrgan) {
+            dropped[change.track].resize(track.size(), false);
+            std::fill_n(dropped[change.track].begin() + change.first, change.count, true);
+            changedTrack[change.track] = true;
+            result.dropped++;
+            continue;
+        }
+
+        // Earliest tick: the start of the rest, after the last marker and the last change kept
+        uint32_t earliest = change.tick;
+        auto before = std::lower_bound(sounding.begin(), sounding.end(), change.tick,
+                                       [](const Sounding& s, uint32_t tick) { return s.tick < tick; });
+        uint32_t silentFrom = before == sounding.begin() ? 0 : std::prev(before)->silentFrom;
+        if (silentFrom != NOT_SILENT) {
+            earliest = silentFrom;
+            if (nextBarrier > 0) {
+                uint32_t barrier = barriers[nextBarrier - 1];
+                earliest = std::max(earliest, barrier == change.tick ? barrier : barrier + 1);
+            }
+            earliest = std::max(earliest, lastTick + (lastTrack > change.track ? 1 : 0));
+        }
+
+        uint32_t tick = std::min(earliest, change.tick);
+        if (tick < change.tick) {
+            for (size_t e = change.first; e < change.first + change.count; e++) {
+                ticks[change.track][e] = tick;
+            }
+            changedTrack[change.track] = true;
+            result.moved++;
+        }
+        lastTick = tick;
+        lastTrack = change.track;
+    }
+
+    // Rebuild the changed tracks; moved events follow those already at their new tick
+    for (size_t t = 0; t < file.size(); t++) {
+        if (!changedTrack[t]) {
+            continue;
+        }
+        cxxmidi::Track& track = file[t];
+        std::vector<std::pair<uint32_t, size_t>> order;
+        order.reserve(track.size());
+        uint32_t previous = 0;
+        bool moved = false;
+        for (size_t e = 0; e < track.size(); e++) {
+            if (e < dropped[t].size() && dropped[t][e]) {
+                continue;
+            }
+            moved = moved || ticks[t][e] < previous;
+            previous = std::max(previous, ticks[t][e]);
+            order.emplace_back(ticks[t][e], e);
+        }
+        if (moved) {
+            std::stable_sort(order.begin(), order.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+        }
+
+        cxxmidi::Track rebuilt;
+        rebuilt.reserve(order.size());
+        uint32_t tick = 0;
+        for (const auto& [eventTick, e] : order) {
+            cxxmidi::Event event = std::move(track[e]);
+            event.SetDt(eventTick - tick);
+            tick = eventTick;
+            rebuilt.push_back(std::move(event));
+        }
+        track = std::move(rebuilt);
+    }
+
+    return result;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cxxmidi/file.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "event_preprocessor.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Moves organ stop changes ahead of the notes they prepare, at load time
+ *
+ * A registration change is a burst of NRPN parameter and Data Entry control
+ * changes (see EventPreProcessor::shouldLoadControlChangeEvent). In a hymn
+ * file it usually shares a tick with the first notes of the next phrase
+ * and, being earlier in the file, goes out ahead of them, delaying the
+ * chord by the time the burst takes on the wire.
+ *
+ * schedule() rewrites the loaded tracks once:
+ * - Each burst is moved back to the start of the rest before it, the tick
+ *   at which the last note of every channel was released. A burst with a
+ *   note held up to its tick stays where it is, since changing stops under
+ *   a sounding note would be heard.
+ * - A burst never passes a marker, so every introduction segment, verse
+ *   and D.C. al Fine jump still finds the registration the file gives it,
+ *   and never passes another registration change (or program change).
+ * - A burst that would leave the organ exactly as it is (every parameter
+ *   already holding the value it sends, the same parameter left selected)
+ *   is dropped. What the organ has is only known from the previous marker
+ *   on, so a burst is only dropped against changes since then.
+ *
+ * The rewritten tracks are stored in the hymn cache, so a warm start does
+ * not schedule again.
+ */
+class RegistrationScheduler {
+public:
+    struct Result {
+        size_t moved = 0;       // Bursts moved earlier
+        size_t dropped = 0;     // Bursts that changed nothing
+    };
+
+    /**
+     * @brief Reschedule the registration bursts of loaded tracks in place
+     * @param file Tracks as loaded through EventPreProcessor
+     * @param directives The file's markers (EventPreProcessor::getDirectives())
+     */
+    static Result schedule(cxxmidi::File& file, const std::vector<Directive>& directives);
+};
+
+} // namespace MidiPlay
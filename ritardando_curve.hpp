@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace MidiPlay {
+
+/**
+ * @brief Speed curve of a ritardando as a function of musical position
+ *
+ * The speed factor falls from 1 at the ritardando marker to targetFactor
+ * over a fixed number of beats and then holds. Because the factor depends
+ * only on how far the music has progressed since the marker, the slowdown
+ * is the same on every run regardless of when heartbeats happen to fire.
+ */
+class RitardandoCurve {
+public:
+    enum class Shape : uint8_t {
+        Linear,         // Equal speed reduction per beat
+        Exponential     // Equal ratio per beat; eases in more gently
+    };
+
+    static constexpr float DEFAULT_TARGET_FACTOR = 0.85f;
+    static constexpr float DEFAULT_BEATS = 8.0f;
+
+    /**
+     * @param shape How the factor moves from 1 to targetFactor
+     * @param targetFactor Speed factor reached at the end of the curve (0 < factor <= 1)
+     * @param beats Length of the curve in beats
+     */
+    explicit RitardandoCurve(Shape shape = Shape::Linear,
+                             float targetFactor = DEFAULT_TARGET_FACTOR,
+                             float beats = DEFAULT_BEATS)
+        : shape_(shape)
+        , targetFactor_(std::clamp(targetFactor, MIN_FACTOR, 1.0f))
+        , beats_(std::max(beats, 0.0f))
+    {
+    }
+
+    /**
+     * @brief Speed factor after a number of beats since the marker
+     */
+    float factorAt(double beatsElapsed) const {
+        if (beats_ <= 0.0f) {
+            return targetFactor_;
+        }
+        double progress = std::clamp(beatsElapsed / beats_, 0.0, 1.0);
+
+        switch (shape_) {
+        case Shape::Exponential:
+            return static_cast<float>(std::pow(static_cast<double>(targetFactor_), progress));
+        case Shape::Linear:
+        default:
+            return static_cast<float>(1.0 + (targetFactor_ - 1.0) * progress);
+        }
+    }
+
+    Shape getShape() const { return shape_; }
+    float getTargetFactor() const { return targetFactor_; }
+    float getBeats() const { return beats_; }
+
+private:
+    static constexpr float MIN_FACTOR = 0.1f;
+
+    Shape shape_;
+    float targetFactor_;
+    float beats_;
+};
+
+} // namespace MidiPlay
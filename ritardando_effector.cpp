@@ -1,26 +1,55 @@
 #include "ritardando_effector.hpp"
 
+#include <cmath>
+
 namespace MidiPlay {
 
-RitardandoEffector::RitardandoEffector(cxxmidi::player::PlayerSync& player,
+RitardandoEffector::RitardandoEffector(PlaybackEngine& player,
                                        PlaybackStateMachine& stateMachine,
-                                       float decrementRate)
+                                       const RitardandoCurve& curve)
     : player_(player)
     , stateMachine_(stateMachine)
-    , decrementRate_(decrementRate)
+    , curve_(curve)
 {
 }
 
+void RitardandoEffector::start(std::chrono::microseconds origin) {
+    active_ = true;
+    startPos_ = origin;
+    startSpeed_ = player_.getSpeed();
+    appliedSpeed_ = startSpeed_;
+    reachedTarget_ = false;
+}
+
 void RitardandoEffector::handleHeartbeat() {
-    if (stateMachine_.isRitardando()) {
-        // Diminish speed gradually
-        int64_t count = player_.CurrentTimePos().count();
-        if (count % HEARTBEAT_CHECK_INTERVAL == 0) {
-            float currentSpeed = player_.GetSpeed();
-            currentSpeed -= decrementRate_;
-            player_.SetSpeed(currentSpeed);
-        }
+    if (!stateMachine_.isRitardando()) {
+        active_ = false;
+        return;
+    }
+    
+    std::chrono::microseconds position = player_.currentTimePos();
+    if (!active_) {
+        start(position);
+    }
+    
+    // Before the marker (the player was moved back) the curve holds the starting speed
+    double beats = static_cast<double>((position - startPos_).count()) / beatDuration_.count();
+    float speed = startSpeed_ * curve_.factorAt(beats);
+    bool target = speed == startSpeed_ * curve_.getTargetFactor();
+    
+    if (std::fabs(speed - appliedSpeed_) >= SPEED_STEP || (speed != appliedSpeed_ && target)) {
+        player_.setSpeed(speed);
+        appliedSpeed_ = speed;
+    }
+    reachedTarget_ = target && appliedSpeed_ == speed;
+}
+
+bool RitardandoEffector::checkHeartbeatNeeded() {
+    if (!stateMachine_.isRitardando()) {
+        active_ = false;
+        return false;
     }
+    return !active_ || !reachedTarget_;
 }
 
-} // namespace MidiPlay
\ No newline at end of file
+} // namespace MidiPlay
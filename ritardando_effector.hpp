@@ -1,28 +1,33 @@
 #pragma once
 
-#include <cxxmidi/player/player_sync.hpp>
+#include <chrono>
+
+#include "playback_engine.hpp"
 #include "playback_state_machine.hpp"
+#include "ritardando_curve.hpp"
 
 namespace MidiPlay {
 
 /**
  * @brief Handles gradual tempo slowdown (ritardando effect)
  * 
- * Applies progressive speed reduction during playback when ritardando
- * is active. The effect is triggered by the state machine and applied
- * via periodic heartbeat callbacks.
+ * MusicalDirector starts a RitardandoCurve at the position of the
+ * ritardando marker, with the speed playing there. Each heartbeat then
+ * sets the speed the curve gives for the current musical position, so the
+ * slowdown does not depend on heartbeat phase or scheduling jitter. The
+ * speed is only changed when the curve has moved by at least SPEED_STEP.
  */
 class RitardandoEffector {
 public:
     /**
      * @brief Constructor with dependency injection
-     * @param player Reference to player for speed control
+     * @param player Reference to playback engine for speed control
      * @param stateMachine Reference to state machine for ritardando flag
-     * @param decrementRate Speed decrement per heartbeat interval (default: RITARDANDO_DECREMENT)
+     * @param curve Slowdown curve (default: linear to 85% over 8 beats)
      */
-    RitardandoEffector(cxxmidi::player::PlayerSync& player,
+    RitardandoEffector(PlaybackEngine& player,
                        PlaybackStateMachine& stateMachine,
-                       float decrementRate = RITARDANDO_DECREMENT);
+                       const RitardandoCurve& curve = RitardandoCurve());
     
     ~RitardandoEffector() = default;
     
@@ -30,36 +35,66 @@ public:
     RitardandoEffector(const RitardandoEffector&) = delete;
     RitardandoEffector& operator=(const RitardandoEffector&) = delete;
     
+    /**
+     * @brief Start the curve at a ritardando marker (player thread)
+     * @param origin Piece time of the marker
+     */
+    void start(std::chrono::microseconds origin);
+    
     /**
      * @brief Handle heartbeat callback from player
      * 
      * Called periodically during playback. When ritardando is active,
-     * progressively reduces playback speed at regular intervals.
+     * applies the curve's speed for the current position. A ritardando
+     * set without start() begins its curve at this heartbeat.
      */
     void handleHeartbeat();
     
     /**
-     * @brief Set the speed decrement rate
-     * @param rate Speed reduction per heartbeat interval
+     * @brief Whether the curve still needs heartbeats (player thread)
+     * 
+     * True from the start of a ritardando until the curve has reached its
+     * target speed. Forgets a finished curve once the ritardando is over,
+     * so the next one starts afresh even if no heartbeat ran in between.
+     */
+    bool checkHeartbeatNeeded();
+    
+    /**
+     * @brief Set the slowdown curve; takes effect at the next ritardando
+     */
+    void setCurve(const RitardandoCurve& curve) { curve_ = curve; }
+    const RitardandoCurve& getCurve() const { return curve_; }
+    
+    /**
+     * @brief Set the length of one beat at normal speed
+     * @param beat Beat duration in piece time (default: 500000 us, 120 bpm)
      */
-    void setDecrementRate(float rate) { decrementRate_ = rate; }
+    void setBeatDuration(std::chrono::microseconds beat) {
+        if (beat.count() > 0) {
+            beatDuration_ = beat;
+        }
+    }
+    std::chrono::microseconds getBeatDuration() const { return beatDuration_; }
     
     /**
-     * @brief Get the current decrement rate
-     * @return Current speed reduction per heartbeat interval
+     * @brief Speed change below which the player is left alone
      */
-    float getDecrementRate() const { return decrementRate_; }
+    static constexpr float SPEED_STEP = 0.001f;
     
 private:
-    cxxmidi::player::PlayerSync& player_;
+    PlaybackEngine& player_;
     PlaybackStateMachine& stateMachine_;
-    float decrementRate_;
+    RitardandoCurve curve_;
+    std::chrono::microseconds beatDuration_{DEFAULT_BEAT_DURATION_US};
     
-    // Heartbeat interval for checking and applying ritardando
-    static constexpr int64_t HEARTBEAT_CHECK_INTERVAL = 100000;
+    // === Active curve ===
+    bool active_ = false;
+    std::chrono::microseconds startPos_{0};    // Position of the marker
+    float startSpeed_ = 1.0f;                  // Speed the curve scales
+    float appliedSpeed_ = 1.0f;                // Last speed given to the player
+    bool reachedTarget_ = false;               // Curve holds; nothing left to apply
     
-    // Default speed decrement per interval
-    static constexpr float RITARDANDO_DECREMENT = 0.002f;
+    static constexpr int64_t DEFAULT_BEAT_DURATION_US = 500000;
 };
 
-} // namespace MidiPlay
\ No newline at end of file
+} // namespace MidiPlay
@@ -0,0 +1,20 @@
+#include "section_cursor.hpp"
+
+namespace MidiPlay {
+
+void SectionCursor::set(const PlaybackSchedule& schedule, const PlaybackSchedule::SectionCallback& callback) {
+    schedule_ = schedule;
+    callback_ = callback;
+    section_ = 0;
+    active_ = !schedule_.empty();
+}
+
+const ScheduledSection* SectionCursor::next() {
+    if (!active_ || section_ + 1 >= schedule_.size()) {
+        active_ = false;
+        return nullptr;
+    }
+    return &schedule_[++section_];
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "playback_schedule.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief The player thread's place in a PlaybackSchedule
+ *
+ * Keeps the section playing and moves on to the next one the section
+ * callback lets play. The player starts that section at the scheduled end
+ * of the previous one plus pauseAfterUs(), so every pause is exact and
+ * needs no round-trip through the main thread.
+ *
+ * Not thread safe; the player guards it with its own mutex.
+ */
+class SectionCursor {
+public:
+    /**
+     * @brief Start over at the first section of @p schedule
+     * @param callback Asked before each later section starts; may be empty
+     */
+    void set(const PlaybackSchedule& schedule, const PlaybackSchedule::SectionCallback& callback);
+
+    /**
+     * @brief A schedule is set and sections are left
+     */
+    bool isActive() const { return active_; }
+
+    /**
+     * @brief Pause after the section playing
+     */
+    uint64_t pauseAfterUs() const { return schedule_[section_].pauseAfterUs; }
+
+    /**
+     * @brief Move to the next section
+     * @return nullptr past the last section, which leaves the cursor inactive
+     */
+    const ScheduledSection* next();
+
+    /**
+     * @brief Whether @p section plays; runs the section callback, so call it without the player's lock
+     */
+    bool accept(const ScheduledSection& section) const { return !callback_ || callback_(section); }
+
+    /**
+     * @brief Play no further section
+     */
+    void end() { active_ = false; }
+
+private:
+    PlaybackSchedule schedule_;
+    PlaybackSchedule::SectionCallback callback_;
+    size_t section_ = 0;
+    bool active_ = false;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,144 @@
+#include "seek_index.hpp"
+#include "midi_constants.hpp"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <tuple>
+
+namespace MidiPlay {
+
+SeekIndex::SeekIndex(const PlaybackTimeline& timeline) {
+    // Keyed by (kind, channel, parameter), so controllers come out grouped by kind
+    std::map<std::tuple<Kind, uint8_t, uint16_t>, std::vector<Change>> found;
+
+    // NRPN parameter selected on each channel, as CC 99 and CC 98 left it
+    std::array<uint8_t, 16> selectedMsb;
+    std::array<uint8_t, 16> selectedLsb;
+    selectedMsb.fill(UNSET);
+    selectedLsb.fill(UNSET);
+
+    for (size_t index = 0; index < timeline.size(); index++) {
+        EventView event = timeline.eventAt(index);
+        if (event.size() < 2 || event.isMeta() || event.isSysex()) {
+            continue;
+        }
+        uint8_t type = event[0] & Midi::STATUS_TYPE_MASK;
+        uint8_t channel = event[0] & Midi::CHANNEL_MASK;
+
+        if (type == Midi::PROGRAM_CHANGE) {
+            found[{Kind::Program, channel, 0}].push_back({index, event[1], UNSET});
+            continue;
+        }
+        if (type != Midi::CONTROL_CHANGE || event.size() < 3) {
+            continue;
+        }
+
+        uint8_t value = event[2] & 0x7F;
+        uint16_t parameter = static_cast<uint16_t>(selectedMsb[channel] << 8 | selectedLsb[channel]);
+        switch (event[1]) {
+            case Midi::CC_NRPN_MSB:
+            case Midi::CC_NRPN_LSB:
+                (event[1] == Midi::CC_NRPN_MSB ? selectedMsb : selectedLsb)[channel] = value;
+                found[{Kind::Selection, channel, 0}].push_back({index, selectedMsb[channel], selectedLsb[channel]});
+                break;
+            case Midi::CC_DATA_ENTRY_MSB:
+                if (selectedMsb[channel] != UNSET || selectedLsb[channel] != UNSET) {
+                    // A new MSB starts a new value; the LSB, if any, follows
+                    found[{Kind::Parameter, channel, parameter}].push_back({index, value, UNSET});
+                }
+                break;
+            case Midi::CC_DATA_ENTRY_LSB:
+                if (selectedMsb[channel] != UNSET || selectedLsb[channel] != UNSET) {
+                    std::vector<Change>& changes = found[{Kind::Parameter, channel, parameter}];
+                    uint8_t msb = changes.empty() ? UNSET : changes.back().msb;
+                    changes.push_back({index, msb, value});
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    for (auto& [key, changes] : found) {
+        auto [kind, channel, parameter] = key;
+        uint32_t begin = static_cast<uint32_t>(changes_.size());
+        changes_.insert(changes_.end(), changes.begin(), changes.end());
+        controllers_.push_back({kind, channel, parameter, begin, static_cast<uint32_t>(changes_.size())});
+
+        // Program: one message; selection: two; parameter: selection plus two data entries
+        maxChaseMessages_ += kind == Kind::Program ? 1 : kind == Kind::Selection ? 2 : 4;
+    }
+}
+
+const SeekIndex::Change* SeekIndex::valueAt(const Controller& controller, size_t index) const {
+    const Change* first = changes_.data() + controller.begin;
+    const Change* last = changes_.data() + controller.end;
+    const Change* next = std::lower_bound(first, last, index,
+                                          [](const Change& change, size_t i) { return change.index < i; });
+    return next == first ? nullptr : next - 1;
+}
+
+size_t SeekIndex::chase(size_t from, size_t to, MidiBatch& out) const {
+    size_t added = 0;
+    uint8_t message[3];
+    auto send = [&](uint8_t status, uint8_t data1, uint8_t data2, size_t size) {
+        message[0] = status;
+        message[1] = data1;
+        message[2] = data2;
+        out.add(EventView(message, size, 0));
+        added++;
+    };
+    auto control = [&](uint8_t channel, uint8_t number, uint8_t value) {
+        if (value != UNSET) {
+            send(Midi::CONTROL_CHANGE | channel, number, value, 3);
+        }
+    };
+
+    uint16_t reselect = 0;      // Channels whose NRPN selection the chase moved
+    for (const Controller& controller : controllers_) {
+        const Change* target = valueAt(controller, to);
+        if (!target) {
+            continue;
+        }
+        const Change* current = valueAt(controller, from);
+        bool changed = !current || current->msb != target->msb || current->lsb != target->lsb;
+
+        switch (controller.kind) {
+            case Kind::Program:
+                if (changed) {
+                    send(Midi::PROGRAM_CHANGE | controller.channel, target->msb, 0, 2);
+                }
+                break;
+            case Kind::Parameter:
+                if (changed) {
+                    control(controller.channel, Midi::CC_NRPN_MSB, static_cast<uint8_t>(controller.parameter >> 8));
+                    control(controller.channel, Midi::CC_NRPN_LSB, static_cast<uint8_t>(controller.parameter & 0xFF));
+                    control(controller.channel, Midi::CC_DATA_ENTRY_MSB, target->msb);
+                    control(controller.channel, Midi::CC_DATA_ENTRY_LSB, target->lsb);
+                    reselect |= static_cast<uint16_t>(1u << controller.channel);
+                }
+                break;
+            case Kind::Selection:
+                break;  // After the parameters, which move it
+        }
+    }
+
+    // Leave each channel's selection where the file has it, for Data Entry that relies on it
+    for (const Controller& controller : controllers_) {
+        if (controller.kind != Kind::Selection) {
+            continue;
+        }
+        const Change* target = valueAt(controller, to);
+        const Change* current = valueAt(controller, from);
+        bool moved = reselect & (1u << controller.channel);
+        if (target && (moved || !current || current->msb != target->msb || current->lsb != target->lsb)) {
+            control(controller.channel, Midi::CC_NRPN_MSB, target->msb);
+            control(controller.channel, Midi::CC_NRPN_LSB, target->lsb);
+        }
+    }
+
+    return added;
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "midi_batch.hpp"
+#include "playback_timeline.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Controller state of a timeline at any event, for seamless seeks
+ *
+ * A seek skips every event between the old and the new position, and with
+ * them the organ stop changes (NRPN parameter, then Data Entry) and
+ * program changes made there. Built once from a complete timeline, the
+ * index keeps, for each controller, the event indices at which its value
+ * changes. The value in effect at any position is then one binary search
+ * per controller instead of a replay from the start of the piece.
+ *
+ * chase() gives the messages that take a device from the state at one
+ * position to the state at another: changed programs, changed NRPN values
+ * (each preceded by its parameter number) and, where the chase moved it,
+ * the parameter selection the file had left in place.
+ *
+ * Notes are not chased; held notes are released on a jump (ActiveNotes).
+ */
+class SeekIndex {
+public:
+    /**
+     * @param timeline Complete timeline
+     */
+    explicit SeekIndex(const PlaybackTimeline& timeline);
+
+    /**
+     * @brief Messages taking the controllers from their state before event @p from to their state before event @p to
+     * @param out Batch the messages are appended to
+     * @return Number of messages appended
+     */
+    size_t chase(size_t from, size_t to, MidiBatch& out) const;
+
+    /**
+     * @brief Programs, NRPN selections and NRPN parameters used in the timeline
+     */
+    size_t getControllerCount() const { return controllers_.size(); }
+
+    /**
+     * @brief Most messages one chase() can append
+     */
+    size_t getMaxChaseMessages() const { return maxChaseMessages_; }
+
+private:
+    enum class Kind : uint8_t {
+        Program,        // Program change; value in msb
+        Selection,      // NRPN parameter selected (CC 99, CC 98)
+        Parameter       // NRPN parameter value (CC 6, CC 38)
+    };
+
+    // A value from an event onwards; UNSET for a half not sent (yet)
+    struct Change {
+        size_t index;       // Event that set it
+        uint8_t msb;
+        uint8_t lsb;
+    };
+
+    struct Controller {
+        Kind kind;
+        uint8_t channel;
+        uint16_t parameter;     // Kind::Parameter only
+        uint32_t begin;         // Its changes in changes_
+        uint32_t end;
+    };
+
+    // Value in effect before event `index`, or nullptr if none yet
+    const Change* valueAt(const Controller& controller, size_t index) const;
+
+    std::vector<Controller> controllers_;   // Programs, then selections, then parameters
+    std::vector<Change> changes_;
+    size_t maxChaseMessages_ = 0;
+
+    static constexpr uint8_t UNSET = 0x80;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,229 @@
+#include "session_telemetry.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace MidiPlay {
+
+namespace {
+
+constexpr const char* PROMETHEUS_SUFFIX = ".prom";
+
+// Escape for a JSON string or a Prometheus label value; titles may hold quotes
+std::string quoted(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+std::string seconds(double value) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3) << value;
+    return text.str();
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+SessionTelemetry::Record SessionTelemetry::collect(const Options& options, const MidiLoader& midiLoader,
+                                                   const StartupProfiler& profiler, const TimingManager& timingManager,
+                                                   const JitterRecorder* recorder, bool cancelled) {
+    Record record;
+    record.timestamp = static_cast<int64_t>(std::time(nullptr));
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    record.host = host;
+    record.platform = platformName();
+    record.version = Options::getSemanticVersion();
+    record.hymn = options.getFileName();
+    record.title = midiLoader.getTitle();
+    record.verses = midiLoader.getVerses();
+    record.fromCache = midiLoader.isLoadedFromCache();
+    record.cancelled = cancelled;
+    record.engine = options.isTimelineEngine() ? "timeline" : "player-sync";
+
+    if (profiler.isEnabled()) {
+        record.preMainUs = profiler.getPreMainNs() >= 0 ? profiler.getPreMainNs() / 1000 : -1;
+        for (size_t i = 0; i < StartupProfiler::PHASE_COUNT; i++) {
+            const StartupProfiler::Sample& sample = profiler.at(static_cast<StartupProfiler::Phase>(i));
+            if (sample.recorded) {
+                record.phaseUs[i] = (sample.endNs - sample.beginNs) / 1000;
+            }
+        }
+        record.startupUs = profiler.getTotalNs() / 1000;
+    }
+
+    record.events = midiLoader.getEventCount();
+    if (recorder) {
+        record.sent = recorder->size();
+        record.dropped = recorder->dropped();
+        for (size_t i = 0; i < record.sent; i++) {
+            const JitterRecorder::Sample& sample = recorder->at(i);
+            int64_t latenessUs = (sample.actualNs - sample.scheduledNs) / 1000;
+            record.late += latenessUs >= LATE_US;
+            record.veryLate += latenessUs >= VERY_LATE_US;
+            record.maxLatenessUs = std::max(record.maxLatenessUs, latenessUs);
+        }
+    }
+
+    float speed = midiLoader.getSpeed();
+    record.expectedSeconds = midiLoader.getProjectedDurationSeconds() / (speed > 0.0f ? speed : 1.0f);
+    record.actualSeconds = timingManager.getElapsedSeconds();
+    record.cpuPercent = timingManager.getCpuPercent();
+    return record;
+}
+
+void SessionTelemetry::writeJson(const Record& record, std::ostream& out) {
+    out << "{\"timestamp\":" << record.timestamp
+        << ",\"host\":" << quoted(record.host)
+        << ",\"platform\":" << quoted(record.platform)
+        << ",\"version\":" << quoted(record.version)
+        << ",\"hymn\":" << quoted(record.hymn)
+        << ",\"title\":" << quoted(record.title)
+        << ",\"verses\":" << record.verses
+        << ",\"from_cache\":" << (record.fromCache ? "true" : "false")
+        << ",\"cancelled\":" << (record.cancelled ? "true" : "false")
+        << ",\"engine\":" << quoted(record.engine)
+        << ",\"pre_main_us\":" << record.preMainUs
+        << ",\"startup_us\":" << record.startupUs
+        << ",\"phases\":{";
+    bool first = true;
+    for (size_t i = 0; i < StartupProfiler::PHASE_COUNT; i++) {
+        if (record.phaseUs[i] < 0) {
+            continue;
+        }
+        out << (first ? "" : ",") << quoted(StartupProfiler::phaseName(static_cast<StartupProfiler::Phase>(i)))
+            << ":" << record.phaseUs[i];
+        first = false;
+    }
+    out << "}"
+        << ",\"load_us\":" << record.phase(StartupProfiler::Phase::LoadFile)
+        << ",\"connect_us\":" << record.phase(StartupProfiler::Phase::ConnectDevice)
+        << ",\"events\":" << record.events
+        << ",\"sent\":" << record.sent
+        << ",\"dropped\":" << record.dropped
+        << ",\"late_1ms\":" << record.late
+        << ",\"late_5ms\":" << record.veryLate
+        << ",\"max_lateness_us\":" << record.maxLatenessUs
+        << ",\"expected_s\":" << seconds(record.expectedSeconds)
+        << ",\"actual_s\":" << seconds(record.actualSeconds)
+        << ",\"cpu_percent\":" << seconds(record.cpuPercent)
+        << "}\n";
+}
+
+void SessionTelemetry::writePrometheus(const Record& record, std::ostream& out) {
+    auto metric = [&out](const char* name, const char* type, const char* help, const std::string& value) {
+        out << "# HELP midiplay_" << name << " " << help << "\n";
+        out << "# TYPE midiplay_" << name << " " << type << "\n";
+        out << "midiplay_" << name << " " << value << "\n";
+    };
+    auto microseconds = [](int64_t us) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(6) << us / 1e6;
+        return text.str();
+    };
+
+    out << "# HELP midiplay_session_info The last hymn played.\n";
+    out << "# TYPE midiplay_session_info gauge\n";
+    out << "midiplay_session_info{version=" << quoted(record.version) << ",platform=" << quoted(record.platform)
+        << ",hymn=" << quoted(record.hymn) << ",title=" << quoted(record.title) << ",engine=" << quoted(record.engine)
+        << "} 1\n";
+    metric("session_timestamp_seconds", "gauge", "When the last hymn finished.", std::to_string(record.timestamp));
+    metric("session_cancelled", "gauge", "1 if the last hymn was stopped before the end.", record.cancelled ? "1" : "0");
+    metric("session_from_cache", "gauge", "1 if the last hymn was loaded from the hymn cache.", record.fromCache ? "1" : "0");
+
+    if (record.startupUs >= 0) {
+        out << "# HELP midiplay_startup_phase_seconds Time each startup phase took.\n";
+        out << "# TYPE midiplay_startup_phase_seconds gauge\n";
+        for (size_t i = 0; i < StartupProfiler::PHASE_COUNT; i++) {
+            if (record.phaseUs[i] >= 0) {
+                out << "midiplay_startup_phase_seconds{phase="
+                    << quoted(StartupProfiler::phaseName(static_cast<StartupProfiler::Phase>(i))) << "} "
+                    << microseconds(record.phaseUs[i]) << "\n";
+            }
+        }
+        metric("startup_seconds", "gauge", "From main() to the end of the last startup phase.",
+               microseconds(record.startupUs));
+    }
+    if (record.preMainUs >= 0) {
+        metric("pre_main_seconds", "gauge", "From exec() to main().", microseconds(record.preMainUs));
+    }
+
+    metric("events", "gauge", "Events in the hymn as loaded.", std::to_string(record.events));
+    metric("events_sent", "gauge", "Events sent to the port, including repeats.", std::to_string(record.sent));
+    metric("events_unrecorded", "gauge", "Sends not timed because the recorder was full.", std::to_string(record.dropped));
+    metric("events_late_1ms", "gauge", "Events sent 1 ms or more after their time.", std::to_string(record.late));
+    metric("events_late_5ms", "gauge", "Events sent 5 ms or more after their time.", std::to_string(record.veryLate));
+    metric("max_lateness_seconds", "gauge", "Latest send after its time.", microseconds(record.maxLatenessUs));
+    metric("expected_duration_seconds", "gauge", "Projected playing time, without ritardandos.",
+           seconds(record.expectedSeconds));
+    metric("actual_duration_seconds", "gauge", "Elapsed playing time.", seconds(record.actualSeconds));
+    metric("cpu_percent", "gauge", "CPU time while playing, in percent of one core.", seconds(record.cpuPercent));
+}
+
+bool SessionTelemetry::write(const Record& record, const std::string& path) {
+    std::ostringstream text;
+
+    if (endsWith(path, PROMETHEUS_SUFFIX)) {
+        // The collector reads only *.prom, so it never sees the file half-written
+        writePrometheus(record, text);
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            out << text.str();
+            if (!out.flush()) {
+                return false;
+            }
+        }
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    // One write() on an O_APPEND descriptor: concurrent sessions append whole lines
+    writeJson(record, text);
+    std::string line = text.str();
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t written;
+    do {
+        written = ::write(fd, line.data(), line.size());
+    } while (written < 0 && errno == EINTR);
+    close(fd);
+    return written == static_cast<ssize_t>(line.size());
+}
+
+std::string SessionTelemetry::platformName() {
+    std::ifstream model("/proc/device-tree/model");
+    std::string name;
+    if (model && std::getline(model, name, '\0') && !name.empty()) {
+        return name;
+    }
+    utsname system{};
+    if (uname(&system) == 0) {
+        return system.machine;
+    }
+    return "unknown";
+}
+
+} // namespace MidiPlay
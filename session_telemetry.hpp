@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "jitter_recorder.hpp"
+#include "midi_loader.hpp"
+#include "options.hpp"
+#include "startup_profiler.hpp"
+#include "timing_manager.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief One record per played hymn, for collecting across many units (--telemetry)
+ *
+ * After playback, with the player thread stopped, collect() gathers what the
+ * session already measured: the startup phases (StartupProfiler), the send
+ * lateness of every event (JitterRecorder) and the elapsed time
+ * (TimingManager). Nothing is measured for the record itself while the hymn
+ * plays beyond what JitterRecorder does.
+ *
+ * write() appends the record to a file as one JSON line, or, for a path
+ * ending in ".prom", replaces a Prometheus textfile for node_exporter's
+ * textfile collector. Slow SD cards show as long load times, overloaded
+ * units as late events.
+ */
+class SessionTelemetry {
+public:
+    // Lateness thresholds of the late-event counts
+    static constexpr int64_t LATE_US = 1000;
+    static constexpr int64_t VERY_LATE_US = 5000;
+
+    struct Record {
+        int64_t timestamp = 0;          // Unix seconds at the end of the session
+        std::string host;
+        std::string platform;
+        std::string version;
+        std::string hymn;               // File name as given
+        std::string title;
+        int verses = 0;
+        bool fromCache = false;
+        bool cancelled = false;
+        std::string engine;             // "timeline" or "player-sync"
+
+        // Startup, in microseconds; -1 if the phase did not run or was not timed
+        int64_t preMainUs = -1;
+        std::array<int64_t, StartupProfiler::PHASE_COUNT> phaseUs{};
+        int64_t startupUs = -1;         // main() to the end of the last phase
+
+        size_t events = 0;              // Loaded
+        size_t sent = 0;                // Sent to the port, including repeats
+        size_t dropped = 0;             // Sends past the recorder's capacity, not in the counts
+        size_t late = 0;                // At least LATE_US after schedule
+        size_t veryLate = 0;            // At least VERY_LATE_US after schedule
+        int64_t maxLatenessUs = 0;
+
+        double expectedSeconds = 0.0;   // Projected at the speed set; ritardandos are not modelled
+        double actualSeconds = 0.0;
+        double cpuPercent = 0.0;
+
+        Record() { phaseUs.fill(-1); }
+
+        int64_t phase(StartupProfiler::Phase phase) const { return phaseUs[static_cast<size_t>(phase)]; }
+    };
+
+    /**
+     * @brief Gather the record of a session that has finished playing
+     * @param recorder Lateness of every send; nullptr leaves the counts at 0
+     * @param cancelled Playback was stopped before the end
+     */
+    static Record collect(const Options& options, const MidiLoader& midiLoader, const StartupProfiler& profiler,
+                          const TimingManager& timingManager, const JitterRecorder* recorder, bool cancelled);
+
+    /**
+     * @brief Write the record as a single line of JSON
+     */
+    static void writeJson(const Record& record, std::ostream& out);
+
+    /**
+     * @brief Write the record in the Prometheus text exposition format
+     */
+    static void writePrometheus(const Record& record, std::ostream& out);
+
+    /**
+     * @brief Append a JSON line to path, or replace it as a Prometheus textfile if it ends in ".prom"
+     *
+     * The JSON line goes out in one append, so sessions writing to the same
+     * file do not interleave. The textfile is written beside the path and
+     * renamed over it, so a collector never reads half a file.
+     * @return false if the file could not be written
+     */
+    static bool write(const Record& record, const std::string& path);
+
+    /**
+     * @brief Board model (e.g. "Raspberry Pi 5 Model B Rev 1.0") or machine architecture
+     */
+    static std::string platformName();
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,87 @@
+#include "setlist.hpp"
+#include "i18n.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+namespace MidiPlay {
+
+bool Setlist::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        entries_.clear();
+        error_ = _("Cannot read setlist ") + path;
+        return false;
+    }
+
+    std::ostringstream text;
+    text << in.rdbuf();
+    return parse(text.str());
+}
+
+bool Setlist::parse(const std::string& text) {
+    entries_.clear();
+    error_.clear();
+
+    std::istringstream in(text);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+
+        SetlistEntry entry;
+        entry.lineNumber = lineNumber;
+        if (!splitArguments(line, entry.args)) {
+            entries_.clear();
+            error_ = _("Unterminated quote in setlist line ") + std::to_string(lineNumber);
+            return false;
+        }
+        if (!entry.args.empty()) {
+            entries_.push_back(std::move(entry));
+        }
+    }
+
+    if (entries_.empty()) {
+        error_ = _("The setlist has no hymns");
+        return false;
+    }
+    return true;
+}
+
+bool Setlist::splitArguments(const std::string& line, std::vector<std::string>& args) {
+    args.clear();
+
+    size_t i = 0;
+    while (i < line.size()) {
+        // Skip the blanks between arguments
+        while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) {
+            i++;
+        }
+        if (i == line.size() || line[i] == '#') {
+            break;  // End of line or comment
+        }
+
+        // One argument; quotes group blanks and may appear anywhere in it
+        std::string arg;
+        while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) {
+            char c = line[i++];
+            if (c == '"' || c == '\'') {
+                size_t close = line.find(c, i);
+                if (close == std::string::npos) {
+                    args.clear();
+                    return false;
+                }
+                arg.append(line, i, close - i);
+                i = close + 1;
+            } else {
+                arg += c;
+            }
+        }
+        args.push_back(std::move(arg));
+    }
+
+    return true;
+}
+
+} // namespace MidiPlay
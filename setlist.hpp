@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace MidiPlay {
+
+/**
+ * @brief One hymn of a setlist
+ */
+struct SetlistEntry {
+    std::vector<std::string> args;  // Hymn file name and its options, as typed on the line
+    int lineNumber = 0;             // 1-based line in the setlist file, for messages
+};
+
+/**
+ * @brief Ordered list of hymns for a service (--setlist)
+ *
+ * A setlist file has one hymn per line, written as its play command line
+ * without the command itself:
+ *
+ *     # Sacrament meeting
+ *     prelude -p                 # Prelude at 90%
+ *     2 -n3
+ *     "169" -x2 -t80
+ *
+ * Arguments are separated by blanks; single or double quotes group an
+ * argument containing blanks. A '#' at the start of an argument begins a
+ * comment. Blank lines and comment lines are ignored.
+ */
+class Setlist {
+public:
+    /**
+     * @brief Read a setlist file
+     * @return false if the file cannot be read, has an unterminated quote or
+     *         lists no hymns; see getError()
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Read a setlist from text
+     * @return false on an unterminated quote or no hymns; see getError()
+     */
+    bool parse(const std::string& text);
+
+    const std::vector<SetlistEntry>& entries() const { return entries_; }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    const std::string& getError() const { return error_; }
+
+    /**
+     * @brief Split one line into arguments
+     * @param line Line text
+     * @param args Receives the arguments; empty for a blank or comment line
+     * @return false on an unterminated quote
+     */
+    static bool splitArguments(const std::string& line, std::vector<std::string>& args);
+
+private:
+    std::vector<SetlistEntry> entries_;
+    std::string error_;
+};
+
+} // namespace MidiPlay
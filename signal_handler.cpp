@@ -36,6 +36,12 @@ void SignalHandler::handleSignal(int signum) {
 }
 
 void SignalHandler::emergencyNotesOff() {
+    // Only the notes that are sounding: lock-free and allocation-free
+    if (m_activeNotes != nullptr) {
+        m_activeNotes->release(m_outport, m_panicMessage, true);
+        return;
+    }
+    
     // Turn all notes off to prevent stuck notes
     Event e;
     
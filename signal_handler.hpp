@@ -2,11 +2,12 @@
 
 #include <signal.h>
 #include <chrono>
-#include <cxxmidi/output/default.hpp>
+#include <cxxmidi/output/abstract.hpp>
 #include <cxxmidi/event.hpp>
 #include <cxxmidi/note.hpp>
 #include <cxxmidi/message.hpp>
 
+#include "active_notes.hpp"
 #include "playback_synchronizer.hpp"
 
 namespace MidiPlay {
@@ -24,7 +25,7 @@ class SignalHandler {
 public:
     /**
      * @brief Constructor - dependency injection
-     * @param outport Reference to MIDI output port for emergency notes-off
+     * @param outport Reference to MIDI output port for emergency notes-off (the port playback writes to)
      * @param synchronizer Reference to PlaybackSynchronizer for synchronization
      * @param startTime Reference to start time for elapsed time calculation
      */
@@ -48,6 +49,12 @@ public:
      */
     ~SignalHandler();
     
+    /**
+     * @brief Release only the notes the engine reports as held on interrupt
+     * @param notes Bitmap updated by the playback engine, or nullptr for a full sweep
+     */
+    void setActiveNotes(ActiveNotes* notes) { m_activeNotes = notes; }
+    
     /**
      * @brief Setup signal handling - registers the SIGINT handler
      */
@@ -67,16 +74,20 @@ public:
 
 private:
     // Dependencies injected via constructor
-    cxxmidi::output::Default& m_outport;
+    cxxmidi::output::Abstract& m_outport;
     PlaybackSynchronizer& m_synchronizer;
     const std::chrono::time_point<std::chrono::high_resolution_clock>& m_startTime;
+    ActiveNotes* m_activeNotes = nullptr;
+    cxxmidi::Message m_panicMessage = cxxmidi::Message(0, 0, 0);  // Preallocated: no allocation in the handler
     
     // Static instance pointer for signal handler access
     inline static SignalHandler* s_instance = nullptr;
     
     /**
-     * @brief Send emergency notes-off to all channels and notes
-     * Prevents stuck notes when application is interrupted
+     * @brief Send emergency notes-off
+     * Releases the held notes plus All Notes Off when active notes are tracked,
+     * otherwise sweeps C2-C7 on channels 1-3. Prevents stuck notes when
+     * application is interrupted
      */
     void emergencyNotesOff();
     
@@ -0,0 +1,210 @@
+#include "smf_reader.hpp"
+#include "i18n.hpp"
+#include "midi_constants.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace MidiPlay {
+
+namespace {
+
+constexpr size_t CHUNK_HEADER_SIZE = 8;     // Four-character type, 32-bit big-endian length
+constexpr size_t HEADER_DATA_SIZE = 6;      // Format, track count, time division
+constexpr uint16_t SMPTE_DIVISION = 0x8000;
+
+uint32_t readBigEndian(const uint8_t* bytes, size_t count) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < count; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+} // namespace
+
+SmfReader::Track::Track(const uint8_t* data, size_t size)
+    : data_(data)
+    , size_(size)
+{
+}
+
+bool SmfReader::Track::next(cxxmidi::Event& event) {
+    if (atEnd()) {
+        return false;
+    }
+
+    uint32_t dt = readVariableLength();
+    tick_ += dt;
+    event.SetDt(dt);
+    readMessage(readStatus(), event);
+    return true;
+}
+
+bool SmfReader::Track::nextLoadable(cxxmidi::Event& event) {
+    uint32_t dt = 0;
+    while (!atEnd()) {
+        dt += readVariableLength();
+        uint8_t status = readStatus();
+        if (skipDiscarded(status)) {
+            continue;   // Its time passes on to the next event
+        }
+
+        tick_ += dt;
+        event.SetDt(dt);
+        readMessage(status, event);
+        return true;
+    }
+    return false;
+}
+
+uint8_t SmfReader::Track::readStatus() {
+    if (atEnd()) {
+        throw std::runtime_error(_("Truncated MIDI track"));
+    }
+    uint8_t status = data_[position_] & 0x80 ? readByte() : runningStatus_;
+    if (status == 0) {
+        throw std::runtime_error(_("MIDI data byte without a status byte"));
+    }
+    return status;
+}
+
+void SmfReader::Track::readMessage(uint8_t status, cxxmidi::Event& event) {
+    event.clear();
+
+    if (status == Midi::META_STATUS || status == Midi::SYSEX_BEGIN || status == Midi::SYSEX_END) {
+        // Meta events and SysEx cancel running status
+        runningStatus_ = 0;
+        event.push_back(status);
+        if (status == Midi::META_STATUS) {
+            event.push_back(readByte());
+        }
+
+        uint32_t length = readVariableLength();
+        if (length > size_ - position_) {
+            throw std::runtime_error(_("Truncated MIDI track"));
+        }
+        event.insert(event.end(), data_ + position_, data_ + position_ + length);
+        position_ += length;
+        return;
+    }
+
+    // Voice message: program change and channel pressure have one data byte
+    runningStatus_ = status;
+    size_t dataBytes = dataBytesOf(status);
+    event.push_back(status);
+    for (size_t i = 0; i < dataBytes; i++) {
+        event.push_back(readByte());
+    }
+}
+
+// The same decisions EventPreProcessor makes first for every event, from the raw bytes
+bool SmfReader::Track::skipDiscarded(uint8_t status) {
+    if (status == Midi::SYSEX_BEGIN || status == Midi::SYSEX_END) {
+        runningStatus_ = 0;
+        skipLength();
+        return true;
+    }
+
+    if (status == Midi::META_STATUS) {
+        if (atEnd() || data_[position_] != Midi::META_LYRICS) {
+            return false;
+        }
+        runningStatus_ = 0;
+        position_++;
+        skipLength();
+        return true;
+    }
+
+    if ((status & Midi::STATUS_TYPE_MASK) != Midi::CONTROL_CHANGE) {
+        return false;
+    }
+    if (size_ - position_ < 2) {
+        throw std::runtime_error(_("Truncated MIDI track"));
+    }
+    uint8_t controller = data_[position_];
+    if (controller == Midi::CC_NRPN_MSB || controller == Midi::CC_NRPN_LSB
+        || controller == Midi::CC_DATA_ENTRY_MSB || controller == Midi::CC_DATA_ENTRY_LSB) {
+        return false;   // Organ stop settings
+    }
+    runningStatus_ = status;
+    position_ += 2;
+    return true;
+}
+
+void SmfReader::Track::skipLength() {
+    uint32_t length = readVariableLength();
+    if (length > size_ - position_) {
+        throw std::runtime_error(_("Truncated MIDI track"));
+    }
+    position_ += length;
+}
+
+size_t SmfReader::Track::dataBytesOf(uint8_t status) {
+    uint8_t type = status & Midi::STATUS_TYPE_MASK;
+    return (type == 0xC0 || type == 0xD0) ? 1 : 2;
+}
+
+uint32_t SmfReader::Track::readVariableLength() {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t byte = readByte();
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error(_("Invalid variable-length quantity in MIDI track"));
+}
+
+uint8_t SmfReader::Track::readByte() {
+    if (atEnd()) {
+        throw std::runtime_error(_("Truncated MIDI track"));
+    }
+    return data_[position_++];
+}
+
+bool SmfReader::open(const std::string& path) {
+    tracks_.clear();
+    error_.clear();
+
+    file_ = MappedFile(path);
+    if (!file_.isOpen()) {
+        error_ = _("Cannot read ") + path;
+        return false;
+    }
+
+    const uint8_t* data = file_.data();
+    size_t size = file_.size();
+    if (size < CHUNK_HEADER_SIZE + HEADER_DATA_SIZE || std::memcmp(data, "MThd", 4) != 0) {
+        error_ = path + _(" is not a MIDI file");
+        return false;
+    }
+
+    size_t headerSize = readBigEndian(data + 4, 4);
+    if (headerSize < HEADER_DATA_SIZE || headerSize > size - CHUNK_HEADER_SIZE) {
+        error_ = path + _(" has an invalid MIDI header");
+        return false;
+    }
+
+    timeDivision_ = static_cast<uint16_t>(readBigEndian(data + CHUNK_HEADER_SIZE + 4, 2));
+    if (timeDivision_ == 0 || (timeDivision_ & SMPTE_DIVISION)) {
+        error_ = path + _(" does not use PPQ time division");
+        return false;
+    }
+
+    // Track chunks in file order; chunks of other types are skipped, a short last chunk is clipped
+    size_t offset = CHUNK_HEADER_SIZE + headerSize;
+    while (offset + CHUNK_HEADER_SIZE <= size) {
+        size_t length = std::min<size_t>(readBigEndian(data + offset + 4, 4), size - offset - CHUNK_HEADER_SIZE);
+        if (std::memcmp(data + offset, "MTrk", 4) == 0) {
+            tracks_.push_back({data + offset + CHUNK_HEADER_SIZE, length});
+        }
+        offset += CHUNK_HEADER_SIZE + length;
+    }
+
+    return true;
+}
+
+} // namespace MidiPlay
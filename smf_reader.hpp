@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cxxmidi/event.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Standard MIDI File decoder working straight on the mapped file
+ *
+ * Used by MidiLoader, StreamingLoader and HymnalLinter. open() maps the
+ * file and locates the track chunks; each Track cursor then decodes its
+ * chunk one event at a time, independently of the others, so tracks can be
+ * walked one after another or interleaved in time order.
+ *
+ * Events come out in the same form cxxmidi loads them: voice messages with
+ * running status resolved, meta events as status, type and data (no
+ * length), SysEx as status and data.
+ */
+class SmfReader {
+public:
+    /**
+     * @brief Decoding position in one track chunk
+     */
+    class Track {
+    public:
+        Track() = default;
+        Track(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Decode the next event
+         * @param event Receives the delta time and message bytes; its storage is reused
+         * @return false at the end of the chunk
+         * @throws std::runtime_error on a truncated or malformed event
+         */
+        bool next(cxxmidi::Event& event);
+
+        /**
+         * @brief Decode the next event EventPreProcessor may keep
+         *
+         * SysEx, lyrics and controllers other than NRPN and Data Entry are
+         * always discarded by the preprocessor; they are stepped over in
+         * the raw bytes without being decoded into @p event, and their
+         * delta times are added to the event returned. Everything else,
+         * meta events included, comes out as from next().
+         * @return false at the end of the chunk
+         * @throws std::runtime_error on a truncated or malformed event
+         */
+        bool nextLoadable(cxxmidi::Event& event);
+
+        bool atEnd() const { return position_ >= size_; }
+
+        /**
+         * @brief Absolute tick of the last event decoded
+         */
+        uint32_t tick() const { return tick_; }
+
+    private:
+        uint8_t readStatus();
+        void readMessage(uint8_t status, cxxmidi::Event& event);
+        bool skipDiscarded(uint8_t status);
+        void skipLength();
+        static size_t dataBytesOf(uint8_t status);
+        uint32_t readVariableLength();
+        uint8_t readByte();
+
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+        size_t position_ = 0;
+        uint32_t tick_ = 0;
+        uint8_t runningStatus_ = 0;
+    };
+
+    /**
+     * @brief Map a file and read its header and track table
+     * @return false if the file cannot be read or is not a Standard MIDI File
+     *         with PPQ time division; see getError()
+     */
+    bool open(const std::string& path);
+
+    uint16_t getTimeDivision() const { return timeDivision_; }
+    size_t getTrackCount() const { return tracks_.size(); }
+
+    /**
+     * @brief Cursor at the start of a track
+     */
+    Track track(size_t index) const { return Track(tracks_[index].data, tracks_[index].size); }
+
+    const std::string& getError() const { return error_; }
+
+private:
+    struct Chunk {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    MappedFile file_;
+    std::vector<Chunk> tracks_;
+    uint16_t timeDivision_ = 0;
+    std::string error_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <type_traits>
+
+namespace MidiPlay {
+
+/**
+ * @brief Bounded lock-free queue for one producer thread and one consumer thread
+ *
+ * A ring of Capacity slots (a power of two) with a head index written only
+ * by the consumer and a tail index written only by the producer, each on its
+ * own cache line. push() and pop() are a few loads and one release store:
+ * no lock, no allocation, no system call, so the consumer may be the player
+ * thread. A full queue refuses the element instead of waiting.
+ *
+ * Indices run freely and are masked on access; the size is tail - head.
+ */
+template<typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "Elements are copied in and out of the ring");
+
+public:
+    SpscQueue() = default;
+
+    // Disable copy/move
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Append an element (producer thread only)
+     * @return false if the queue is full
+     */
+    bool push(const T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        slots_[tail & MASK] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest element (consumer thread only)
+     * @return std::nullopt if the queue is empty
+     */
+    std::optional<T> pop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        T value = slots_[head & MASK];
+        head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    /**
+     * @brief Elements queued; exact only on the producer or consumer thread
+     */
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    alignas(CACHE_LINE) std::array<T, Capacity> slots_{};
+};
+
+} // namespace MidiPlay
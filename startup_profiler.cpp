@@ -0,0 +1,176 @@
+#include "startup_profiler.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+
+#include "i18n.hpp"
+
+namespace MidiPlay {
+
+StartupProfiler::StartupProfiler(bool enabled)
+    : enabled_(enabled)
+{
+    if (enabled_) {
+        originNs_ = now();
+        preMainNs_ = readPreMainNs();
+    }
+}
+
+bool StartupProfiler::isRequested(int argc, char** argv) {
+    // --telemetry records the phases too
+    static constexpr const char* OPTIONS[] = {"--profile-startup", "--telemetry"};
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--") == 0) {
+            break;
+        }
+        for (const char* option : OPTIONS) {
+            if (std::strncmp(argv[i], option, std::strlen(option)) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int64_t StartupProfiler::now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Process start time is field 22 of /proc/self/stat, in clock ticks since boot
+int64_t StartupProfiler::readPreMainNs() {
+    std::ifstream in("/proc/self/stat");
+    std::string stat;
+    if (!std::getline(in, stat)) {
+        return -1;
+    }
+
+    // The command name (field 2) may contain spaces; fields after it are plain
+    size_t commandEnd = stat.rfind(')');
+    if (commandEnd == std::string::npos) {
+        return -1;
+    }
+    std::istringstream fields(stat.substr(commandEnd + 1));
+    std::string field;
+    for (int i = 3; i < 22; i++) {
+        fields >> field;
+    }
+    unsigned long long startTicks = 0;
+    if (!(fields >> startTicks)) {
+        return -1;
+    }
+
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    timespec boot;
+    if (ticksPerSecond <= 0 || clock_gettime(CLOCK_BOOTTIME, &boot) != 0) {
+        return -1;
+    }
+    int64_t bootNs = static_cast<int64_t>(boot.tv_sec) * 1000000000 + boot.tv_nsec;
+    int64_t startNs = static_cast<int64_t>(startTicks) * (1000000000 / ticksPerSecond);
+    return bootNs > startNs ? bootNs - startNs : 0;
+}
+
+int64_t StartupProfiler::getTotalNs() const {
+    int64_t total = 0;
+    for (const Sample& sample : samples_) {
+        if (sample.recorded && sample.endNs > total) {
+            total = sample.endNs;
+        }
+    }
+    return total;
+}
+
+const char* StartupProfiler::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::InitializeI18n:     return "initializeI18n";
+        case Phase::ParseOptions:       return "Options::parse";
+        case Phase::DaemonConnect:      return "DaemonClient::connect";
+        case Phase::ResolvePath:        return "getFullPath";
+        case Phase::LoadFile:           return "MidiLoader::loadFile";
+        case Phase::PortCount:          return "GetPortCount";
+        case Phase::LoadDevicePresets:  return "loadDevicePresets";
+        case Phase::ConnectDevice:      return "connectAndDetectDevice";
+        case Phase::ConfigureDevice:    return "createAndConfigureDevice";
+    }
+    return "";
+}
+
+void StartupProfiler::print(std::ostream& out) const {
+    auto milliseconds = [](int64_t ns) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(3) << ns / 1e6;
+        return text.str();
+    };
+
+    out << _("Startup (milliseconds):") << std::endl;
+    if (preMainNs_ >= 0) {
+        out << "  " << std::left << std::setw(28) << _("exec to main")
+            << std::right << std::setw(10) << milliseconds(preMainNs_) << std::endl;
+    }
+
+    // Time between phases (printing, option checks) shows up as "other"
+    int64_t measured = 0;
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        const Sample& sample = samples_[i];
+        if (!sample.recorded) {
+            continue;
+        }
+        measured += sample.endNs - sample.beginNs;
+        out << "  " << std::left << std::setw(28) << phaseName(static_cast<Phase>(i))
+            << std::right << std::setw(10) << milliseconds(sample.endNs - sample.beginNs) << std::endl;
+    }
+    int64_t total = getTotalNs();
+    out << "  " << std::left << std::setw(28) << _("other")
+        << std::right << std::setw(10) << milliseconds(total - measured) << std::endl;
+    out << "  " << std::left << std::setw(28) << _("total")
+        << std::right << std::setw(10) << milliseconds(total) << std::endl;
+}
+
+bool StartupProfiler::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+
+    // Phase names and host names need no escaping beyond quotes and backslashes
+    auto quoted = [](const std::string& text) {
+        std::string result = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result + "\"";
+    };
+
+    out << "{\n";
+    out << "  \"host\": " << quoted(host) << ",\n";
+    out << "  \"pre_main_us\": " << (preMainNs_ >= 0 ? preMainNs_ / 1000 : -1) << ",\n";
+    out << "  \"total_us\": " << getTotalNs() / 1000 << ",\n";
+    out << "  \"phases\": [";
+    bool first = true;
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        const Sample& sample = samples_[i];
+        if (!sample.recorded) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n");
+        out << "    {\"name\": " << quoted(phaseName(static_cast<Phase>(i)))
+            << ", \"start_us\": " << sample.beginNs / 1000
+            << ", \"duration_us\": " << (sample.endNs - sample.beginNs) / 1000 << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace MidiPlay {
+
+/**
+ * @brief Times the phases of startup (--profile-startup)
+ *
+ * main() brackets each phase between begin() and end(); the phases run one
+ * after another, so the report shows where the time from main() to the
+ * first note goes on this machine. Phases that did not run (the daemon
+ * check without a daemon socket, for example) are left out of the report.
+ *
+ * Disabled, begin() and end() are an inline test of one flag: no clock
+ * read, no allocation. The first two phases run before the options are
+ * parsed, so whether to profile is decided from the raw command line with
+ * isRequested().
+ *
+ * Times are CLOCK_MONOTONIC nanoseconds relative to construction.
+ */
+class StartupProfiler {
+public:
+    enum class Phase : uint8_t {
+        InitializeI18n,
+        ParseOptions,
+        DaemonConnect,
+        ResolvePath,
+        LoadFile,
+        PortCount,
+        LoadDevicePresets,
+        ConnectDevice,
+        ConfigureDevice,
+    };
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(Phase::ConfigureDevice) + 1;
+
+    struct Sample {
+        int64_t beginNs = 0;
+        int64_t endNs = 0;
+        bool recorded = false;
+    };
+
+    /**
+     * @param enabled Record phases; false makes every call a no-op
+     */
+    explicit StartupProfiler(bool enabled);
+
+    // Disable copy/move
+    StartupProfiler(const StartupProfiler&) = delete;
+    StartupProfiler& operator=(const StartupProfiler&) = delete;
+
+    /**
+     * @brief Whether the command line asks for --profile-startup or --telemetry, before Options parses it
+     */
+    static bool isRequested(int argc, char** argv);
+
+    void begin(Phase phase) {
+        if (enabled_) {
+            samples_[index(phase)].beginNs = now() - originNs_;
+        }
+    }
+
+    void end(Phase phase) {
+        if (enabled_) {
+            Sample& sample = samples_[index(phase)];
+            sample.endNs = now() - originNs_;
+            sample.recorded = true;
+        }
+    }
+
+    bool isEnabled() const { return enabled_; }
+    const Sample& at(Phase phase) const { return samples_[index(phase)]; }
+
+    /**
+     * @brief Time from exec() to construction, from /proc (clock tick resolution)
+     * @return -1 if unknown
+     */
+    int64_t getPreMainNs() const { return preMainNs_; }
+
+    /**
+     * @brief End of the last recorded phase
+     */
+    int64_t getTotalNs() const;
+
+    /**
+     * @brief Name of a phase, after the function it times
+     */
+    static const char* phaseName(Phase phase);
+
+    /**
+     * @brief Print the breakdown in milliseconds
+     */
+    void print(std::ostream& out) const;
+
+    /**
+     * @brief Write the breakdown as JSON, for collecting across machines
+     * @return false if the file could not be written
+     */
+    bool writeJson(const std::string& path) const;
+
+private:
+    static constexpr size_t index(Phase phase) { return static_cast<size_t>(phase); }
+    static int64_t now();
+    static int64_t readPreMainNs();
+
+    bool enabled_;
+    int64_t originNs_ = 0;
+    int64_t preMainNs_ = -1;
+    std::array<Sample, PHASE_COUNT> samples_{};
+};
+
+} // namespace MidiPlay
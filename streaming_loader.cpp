@@ -0,0 +1,174 @@
+#include "streaming_loader.hpp"
+#include "event_view.hpp"
+#include "registration_scheduler.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using cxxmidi::Event;
+using cxxmidi::Message;
+
+namespace MidiPlay {
+
+StreamingLoader::StreamingLoader(const std::string& path, const Options& options, EventPreProcessor& processor)
+    : path_(path)
+    , rewrite_(options)
+{
+    if (!reader_.open(path)) {
+        throw std::runtime_error(reader_.getError());
+    }
+
+    scan(options, processor);
+
+    // All tracks, merged, up to the end of the first measures
+    const TimeSignature& timeSignature = processor.getTimeSignature();
+    uint64_t beats = timeSignature.beatsPerMeasure > 0 ? timeSignature.beatsPerMeasure : 4;
+    uint64_t denominator = timeSignature.beatsPerMeasure > 0 ? timeSignature.denominator : 2;   // Power of two
+    uint64_t ticksPerMeasure = static_cast<uint64_t>(reader_.getTimeDivision()) * 4 * beats >> denominator;
+    fill(HEAD_MEASURES * ticksPerMeasure);
+    timeline_->publish();
+    unpublished_ = 0;
+}
+
+StreamingLoader::~StreamingLoader() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void StreamingLoader::start(HymnCache cache, PreprocessedMetadata metadata) {
+    thread_ = std::thread(&StreamingLoader::run, this, std::move(cache), std::move(metadata));
+}
+
+cxxmidi::File StreamingLoader::takeFile() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    return std::move(file_);
+}
+
+// Every event once, track after track as cxxmidi loads them; nothing is kept but the decisions
+void StreamingLoader::scan(const Options& options, EventPreProcessor& processor) {
+    size_t eventCapacity = 0;
+    size_t byteCapacity = 0;
+
+    size_t trackCount = reader_.getTrackCount();
+    keep_.resize(trackCount);
+    file_.resize(trackCount);
+    file_.SetTimeDivision(reader_.getTimeDivision());
+
+    Event event;    // Storage reused for every event
+    for (size_t t = 0; t < trackCount; t++) {
+        SmfReader::Track track = reader_.track(t);
+        size_t kept = 0;
+        uint32_t keptTick = 0;
+
+        while (track.nextLoadable(event)) {
+            bool keep = processor.processEvent(event, options);
+            keep_[t].push_back(keep);
+            if (!keep) {
+                continue;
+            }
+
+            kept++;
+            keptTick = track.tick();
+
+            EventView view(event);
+            if (view.isMeta(Message::MetaType::EndOfTrack)) {
+                continue;   // Ends the track; not a timeline event
+            }
+            eventCapacity++;
+            byteCapacity += event.size();
+        }
+
+        file_[t].reserve(kept);
+        eventCount_ += kept;
+        totalTicks_ = std::max(totalTicks_, keptTick);
+    }
+
+    // Tempo map fixed before anything is published; later tracks win at equal ticks, as in playback order
+    timeline_ = std::make_unique<PlaybackTimeline>(reader_.getTimeDivision(), eventCapacity, byteCapacity);
+    timeline_->setTempoMap(TempoMap(reader_.getTimeDivision(), processor.getTempoChanges()));
+
+    cursors_.resize(trackCount);
+    for (size_t t = 0; t < trackCount; t++) {
+        cursors_[t].track = reader_.track(t);
+        advance(cursors_[t]);
+    }
+}
+
+// Merge the tracks' loaded events into the timeline and the file, up to a tick
+void StreamingLoader::fill(uint64_t untilTick) {
+    while (true) {
+        // Few tracks, so a linear scan for the earliest one is cheapest.
+        // Strict comparison keeps the lower track first on equal ticks.
+        size_t next = cursors_.size();
+        uint32_t tick = std::numeric_limits<uint32_t>::max();
+        for (size_t t = 0; t < cursors_.size(); t++) {
+            if (cursors_[t].pending && cursors_[t].track.tick() < tick) {
+                next = t;
+                tick = cursors_[t].track.tick();
+            }
+        }
+        if (next == cursors_.size() || tick > untilTick) {
+            return;
+        }
+
+        // Publish only between ticks, so a reader always gets whole chords
+        if (unpublished_ >= PUBLISH_INTERVAL && tick != lastTick_) {
+            timeline_->publish();
+            unpublished_ = 0;
+        }
+
+        Cursor& cursor = cursors_[next];
+        if (keep_[next][cursor.index]) {
+            Event& event = cursor.event;
+            rewrite_.apply(event);
+
+            // Dropped events pass their delta time on
+            event.SetDt(tick - cursor.keptTick);
+            cursor.keptTick = tick;
+            file_[next].push_back(event);
+
+            if (EventView(event).isMeta(Message::MetaType::EndOfTrack)) {
+                timeline_->extendTo(tick);
+            } else {
+                timeline_->append(tick, event.data(), event.size());
+                unpublished_++;
+                lastTick_ = tick;
+            }
+        }
+
+        cursor.index++;
+        advance(cursor);
+    }
+}
+
+void StreamingLoader::advance(Cursor& cursor) {
+    cursor.pending = cursor.track.nextLoadable(cursor.event);
+}
+
+// Producer thread
+void StreamingLoader::run(HymnCache cache, PreprocessedMetadata metadata) {
+    bool filled = true;
+    try {
+        fill(std::numeric_limits<uint64_t>::max());
+    }
+    catch (const std::exception&) {
+        filled = false;     // Cannot happen after a clean scan; play what there is
+    }
+    timeline_->publish();
+    seekIndex_ = std::make_unique<SeekIndex>(*timeline_);
+    timeline_->complete();      // Releases the index to the player with the last events
+
+    if (filled) {
+        // Played as written this time; the file handed over, and the cache, get the registration scheduled
+        RegistrationScheduler::schedule(file_, metadata.directives);
+        if (!cache.getDirectory().empty()) {
+            cache.store(path_, file_, metadata);
+        }
+    }
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_preprocessor.hpp"
+#include "hymn_cache.hpp"
+#include "playback_timeline.hpp"
+#include "seek_index.hpp"
+#include "smf_reader.hpp"
+
+// Forward declaration
+class Options;
+
+namespace MidiPlay {
+
+/**
+ * @brief Loads a MIDI file into a PlaybackTimeline while it is already playing (--stream)
+ *
+ * The constructor runs on the caller's thread and does everything playback
+ * depends on before it can start:
+ * 1. A scan of every track, in file order, through the EventPreProcessor,
+ *    exactly as a normal load would run it, but without storing any event:
+ *    meta data, tempo, introduction segments, the directive table and
+ *    stuck-note detection are complete before the first note plays, and
+ *    the player thread never sees them change.
+ * 2. The events of the first HEAD_MEASURES measures, merged and timed into
+ *    the timeline and published.
+ *
+ * start() then fills in the rest on a producer thread, publishing as it
+ * goes; the timeline's reader needs no lock (see PlaybackTimeline). Before
+ * marking the timeline complete the producer builds its SeekIndex, so seeks
+ * chase the controllers from then on. It then schedules the registration
+ * changes and stores the hymn in the cache, so the next play of it is a
+ * warm start; the performance already under way sends them as written.
+ *
+ * Events dropped by the preprocessor pass their delta time on to the next
+ * event of the track, so timing stays exact.
+ */
+class StreamingLoader {
+public:
+    /**
+     * @brief Scan the file and publish its first measures
+     * @param path Full path of the MIDI file
+     * @param options Options of this play
+     * @param processor Preprocessor to run over every event; reset by the caller
+     * @throws std::runtime_error if the file is not a readable Standard MIDI File
+     */
+    StreamingLoader(const std::string& path, const Options& options, EventPreProcessor& processor);
+
+    /**
+     * @brief Waits for the producer
+     */
+    ~StreamingLoader();
+
+    StreamingLoader(const StreamingLoader&) = delete;
+    StreamingLoader& operator=(const StreamingLoader&) = delete;
+
+    /**
+     * @brief Fill the rest of the timeline on a producer thread
+     * @param cache Cache to store the hymn in once complete; empty directory for none
+     * @param metadata Metadata to store with it
+     */
+    void start(HymnCache cache, PreprocessedMetadata metadata);
+
+    /**
+     * @brief Wait for the producer and hand over the filtered tracks
+     * @return The file as a normal load would have loaded it
+     */
+    cxxmidi::File takeFile();
+
+    const PlaybackTimeline& getTimeline() const { return *timeline_; }
+    uint16_t getTimeDivision() const { return reader_.getTimeDivision(); }
+    uint32_t getTotalTicks() const { return totalTicks_; }
+    size_t getEventCount() const { return eventCount_; }
+
+    /**
+     * @brief Whether the producer has finished
+     */
+    bool isComplete() const { return timeline_->isComplete(); }
+
+    /**
+     * @brief Controller index of the whole timeline, or nullptr while it is still filling
+     */
+    const SeekIndex* getSeekIndex() const { return isComplete() ? seekIndex_.get() : nullptr; }
+
+    static constexpr uint32_t HEAD_MEASURES = 4;
+    static constexpr size_t PUBLISH_INTERVAL = 256;     // Events between publishes
+
+private:
+    // Next event of one track, in timeline order
+    struct Cursor {
+        SmfReader::Track track;
+        cxxmidi::Event event;
+        size_t index = 0;           // Position in the track, into keep_
+        uint32_t keptTick = 0;      // Tick of the last event loaded from this track
+        bool pending = false;       // event holds an event not yet merged
+    };
+
+    void scan(const Options& options, EventPreProcessor& processor);
+    void fill(uint64_t untilTick);
+    void advance(Cursor& cursor);
+    void run(HymnCache cache, PreprocessedMetadata metadata);
+
+    std::string path_;
+    SmfReader reader_;
+    std::vector<std::vector<bool>> keep_;   // Per track and event: loaded by the preprocessor
+    EventRewrite rewrite_;                  // Read again from the file, kept events are rewritten as the scan did
+    std::unique_ptr<PlaybackTimeline> timeline_;
+    std::unique_ptr<SeekIndex> seekIndex_;  // Built by the producer before the timeline is complete
+    std::vector<Cursor> cursors_;
+    cxxmidi::File file_;                    // Filled with the timeline; owned by the producer until takeFile()
+    uint32_t totalTicks_ = 0;
+    size_t eventCount_ = 0;
+    uint32_t lastTick_ = 0;                 // Tick of the last event appended
+    size_t unpublished_ = 0;
+    std::thread thread_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,68 @@
+#include "tempo_map.hpp"
+#include "midi_constants.hpp"
+
+#include <algorithm>
+
+namespace MidiPlay {
+
+TempoMap::TempoMap(uint16_t ppq)
+    : changes_{{0, static_cast<uint32_t>(Midi::DEFAULT_TEMPO_USEC_PER_QUARTER)}}
+    , timesUs_{0}
+    , ppq_(std::max<uint16_t>(ppq, 1))
+{
+}
+
+TempoMap::TempoMap(uint16_t ppq, std::vector<TempoChange> changes)
+    : TempoMap(ppq)
+{
+    // Stable, so the later of two changes at one tick is added last and wins
+    std::stable_sort(changes.begin(), changes.end(),
+                     [](const TempoChange& a, const TempoChange& b) { return a.tick < b.tick; });
+    for (const TempoChange& change : changes) {
+        add(change.tick, change.uSecPerQuarter);
+    }
+}
+
+void TempoMap::add(uint32_t tick, uint32_t uSecPerQuarter) {
+    if (uSecPerQuarter == 0) {
+        return;
+    }
+    if (changes_.back().tick == tick) {
+        changes_.back().uSecPerQuarter = uSecPerQuarter;
+        return;
+    }
+    uint64_t timeUs = timeAt(tick);
+    changes_.push_back({tick, uSecPerQuarter});
+    timesUs_.push_back(timeUs);
+}
+
+uint64_t TempoMap::timeAt(uint32_t tick) const {
+    size_t point = pointAt(tick);
+    return timesUs_[point]
+         + static_cast<uint64_t>(tick - changes_[point].tick) * changes_[point].uSecPerQuarter / ppq_;
+}
+
+uint32_t TempoMap::tickAt(uint64_t timeUs) const {
+    auto next = std::upper_bound(timesUs_.begin(), timesUs_.end(), timeUs);
+    size_t point = static_cast<size_t>(next - timesUs_.begin()) - 1;   // timesUs_ starts at 0
+
+    // Largest tick whose time, rounded down as in timeAt(), is not after timeUs
+    uint64_t ticks = ((timeUs - timesUs_[point] + 1) * ppq_ - 1) / changes_[point].uSecPerQuarter;
+    return static_cast<uint32_t>(std::min<uint64_t>(changes_[point].tick + ticks, UINT32_MAX));
+}
+
+uint32_t TempoMap::uSecPerQuarterAt(uint32_t tick) const {
+    return changes_[pointAt(tick)].uSecPerQuarter;
+}
+
+size_t TempoMap::pointAt(uint32_t tick) const {
+    // Events arrive in tick order while a map is built, so check the last point first
+    if (tick >= changes_.back().tick) {
+        return changes_.size() - 1;
+    }
+    auto next = std::upper_bound(changes_.begin(), changes_.end(), tick,
+                                 [](uint32_t t, const TempoChange& change) { return t < change.tick; });
+    return static_cast<size_t>(next - changes_.begin()) - 1;   // changes_ always starts at tick 0
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MidiPlay {
+
+/**
+ * @brief Tempo meta event of a file: microseconds per quarter note from a tick onwards
+ */
+struct TempoChange {
+    uint32_t tick = 0;
+    uint32_t uSecPerQuarter = 0;
+};
+
+/**
+ * @brief Every tempo of a file with the absolute time at which it starts
+ *
+ * Built once at load time. Each point holds the microseconds elapsed at its
+ * tick (a prefix sum over the segments before it), so tick to time and time
+ * to tick are a binary search and one multiply-divide, at any tempo, with
+ * no per-tick truncation: rounding happens within one segment and every
+ * tempo change re-anchors.
+ *
+ * The map always starts at tick 0, at the MIDI default of 120 quarter
+ * notes per minute until the file's first tempo says otherwise.
+ */
+class TempoMap {
+public:
+    /**
+     * @brief Default tempo throughout
+     */
+    explicit TempoMap(uint16_t ppq = 1);
+
+    /**
+     * @brief Map of a file's tempo changes
+     * @param ppq Time division of the file
+     * @param changes Tempo events in any order; later entries win at equal ticks
+     */
+    TempoMap(uint16_t ppq, std::vector<TempoChange> changes);
+
+    /**
+     * @brief Add a tempo from @p tick on; ticks must not decrease
+     *
+     * A change at the tick of the last one replaces it. A tempo of 0 is ignored.
+     */
+    void add(uint32_t tick, uint32_t uSecPerQuarter);
+
+    /**
+     * @brief Microseconds from the start of the piece to a tick
+     */
+    uint64_t timeAt(uint32_t tick) const;
+
+    /**
+     * @brief Last tick reached at a time; inverse of timeAt()
+     */
+    uint32_t tickAt(uint64_t timeUs) const;
+
+    /**
+     * @brief Microseconds between two ticks (0 if @p to is not after @p from)
+     */
+    uint64_t durationUs(uint32_t from, uint32_t to) const {
+        return to > from ? timeAt(to) - timeAt(from) : 0;
+    }
+
+    /**
+     * @brief Tempo in effect at a tick
+     */
+    uint32_t uSecPerQuarterAt(uint32_t tick) const;
+
+    /**
+     * @brief Tempo points, the first one at tick 0
+     */
+    const std::vector<TempoChange>& getChanges() const { return changes_; }
+    size_t size() const { return changes_.size(); }
+    uint16_t getPpq() const { return ppq_; }
+
+private:
+    size_t pointAt(uint32_t tick) const;
+
+    std::vector<TempoChange> changes_;
+    std::vector<uint64_t> timesUs_;     // Start of each point, parallel to changes_
+    uint16_t ppq_;
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,191 @@
+#include "allocation_tracker.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <iomanip>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define MIDIPLAY_TRACK_ALLOCATIONS 1
+#endif
+
+namespace MidiPlay {
+
+namespace {
+
+// Counters of one thread; a cache line of its own so threads do not share one
+struct alignas(64) ThreadCounts {
+    std::array<std::atomic<uint64_t>, AllocationTracker::PHASES> allocations;
+    std::array<std::atomic<uint64_t>, AllocationTracker::PHASES> bytes;
+};
+
+// Zero-initialized before any code runs, so the first malloc of the process may count
+ThreadCounts threads[AllocationTracker::MAX_THREADS];
+std::atomic<size_t> threadCount{0};
+std::atomic<uint8_t> currentPhase{0};
+std::atomic<int> playerSlot{-1};
+
+thread_local int slot = -1;
+
+int threadSlot() {
+    if (slot < 0) {
+        size_t claimed = threadCount.fetch_add(1, std::memory_order_relaxed);
+        slot = static_cast<int>(claimed < AllocationTracker::MAX_THREADS ? claimed : AllocationTracker::MAX_THREADS - 1);
+    }
+    return slot;
+}
+
+[[maybe_unused]] void record(size_t bytes) {
+    ThreadCounts& counts = threads[threadSlot()];
+    size_t phase = currentPhase.load(std::memory_order_relaxed);
+    counts.allocations[phase].fetch_add(1, std::memory_order_relaxed);
+    counts.bytes[phase].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+size_t usedSlots() {
+    size_t used = threadCount.load(std::memory_order_relaxed);
+    return used < AllocationTracker::MAX_THREADS ? used : AllocationTracker::MAX_THREADS;
+}
+
+} // namespace
+
+bool AllocationTracker::isActive() {
+#ifdef MIDIPLAY_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocationTracker::setPhase(Phase phase) {
+    currentPhase.store(static_cast<uint8_t>(phase), std::memory_order_relaxed);
+}
+
+AllocationTracker::Phase AllocationTracker::phase() {
+    return static_cast<Phase>(currentPhase.load(std::memory_order_relaxed));
+}
+
+void AllocationTracker::markPlayerThread() {
+    playerSlot.store(threadSlot(), std::memory_order_relaxed);
+}
+
+void AllocationTracker::reset() {
+    for (size_t i = 0; i < usedSlots(); i++) {
+        for (size_t phase = 0; phase < PHASES; phase++) {
+            threads[i].allocations[phase].store(0, std::memory_order_relaxed);
+            threads[i].bytes[phase].store(0, std::memory_order_relaxed);
+        }
+    }
+    playerSlot.store(-1, std::memory_order_relaxed);
+}
+
+AllocationTracker::Counts AllocationTracker::playerThread(Phase phase) {
+    Counts counts;
+    int player = playerSlot.load(std::memory_order_relaxed);
+    if (player >= 0) {
+        size_t index = static_cast<size_t>(phase);
+        counts.allocations = threads[player].allocations[index].load(std::memory_order_relaxed);
+        counts.bytes = threads[player].bytes[index].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+AllocationTracker::Counts AllocationTracker::otherThreads(Phase phase) {
+    Counts counts;
+    int player = playerSlot.load(std::memory_order_relaxed);
+    size_t index = static_cast<size_t>(phase);
+    for (size_t i = 0; i < usedSlots(); i++) {
+        if (static_cast<int>(i) != player) {
+            counts.allocations += threads[i].allocations[index].load(std::memory_order_relaxed);
+            counts.bytes += threads[i].bytes[index].load(std::memory_order_relaxed);
+        }
+    }
+    return counts;
+}
+
+void AllocationTracker::writeReport(std::ostream& out) {
+    auto column = [&out](const Counts& counts) {
+        out << std::setw(8) << counts.allocations << " (" << std::setw(9) << counts.bytes << " bytes)";
+    };
+
+    out << std::left << std::setw(14) << "  Phase" << std::right
+        << std::setw(28) << "Player thread" << std::setw(28) << "Other threads" << std::endl;
+    for (size_t index = 0; index < PHASES; index++) {
+        Phase phase = static_cast<Phase>(index);
+        out << "  " << std::left << std::setw(12) << phaseName(phase) << std::right << "  ";
+        column(playerThread(phase));
+        out << "  ";
+        column(otherThreads(phase));
+        out << std::endl;
+    }
+}
+
+const char* AllocationTracker::phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::Load:           return "load";
+    case Phase::DeviceSetup:    return "device setup";
+    case Phase::Introduction:   return "introduction";
+    case Phase::Verses:         return "verses";
+    case Phase::Other:          break;
+    }
+    return "other";
+}
+
+} // namespace MidiPlay
+
+#ifdef MIDIPLAY_TRACK_ALLOCATIONS
+
+// glibc's own allocator, under the names it exports for interposers like this one
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) noexcept {
+    MidiPlay::record(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    MidiPlay::record(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept {
+    if (size > 0) {
+        MidiPlay::record(size);     // May move; an allocation all the same
+    }
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    MidiPlay::record(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    MidiPlay::record(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size) noexcept {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    MidiPlay::record(size);
+    void* allocated = __libc_memalign(alignment, size);
+    if (!allocated && size > 0) {
+        return ENOMEM;
+    }
+    *pointer = allocated;
+    return 0;
+}
+
+void free(void* pointer) noexcept {
+    __libc_free(pointer);
+}
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace MidiPlay {
+
+/**
+ * @brief Heap allocations counted by thread and by playback phase (test build only)
+ *
+ * Linking allocation_tracker.cpp into a test runner replaces malloc, calloc,
+ * realloc and the aligned allocators with versions that count each call and
+ * its size before handing it to glibc. operator new and the C libraries
+ * allocate through malloc, so every allocation in the process is seen.
+ *
+ * Each thread gets a slot of counters on its first allocation, split by the
+ * phase set last with setPhase(). A test names the player thread by calling
+ * markPlayerThread() on it (from a port or annotator the engine calls), and
+ * reads that thread's counts apart from everyone else's: after the player
+ * starts, the real-time path should not allocate at all.
+ *
+ * Counting is a few relaxed atomic adds. It is compiled out under the
+ * sanitizers and on C libraries other than glibc, which interpose malloc
+ * themselves; isActive() then returns false and every count stays zero.
+ */
+class AllocationTracker {
+public:
+    enum class Phase : uint8_t {
+        Other,          // Before, between and after the phases below
+        Load,           // Reading and preparing the hymn
+        DeviceSetup,    // Output, engine and orchestrator set up
+        Introduction,
+        Verses
+    };
+
+    static constexpr size_t PHASES = 5;
+    static constexpr size_t MAX_THREADS = 1024;     // Later threads share the last slot
+
+    struct Counts {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    /**
+     * @brief Whether allocations are being counted in this build
+     */
+    static bool isActive();
+
+    /**
+     * @brief Charge allocations from now on to this phase, on every thread
+     */
+    static void setPhase(Phase phase);
+    static Phase phase();
+
+    /**
+     * @brief Take the calling thread as the player thread; cheap enough to call per message
+     */
+    static void markPlayerThread();
+
+    /**
+     * @brief Zero every count and forget the player thread
+     */
+    static void reset();
+
+    static Counts playerThread(Phase phase);
+    static Counts otherThreads(Phase phase);
+
+    /**
+     * @brief Write the counts of each phase, player thread against the others
+     */
+    static void writeReport(std::ostream& out);
+
+    static const char* phaseName(Phase phase);
+};
+
+} // namespace MidiPlay
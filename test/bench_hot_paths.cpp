@@ -0,0 +1,301 @@
+#include "external/catch_amalgamated.hpp"
+#include "../midi_loader.hpp"
+#include "../event_preprocessor.hpp"
+#include "../musical_director.hpp"
+#include "../playback_state_machine.hpp"
+#include "../player_sync_engine.hpp"
+#include "../device_manager.hpp"
+#include "../options.hpp"
+#include "../midi_batch.hpp"
+#include "../playback_timeline.hpp"
+#include "../rawmidi_output.hpp"
+#include "../wire_stream.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <cxxmidi/output/default.hpp>
+#include <cxxmidi/player/player_sync.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <getopt.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// ============================================================================
+// Hot path benchmarks
+// ============================================================================
+// Built as a separate runner (see "Build Benchmarks (Catch2)"), run from
+// test/ so the fixture paths resolve. For release-to-release comparison use
+// the XML reporter, e.g.
+//   ./run_benchmarks --reporter console --reporter xml::out=benchmark_results.xml
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::vector<std::string> CORPUS = {
+    "fixtures/test_files/simple.mid",
+    "fixtures/test_files/with_intro.mid",
+    "fixtures/test_files/ritardando.mid",
+    "fixtures/test_files/dc_al_fine.mid",
+};
+
+const char* const DEVICE_CONFIG = "fixtures/test_configs/valid_devices.yaml";
+
+// Options parsed once from a fixed command line; argv must outlive Options
+struct BenchOptions {
+    std::vector<std::string> args;
+    std::vector<char*> argv;
+    Options options;
+
+    explicit BenchOptions(std::vector<std::string> arguments)
+        : args(std::move(arguments))
+        , argv(makeArgv(args))
+        , options(static_cast<int>(args.size()), argv.data())
+    {
+        optind = 0;
+        options.parse();
+    }
+
+    static std::vector<char*> makeArgv(std::vector<std::string>& args) {
+        std::vector<char*> argv;
+        for (std::string& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        return argv;
+    }
+};
+
+// Copy of every event in a file, in track order
+std::vector<cxxmidi::Event> collectEvents(const cxxmidi::File& file) {
+    std::vector<cxxmidi::Event> events;
+    for (const cxxmidi::Track& track : file) {
+        events.insert(events.end(), track.begin(), track.end());
+    }
+    return events;
+}
+
+bool corpusPresent() {
+    for (const std::string& path : CORPUS) {
+        if (!fs::exists(path)) {
+            WARN("Fixture not found: " << path);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("MidiLoader::loadFile across the fixture corpus", "[benchmark][midi_loader]") {
+    if (!corpusPresent()) {
+        return;
+    }
+    BenchOptions bench({"play", "bench.mid", "--no-cache"});
+
+    BENCHMARK("loadFile, parse (corpus)") {
+        size_t loaded = 0;
+        for (const std::string& path : CORPUS) {
+            MidiLoader loader;
+            loader.setCacheDirectory("");
+            loaded += loader.loadFile(path, bench.options) ? 1 : 0;
+        }
+        return loaded;
+    };
+
+    fs::path cacheDir = fs::temp_directory_path() / ("midiplay_bench_cache_" + std::to_string(getpid()));
+    BenchOptions cached({"play", "bench.mid"});
+    for (const std::string& path : CORPUS) {
+        MidiLoader warmup;
+        warmup.setCacheDirectory(cacheDir.string());
+        warmup.loadFile(path, cached.options);
+    }
+
+    BENCHMARK("loadFile, hymn cache (corpus)") {
+        size_t loaded = 0;
+        for (const std::string& path : CORPUS) {
+            MidiLoader loader;
+            loader.setCacheDirectory(cacheDir.string());
+            loaded += loader.loadFile(path, cached.options) ? 1 : 0;
+        }
+        return loaded;
+    };
+
+    fs::remove_all(cacheDir);
+}
+
+TEST_CASE("EventPreProcessor::processEvent throughput", "[benchmark][event_preprocessor]") {
+    if (!corpusPresent()) {
+        return;
+    }
+    BenchOptions bench({"play", "bench.mid", "--no-cache"});
+
+    std::vector<cxxmidi::Event> events;
+    for (const std::string& path : CORPUS) {
+        cxxmidi::File file;
+        file.Load(path.c_str());
+        std::vector<cxxmidi::Event> fileEvents = collectEvents(file);
+        events.insert(events.end(), fileEvents.begin(), fileEvents.end());
+    }
+
+    BENCHMARK_ADVANCED("processEvent, corpus events")(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::vector<cxxmidi::Event>> inputs(meter.runs(), events);
+        std::vector<EventPreProcessor> processors(meter.runs());
+        meter.measure([&](int run) {
+            size_t kept = 0;
+            for (cxxmidi::Event& event : inputs[run]) {
+                kept += processors[run].processEvent(event, bench.options) ? 1 : 0;
+            }
+            return kept;
+        });
+    };
+}
+
+TEST_CASE("MusicalDirector::handleEvent per-event cost", "[benchmark][musical_director]") {
+    const std::string path = "fixtures/test_files/with_intro.mid";
+    if (!fs::exists(path)) {
+        WARN("Fixture not found: " << path);
+        return;
+    }
+    BenchOptions bench({"play", "bench.mid", "--no-cache"});
+
+    MidiLoader loader;
+    loader.setCacheDirectory("");
+    REQUIRE(loader.loadFile(path, bench.options));
+    std::vector<cxxmidi::Event> events = collectEvents(loader.getFile());
+
+    cxxmidi::output::Default outport;
+    cxxmidi::player::PlayerSync player(&outport);
+    PlayerSyncEngine engine(player);
+    PlaybackStateMachine stateMachine;     // Not playing intro or last verse: markers only advance the cursor
+    MusicalDirector director(engine, stateMachine, loader);
+
+    BENCHMARK("handleEvent, one pass over with_intro.mid") {
+        director.seekDirectives(0);
+        size_t sent = 0;
+        for (const cxxmidi::Event& event : events) {
+            sent += director.handleEvent(event) ? 1 : 0;
+        }
+        return sent;
+    };
+}
+
+TEST_CASE("DeviceManager YAML parsing", "[benchmark][device_manager]") {
+    if (!fs::exists(DEVICE_CONFIG)) {
+        WARN("Fixture not found: " << DEVICE_CONFIG);
+        return;
+    }
+    BenchOptions bench({"play", "bench.mid"});
+
+    // parseYamlFile is private; loadDevicePresets with an explicit path is
+    // an existence check followed by parseYamlFile
+    BENCHMARK("loadDevicePresets (parseYamlFile), valid_devices.yaml") {
+        DeviceManager manager(bench.options);
+        manager.loadDevicePresets(DEVICE_CONFIG);
+    };
+}
+
+TEST_CASE("Tick bytes: encoded at send time vs pre-encoded", "[benchmark][wire_stream]") {
+    if (!corpusPresent()) {
+        return;
+    }
+    std::vector<cxxmidi::File> files(CORPUS.size());
+    std::vector<std::unique_ptr<PlaybackTimeline>> timelines;
+    std::vector<std::unique_ptr<WireStream>> wires;
+    for (size_t i = 0; i < CORPUS.size(); i++) {
+        files[i].Load(CORPUS[i].c_str());
+        timelines.push_back(std::make_unique<PlaybackTimeline>(files[i]));
+        wires.push_back(std::make_unique<WireStream>(*timelines.back()));
+    }
+
+    // What TimelinePlayer does per tick in Stream mode
+    MidiBatch batch;
+    BENCHMARK("MidiBatch::stream per tick (corpus)") {
+        size_t bytes = 0;
+        for (const auto& timeline : timelines) {
+            size_t index = 0;
+            while (index < timeline->size()) {
+                uint32_t tick = timeline->tickAt(index);
+                batch.clear();
+                for (; index < timeline->size() && timeline->tickAt(index) == tick; index++) {
+                    EventView event = timeline->eventAt(index);
+                    if (!event.empty() && !event.isMeta()) {
+                        batch.add(event);
+                    }
+                }
+                bytes += batch.stream().size();
+            }
+        }
+        return bytes;
+    };
+
+    // What it does in Wire mode
+    BENCHMARK("WireStream::range per tick (corpus)") {
+        size_t bytes = 0;
+        for (size_t t = 0; t < timelines.size(); t++) {
+            const PlaybackTimeline& timeline = *timelines[t];
+            size_t index = 0;
+            while (index < timeline.size()) {
+                size_t first = index;
+                uint32_t tick = timeline.tickAt(index);
+                while (index < timeline.size() && timeline.tickAt(index) == tick) {
+                    index++;
+                }
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+                wires[t]->range(first, index, data, size);
+                bytes += size;
+            }
+        }
+        return bytes;
+    };
+}
+
+// Needs the instrument attached: run with
+//   MIDIPLAY_RAWMIDI_DEVICE=hw:1,0,0 ./run_benchmarks "[rawmidi]"
+// The sequencer port is the first with the same device's name; the two are
+// opened one after the other, never together.
+TEST_CASE("Note on latency: sequencer vs rawmidi", "[.][benchmark][rawmidi]") {
+    const char* device = std::getenv("MIDIPLAY_RAWMIDI_DEVICE");
+    if (!device) {
+        WARN("MIDIPLAY_RAWMIDI_DEVICE not set");
+        return;
+    }
+    cxxmidi::Message noteOn(0x90, 60, 1);
+    cxxmidi::Message noteOff(0x80, 60, 0);
+
+    {
+        cxxmidi::output::Default sequencer;
+        size_t port = 0;
+        for (; port < sequencer.GetPortCount(); port++) {
+            if (RawMidiOutput::deviceForPort(sequencer.GetPortName(port)) == device) {
+                break;
+            }
+        }
+        if (port == sequencer.GetPortCount()) {
+            WARN("No sequencer port for " << device);
+            return;
+        }
+        sequencer.OpenPort(static_cast<unsigned int>(port));
+        BENCHMARK("SendMessage, ALSA sequencer") {
+            sequencer.SendMessage(&noteOn);
+            sequencer.SendMessage(&noteOff);
+        };
+        sequencer.ClosePort();
+    }
+
+    RawMidiOutput raw;
+    if (!raw.open(device)) {
+        WARN(raw.getError());
+        return;
+    }
+    BENCHMARK("SendMessage, rawmidi") {
+        raw.SendMessage(&noteOn);
+        raw.SendMessage(&noteOff);
+    };
+    REQUIRE(raw.getWriteErrors() == 0);
+}
@@ -0,0 +1,98 @@
+#include "external/catch_amalgamated.hpp"
+#include "../active_notes.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace MidiPlay;
+
+namespace {
+
+// Records every message sent, as ActiveNotes::release() sees a port
+struct RecordingOutput {
+    std::vector<std::vector<uint8_t>> sent;
+
+    void SendMessage(const cxxmidi::Message* message) {
+        sent.emplace_back(message->begin(), message->end());
+    }
+};
+
+void observe(ActiveNotes& notes, std::vector<uint8_t> bytes) {
+    notes.observe(EventView(bytes.data(), bytes.size(), 0));
+}
+
+} // namespace
+
+TEST_CASE("ActiveNotes tracks NoteOn and NoteOff", "[active_notes][unit]") {
+    ActiveNotes notes;
+    REQUIRE(notes.count() == 0);
+
+    observe(notes, {0x90, 60, 100});
+    observe(notes, {0x91, 100, 80});
+    REQUIRE(notes.isHeld(0, 60));
+    REQUIRE(notes.isHeld(1, 100));
+    REQUIRE_FALSE(notes.isHeld(1, 60));
+    REQUIRE(notes.count() == 2);
+    REQUIRE(notes.getChannelsUsed() == 0x0003);
+
+    SECTION("NoteOff clears the note") {
+        observe(notes, {0x80, 60, 64});
+        REQUIRE_FALSE(notes.isHeld(0, 60));
+        REQUIRE(notes.count() == 1);
+    }
+
+    SECTION("NoteOn with velocity 0 clears the note") {
+        observe(notes, {0x91, 100, 0});
+        REQUIRE_FALSE(notes.isHeld(1, 100));
+        REQUIRE(notes.count() == 1);
+    }
+
+    SECTION("All Notes Off clears the channel") {
+        observe(notes, {0x90, 61, 100});
+        observe(notes, {0xB0, Midi::CC_ALL_NOTES_OFF, 0});
+        REQUIRE_FALSE(notes.isHeld(0, 60));
+        REQUIRE_FALSE(notes.isHeld(0, 61));
+        REQUIRE(notes.isHeld(1, 100));
+    }
+
+    SECTION("other messages are ignored") {
+        observe(notes, {0xB0, Midi::CC_VOLUME, 0});
+        observe(notes, {0xC0, 5});
+        observe(notes, {0xFF, 0x06, 0});
+        REQUIRE(notes.count() == 2);
+    }
+}
+
+TEST_CASE("ActiveNotes release", "[active_notes][unit]") {
+    ActiveNotes notes;
+    RecordingOutput output;
+    cxxmidi::Message scratch(0, 0, 0);
+
+    observe(notes, {0x90, 0, 100});
+    observe(notes, {0x90, 127, 100});
+    observe(notes, {0x92, 64, 100});
+
+    SECTION("only held notes are released") {
+        REQUIRE(notes.release(output, scratch) == 3);
+        REQUIRE(output.sent.size() == 3);
+        REQUIRE(output.sent[0] == std::vector<uint8_t>{0x90, 0, 0});
+        REQUIRE(output.sent[1] == std::vector<uint8_t>{0x90, 127, 0});
+        REQUIRE(output.sent[2] == std::vector<uint8_t>{0x92, 64, 0});
+        REQUIRE(notes.count() == 0);
+    }
+
+    SECTION("All Notes Off goes to each channel used") {
+        observe(notes, {0x92, 64, 0});
+        REQUIRE(notes.release(output, scratch, true) == 2);
+        REQUIRE(output.sent.size() == 4);
+        REQUIRE(output.sent[2] == std::vector<uint8_t>{0xB0, Midi::CC_ALL_NOTES_OFF, 0});
+        REQUIRE(output.sent[3] == std::vector<uint8_t>{0xB2, Midi::CC_ALL_NOTES_OFF, 0});
+    }
+
+    SECTION("a second release sends nothing") {
+        notes.release(output, scratch);
+        output.sent.clear();
+        REQUIRE(notes.release(output, scratch) == 0);
+        REQUIRE(output.sent.empty());
+    }
+}
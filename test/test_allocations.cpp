@@ -0,0 +1,300 @@
+#include "external/catch_amalgamated.hpp"
+#include "allocation_tracker.hpp"
+#include "../active_notes.hpp"
+#include "../jitter_recorder.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include "../playback_command.hpp"
+#include "../playback_orchestrator.hpp"
+#include "../playback_synchronizer.hpp"
+#include "../player_sync_engine.hpp"
+#include "../recording_output.hpp"
+#include "../timeline_player.hpp"
+#include "../virtual_clock.hpp"
+
+#include <cxxmidi/player/player_sync.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <getopt.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+using Phase = AllocationTracker::Phase;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+const std::vector<std::string> CORPUS = {"simple.mid", "with_intro.mid", "ritardando.mid", "dc_al_fine.mid"};
+
+constexpr size_t NOTES_OFF_MESSAGES = 16 * 128;
+const std::string FAST_TEMPO = "-t2400";    // PlayerSync plays in real time; a few seconds for the corpus
+
+// Through a volatile pointer, so the compiler cannot drop the allocation
+void* (*volatile allocate)(size_t) = std::malloc;
+
+// Load a fixture, or return false if it is missing
+bool loadFixture(MidiLoader& loader, const std::string& name, const std::vector<std::string>& extra = {}) {
+    std::string path = "fixtures/test_files/" + name;
+    if (!fs::exists(path)) {
+        WARN("Test file not found: " << path);
+        return false;
+    }
+    std::vector<std::string> args = {"play", path, "--no-cache"};
+    args.insert(args.end(), extra.begin(), extra.end());
+    int argc = static_cast<int>(args.size());
+    optind = 0;
+    auto argv = makeArgv(args);
+    Options options(argc, argv);
+    options.parse();
+    bool loaded = loader.loadFile(path, options);
+    freeArgv(argv, argc);
+    return loaded;
+}
+
+/**
+ * Forwards to an engine, and takes the thread its callbacks run on as the
+ * player thread: from the first callback on, allocations are charged to
+ * the introduction or the verses, whichever is playing.
+ */
+class TrackedEngine : public PlaybackEngine {
+public:
+    TrackedEngine(PlaybackEngine& engine, const JitterRecorder& sections)
+        : engine_(engine)
+        , sections_(sections)
+    {
+    }
+
+    void play() override { engine_.play(); }
+    void stop() override { engine_.stop(); }
+    void finish() override { engine_.finish(); }
+    void rewind() override { engine_.rewind(); }
+    void goToTick(uint32_t tick) override { engine_.goToTick(tick); }
+    void notesOff() override { engine_.notesOff(); }
+    void releaseHeldNotes() override { engine_.releaseHeldNotes(); }
+    void setSpeed(float speed) override { engine_.setSpeed(speed); }
+    float getSpeed() const override { return engine_.getSpeed(); }
+    std::chrono::microseconds currentTimePos() const override { return engine_.currentTimePos(); }
+    void setHeartbeatNeeded(bool needed) override { engine_.setHeartbeatNeeded(needed); }
+    void requestHeartbeat() override { engine_.requestHeartbeat(); }
+    void setJitterRecorder(JitterRecorder* recorder) override { engine_.setJitterRecorder(recorder); }
+    void setActiveNotes(ActiveNotes* notes) override { engine_.setActiveNotes(notes); }
+
+    void setCallbackHeartbeat(const Callback& callback) override {
+        engine_.setCallbackHeartbeat(tracked(callback));
+    }
+
+    void setCallbackFinished(const Callback& callback) override {
+        engine_.setCallbackFinished(tracked(callback));
+    }
+
+    void setCallbackEvent(const EventCallback& callback) override {
+        if (!callback) {
+            engine_.setCallbackEvent(nullptr);
+            return;
+        }
+        engine_.setCallbackEvent([this, callback](const EventView& event) {
+            enter(sections_.section() == 0 ? Phase::Introduction : Phase::Verses);
+            if (++events_ == commandAfter_ && commands_) {
+                commands_->push(command_);
+                engine_.requestHeartbeat();
+            }
+            return callback(event);
+        });
+    }
+
+    bool setSchedule(const PlaybackSchedule& schedule,
+                     const PlaybackSchedule::SectionCallback& callback) override {
+        return engine_.setSchedule(schedule, [this, callback](const ScheduledSection& section) {
+            enter(section.kind == ScheduledSection::Kind::Introduction ? Phase::Introduction : Phase::Verses);
+            return callback(section);
+        });
+    }
+
+    /**
+     * Send a command from the player thread once this many events have
+     * played, as a keyboard would in the middle of a verse
+     */
+    void sendAfter(size_t events, PlaybackCommandQueue& queue, PlaybackCommand command) {
+        commandAfter_ = events;
+        commands_ = &queue;
+        command_ = command;
+    }
+
+    // Callbacks run so far; none means the player thread was never seen
+    size_t callbacks() const { return callbacks_.load(std::memory_order_relaxed); }
+
+private:
+    Callback tracked(const Callback& callback) {
+        if (!callback) {
+            return nullptr;
+        }
+        return [this, callback]() {
+            enter(sections_.section() == 0 ? Phase::Introduction : Phase::Verses);
+            callback();
+        };
+    }
+
+    void enter(Phase phase) {
+        AllocationTracker::markPlayerThread();
+        AllocationTracker::setPhase(phase);
+        callbacks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    PlaybackEngine& engine_;
+    const JitterRecorder& sections_;
+    std::atomic<size_t> callbacks_{0};
+    size_t events_ = 0;             // Player thread
+    size_t commandAfter_ = 0;
+    PlaybackCommandQueue* commands_ = nullptr;
+    PlaybackCommand command_{PlaybackCommand::Kind::Stop};
+};
+
+enum class Engine { Timeline, PlayerSync };
+
+struct Performance {
+    size_t messages = 0;
+    size_t callbacks = 0;
+    AllocationTracker::Counts introduction;
+    AllocationTracker::Counts verses;
+};
+
+constexpr size_t COMMAND_AFTER_EVENTS = 40;
+
+// Play a loaded hymn through the orchestrator as play.cpp sets it up, counting allocations by phase
+Performance perform(Engine kind, const MidiLoader& loader, const PlaybackCommand* command = nullptr) {
+    Performance performance;
+    AllocationTracker::setPhase(Phase::DeviceSetup);
+    {
+        VirtualClock clock;
+        RecordingOutput output(loader.getEventCount() * (loader.getVerses() + 2) + NOTES_OFF_MESSAGES,
+                               kind == Engine::Timeline ? &clock : nullptr);
+        cxxmidi::player::PlayerSync playerSync(&output);
+        std::unique_ptr<PlaybackEngine> engine;
+        if (kind == Engine::Timeline) {
+            auto timelinePlayer = std::make_unique<TimelinePlayer>(output, loader.getEvents());
+            timelinePlayer->setVirtualClock(&clock);
+            engine = std::move(timelinePlayer);
+        } else {
+            playerSync.SetFile(&loader.getFile());
+            engine = std::make_unique<PlayerSyncEngine>(playerSync, &output);
+        }
+
+        JitterRecorder sections(0);     // Only labels the sections
+        ActiveNotes notes;
+        TrackedEngine tracked(*engine, sections);
+        tracked.setActiveNotes(&notes);
+
+        PlaybackSynchronizer synchronizer;
+        PlaybackCommandQueue queue;
+        PlaybackOrchestrator orchestrator(tracked, synchronizer, loader);
+        orchestrator.initialize();
+        orchestrator.setDisplayWarnings(false);
+        orchestrator.setJitterRecorder(&sections);
+        if (command) {
+            orchestrator.setCommandQueue(&queue);
+            tracked.sendAfter(COMMAND_AFTER_EVENTS, queue, *command);
+        }
+
+        // The phase moves to the introduction or the verses with the first callback
+        orchestrator.executePlayback();
+        AllocationTracker::setPhase(Phase::Other);
+        performance.messages = output.size();
+        performance.callbacks = tracked.callbacks();
+    }   // Joins the player thread
+    performance.introduction = AllocationTracker::playerThread(Phase::Introduction);
+    performance.verses = AllocationTracker::playerThread(Phase::Verses);
+    return performance;
+}
+
+void report(std::ostream& out, const std::string& name) {
+    out << name << std::endl;
+    AllocationTracker::writeReport(out);
+    out << std::endl;
+}
+
+void check(const std::string& name, const Performance& performance) {
+    INFO(name << ": " << performance.introduction.allocations << " allocations in the introduction, "
+              << performance.verses.allocations << " in the verses");
+    REQUIRE(performance.callbacks > 0);     // The player thread was seen
+    REQUIRE(performance.messages > 0);
+    CHECK(performance.introduction.allocations == 0);
+    CHECK(performance.verses.allocations == 0);
+}
+
+} // namespace
+
+TEST_CASE("AllocationTracker counts by thread and phase", "[allocations][unit]") {
+    if (!AllocationTracker::isActive()) {
+        SKIP("Allocations are not counted in this build");
+    }
+    AllocationTracker::reset();
+    AllocationTracker::setPhase(Phase::Load);
+    void* loaded = allocate(100);
+
+    std::thread player([]() {
+        AllocationTracker::markPlayerThread();
+        AllocationTracker::setPhase(Phase::Verses);
+        for (int i = 0; i < 3; i++) {
+            std::free(allocate(64));
+        }
+    });
+    player.join();
+    AllocationTracker::setPhase(Phase::Other);
+    std::free(loaded);
+
+    REQUIRE(AllocationTracker::playerThread(Phase::Verses).allocations == 3);
+    REQUIRE(AllocationTracker::playerThread(Phase::Verses).bytes == 192);
+    REQUIRE(AllocationTracker::playerThread(Phase::Load).allocations == 0);
+    REQUIRE(AllocationTracker::otherThreads(Phase::Load).allocations >= 1);
+    REQUIRE(AllocationTracker::otherThreads(Phase::Load).bytes >= 100);
+
+    AllocationTracker::reset();
+    REQUIRE(AllocationTracker::playerThread(Phase::Verses).allocations == 0);
+    REQUIRE(AllocationTracker::otherThreads(Phase::Load).allocations == 0);
+}
+
+TEST_CASE("No allocation on the player thread while playing", "[allocations][integration]") {
+    if (!AllocationTracker::isActive()) {
+        SKIP("Allocations are not counted in this build");
+    }
+    std::ofstream out("allocation_report.txt");
+    for (Engine kind : {Engine::Timeline, Engine::PlayerSync}) {
+        for (const std::string& name : CORPUS) {
+            AllocationTracker::reset();
+            AllocationTracker::setPhase(Phase::Load);
+            MidiLoader loader;
+            if (!loadFixture(loader, name, {"-n2", FAST_TEMPO})) {
+                continue;
+            }
+            Performance performance = perform(kind, loader);
+            std::string label = name + (kind == Engine::Timeline ? " (timeline)" : " (PlayerSync)");
+            report(out, label);
+            check(label, performance);
+        }
+    }
+}
+
+TEST_CASE("No allocation on the player thread when skipping or stopping", "[allocations][integration]") {
+    if (!AllocationTracker::isActive()) {
+        SKIP("Allocations are not counted in this build");
+    }
+    Engine kind = GENERATE(Engine::Timeline, Engine::PlayerSync);
+    // Skipping to the last verse releases the held notes; stopping silences every note
+    PlaybackCommand command = GENERATE(PlaybackCommand{PlaybackCommand::Kind::LastVerse},
+                                       PlaybackCommand{PlaybackCommand::Kind::Stop});
+
+    AllocationTracker::reset();
+    AllocationTracker::setPhase(Phase::Load);
+    MidiLoader loader;
+    if (!loadFixture(loader, "with_intro.mid", {"-n3", FAST_TEMPO})) {
+        return;
+    }
+    Performance performance = perform(kind, loader, &command);
+    check(kind == Engine::Timeline ? "with_intro.mid (timeline)" : "with_intro.mid (PlayerSync)", performance);
+}
@@ -0,0 +1,57 @@
+#include "external/catch_amalgamated.hpp"
+#include "../console_log.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace MidiPlay;
+
+TEST_CASE("ConsoleLog writes at once when not running", "[console_log][unit]") {
+    std::ostringstream out;
+    ConsoleLog log(out);
+    REQUIRE_FALSE(log.isRunning());
+
+    log.post(ConsoleMessage::PlayingVerse, 2);
+    REQUIRE(out.str() == " Playing verse 2\n");
+
+    log.post(ConsoleMessage::PlayingLastVerse, 3);
+    log.post(ConsoleMessage::Ritardando);
+    log.post(ConsoleMessage::DaCapoAlFine);
+    REQUIRE(out.str() == " Playing verse 2\n Playing verse 3, last verse\n  Ritardando\nD.C. al Fine\n");
+}
+
+TEST_CASE("ConsoleLog writes posted lines from its drain thread", "[console_log][unit]") {
+    std::ostringstream out;
+    ConsoleLog log(out);
+    REQUIRE(log.start());
+    REQUIRE(log.isRunning());
+
+    // Posted from another thread, as the player thread does
+    std::thread player([&log]() {
+        log.post(ConsoleMessage::PlayingIntroduction);
+        for (int verse = 1; verse <= 3; verse++) {
+            log.post(ConsoleMessage::PlayingVerse, verse);
+        }
+        log.post(ConsoleMessage::IntroMarkerWarning);
+    });
+    player.join();
+    log.stop();
+
+    REQUIRE_FALSE(log.isRunning());
+    REQUIRE(log.getDropped() == 0);
+    REQUIRE(out.str() == " Playing introduction\n Playing verse 1\n Playing verse 2\n Playing verse 3\n"
+                         "   Warning: Final intro marker not past last NoteOff event\n");
+
+    SECTION("stopped again, it writes at once") {
+        log.post(ConsoleMessage::Ritardando);
+        REQUIRE(out.str().find("  Ritardando\n") != std::string::npos);
+    }
+
+    SECTION("it can be started again") {
+        REQUIRE(log.start());
+        log.post(ConsoleMessage::Ritardando);
+        log.stop();
+        REQUIRE(out.str().find("  Ritardando\n") != std::string::npos);
+    }
+}
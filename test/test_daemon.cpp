@@ -0,0 +1,117 @@
+#include "external/catch_amalgamated.hpp"
+#include "../daemon_client.hpp"
+#include "../daemon_server.hpp"
+#include "../binary_io.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+// Socket path unique to this test process
+std::string testSocketPath() {
+    return (fs::temp_directory_path() / ("midiplay-test-" + std::to_string(getpid()) + ".sock")).string();
+}
+
+int connectTo(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+TEST_CASE("DaemonClient without a daemon", "[daemon][unit]") {
+    DaemonClient client(testSocketPath());
+    REQUIRE_FALSE(client.connect());
+}
+
+TEST_CASE("DaemonServer serves a forwarded command line", "[daemon][integration]") {
+    DaemonServer server(testSocketPath());
+    REQUIRE(server.listen());
+    REQUIRE(fs::exists(server.getSocketPath()));
+
+    SECTION("a second daemon on the same socket is refused") {
+        DaemonServer second(server.getSocketPath());
+        REQUIRE_FALSE(second.listen());
+        REQUIRE_FALSE(second.getError().empty());
+    }
+
+    SECTION("arguments, output and exit code round trip") {
+        DaemonRequest received;
+        std::thread daemon([&]() {
+            server.serveOne([&](const DaemonRequest& request) {
+                received = request;
+                std::cout << "Playing: " << request.args[1] << std::endl;
+                std::cerr << "warning" << std::endl;
+                return 3;
+            });
+        });
+
+        std::vector<std::string> args{"play", "hymn 162", "-x2"};
+        char** argv = makeArgv(args);
+        std::ostringstream out;
+        DaemonClient client(server.getSocketPath());
+        REQUIRE(client.connect());
+        int rc = client.run(static_cast<int>(args.size()), argv, out);
+        daemon.join();
+        freeArgv(argv, args.size());
+
+        REQUIRE(rc == 3);
+        REQUIRE(received.args == args);
+        REQUIRE(received.workingDirectory == fs::current_path().string());
+        REQUIRE(out.str() == "Playing: hymn 162\nwarning\n");
+    }
+
+    SECTION("a client that hangs up fires the hangup callback") {
+        std::atomic<bool> hungUp{false};
+        std::thread daemon([&]() {
+            server.serveOne([&](const DaemonRequest&) {
+                server.setHangupCallback([&]() { hungUp = true; });
+                for (int i = 0; i < 500 && !hungUp; i++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                return 0;
+            });
+        });
+
+        // Send a request by hand, then drop the connection as Ctrl-C in the client would
+        int fd = connectTo(server.getSocketPath());
+        REQUIRE(fd >= 0);
+        ByteWriter payload;
+        payload.putString("");
+        payload.putVarint(2);
+        payload.putString("play");
+        payload.putString("hymn");
+        uint32_t size = static_cast<uint32_t>(payload.size());
+        REQUIRE(::write(fd, &size, sizeof(size)) == sizeof(size));
+        REQUIRE(::write(fd, payload.data().data(), payload.size()) == static_cast<ssize_t>(payload.size()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ::close(fd);
+
+        daemon.join();
+        REQUIRE(hungUp);
+    }
+}
@@ -0,0 +1,123 @@
+#include "external/catch_amalgamated.hpp"
+#include "../deadline_sleeper.hpp"
+#include "../options.hpp"
+#include "../timeline_player.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <getopt.h>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace MidiPlay;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Records when each message was sent
+class RecordingOutput : public cxxmidi::output::Abstract {
+public:
+    void OpenPort(unsigned int) override {}
+    void ClosePort() override {}
+    void OpenVirtualPort(const std::string&) override {}
+    size_t GetPortCount() override { return 1; }
+    std::string GetPortName(unsigned int) override { return "recording"; }
+
+    void SendMessage(const cxxmidi::Message*) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        sent.push_back(Clock::now());
+    }
+
+    std::mutex mutex;
+    std::vector<Clock::time_point> sent;
+};
+
+// A note every 240 ticks at 20000 us per quarter, 480 ppq: one every 10 ms
+cxxmidi::File makeNotes(int count) {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    cxxmidi::Track& track = file.AddTrack();
+    track.push_back(makeEvent(0, {0xFF, 0x51, 0x00, 0x4E, 0x20}));
+    for (int i = 0; i < count; i++) {
+        track.push_back(makeEvent(i == 0 ? 0 : 240, {0x90, 60, 100}));
+    }
+    track.push_back(makeEvent(240, {0xFF, 0x2F}));
+    return file;
+}
+
+} // namespace
+
+TEST_CASE("DeadlineSleeper never returns early", "[deadline_sleeper][unit]") {
+    SECTION("a deadline in the future") {
+        for (int i = 0; i < 20; i++) {
+            Clock::time_point deadline = Clock::now() + std::chrono::microseconds(500 + i * 100);
+            DeadlineSleeper::sleepUntil(deadline);
+            Clock::time_point woke = Clock::now();
+            REQUIRE(woke >= deadline);
+            REQUIRE(woke - deadline < std::chrono::milliseconds(20));
+        }
+    }
+
+    SECTION("a deadline already past returns at once") {
+        Clock::time_point started = Clock::now();
+        DeadlineSleeper::sleepUntil(started - std::chrono::milliseconds(5));
+        REQUIRE(Clock::now() - started < std::chrono::milliseconds(5));
+    }
+
+    SECTION("spinning the whole wait") {
+        Clock::time_point deadline = Clock::now() + std::chrono::microseconds(200);
+        DeadlineSleeper::sleepUntil(deadline, std::chrono::milliseconds(1));
+        REQUIRE(Clock::now() >= deadline);
+    }
+}
+
+TEST_CASE("TimelinePlayer with precise timing", "[deadline_sleeper][integration]") {
+    constexpr int NOTES = 10;
+    RecordingOutput output;
+    cxxmidi::File file = makeNotes(NOTES);
+    TimelinePlayer player(output, file);
+    player.setPreciseTiming(true);
+    REQUIRE(player.isPreciseTiming());
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    player.setCallbackFinished([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        finished.notify_one();
+    });
+
+    player.play();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(finished.wait_for(lock, std::chrono::seconds(5), [&]() { return done; }));
+    }
+
+    // Every note on its absolute time from the first; lateness never adds up
+    std::lock_guard<std::mutex> lock(output.mutex);
+    REQUIRE(output.sent.size() == NOTES);
+    for (int i = 1; i < NOTES; i++) {
+        auto offset = std::chrono::duration_cast<std::chrono::microseconds>(output.sent[i] - output.sent[0]);
+        REQUIRE(offset.count() >= i * 10000 - 1000);
+        REQUIRE(offset.count() < i * 10000 + 10000);
+    }
+}
+
+TEST_CASE("--precise-timing implies the timeline player", "[deadline_sleeper][options][unit]") {
+    optind = 0;
+    auto argv = makeArgv({"play", "162", "--precise-timing"});
+    Options options(3, argv);
+    REQUIRE(options.parse() == 0);
+    REQUIRE(options.isPreciseTiming());
+    REQUIRE(options.isTimelineEngine());
+    freeArgv(argv, 3);
+}
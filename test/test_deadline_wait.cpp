@@ -0,0 +1,61 @@
+#include "external/catch_amalgamated.hpp"
+#include "../deadline_wait.hpp"
+#include "../virtual_clock.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace MidiPlay;
+using namespace std::chrono_literals;
+
+TEST_CASE("DeadlineWait on a virtual clock moves the clock", "[deadline_wait][unit]") {
+    VirtualClock clock;
+    DeadlineWait wait;
+    wait.setVirtualClock(&clock);
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto deadline = clock.now() + 10s;
+    REQUIRE(wait.until(condition, lock, deadline, []() { return false; }));
+    REQUIRE(wait.now() == deadline);
+    REQUIRE(wait.nowNs() == clock.nowNs());
+    REQUIRE(wait.getWakeups() == 0);
+    REQUIRE(lock.owns_lock());
+}
+
+TEST_CASE("DeadlineWait in real time", "[deadline_wait][unit]") {
+    bool precise = GENERATE(false, true);
+    DeadlineWait wait;
+    wait.setPrecise(precise);
+    REQUIRE(wait.isPrecise() == precise);
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    SECTION("Returns at the deadline") {
+        auto deadline = DeadlineWait::Clock::now() + 5ms;
+        REQUIRE(wait.until(condition, lock, deadline, []() { return false; }));
+        REQUIRE(DeadlineWait::Clock::now() >= deadline);
+        REQUIRE(wait.getWakeups() == 1);
+        REQUIRE(lock.owns_lock());
+    }
+
+    SECTION("A change cuts the wait short") {
+        bool changed = false;
+        std::thread changer([&]() {
+            std::this_thread::sleep_for(5ms);
+            std::lock_guard<std::mutex> guard(mutex);
+            changed = true;
+            condition.notify_one();
+        });
+        auto deadline = DeadlineWait::Clock::now() + 10s;
+        REQUIRE_FALSE(wait.until(condition, lock, deadline, [&changed]() { return changed; }));
+        REQUIRE(DeadlineWait::Clock::now() < deadline);
+        REQUIRE(lock.owns_lock());
+        lock.unlock();
+        changer.join();
+    }
+}
@@ -0,0 +1,174 @@
+#include "external/catch_amalgamated.hpp"
+#include "../device_config_cache.hpp"
+#include "../device_manager.hpp"
+#include "../options.hpp"
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#include <getopt.h>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+// Helper functions (shared with other test files)
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+// Scratch directory removed when the test finishes
+struct TempDir {
+    fs::path path;
+
+    TempDir() {
+        path = fs::temp_directory_path() / ("midiplay_device_cache_test_" + std::to_string(getpid()));
+        fs::remove_all(path);
+        fs::create_directories(path);
+    }
+
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+};
+
+DeviceManager::YamlConfig sampleConfig() {
+    DeviceManager::YamlConfig config;
+    config.version = "1.0";
+    config.connection.timeout_iterations = 7;
+    config.connection.poll_sleep_seconds = 2;
+    config.connection.min_port_count = 3;
+    config.connection.output_port_index = 1;
+    config.connection.secondary_outputs = {"USB MIDI Recorder", "Choir"};
+
+    DeviceManager::DeviceConfig device;
+    device.name = "Casio Test";
+    device.description = "Test keyboard";
+    device.detection_strings = {"Casio USB-MIDI", "CTX"};
+    device.channels[1] = {0, 0, 19, "Organ"};
+    device.channels[3] = {121, 2, 48, "Strings"};
+    device.setupMessages = DeviceManager::buildSetupMessages(device);
+    device.output = "rawmidi";
+    device.rawmidi_device = "hw:1,0,0";
+    config.devices["casio_ctx3000"] = device;
+    return config;
+}
+
+} // namespace
+
+TEST_CASE("DeviceManager::buildSetupMessages", "[device_config_cache][unit]") {
+    DeviceManager::DeviceConfig device;
+    device.channels[1] = {0, 0, 19, "Organ"};
+    device.channels[3] = {121, 2, 48, "Strings"};
+
+    // Bank select only when non-zero, program change always
+    std::vector<std::uint8_t> expected{
+        0xC0, 19,
+        0xB2, 0, 121, 0xB2, 32, 2, 0xC2, 48,
+    };
+    REQUIRE(DeviceManager::buildSetupMessages(device) == expected);
+}
+
+TEST_CASE("DeviceConfigCache round trip", "[device_config_cache][unit]") {
+    TempDir temp;
+    fs::path yaml = temp.path / "midi_devices.yaml";
+    std::ofstream(yaml) << "version: \"1.0\"\n";
+
+    DeviceConfigCache cache((temp.path / "cache").string());
+    DeviceManager::YamlConfig config = sampleConfig();
+    DeviceManager::YamlConfig loaded;
+
+    SECTION("nothing cached is a miss") {
+        REQUIRE_FALSE(cache.load(yaml.string(), loaded));
+    }
+
+    SECTION("a stored configuration loads back unchanged") {
+        REQUIRE(cache.store(yaml.string(), config));
+        REQUIRE(cache.load(yaml.string(), loaded));
+
+        REQUIRE(loaded.version == "1.0");
+        REQUIRE(loaded.connection.timeout_iterations == 7);
+        REQUIRE(loaded.connection.poll_sleep_seconds == 2);
+        REQUIRE(loaded.connection.min_port_count == 3);
+        REQUIRE(loaded.connection.output_port_index == 1);
+        REQUIRE(loaded.connection.secondary_outputs == std::vector<std::string>{"USB MIDI Recorder", "Choir"});
+
+        REQUIRE(loaded.devices.size() == 1);
+        const DeviceManager::DeviceConfig& device = loaded.devices.at("casio_ctx3000");
+        REQUIRE(device.name == "Casio Test");
+        REQUIRE(device.description == "Test keyboard");
+        REQUIRE(device.detection_strings == std::vector<std::string>{"Casio USB-MIDI", "CTX"});
+        REQUIRE(device.channels.size() == 2);
+        REQUIRE(device.channels.at(3).bank_msb == 121);
+        REQUIRE(device.channels.at(3).bank_lsb == 2);
+        REQUIRE(device.channels.at(3).program == 48);
+        REQUIRE(device.channels.at(3).description == "Strings");
+        REQUIRE(device.setupMessages == config.devices.at("casio_ctx3000").setupMessages);
+        REQUIRE(device.usesRawMidi());
+        REQUIRE(device.rawmidi_device == "hw:1,0,0");
+    }
+
+    SECTION("editing the YAML file makes the cache stale") {
+        REQUIRE(cache.store(yaml.string(), config));
+        std::ofstream(yaml, std::ios::app) << "# edited\n";
+        REQUIRE_FALSE(cache.load(yaml.string(), loaded));
+    }
+
+    SECTION("another YAML file misses") {
+        fs::path other = temp.path / "other.yaml";
+        fs::copy_file(yaml, other);
+        fs::last_write_time(other, fs::last_write_time(yaml));
+        REQUIRE(cache.store(yaml.string(), config));
+        REQUIRE_FALSE(cache.load(other.string(), loaded));
+    }
+
+    SECTION("a truncated image misses") {
+        REQUIRE(cache.store(yaml.string(), config));
+        fs::resize_file(cache.getCachePath(), fs::file_size(cache.getCachePath()) - 4);
+        REQUIRE_FALSE(cache.load(yaml.string(), loaded));
+    }
+}
+
+TEST_CASE("DeviceManager uses the config cache", "[device_config_cache][integration]") {
+    std::string configPath = "fixtures/test_configs/valid_devices.yaml";
+    if (!fs::exists(configPath)) {
+        WARN("Test config not found: " << configPath);
+        return;
+    }
+
+    TempDir temp;
+
+    SECTION("the second load comes from the cache") {
+        optind = 0;
+        auto argv = makeArgv({"play", "test.mid"});
+        Options opts(2, argv);
+
+        DeviceManager first(opts);
+        first.setCacheDirectory(temp.path.string());
+        first.loadDevicePresets(configPath);
+        REQUIRE_FALSE(first.isLoadedFromCache());
+
+        DeviceManager second(opts);
+        second.setCacheDirectory(temp.path.string());
+        second.loadDevicePresets(configPath);
+        REQUIRE(second.isLoadedFromCache());
+        REQUIRE(second.getDeviceTypeName(DeviceType::CASIO_CTX3000) ==
+                first.getDeviceTypeName(DeviceType::CASIO_CTX3000));
+        freeArgv(argv, 2);
+    }
+
+    SECTION("--no-cache reads the YAML file") {
+        optind = 0;
+        auto argv = makeArgv({"play", "test.mid", "--no-cache"});
+        Options opts(3, argv);
+        opts.parse();
+
+        DeviceManager dm(opts);
+        dm.setCacheDirectory(temp.path.string());
+        dm.loadDevicePresets(configPath);
+        dm.loadDevicePresets(configPath);
+        REQUIRE_FALSE(dm.isLoadedFromCache());
+        REQUIRE_FALSE(fs::exists(DeviceConfigCache(temp.path.string()).getCachePath()));
+        freeArgv(argv, 3);
+    }
+}
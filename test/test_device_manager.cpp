@@ -293,6 +293,42 @@ TEST_CASE("DeviceManager: YAML Error Handling", "[device_manager][unit]") {
         );
     }
     
+    SECTION("Accepts a rawmidi output") {
+        std::string configPath = "fixtures/test_configs/rawmidi_devices.yaml";
+        
+        if (!fs::exists(configPath)) {
+            WARN("Test config not found: " << configPath);
+            freeArgv(argv, 2);
+            return;
+        }
+        
+        DeviceManager dm(opts);
+        dm.setCacheDirectory("");
+        
+        REQUIRE_NOTHROW(dm.loadDevicePresets(configPath));
+        REQUIRE(dm.getDeviceTypeName(DeviceType::CASIO_CTX3000) == "Casio Test");
+    }
+    
+    SECTION("Throws on an unknown output") {
+        std::string configPath = "fixtures/test_configs/unknown_output.yaml";
+        
+        if (!fs::exists(configPath)) {
+            WARN("Test config not found: " << configPath);
+            freeArgv(argv, 2);
+            return;
+        }
+        
+        DeviceManager dm(opts);
+        dm.setCacheDirectory("");
+        
+        try {
+            dm.loadDevicePresets(configPath);
+            FAIL("Should have thrown");
+        } catch (const std::runtime_error& e) {
+            REQUIRE(std::string(e.what()).find("network") != std::string::npos);
+        }
+    }
+    
     SECTION("Error messages are descriptive") {
         std::string configPath = "fixtures/test_configs/invalid_syntax.yaml";
         
@@ -0,0 +1,120 @@
+#include "external/catch_amalgamated.hpp"
+#include "../dry_run.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include "../virtual_clock.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <getopt.h>
+#include <sstream>
+#include <vector>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+TEST_CASE("VirtualClock", "[dry_run][unit]") {
+    VirtualClock clock;
+    REQUIRE(clock.nowNs() == 0);
+
+    clock.advanceTo(VirtualClock::Clock::time_point(std::chrono::milliseconds(5)));
+    REQUIRE(clock.nowNs() == 5000000);
+
+    SECTION("never goes backwards") {
+        clock.advanceTo(VirtualClock::Clock::time_point(std::chrono::milliseconds(1)));
+        REQUIRE(clock.nowNs() == 5000000);
+    }
+}
+
+TEST_CASE("--dry-run", "[dry_run][options][unit]") {
+    optind = 0;
+    auto argv = makeArgv({"play", "162", "--dry-run"});
+    Options options(3, argv);
+    REQUIRE(options.parse() == 0);
+    REQUIRE(options.isDryRun());
+    freeArgv(argv, 3);
+}
+
+TEST_CASE("DryRun plays a whole hymn without waiting", "[dry_run][integration]") {
+    std::string introFile = "fixtures/test_files/with_intro.mid";
+    if (!fs::exists(introFile)) {
+        WARN("Test file not found: " << introFile);
+        return;
+    }
+
+    optind = 0;
+    auto argv = makeArgv({"play", introFile, "-n2", "--no-cache"});
+    Options options(4, argv);
+    options.parse();
+
+    MidiLoader loader;
+    REQUIRE(loader.loadFile(introFile, options));
+
+    DryRun dryRun(loader);
+    DryRun::Report report = dryRun.run(false);
+
+    SECTION("every section is played, in order") {
+        size_t expected = (loader.shouldPlayIntro() ? 1 : 0) + 2;
+        REQUIRE(report.sections.size() == expected);
+        for (size_t i = 1; i < report.sections.size(); i++) {
+            REQUIRE(report.sections[i].startUs > report.sections[i - 1].endUs);
+            REQUIRE(report.sections[i].events > 0);
+        }
+        REQUIRE(report.sections.back().number == 2);
+    }
+
+    SECTION("virtual time matches the projected duration") {
+        // No ritardando is modelled by the projection, so the performance is never shorter
+        double projectedUs = loader.getProjectedDurationSeconds() * 1e6;
+        REQUIRE(static_cast<double>(report.durationUs) >= projectedUs * 0.99);
+        REQUIRE(report.renderMs < report.durationUs / 1000.0);
+    }
+
+    SECTION("the report is printed") {
+        std::ostringstream out;
+        DryRun::print(report, out);
+        REQUIRE(out.str().find("Verse 2") != std::string::npos);
+    }
+
+    freeArgv(argv, 4);
+}
+
+TEST_CASE("DryRun of a streaming load plays the whole hymn", "[dry_run][streaming_loader][integration]") {
+    std::string introFile = "fixtures/test_files/with_intro.mid";
+    if (!fs::exists(introFile)) {
+        WARN("Test file not found: " << introFile);
+        return;
+    }
+
+    optind = 0;
+    auto normalArgv = makeArgv({"play", introFile, "-n2", "--no-cache"});
+    Options normalOptions(4, normalArgv);
+    normalOptions.parse();
+    optind = 0;
+    auto streamArgv = makeArgv({"play", introFile, "-n2", "--no-cache", "--stream"});
+    Options streamOptions(5, streamArgv);
+    streamOptions.parse();
+
+    MidiLoader normal;
+    REQUIRE(normal.loadFile(introFile, normalOptions));
+    MidiLoader streamed;
+    REQUIRE(streamed.loadFile(introFile, streamOptions));
+    REQUIRE(streamed.isStreaming());
+
+    DryRun::Report expected = DryRun(normal).run(false);
+    DryRun::Report report = DryRun(streamed).run(false);
+
+    REQUIRE(report.durationUs == expected.durationUs);
+    REQUIRE(report.messages == expected.messages);
+    REQUIRE(report.sections.size() == expected.sections.size());
+    for (size_t i = 0; i < expected.sections.size(); i++) {
+        REQUIRE(report.sections[i].number == expected.sections[i].number);
+        REQUIRE(report.sections[i].events == expected.sections[i].events);
+    }
+
+    freeArgv(normalArgv, 4);
+    freeArgv(streamArgv, 5);
+}
@@ -0,0 +1,115 @@
+#include "external/catch_amalgamated.hpp"
+#include "../event_arena.hpp"
+#include "../playback_timeline.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <cxxmidi/message.hpp>
+#include <initializer_list>
+#include <vector>
+
+using namespace MidiPlay;
+using cxxmidi::Event;
+using cxxmidi::Message;
+
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+// Track 0: tempo, marker, note; track 1: two notes and a SysEx
+cxxmidi::File makeFile() {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+
+    cxxmidi::Track& first = file.AddTrack();
+    first.push_back(makeEvent(0, {0xFF, 0x51, 0x07, 0xA1, 0x20}));
+    first.push_back(makeEvent(0, {0xFF, 0x06, '['}));
+    first.push_back(makeEvent(480, {0x90, 60, 100}));
+    first.push_back(makeEvent(480, {0xFF, 0x2F}));
+
+    cxxmidi::Track& second = file.AddTrack();
+    second.push_back(makeEvent(0, {0x91, 48, 90}));
+    second.push_back(makeEvent(240, {0xF0, 0x43, 0x10, 0x4C, 0xF7}));
+    second.push_back(makeEvent(240, {0x81, 48, 0}));
+    second.push_back(makeEvent(1440, {0xFF, 0x2F}));
+
+    return file;
+}
+
+std::vector<uint8_t> bytesOf(const EventView& event) {
+    return std::vector<uint8_t>(event.data(), event.data() + event.size());
+}
+
+} // namespace
+
+TEST_CASE("EventArena holds the tracks of a file", "[event_arena][unit]") {
+    cxxmidi::File file = makeFile();
+    EventArena arena(file);
+
+    REQUIRE(arena.getTimeDivision() == file.TimeDivision());
+    REQUIRE(arena.getTrackCount() == 2);
+    REQUIRE(arena.getTrackSize(0) == 4);
+    REQUIRE(arena.getTrackSize(1) == 4);
+    REQUIRE(arena.size() == 8);
+
+    SECTION("every event keeps its bytes and delta time") {
+        for (size_t t = 0; t < file.size(); t++) {
+            for (size_t i = 0; i < file[t].size(); i++) {
+                EventView event = arena.at(t, i);
+                REQUIRE(event.dt() == file[t][i].Dt());
+                REQUIRE(bytesOf(event) == std::vector<uint8_t>(file[t][i].begin(), file[t][i].end()));
+            }
+        }
+    }
+
+    SECTION("short events are stored in their record, longer ones in the payload") {
+        const uint8_t* record = arena.at(1, 0).data();
+        const uint8_t* nextRecord = arena.at(1, 2).data();
+        REQUIRE(nextRecord > record);
+        REQUIRE(static_cast<size_t>(nextRecord - record) <= 2 * 16);
+
+        const uint8_t* tempo = arena.at(0, 0).data();
+        const uint8_t* sysex = arena.at(1, 1).data();
+        REQUIRE(sysex == tempo + 5);    // Back to back in the payload block
+    }
+
+    SECTION("clear frees everything") {
+        arena.clear();
+        REQUIRE(arena.empty());
+        REQUIRE(arena.getTrackCount() == 0);
+        REQUIRE(arena.getMemoryBytes() == 0);
+    }
+}
+
+TEST_CASE("EventArena is filled track by track", "[event_arena][unit]") {
+    EventArena arena;
+    const uint8_t note[] = {0x90, 60, 100};
+
+    arena.addTrack();
+    arena.addTrack();
+    arena.append(10, note, sizeof(note));
+    arena.addTrack();
+
+    REQUIRE(arena.getTrackCount() == 3);
+    REQUIRE(arena.getTrackSize(0) == 0);
+    REQUIRE(arena.getTrackSize(1) == 1);
+    REQUIRE(arena.getTrackSize(2) == 0);
+    REQUIRE(arena.at(1, 0).dt() == 10);
+    REQUIRE(arena.at(1, 0)[1] == 60);
+}
+
+TEST_CASE("PlaybackTimeline from an arena matches one from the file", "[event_arena][playback_timeline][unit]") {
+    cxxmidi::File file = makeFile();
+    EventArena arena(file);
+    PlaybackTimeline fromFile(file);
+    PlaybackTimeline fromArena(arena);
+
+    REQUIRE(fromArena.size() == fromFile.size());
+    REQUIRE(fromArena.getEndTick() == fromFile.getEndTick());
+    REQUIRE(fromArena.getChannelMask() == fromFile.getChannelMask());
+    for (size_t i = 0; i < fromFile.size(); i++) {
+        REQUIRE(fromArena.tickAt(i) == fromFile.tickAt(i));
+        REQUIRE(fromArena.timeAt(i) == fromFile.timeAt(i));
+        REQUIRE(bytesOf(fromArena.eventAt(i)) == bytesOf(fromFile.eventAt(i)));
+    }
+}
@@ -0,0 +1,72 @@
+#include "external/catch_amalgamated.hpp"
+#include "../event_view.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/message.hpp>
+
+using namespace MidiPlay;
+using cxxmidi::Event;
+using cxxmidi::Message;
+
+TEST_CASE("EventView reads events in place", "[event_view][unit]") {
+    SECTION("view refers to the event bytes without copying") {
+        Event event(96, 0x90, 60, 100);
+        EventView view(event);
+
+        REQUIRE(view.data() == event.data());
+        REQUIRE(view.size() == 3);
+        REQUIRE(view.dt() == 96);
+        REQUIRE(view[1] == 60);
+        REQUIRE(view.status() == 0x90);
+    }
+
+    SECTION("empty view has no status") {
+        EventView view(nullptr, 0, 0);
+
+        REQUIRE(view.empty());
+        REQUIRE(view.status() == 0);
+        REQUIRE_FALSE(view.isMeta());
+        REQUIRE_FALSE(view.isSysex());
+        REQUIRE_FALSE(view.isControlChange());
+    }
+}
+
+TEST_CASE("EventView predicates match cxxmidi::Message", "[event_view][unit]") {
+    SECTION("voice categories ignore the channel") {
+        Event noteOn(0, 0x93, 60, 100);
+        EventView view(noteOn);
+
+        REQUIRE(view.isVoiceCategory(Message::Type::NoteOn));
+        REQUIRE_FALSE(view.isVoiceCategory(Message::Type::NoteOff));
+        REQUIRE(view.isVoiceCategory(Message::Type::NoteOn) == noteOn.IsVoiceCategory(Message::Type::NoteOn));
+    }
+
+    SECTION("control change with controller number") {
+        Event nrpn(0, 0xB1, 99, 1);
+        EventView view(nrpn);
+
+        REQUIRE(view.isControlChange());
+        REQUIRE(view.isControlChange(Message::ControlType::NonRegisteredParameterNumberMsb));
+        REQUIRE_FALSE(view.isControlChange(Message::ControlType::DataEntryMsb));
+    }
+
+    SECTION("meta events and their text") {
+        const uint8_t marker[] = {0xFF, 0x06, 'F', 'i', 'n', 'e'};
+        EventView view(marker, sizeof(marker), 0);
+
+        REQUIRE(view.isMeta());
+        REQUIRE(view.isMeta(Message::MetaType::Marker));
+        REQUIRE_FALSE(view.isMeta(Message::MetaType::Text));
+        REQUIRE(view.text() == "Fine");
+    }
+
+    SECTION("non-meta events have no text") {
+        Event noteOff(0, 0x80, 60, 0);
+        REQUIRE(EventView(noteOff).text().empty());
+    }
+
+    SECTION("sysex") {
+        const uint8_t sysex[] = {0xF0, 0x7E, 0xF7};
+        REQUIRE(EventView(sysex, sizeof(sysex), 0).isSysex());
+    }
+}
@@ -0,0 +1,255 @@
+#include "external/catch_amalgamated.hpp"
+#include "../hymn_cache.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <unistd.h>
+#include <getopt.h>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+// Helper functions (shared with other test files)
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+// Scratch directory removed when the test finishes
+struct TempDir {
+    fs::path path;
+
+    TempDir() {
+        path = fs::temp_directory_path() / ("midiplay_cache_test_" + std::to_string(getpid()));
+        fs::remove_all(path);
+        fs::create_directories(path);
+    }
+
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+};
+
+} // namespace
+
+TEST_CASE("HymnCache location", "[hymn_cache][unit]") {
+    SECTION("default directory honors XDG_CACHE_HOME") {
+        const char* saved = getenv("XDG_CACHE_HOME");
+        std::string savedValue = saved ? saved : "";
+
+        setenv("XDG_CACHE_HOME", "/tmp/xdg-test", 1);
+        REQUIRE(HymnCache::defaultDirectory() == "/tmp/xdg-test/midiplay");
+
+        if (saved) {
+            setenv("XDG_CACHE_HOME", savedValue.c_str(), 1);
+        } else {
+            unsetenv("XDG_CACHE_HOME");
+        }
+    }
+
+    SECTION("cache path is stable and inside the cache directory") {
+        HymnCache cache("/tmp/cache-dir");
+        std::string first = cache.cachePathFor("/hymns/abide.mid");
+
+        REQUIRE(first == cache.cachePathFor("/hymns/abide.mid"));
+        REQUIRE(first.rfind("/tmp/cache-dir/", 0) == 0);
+        REQUIRE(first != cache.cachePathFor("/hymns/other.mid"));
+    }
+
+    SECTION("empty directory disables caching") {
+        HymnCache cache("");
+        cxxmidi::File file;
+        PreprocessedMetadata metadata;
+
+        REQUIRE_FALSE(cache.load("fixtures/test_files/simple.mid", file, metadata));
+        REQUIRE_FALSE(cache.store("fixtures/test_files/simple.mid", file, metadata));
+    }
+}
+
+TEST_CASE("HymnCache round trip", "[hymn_cache][integration]") {
+    std::string sourceFile = "fixtures/test_files/with_intro.mid";
+
+    if (!fs::exists(sourceFile)) {
+        WARN("Test file not found: " << sourceFile);
+        return;
+    }
+
+    TempDir dir;
+
+    // Work on a private copy so the fixture's mtime is never touched
+    fs::path source = dir.path / "with_intro.mid";
+    fs::copy_file(sourceFile, source);
+
+    optind = 0;
+    auto argv = makeArgv({"play", source.string(), "--no-cache"});
+    Options options(3, argv);
+    options.parse();
+
+    MidiLoader loader;
+    REQUIRE(loader.loadFile(source.string(), options));
+
+    HymnCache cache((dir.path / "cache").string());
+
+    SECTION("stored image restores identical events and metadata") {
+        PreprocessedMetadata original;
+        original.title = loader.getTitle();
+        original.keySignature = loader.getKeySignature();
+        original.introSegments = loader.getIntroSegments();
+        original.verses = 2;
+        original.uSecPerQuarter = loader.getUSecPerQuarter();
+        original.fileTempo = loader.getFileTempo();
+        original.tempoFound = true;
+        original.tempoChanges = {{0, 500000}, {1920, 750000}};
+        original.pauseTicks = MidiTicks(480);
+
+        REQUIRE(cache.store(source.string(), loader.getFile(), original));
+
+        cxxmidi::File restored;
+        PreprocessedMetadata metadata;
+        REQUIRE(cache.load(source.string(), restored, metadata));
+
+        REQUIRE(restored.TimeDivision() == loader.getFile().TimeDivision());
+        REQUIRE(restored.size() == loader.getFile().size());
+        for (size_t t = 0; t < restored.size(); t++) {
+            REQUIRE(restored[t].size() == loader.getFile()[t].size());
+            for (size_t e = 0; e < restored[t].size(); e++) {
+                REQUIRE(restored[t][e].Dt() == loader.getFile()[t][e].Dt());
+                REQUIRE(static_cast<const std::vector<uint8_t>&>(restored[t][e])
+                        == static_cast<const std::vector<uint8_t>&>(loader.getFile()[t][e]));
+            }
+        }
+
+        REQUIRE(metadata.title == original.title);
+        REQUIRE(metadata.keySignature == original.keySignature);
+        REQUIRE(metadata.introSegments.size() == original.introSegments.size());
+        REQUIRE(metadata.verses == 2);
+        REQUIRE(metadata.uSecPerQuarter == original.uSecPerQuarter);
+        REQUIRE(metadata.fileTempo == original.fileTempo);
+        REQUIRE(metadata.tempoChanges.size() == 2);
+        REQUIRE(metadata.tempoChanges[1].tick == 1920);
+        REQUIRE(metadata.tempoChanges[1].uSecPerQuarter == 750000);
+        REQUIRE(metadata.pauseTicks == 480);
+    }
+
+    SECTION("modified source invalidates the entry") {
+        REQUIRE(cache.store(source.string(), loader.getFile(), PreprocessedMetadata()));
+
+        // Appending a byte changes both size and mtime
+        std::ofstream(source, std::ios::app) << '\0';
+
+        cxxmidi::File restored;
+        PreprocessedMetadata metadata;
+        REQUIRE_FALSE(cache.load(source.string(), restored, metadata));
+    }
+
+    SECTION("truncated image is treated as a miss") {
+        REQUIRE(cache.store(source.string(), loader.getFile(), PreprocessedMetadata()));
+
+        std::string image = cache.cachePathFor(source.string());
+        fs::resize_file(image, fs::file_size(image) / 2);
+
+        cxxmidi::File restored;
+        PreprocessedMetadata metadata;
+        REQUIRE_FALSE(cache.load(source.string(), restored, metadata));
+    }
+
+    freeArgv(argv, 3);
+}
+
+TEST_CASE("MidiLoader warm start from cache", "[hymn_cache][midi_loader][integration]") {
+    std::string sourceFile = "fixtures/test_files/with_intro.mid";
+
+    if (!fs::exists(sourceFile)) {
+        WARN("Test file not found: " << sourceFile);
+        return;
+    }
+
+    TempDir dir;
+
+    SECTION("second load comes from the cache with the same metadata") {
+        optind = 0;
+        auto argv = makeArgv({"play", sourceFile, "-t100"});
+        Options options(3, argv);
+        options.parse();
+
+        MidiLoader cold;
+        cold.setCacheDirectory(dir.path.string());
+        REQUIRE(cold.loadFile(sourceFile, options));
+        REQUIRE_FALSE(cold.isLoadedFromCache());
+
+        MidiLoader warm;
+        warm.setCacheDirectory(dir.path.string());
+        REQUIRE(warm.loadFile(sourceFile, options));
+        REQUIRE(warm.isLoadedFromCache());
+
+        REQUIRE(warm.getTitle() == cold.getTitle());
+        REQUIRE(warm.getKeySignature() == cold.getKeySignature());
+        REQUIRE(warm.getVerses() == cold.getVerses());
+        REQUIRE(warm.getBpm() == 100);
+        REQUIRE(warm.getFileTempo() == cold.getFileTempo());
+        REQUIRE(warm.getUSecPerTick() == cold.getUSecPerTick());
+        REQUIRE(warm.getTempoMap().getChanges().size() == cold.getTempoMap().getChanges().size());
+        REQUIRE(warm.getPauseMicroseconds() == cold.getPauseMicroseconds());
+        REQUIRE(warm.getIntroSegments().size() == cold.getIntroSegments().size());
+        REQUIRE(warm.shouldPlayIntro() == cold.shouldPlayIntro());
+        REQUIRE(warm.hasPotentialStuckNote() == cold.hasPotentialStuckNote());
+        REQUIRE(warm.getFile().size() == cold.getFile().size());
+
+        freeArgv(argv, 3);
+    }
+
+    SECTION("cached verse count does not depend on the options of the first run") {
+        optind = 0;
+        auto argvFirst = makeArgv({"play", sourceFile, "-x3"});
+        Options first(3, argvFirst);
+        first.parse();
+
+        MidiLoader cold;
+        cold.setCacheDirectory(dir.path.string());
+        REQUIRE(cold.loadFile(sourceFile, first));
+        REQUIRE(cold.getVerses() == 3);
+
+        optind = 0;
+        auto argvSecond = makeArgv({"play", sourceFile, "--no-cache"});
+        Options uncached(3, argvSecond);
+        uncached.parse();
+
+        MidiLoader reference;
+        REQUIRE(reference.loadFile(sourceFile, uncached));
+
+        optind = 0;
+        auto argvThird = makeArgv({"play", sourceFile});
+        Options second(2, argvThird);
+        second.parse();
+
+        MidiLoader warm;
+        warm.setCacheDirectory(dir.path.string());
+        REQUIRE(warm.loadFile(sourceFile, second));
+        REQUIRE(warm.isLoadedFromCache());
+        REQUIRE(warm.getVerses() == reference.getVerses());
+
+        freeArgv(argvFirst, 3);
+        freeArgv(argvSecond, 3);
+        freeArgv(argvThird, 2);
+    }
+
+    SECTION("--no-cache bypasses the cache") {
+        optind = 0;
+        auto argv = makeArgv({"play", sourceFile, "--no-cache"});
+        Options options(3, argv);
+        options.parse();
+
+        REQUIRE_FALSE(options.isCacheEnabled());
+
+        MidiLoader loader;
+        loader.setCacheDirectory(dir.path.string());
+        REQUIRE(loader.loadFile(sourceFile, options));
+        REQUIRE_FALSE(loader.isLoadedFromCache());
+        REQUIRE(fs::is_empty(dir.path));
+
+        freeArgv(argv, 3);
+    }
+}
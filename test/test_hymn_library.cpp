@@ -0,0 +1,131 @@
+#include "external/catch_amalgamated.hpp"
+#include "../hymn_library.hpp"
+#include "../hymn_cache.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <getopt.h>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+// Helper functions (shared with other test files)
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+// Hymn and cache directories removed when the test finishes
+struct LibraryDirs {
+    fs::path root;
+    fs::path hymns;
+    fs::path cache;
+
+    LibraryDirs() {
+        root = fs::temp_directory_path() / ("midiplay_library_test_" + std::to_string(getpid()));
+        hymns = root / "hymns";
+        cache = root / "cache";
+        fs::remove_all(root);
+        fs::create_directories(hymns);
+        for (const char* name : {"simple.mid", "with_intro.mid", "dc_al_fine.mid"}) {
+            fs::copy_file(fs::path("fixtures/test_files") / name, hymns / name);
+        }
+        std::ofstream(hymns / "notes.txt") << "not a hymn";
+    }
+
+    ~LibraryDirs() {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+};
+
+} // namespace
+
+TEST_CASE("HymnLibrary location", "[hymn_library][unit]") {
+    REQUIRE(HymnLibrary::pathIn("/tmp/cache-dir", false) == "/tmp/cache-dir/hymnal.mpl");
+    REQUIRE(HymnLibrary::pathIn("/tmp/cache-dir", true) == "/tmp/cache-dir/hymnal-staging.mpl");
+    REQUIRE(HymnLibrary::pathIn("", false).empty());
+
+    HymnLibrary library;
+    REQUIRE_FALSE(library.attach(""));
+    REQUIRE_FALSE(library.attach("/nonexistent/hymnal.mpl"));
+    REQUIRE_FALSE(library.isAttached());
+}
+
+TEST_CASE("HymnLibrary publish and load", "[hymn_library][integration]") {
+    if (!fs::exists("fixtures/test_files/with_intro.mid")) {
+        WARN("Test files not found");
+        return;
+    }
+
+    LibraryDirs dirs;
+    HymnCache cache(dirs.cache.string());
+    std::string libraryPath = HymnLibrary::pathIn(cache.getDirectory(), false);
+
+    HymnLibrary::PublishStats stats = HymnLibrary::publish(dirs.hymns.string(), cache, libraryPath);
+    REQUIRE(stats.published == 3);
+    REQUIRE(stats.loaded == 3);
+    REQUIRE(stats.failed == 0);
+    REQUIRE(stats.bytes == fs::file_size(libraryPath));
+
+    HymnLibrary library;
+    REQUIRE(library.attach(libraryPath));
+    REQUIRE(library.size() == 3);
+
+    SECTION("hymns load as they do from the cache") {
+        std::string path = (dirs.hymns / "with_intro.mid").string();
+        cxxmidi::File fromLibrary;
+        PreprocessedMetadata libraryMetadata;
+        REQUIRE(library.load(path, fromLibrary, libraryMetadata));
+
+        cxxmidi::File fromCache;
+        PreprocessedMetadata cacheMetadata;
+        REQUIRE(cache.load(path, fromCache, cacheMetadata));
+
+        REQUIRE(libraryMetadata.title == cacheMetadata.title);
+        REQUIRE(libraryMetadata.introSegments.size() == cacheMetadata.introSegments.size());
+        REQUIRE(fromLibrary.size() == fromCache.size());
+        for (size_t t = 0; t < fromCache.size(); t++) {
+            REQUIRE(fromLibrary[t].size() == fromCache[t].size());
+        }
+    }
+
+    SECTION("MidiLoader reads the library without the hymn's own cache image") {
+        std::string path = (dirs.hymns / "simple.mid").string();
+        fs::remove(cache.cachePathFor(path));
+
+        optind = 0;
+        auto argv = makeArgv({"play", path});
+        Options options(2, argv);
+        options.parse();
+
+        MidiLoader loader;
+        loader.setCacheDirectory(cache.getDirectory());
+        REQUIRE(loader.loadFile(path, options));
+        REQUIRE(loader.isLoadedFromCache());
+        REQUIRE_FALSE(fs::exists(cache.cachePathFor(path)));
+
+        freeArgv(argv, 2);
+    }
+
+    SECTION("a hymn changed since publishing is not found") {
+        std::string path = (dirs.hymns / "dc_al_fine.mid").string();
+        std::ofstream(path, std::ios::app) << '\0';
+
+        cxxmidi::File file;
+        PreprocessedMetadata metadata;
+        REQUIRE_FALSE(library.load(path, file, metadata));
+
+        // Publishing again loads only that hymn, and attach() picks up the new file
+        HymnLibrary::PublishStats again = HymnLibrary::publish(dirs.hymns.string(), cache, libraryPath);
+        REQUIRE(again.published == 3);
+        REQUIRE(again.loaded == 1);
+        REQUIRE(library.attach(libraryPath));
+        REQUIRE(library.load(path, file, metadata));
+    }
+}
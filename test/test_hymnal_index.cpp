@@ -0,0 +1,187 @@
+#include "external/catch_amalgamated.hpp"
+#include "../hymnal_index.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <unistd.h>
+#include <getopt.h>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+// Helper functions (shared with other test files)
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+// Hymn directory holding copies of the fixtures; the hymn cache is redirected
+// inside it so indexing never writes to the user's cache
+struct HymnDir {
+    fs::path path;
+    fs::path hymns;
+    std::string savedCacheHome;
+    bool hadCacheHome;
+
+    HymnDir() {
+        path = fs::temp_directory_path() / ("midiplay_index_test_" + std::to_string(getpid()));
+        hymns = path / "hymns";
+        fs::remove_all(path);
+        fs::create_directories(hymns);
+
+        for (const char* name : {"simple.mid", "with_intro.mid", "ritardando.mid"}) {
+            fs::path source = fs::path("fixtures/test_files") / name;
+            if (fs::exists(source)) {
+                fs::copy_file(source, hymns / name);
+            }
+        }
+
+        const char* cacheHome = getenv("XDG_CACHE_HOME");
+        hadCacheHome = cacheHome != nullptr;
+        savedCacheHome = cacheHome ? cacheHome : "";
+        setenv("XDG_CACHE_HOME", (path / "cache").c_str(), 1);
+    }
+
+    ~HymnDir() {
+        if (hadCacheHome) {
+            setenv("XDG_CACHE_HOME", savedCacheHome.c_str(), 1);
+        } else {
+            unsetenv("XDG_CACHE_HOME");
+        }
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+
+    std::string indexPath() const { return (path / "hymnal.idx").string(); }
+};
+
+} // namespace
+
+TEST_CASE("HymnalIndex location", "[hymnal_index][unit]") {
+    const char* saved = getenv("XDG_CACHE_HOME");
+    std::string savedValue = saved ? saved : "";
+
+    setenv("XDG_CACHE_HOME", "/tmp/xdg-test", 1);
+    REQUIRE(HymnalIndex::defaultIndexPath(false) == "/tmp/xdg-test/midiplay/hymnal.idx");
+    REQUIRE(HymnalIndex::defaultIndexPath(true) == "/tmp/xdg-test/midiplay/hymnal-staging.idx");
+
+    if (saved) {
+        setenv("XDG_CACHE_HOME", savedValue.c_str(), 1);
+    } else {
+        unsetenv("XDG_CACHE_HOME");
+    }
+}
+
+TEST_CASE("HymnalIndex missing index loads empty", "[hymnal_index][unit]") {
+    HymnalIndex index("/nonexistent/hymnal.idx");
+
+    REQUIRE_FALSE(index.load());
+    REQUIRE(index.entries().empty());
+    REQUIRE(index.find("simple.mid") == nullptr);
+}
+
+TEST_CASE("HymnalIndex update and persistence", "[hymnal_index][integration]") {
+    if (!fs::exists("fixtures/test_files/with_intro.mid")) {
+        WARN("Test files not found in fixtures/test_files");
+        return;
+    }
+
+    HymnDir dir;
+    size_t fileCount = std::distance(fs::directory_iterator(dir.hymns), fs::directory_iterator());
+
+    HymnalIndex index(dir.indexPath());
+    HymnalIndex::UpdateStats stats = index.update(dir.hymns.string());
+
+    SECTION("first scan indexes every MIDI file") {
+        REQUIRE(stats.indexed == fileCount);
+        REQUIRE(stats.reused == 0);
+        REQUIRE(index.entries().size() == fileCount);
+    }
+
+    SECTION("entries match a full load") {
+        optind = 0;
+        Options defaults(0, nullptr);
+        MidiLoader loader;
+        REQUIRE(loader.loadFile((dir.hymns / "with_intro.mid").string(), defaults));
+
+        const HymnalEntry* entry = index.find("with_intro.mid");
+        REQUIRE(entry != nullptr);
+        REQUIRE(entry->title == loader.getTitle());
+        REQUIRE(entry->keySignature == loader.getKeySignature());
+        REQUIRE(entry->verses == loader.getVerses());
+        REQUIRE(entry->bpm == loader.getBpm());
+        REQUIRE(entry->hasIntro == !loader.getIntroSegments().empty());
+        REQUIRE(entry->durationSeconds == Catch::Approx(loader.getProjectedDurationSeconds()));
+        REQUIRE(entry->durationSeconds > 0.0);
+    }
+
+    SECTION("saved index reloads identically") {
+        REQUIRE(index.save());
+
+        HymnalIndex reloaded(dir.indexPath());
+        REQUIRE(reloaded.load());
+        REQUIRE(reloaded.getDirectory() == dir.hymns.string());
+        REQUIRE(reloaded.entries().size() == index.entries().size());
+
+        for (size_t i = 0; i < index.entries().size(); i++) {
+            const HymnalEntry& a = index.entries()[i];
+            const HymnalEntry& b = reloaded.entries()[i];
+            REQUIRE(a.fileName == b.fileName);
+            REQUIRE(a.title == b.title);
+            REQUIRE(a.verses == b.verses);
+            REQUIRE(a.mtimeNs == b.mtimeNs);
+            REQUIRE(a.durationSeconds == b.durationSeconds);
+        }
+    }
+
+    SECTION("rescan only reloads changed files") {
+        std::ofstream(dir.hymns / "simple.mid", std::ios::app) << '\0';
+        fs::remove(dir.hymns / "ritardando.mid");
+
+        HymnalIndex::UpdateStats rescan = index.update(dir.hymns.string());
+        REQUIRE(rescan.indexed + rescan.failed == 1);
+        REQUIRE(rescan.reused == fileCount - 2);
+        REQUIRE(rescan.removed == 1);
+        REQUIRE(index.find("ritardando.mid") == nullptr);
+    }
+
+    SECTION("search matches title and file name case-insensitively") {
+        REQUIRE(index.search("").size() == index.entries().size());
+        REQUIRE(index.search("WITH_INTRO").size() == 1);
+
+        const HymnalEntry* entry = index.find("with_intro.mid");
+        REQUIRE(entry != nullptr);
+        if (!entry->title.empty()) {
+            REQUIRE_FALSE(index.search(entry->title).empty());
+        }
+
+        REQUIRE(index.search("no hymn has this title").empty());
+    }
+}
+
+TEST_CASE("Options --list", "[hymnal_index][options][unit]") {
+    SECTION("no file name is required") {
+        optind = 0;
+        auto argv = makeArgv({"play", "--list"});
+        Options options(2, argv);
+
+        REQUIRE(options.parse() == MidiPlay::OptionsParseResult::SUCCESS);
+        REQUIRE(options.isListMode());
+        REQUIRE(options.getListQuery().empty());
+
+        freeArgv(argv, 2);
+    }
+
+    SECTION("search text is captured") {
+        optind = 0;
+        auto argv = makeArgv({"play", "--list=abide"});
+        Options options(2, argv);
+
+        REQUIRE(options.parse() == MidiPlay::OptionsParseResult::SUCCESS);
+        REQUIRE(options.getListQuery() == "abide");
+
+        freeArgv(argv, 2);
+    }
+}
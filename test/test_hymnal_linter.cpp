@@ -0,0 +1,183 @@
+#include "external/catch_amalgamated.hpp"
+#include "../hymnal_linter.hpp"
+#include "../event_preprocessor.hpp"
+#include "../options.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <getopt.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+const std::vector<uint8_t> TEMPO = {0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20};
+const std::vector<uint8_t> NOTE = {0x00, 0x90, 60, 100, 0x83, 0x60, 0x80, 60, 0};
+const std::vector<uint8_t> END_OF_TRACK = {0x00, 0xFF, 0x2F, 0x00};
+
+std::vector<uint8_t> marker(char text) {
+    return {0x00, 0xFF, 0x06, 0x01, static_cast<uint8_t>(text)};
+}
+
+// Format 0 file, 480 PPQ, with one track made of the given events
+void writeMidi(const fs::path& path, const std::vector<std::vector<uint8_t>>& events) {
+    std::vector<uint8_t> track;
+    for (const std::vector<uint8_t>& event : events) {
+        track.insert(track.end(), event.begin(), event.end());
+    }
+    track.insert(track.end(), END_OF_TRACK.begin(), END_OF_TRACK.end());
+
+    std::vector<uint8_t> bytes = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0x01, 0xE0,
+                                  'M', 'T', 'r', 'k'};
+    uint32_t size = static_cast<uint32_t>(track.size());
+    bytes.push_back(static_cast<uint8_t>(size >> 24));
+    bytes.push_back(static_cast<uint8_t>(size >> 16));
+    bytes.push_back(static_cast<uint8_t>(size >> 8));
+    bytes.push_back(static_cast<uint8_t>(size));
+    bytes.insert(bytes.end(), track.begin(), track.end());
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::vector<std::string> codesOf(const LintResult& result) {
+    std::vector<std::string> codes;
+    for (const LintIssue& issue : result.issues) {
+        codes.push_back(LintIssue::code(issue.kind));
+    }
+    return codes;
+}
+
+const LintResult& resultFor(const std::vector<LintResult>& results, const std::string& path) {
+    auto it = std::find_if(results.begin(), results.end(),
+                           [&path](const LintResult& result) { return result.path == path; });
+    REQUIRE(it != results.end());
+    return *it;
+}
+
+class LibraryFixture {
+public:
+    LibraryFixture() : directory_(fs::temp_directory_path() / "midiplay_lint_test") {
+        fs::remove_all(directory_);
+        fs::create_directories(directory_ / "hymns");
+
+        writeMidi(directory_ / "clean.mid", {TEMPO, NOTE});
+        writeMidi(directory_ / "no_tempo.mid", {NOTE});
+        writeMidi(directory_ / "hymns" / "open_intro.mid", {TEMPO, marker('['), NOTE});
+        writeMidi(directory_ / "hymns" / "extra_end.mid", {TEMPO, NOTE, marker(']')});
+        writeMidi(directory_ / "deprecated.MID", {TEMPO, {0x00, 0xFF, 0x10, 0x01, 3}, NOTE});
+        std::ofstream(directory_ / "truncated.mid") << "MThd";
+        std::ofstream(directory_ / "notes.txt") << "not a hymn";
+    }
+
+    ~LibraryFixture() {
+        fs::remove_all(directory_);
+    }
+
+    std::string path() const { return directory_.string(); }
+
+private:
+    fs::path directory_;
+};
+
+} // namespace
+
+TEST_CASE("--lint", "[hymnal_linter][options][unit]") {
+    SECTION("defaults to the hymn directory") {
+        optind = 0;
+        auto argv = makeArgv({"play", "--lint"});
+        Options options(2, argv);
+        REQUIRE(options.parse() == 0);
+        REQUIRE(options.isLintMode());
+        REQUIRE(options.getLintDirectory().empty());
+        freeArgv(argv, 2);
+    }
+
+    SECTION("takes a directory and a JSON file") {
+        optind = 0;
+        auto argv = makeArgv({"play", "--lint=/srv/hymns", "--lint-json=report.json"});
+        Options options(3, argv);
+        REQUIRE(options.parse() == 0);
+        REQUIRE(options.getLintDirectory() == "/srv/hymns");
+        REQUIRE(options.getLintJsonPath() == "report.json");
+        freeArgv(argv, 3);
+    }
+}
+
+TEST_CASE("HymnalLinter finds problems in a library", "[hymnal_linter][integration]") {
+    LibraryFixture library;
+    HymnalLinter linter(4);
+    std::vector<LintResult> results = linter.lintDirectory(library.path());
+
+    SECTION("every MIDI file is checked, in path order") {
+        REQUIRE(results.size() == 6);
+        REQUIRE(std::is_sorted(results.begin(), results.end(),
+                               [](const LintResult& a, const LintResult& b) { return a.path < b.path; }));
+        REQUIRE(linter.getSummary().files == 6);
+        REQUIRE(linter.getSummary().filesWithIssues == 5);
+    }
+
+    SECTION("each file gets its own issues") {
+        REQUIRE(resultFor(results, "clean.mid").issues.empty());
+        REQUIRE(codesOf(resultFor(results, "no_tempo.mid")) == std::vector<std::string>{"missing-tempo"});
+        REQUIRE(codesOf(resultFor(results, "deprecated.MID")) == std::vector<std::string>{"deprecated-verses"});
+        REQUIRE(codesOf(resultFor(results, "truncated.mid")) == std::vector<std::string>{"unreadable"});
+        REQUIRE(codesOf(resultFor(results, "hymns/open_intro.mid")) == std::vector<std::string>{"unbalanced-intro"});
+        REQUIRE(codesOf(resultFor(results, "hymns/extra_end.mid")) == std::vector<std::string>{"unbalanced-intro"});
+    }
+
+    SECTION("the report has one line per issue") {
+        std::ostringstream out;
+        linter.printReport(results, out, false);
+        REQUIRE(out.str().find("no_tempo.mid:0: missing-tempo: ") != std::string::npos);
+        REQUIRE(out.str().find("clean.mid") == std::string::npos);
+    }
+
+    SECTION("the JSON report lists the files with issues") {
+        fs::path json = fs::temp_directory_path() / "midiplay_lint_test.json";
+        REQUIRE(linter.writeJson(results, json.string()));
+        std::ifstream in(json);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        REQUIRE(text.find("\"files\": 6") != std::string::npos);
+        REQUIRE(text.find("\"code\": \"unreadable\"") != std::string::npos);
+        REQUIRE(text.find("clean.mid") == std::string::npos);
+        fs::remove(json);
+    }
+}
+
+TEST_CASE("HymnalLinter gives the same results on one thread", "[hymnal_linter][integration]") {
+    LibraryFixture library;
+    std::vector<LintResult> parallel = HymnalLinter(8).lintDirectory(library.path());
+    std::vector<LintResult> serial = HymnalLinter(1).lintDirectory(library.path());
+
+    REQUIRE(parallel.size() == serial.size());
+    for (size_t i = 0; i < parallel.size(); i++) {
+        REQUIRE(parallel[i].path == serial[i].path);
+        REQUIRE(codesOf(parallel[i]) == codesOf(serial[i]));
+    }
+}
+
+TEST_CASE("HymnalLinter accepts the test hymns", "[hymnal_linter][integration]") {
+    std::string introFile = "fixtures/test_files/with_intro.mid";
+    if (!fs::exists(introFile)) {
+        WARN("Test file not found: " << introFile);
+        return;
+    }
+
+    Options defaults(0, nullptr);
+    EventPreProcessor processor;
+    LintResult result = HymnalLinter::lintFile(introFile, processor, defaults);
+    for (const LintIssue& issue : result.issues) {
+        REQUIRE(issue.kind != LintIssue::Kind::Unreadable);
+        REQUIRE(issue.kind != LintIssue::Kind::UnbalancedIntro);
+    }
+}
@@ -0,0 +1,104 @@
+#include "external/catch_amalgamated.hpp"
+#include "../jitter_recorder.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+TEST_CASE("JitterRecorder buffer", "[jitter][unit]") {
+    SECTION("records up to capacity, then counts drops") {
+        JitterRecorder recorder(2);
+        recorder.record(1000, 2000);
+        recorder.record(3000, 3500);
+        recorder.record(5000, 6000);
+
+        REQUIRE(recorder.size() == 2);
+        REQUIRE(recorder.dropped() == 1);
+        REQUIRE(recorder.at(1).scheduledNs == 3000);
+        REQUIRE(recorder.at(1).actualNs == 3500);
+    }
+
+    SECTION("samples carry the current section") {
+        JitterRecorder recorder(4);
+        recorder.record(0, 0);
+        recorder.beginSection(2);
+        recorder.record(0, 0);
+
+        REQUIRE(recorder.at(0).section == 0);
+        REQUIRE(recorder.at(1).section == 2);
+    }
+
+    SECTION("monotonic clock does not go backwards") {
+        int64_t first = JitterRecorder::now();
+        int64_t second = JitterRecorder::now();
+
+        REQUIRE(second >= first);
+    }
+}
+
+TEST_CASE("JitterRecorder summary", "[jitter][unit]") {
+    JitterRecorder recorder(300);
+
+    // Introduction: 100 events 10..1000 us late
+    for (int i = 1; i <= 100; i++) {
+        recorder.record(0, i * 10000);
+    }
+    // Verse 1: everything on time but one 20 ms outlier
+    recorder.beginSection(1);
+    for (int i = 0; i < 99; i++) {
+        recorder.record(0, 0);
+    }
+    recorder.record(0, 20000000);
+
+    std::vector<JitterRecorder::SectionStats> stats = recorder.summarize();
+
+    REQUIRE(stats.size() == 2);
+
+    SECTION("percentiles and maximum") {
+        REQUIRE(stats[0].section == 0);
+        REQUIRE(stats[0].count == 100);
+        REQUIRE(stats[0].p50Us == 500);
+        REQUIRE(stats[0].p99Us == 990);
+        REQUIRE(stats[0].maxUs == 1000);
+
+        REQUIRE(stats[1].section == 1);
+        REQUIRE(stats[1].p50Us == 0);
+        REQUIRE(stats[1].p99Us == 0);
+        REQUIRE(stats[1].maxUs == 20000);
+    }
+
+    SECTION("histogram buckets") {
+        size_t total = 0;
+        for (size_t count : stats[0].histogram) {
+            total += count;
+        }
+        REQUIRE(total == 100);
+        REQUIRE(stats[0].histogram[0] == 9);    // 10..90 us
+        REQUIRE(stats[1].histogram[0] == 99);
+        REQUIRE(stats[1].histogram[JitterRecorder::BUCKET_COUNT - 1] == 1);
+    }
+}
+
+TEST_CASE("JitterRecorder CSV dump", "[jitter][unit]") {
+    fs::path path = fs::temp_directory_path() / ("midiplay_jitter_" + std::to_string(getpid()) + ".csv");
+
+    JitterRecorder recorder(4);
+    recorder.beginSection(1);
+    recorder.record(1000000, 1250000);
+
+    REQUIRE(recorder.writeCsv(path.string()));
+
+    std::ifstream in(path);
+    std::string header, line;
+    std::getline(in, header);
+    std::getline(in, line);
+
+    REQUIRE(header == "section,scheduled_ns,actual_ns,lateness_us");
+    REQUIRE(line == "1,1000000,1250000,250");
+
+    fs::remove(path);
+}
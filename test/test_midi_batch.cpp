@@ -0,0 +1,76 @@
+#include "external/catch_amalgamated.hpp"
+#include "../midi_batch.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace MidiPlay;
+
+namespace {
+
+// Add raw bytes as one message
+void addMessage(MidiBatch& batch, std::vector<uint8_t> bytes) {
+    batch.add(EventView(bytes.data(), bytes.size(), 0));
+}
+
+} // namespace
+
+TEST_CASE("MidiBatch keeps messages as added", "[midi_batch][unit]") {
+    MidiBatch batch;
+    addMessage(batch, {0x90, 60, 100});
+    addMessage(batch, {0xC1, 5});
+
+    REQUIRE(batch.size() == 2);
+    REQUIRE(batch.message(0).size() == 3);
+    REQUIRE(batch.message(1).size() == 2);
+    REQUIRE(batch.message(1)[1] == 5);
+
+    SECTION("empty messages are ignored") {
+        batch.add(EventView(nullptr, 0, 0));
+        REQUIRE(batch.size() == 2);
+    }
+
+    SECTION("clear empties the batch") {
+        batch.clear();
+        REQUIRE(batch.empty());
+        REQUIRE(batch.stream().empty());
+    }
+}
+
+TEST_CASE("MidiBatch running status", "[midi_batch][unit]") {
+    MidiBatch batch;
+
+    SECTION("repeated status is left out") {
+        addMessage(batch, {0x90, 60, 100});
+        addMessage(batch, {0x90, 64, 100});
+        addMessage(batch, {0x90, 67, 100});
+        addMessage(batch, {0x90, 72, 100});
+
+        REQUIRE(batch.stream() == std::vector<uint8_t>{0x90, 60, 100, 64, 100, 67, 100, 72, 100});
+    }
+
+    SECTION("a different channel needs its status byte") {
+        addMessage(batch, {0x90, 60, 100});
+        addMessage(batch, {0x91, 48, 90});
+        addMessage(batch, {0x91, 52, 90});
+        addMessage(batch, {0x90, 64, 0});
+
+        REQUIRE(batch.stream() == std::vector<uint8_t>{0x90, 60, 100, 0x91, 48, 90, 52, 90, 0x90, 64, 0});
+    }
+
+    SECTION("SysEx cancels running status") {
+        addMessage(batch, {0x90, 60, 100});
+        addMessage(batch, {0xF0, 0x43, 0xF7});
+        addMessage(batch, {0x90, 64, 100});
+
+        REQUIRE(batch.stream() == std::vector<uint8_t>{0x90, 60, 100, 0xF0, 0x43, 0xF7, 0x90, 64, 100});
+    }
+
+    SECTION("real-time messages keep running status") {
+        addMessage(batch, {0x90, 60, 100});
+        addMessage(batch, {0xF8});
+        addMessage(batch, {0x90, 64, 100});
+
+        REQUIRE(batch.stream() == std::vector<uint8_t>{0x90, 60, 100, 0xF8, 64, 100});
+    }
+}
@@ -1,12 +1,24 @@
 #include "external/catch_amalgamated.hpp"
 #include "../midi_loader.hpp"
 #include "../options.hpp"
+#include <cxxmidi/event.hpp>
 #include <filesystem>
 #include <getopt.h>  // For optind reset
+#include <initializer_list>
 
 using namespace MidiPlay;
 namespace fs = std::filesystem;
 
+namespace {
+
+cxxmidi::Event makeEvent(std::initializer_list<uint8_t> bytes) {
+    cxxmidi::Event event;
+    event.assign(bytes.begin(), bytes.end());
+    return event;
+}
+
+} // namespace
+
 // ============================================================================
 // Phase 2: Business Logic - MIDI Loader Tests
 // ============================================================================
@@ -408,4 +420,95 @@ TEST_CASE("MidiLoader: Verse Counting", "[business_logic][midi_loader][integrati
         // Should use command-line value
         REQUIRE(verses == 3);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("EventRewrite: Transpose and Channel Remap", "[business_logic][midi_loader][event_preprocessor][unit]") {
+    EventRewrite rewrite;
+    REQUIRE(rewrite.isIdentity());
+    
+    rewrite.transpose = -2;
+    rewrite.channelMap[0] = 1;      // Swell to Great
+    REQUIRE_FALSE(rewrite.isIdentity());
+    
+    SECTION("Notes move down and to the new channel") {
+        cxxmidi::Event noteOn = makeEvent({0x90, 64, 100});
+        REQUIRE(rewrite.apply(noteOn));
+        REQUIRE(noteOn == makeEvent({0x91, 62, 100}));
+        
+        cxxmidi::Event noteOff = makeEvent({0x82, 48, 0});
+        REQUIRE(rewrite.apply(noteOff));
+        REQUIRE(noteOff == makeEvent({0x82, 46, 0}));
+    }
+    
+    SECTION("Registration stays on its channel") {
+        cxxmidi::Event program = makeEvent({0xC0, 19});
+        REQUIRE(rewrite.apply(program));
+        REQUIRE(program == makeEvent({0xC0, 19}));
+        
+        cxxmidi::Event nrpn = makeEvent({0xB0, 99, 2});
+        REQUIRE(rewrite.apply(nrpn));
+        REQUIRE(nrpn == makeEvent({0xB0, 99, 2}));
+    }
+    
+    SECTION("Notes moved out of range are dropped; percussion is not transposed") {
+        cxxmidi::Event low = makeEvent({0x90, 1, 100});
+        REQUIRE_FALSE(rewrite.apply(low));
+        
+        cxxmidi::Event drum = makeEvent({0x99, 36, 100});
+        REQUIRE(rewrite.apply(drum));
+        REQUIRE(drum == makeEvent({0x99, 36, 100}));
+    }
+    
+    SECTION("Key signatures follow the transposition") {
+        cxxmidi::Event key = makeEvent({0xFF, 0x59, 0x02, 0x00});    // D major
+        REQUIRE(rewrite.apply(key));
+        REQUIRE(key == makeEvent({0xFF, 0x59, 0x00, 0x00}));        // C major
+        
+        REQUIRE(EventRewrite::transposeKey(0, 1) == -5);            // C up to Db
+        REQUIRE(EventRewrite::transposeKey(-1, -1) == 4);           // F down to E
+        REQUIRE(EventRewrite::transposeKey(0, 6) == -6);            // Gb, not F#
+        REQUIRE(EventRewrite::transposeKey(3, 12) == 3);
+    }
+}
+
+TEST_CASE("MidiLoader: Transposed Load", "[business_logic][midi_loader][integration]") {
+    std::string testFile = "fixtures/test_files/simple.mid";
+    
+    if (!fs::exists(testFile)) {
+        WARN("Test file not found: " << testFile);
+        return;
+    }
+    
+    optind = 0;  // Reset getopt global state (GNU: complete reinitialization)
+    MidiLoader plain;
+    const char* plainArgv[] = {"midiplay", testFile.c_str(), "--no-cache"};
+    Options plainOptions(3, const_cast<char**>(plainArgv));
+    plainOptions.parse();
+    REQUIRE(plain.loadFile(testFile, plainOptions));
+    
+    optind = 0;
+    MidiLoader transposed;
+    const char* argv[] = {"midiplay", testFile.c_str(), "--transpose=12"};
+    Options options(3, const_cast<char**>(argv));
+    options.parse();
+    REQUIRE(transposed.loadFile(testFile, options));
+    REQUIRE_FALSE(transposed.isLoadedFromCache());
+    
+    // Every note of the stored events is an octave up; the key is the same
+    REQUIRE(transposed.getKeySignature() == plain.getKeySignature());
+    const cxxmidi::File& before = plain.getFile();
+    const cxxmidi::File& after = transposed.getFile();
+    REQUIRE(after.size() == before.size());
+    for (size_t t = 0; t < before.size(); t++) {
+        REQUIRE(after[t].size() == before[t].size());
+        for (size_t e = 0; e < before[t].size(); e++) {
+            const cxxmidi::Event& event = before[t][e];
+            uint8_t type = event.size() > 1 ? (event[0] & 0xF0) : 0;
+            if (type == 0x80 || type == 0x90) {
+                REQUIRE(after[t][e][1] == event[1] + 12);
+            } else {
+                REQUIRE(after[t][e] == event);
+            }
+        }
+    }
+}
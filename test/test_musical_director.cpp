@@ -1,6 +1,7 @@
 #include "external/catch_amalgamated.hpp"
 #include "../musical_director.hpp"
 #include "../playback_state_machine.hpp"
+#include "../player_sync_engine.hpp"
 #include "../midi_loader.hpp"
 #include "../midi_markers.hpp"
 #include "../options.hpp"
@@ -11,6 +12,8 @@
 #include <cxxmidi/event.hpp>
 #include <cxxmidi/message.hpp>
 #include <filesystem>
+#include <algorithm>
+#include <getopt.h>
 
 using namespace MidiPlay;
 using namespace Catch;
@@ -82,15 +85,16 @@ TEST_CASE("MusicalDirector component design", "[musical_director][unit]") {
 TEST_CASE("MusicalDirector construction", "[musical_director][integration]") {
     Default outport;
     PlayerSync player(&outport);
+    PlayerSyncEngine engine(player);
     PlaybackStateMachine stateMachine;
     MidiLoader loader;
     
     SECTION("constructor accepts all dependencies") {
-        REQUIRE_NOTHROW(MusicalDirector(player, stateMachine, loader));
+        REQUIRE_NOTHROW(MusicalDirector(engine, stateMachine, loader));
     }
     
     SECTION("initializeIntroSegments with no segments") {
-        MusicalDirector director(player, stateMachine, loader);
+        MusicalDirector director(engine, stateMachine, loader);
         REQUIRE_NOTHROW(director.initializeIntroSegments());
     }
 }
@@ -98,6 +102,7 @@ TEST_CASE("MusicalDirector construction", "[musical_director][integration]") {
 TEST_CASE("MusicalDirector with loaded MIDI file", "[musical_director][integration]") {
     Default outport;
     PlayerSync player(&outport);
+    PlayerSyncEngine engine(player);
     PlaybackStateMachine stateMachine;
     
     std::string testFile = "fixtures/test_files/with_intro.mid";
@@ -117,7 +122,7 @@ TEST_CASE("MusicalDirector with loaded MIDI file", "[musical_director][integrati
         REQUIRE(loaded);
         
         if (loader.getIntroSegments().size() > 0) {
-            MusicalDirector director(player, stateMachine, loader);
+            MusicalDirector director(engine, stateMachine, loader);
             
             REQUIRE_NOTHROW(director.initializeIntroSegments());
             REQUIRE(loader.getIntroSegments().size() > 0);
@@ -125,6 +130,127 @@ TEST_CASE("MusicalDirector with loaded MIDI file", "[musical_director][integrati
     }
 }
 
+TEST_CASE("Marker directive table", "[musical_director][event_preprocessor][unit]") {
+    SECTION("marker text is classified into directive kinds") {
+        REQUIRE(EventPreProcessor::classifyMarker(MidiMarkers::INTRO_BEGIN) == DirectiveKind::IntroBegin);
+        REQUIRE(EventPreProcessor::classifyMarker(MidiMarkers::INTRO_END) == DirectiveKind::IntroEnd);
+        REQUIRE(EventPreProcessor::classifyMarker(MidiMarkers::RITARDANDO_INDICATOR) == DirectiveKind::Ritardando);
+        REQUIRE(EventPreProcessor::classifyMarker(MidiMarkers::D_C_AL_FINE) == DirectiveKind::DaCapoAlFine);
+        REQUIRE(EventPreProcessor::classifyMarker(MidiMarkers::FINE_INDICATOR) == DirectiveKind::Fine);
+        REQUIRE(EventPreProcessor::classifyMarker("Verse 2") == DirectiveKind::Other);
+        REQUIRE(EventPreProcessor::classifyMarker("fine") == DirectiveKind::Other);
+    }
+}
+
+TEST_CASE("Marker directive table from loaded files", "[musical_director][event_preprocessor][integration]") {
+    for (const char* name : {"with_intro.mid", "ritardando.mid", "dc_al_fine.mid"}) {
+        std::string testFile = std::string("fixtures/test_files/") + name;
+        if (!fs::exists(testFile)) {
+            WARN("Test file not found: " << testFile);
+            continue;
+        }
+        
+        const char* argv[] = {"midiplay", testFile.c_str(), "--no-cache"};
+        optind = 0;
+        Options options(3, const_cast<char**>(argv));
+        options.parse();
+        
+        MidiLoader loader;
+        REQUIRE(loader.loadFile(testFile, options));
+        
+        const std::vector<Directive>& directives = loader.getDirectives();
+        
+        // Ordered by tick, then track, as the player emits them
+        for (size_t i = 1; i < directives.size(); i++) {
+            REQUIRE(directives[i - 1].tick <= directives[i].tick);
+            if (directives[i - 1].tick == directives[i].tick) {
+                REQUIRE(directives[i - 1].track <= directives[i].track);
+            }
+        }
+        
+        // Every introduction segment has matching begin and end directives
+        for (const IntroductionSegment& segment : loader.getIntroSegments()) {
+            bool begin = false;
+            bool end = false;
+            for (const Directive& directive : directives) {
+                begin |= directive.kind == DirectiveKind::IntroBegin && directive.tick == segment.start;
+                end |= directive.kind == DirectiveKind::IntroEnd && directive.tick == segment.end;
+            }
+            REQUIRE(begin);
+            REQUIRE(end);
+        }
+    }
+}
+
+TEST_CASE("MusicalDirector consumes directives from the table", "[musical_director][integration]") {
+    std::string testFile = "fixtures/test_files/dc_al_fine.mid";
+    
+    if (!fs::exists(testFile)) {
+        WARN("Test file not found: " << testFile);
+        return;
+    }
+    
+    const char* argv[] = {"midiplay", testFile.c_str(), "--no-cache"};
+    optind = 0;
+    Options options(3, const_cast<char**>(argv));
+    options.parse();
+    
+    MidiLoader loader;
+    REQUIRE(loader.loadFile(testFile, options));
+    
+    const std::vector<Directive>& directives = loader.getDirectives();
+    auto dcAlFine = std::find_if(directives.begin(), directives.end(),
+                                 [](const Directive& d) { return d.kind == DirectiveKind::DaCapoAlFine; });
+    if (dcAlFine == directives.end()) {
+        WARN("No D.C. al Fine marker in " << testFile);
+        return;
+    }
+    
+    Default outport;
+    PlayerSync player(&outport);
+    PlayerSyncEngine engine(player);
+    player.SetFile(&loader.getFile());
+    PlaybackStateMachine stateMachine;
+    MusicalDirector director(engine, stateMachine, loader);
+    
+    // Marker events carry no text here: the directive table decides what they mean
+    Event marker(0, 0xFF, 0x06, 'x');
+    Event noteOn(0, 0x90, 60, 100);
+    
+    SECTION("non-marker events pass through") {
+        stateMachine.setLastVerse(true);
+        director.seekDirectives(dcAlFine->tick);
+        
+        REQUIRE(director.handleEvent(noteOn));
+        REQUIRE_FALSE(stateMachine.isAlFine());
+    }
+    
+    SECTION("D.C. al Fine is acted on in the last verse") {
+        stateMachine.setLastVerse(true);
+        director.seekDirectives(dcAlFine->tick);
+        
+        // Skip any earlier markers at the same tick
+        size_t index = dcAlFine - directives.begin();
+        while (index > 0 && directives[index - 1].tick == dcAlFine->tick) {
+            index--;
+            REQUIRE(director.handleEvent(marker));
+        }
+        
+        REQUIRE_FALSE(director.handleEvent(marker));
+        REQUIRE(stateMachine.isAlFine());
+    }
+    
+    SECTION("D.C. al Fine is ignored before the last verse") {
+        director.seekDirectives(dcAlFine->tick);
+        
+        // Nothing is suppressed until the last verse
+        for (auto it = dcAlFine; it != directives.end(); ++it) {
+            REQUIRE(director.handleEvent(marker));
+        }
+        REQUIRE_FALSE(stateMachine.isAlFine());
+    }
+}
+
 // Note: Full event-based marker processing requires actual playback with
 // callbacks, which is best tested through end-to-end integration tests or
 // manual validation with hardware. The above tests verify construction,
@@ -320,6 +320,159 @@ TEST_CASE("Options warnings flag", "[options][unit]") {
     }
 }
 
+TEST_CASE("Options realtime mode", "[options][unit]") {
+    SECTION("off by default") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "test.mid"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        opts.parse();
+        
+        REQUIRE_FALSE(opts.isRealtime());
+        REQUIRE(opts.getRealtimePriority() == REALTIME_DEFAULT_PRIORITY);
+        REQUIRE(opts.getRealtimeCpu() == REALTIME_LAST_CPU);
+        
+        freeArgv(argv, args.size());
+    }
+    
+    SECTION("--realtime with priority and core") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "test.mid", "--realtime=80", "--cpu=2"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        REQUIRE(opts.parse() == 0);
+        
+        REQUIRE(opts.isRealtime());
+        REQUIRE(opts.getRealtimePriority() == 80);
+        REQUIRE(opts.getRealtimeCpu() == 2);
+        
+        freeArgv(argv, args.size());
+    }
+    
+    SECTION("non-numeric priority is rejected") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "test.mid", "--realtime=high"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        REQUIRE(opts.parse() == MidiPlay::OptionsParseResult::INVALID_OPTION);
+        
+        freeArgv(argv, args.size());
+    }
+}
+
+TEST_CASE("Options transpose and remap", "[options][unit]") {
+    SECTION("events are loaded as written by default") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "test.mid"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        opts.parse();
+        
+        REQUIRE(opts.getTranspose() == 0);
+        REQUIRE_FALSE(opts.isRemapping());
+        REQUIRE_FALSE(opts.isRewritingEvents());
+        REQUIRE(opts.getChannelMap()[2] == 2);
+        
+        freeArgv(argv, args.size());
+    }
+    
+    SECTION("--transpose down and a channel swap") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "test.mid", "--transpose=-2", "--remap=1:2,2:1"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        REQUIRE(opts.parse() == 0);
+        
+        REQUIRE(opts.getTranspose() == -2);
+        REQUIRE(opts.isRemapping());
+        REQUIRE(opts.isRewritingEvents());
+        REQUIRE(opts.getChannelMap()[0] == 1);
+        REQUIRE(opts.getChannelMap()[1] == 0);
+        REQUIRE(opts.getChannelMap()[2] == 2);
+        
+        freeArgv(argv, args.size());
+    }
+    
+    SECTION("out of range or malformed values are rejected") {
+        for (const char* arg : {"--transpose=13", "--transpose=up", "--remap=0:1", "--remap=1:17", "--remap=1-2", "--remap=1:2,"}) {
+            resetGetopt();
+            auto args = std::vector<std::string>{"play", "test.mid", arg};
+            char** argv = makeArgv(args);
+            
+            Options opts(args.size(), argv);
+            INFO(arg);
+            REQUIRE(opts.parse() == MidiPlay::OptionsParseResult::INVALID_OPTION);
+            
+            freeArgv(argv, args.size());
+        }
+    }
+}
+
+TEST_CASE("Options daemon mode", "[options][unit]") {
+    SECTION("--daemon needs no file name") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "--daemon"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        REQUIRE(opts.parse() == 0);
+        
+        REQUIRE(opts.isDaemonMode());
+        REQUIRE(opts.getFileName().empty());
+        
+        freeArgv(argv, args.size());
+    }
+    
+    SECTION("a running daemon is used unless --no-daemon") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "test.mid", "--no-daemon"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        opts.parse();
+        
+        REQUIRE_FALSE(opts.isDaemonMode());
+        REQUIRE_FALSE(opts.isDaemonAllowed());
+        
+        freeArgv(argv, args.size());
+    }
+}
+
+TEST_CASE("Options setlist mode", "[options][unit]") {
+    SECTION("--setlist needs no file name") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "--setlist=service.txt"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        REQUIRE(opts.parse() == 0);
+        
+        REQUIRE(opts.isSetlistMode());
+        REQUIRE(opts.getSetlistPath() == "service.txt");
+        REQUIRE(opts.getFileName().empty());
+        
+        freeArgv(argv, args.size());
+    }
+    
+    SECTION("not in setlist mode by default") {
+        resetGetopt();
+        auto args = std::vector<std::string>{"play", "test.mid"};
+        char** argv = makeArgv(args);
+        
+        Options opts(args.size(), argv);
+        opts.parse();
+        
+        REQUIRE_FALSE(opts.isSetlistMode());
+        
+        freeArgv(argv, args.size());
+    }
+}
+
 TEST_CASE("Options semantic version", "[options][unit]") {
     SECTION("extracts semantic version") {
         std::string version = Options::getSemanticVersion();
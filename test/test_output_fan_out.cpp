@@ -0,0 +1,149 @@
+#include "external/catch_amalgamated.hpp"
+#include "../output_fan_out.hpp"
+
+#include <cxxmidi/message.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace MidiPlay;
+
+namespace {
+
+// Keeps what it is sent; can be made to hang or fail like a misbehaving port
+class TestOutput : public cxxmidi::output::Abstract {
+public:
+    void OpenPort(unsigned int) override {}
+    void ClosePort() override {}
+    void OpenVirtualPort(const std::string&) override {}
+    size_t GetPortCount() override { return 1; }
+    std::string GetPortName(unsigned int) override { return "test"; }
+
+    void SendMessage(const cxxmidi::Message* msg) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [this]() { return !stalled; });
+        if (failing) {
+            throw std::runtime_error("unplugged");
+        }
+        sent.emplace_back(msg->begin(), msg->end());
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stalled = false;
+        }
+        released.notify_all();
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sent.size();
+    }
+
+    std::mutex mutex;
+    std::condition_variable released;
+    bool stalled = false;
+    bool failing = false;
+    std::vector<std::vector<uint8_t>> sent;
+};
+
+cxxmidi::Message noteOn(uint8_t note) {
+    cxxmidi::Message message;
+    message.assign({0x90, note, 100});
+    return message;
+}
+
+} // namespace
+
+TEST_CASE("OutputFanOut copies every message to every port", "[output_fan_out][unit]") {
+    TestOutput primary;
+    OutputFanOut fanOut(primary);
+
+    auto owned = std::make_unique<TestOutput>();
+    TestOutput& secondary = *owned;
+    fanOut.addPort(std::move(owned), "recorder");
+    REQUIRE(fanOut.getSecondaryCount() == 1);
+
+    for (uint8_t note = 60; note < 70; note++) {
+        cxxmidi::Message message = noteOn(note);
+        fanOut.SendMessage(&message);
+    }
+
+    // The primary port is written before SendMessage returns
+    REQUIRE(primary.count() == 10);
+
+    REQUIRE(fanOut.flush(std::chrono::seconds(5)));
+    REQUIRE(secondary.sent == primary.sent);
+
+    std::vector<OutputFanOut::PortStats> stats = fanOut.getStats();
+    REQUIRE(stats.size() == 1);
+    REQUIRE(stats[0].name == "recorder");
+    REQUIRE(stats[0].sent == 10);
+    REQUIRE(stats[0].dropped == 0);
+    REQUIRE_FALSE(stats[0].failed);
+}
+
+TEST_CASE("OutputFanOut never waits for a secondary port", "[output_fan_out][unit]") {
+    TestOutput primary;
+    OutputFanOut fanOut(primary);
+
+    auto owned = std::make_unique<TestOutput>();
+    TestOutput& stalled = *owned;
+    stalled.stalled = true;
+    fanOut.addPort(std::move(owned), "stalled");
+
+    SECTION("a stalled port fills its ring and drops the rest") {
+        const size_t total = OutputFanOut::RING_CAPACITY * 2;
+        auto started = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < total; i++) {
+            cxxmidi::Message message = noteOn(static_cast<uint8_t>(i & 0x7F));
+            fanOut.SendMessage(&message);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - started;
+
+        REQUIRE(primary.count() == total);
+        REQUIRE(elapsed < std::chrono::seconds(1));
+        REQUIRE_FALSE(fanOut.flush(std::chrono::milliseconds(10)));
+
+        // Capacity in the ring plus the one message the writer holds
+        stalled.release();
+        REQUIRE(fanOut.flush(std::chrono::seconds(5)));
+        OutputFanOut::PortStats stats = fanOut.getStats()[0];
+        REQUIRE(stats.sent + stats.dropped == total);
+        REQUIRE(stats.sent <= OutputFanOut::RING_CAPACITY + 1);
+        REQUIRE(stats.dropped >= total - OutputFanOut::RING_CAPACITY - 1);
+    }
+
+    SECTION("a failed port is given nothing more") {
+        stalled.failing = true;
+        stalled.release();
+
+        cxxmidi::Message message = noteOn(60);
+        fanOut.SendMessage(&message);
+        REQUIRE(fanOut.flush(std::chrono::seconds(5)));
+        REQUIRE(fanOut.getStats()[0].failed);
+
+        fanOut.SendMessage(&message);
+        REQUIRE(fanOut.flush(std::chrono::seconds(5)));
+        REQUIRE(primary.count() == 2);
+        REQUIRE(fanOut.getStats()[0].sent == 0);
+        REQUIRE(fanOut.getStats()[0].dropped == 2);
+    }
+}
+
+TEST_CASE("OutputFanOut without secondary ports is the primary port", "[output_fan_out][unit]") {
+    TestOutput primary;
+    OutputFanOut fanOut(primary);
+
+    cxxmidi::Message message;
+    message.assign({0xF0, 0x43, 0x10, 0x4C, 0x00, 0x00, 0x7E, 0x00, 0xF7, 0, 0, 0, 0, 0, 0, 0, 0xF7});
+    fanOut.SendMessage(&message);
+
+    REQUIRE(primary.count() == 1);
+    REQUIRE(fanOut.getStats().empty());
+    REQUIRE(fanOut.flush(std::chrono::milliseconds(0)));
+}
@@ -0,0 +1,69 @@
+#include "external/catch_amalgamated.hpp"
+#include "../packed_events.hpp"
+#include "../options.hpp"
+
+#include <getopt.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace MidiPlay;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+std::vector<uint8_t> bytesOf(const EventView& event) {
+    return std::vector<uint8_t>(event.data(), event.data() + event.size());
+}
+
+} // namespace
+
+TEST_CASE("PackedEvents keeps every message", "[packed_events][unit]") {
+    const std::vector<uint8_t> note = {0x90, 60, 100};
+    const std::vector<uint8_t> program = {0xC0, 5};
+    const std::vector<uint8_t> tempo = {0xFF, 0x51, 0x07, 0xA1, 0x20};
+    std::vector<uint8_t> lyrics = {0xFF, 0x05};
+    lyrics.resize(400, 'a');
+
+    PackedEvents events;
+    events.reserve(4, PackedEvents::sideBytesFor(tempo.size() + lyrics.size()));
+    events.append(0, tempo.data(), tempo.size());
+    events.append(0, note.data(), note.size());
+    events.append(480, lyrics.data(), lyrics.size());
+    events.append(960, program.data(), program.size());
+
+    REQUIRE(events.size() == 4);
+    REQUIRE(events.tickAt(2) == 480);
+    REQUIRE(bytesOf(events.viewAt(0, 0)) == tempo);
+    REQUIRE(bytesOf(events.viewAt(1, 0)) == note);
+    REQUIRE(bytesOf(events.viewAt(2, 480)) == lyrics);
+    REQUIRE(bytesOf(events.viewAt(3, 480)) == program);
+    REQUIRE(events.viewAt(3, 480).dt() == 480);
+
+    SECTION("channel messages take 8 bytes and nothing else") {
+        REQUIRE(sizeof(PackedEvent) == 8);
+        REQUIRE(events.viewAt(1, 0).data() == events.data()[1].bytes);
+    }
+
+    SECTION("nothing was reallocated past the reservation") {
+        REQUIRE_FALSE(events.fits(note.size()));
+        REQUIRE(events.getMemoryBytes() == 4 * sizeof(PackedEvent) + PackedEvents::sideBytesFor(405));
+    }
+
+    SECTION("clear frees everything") {
+        events.clear();
+        REQUIRE(events.empty());
+        REQUIRE(events.getMemoryBytes() == 0);
+    }
+}
+
+TEST_CASE("--mem-report", "[packed_events][options][unit]") {
+    optind = 0;
+    auto argv = makeArgv({"play", "162", "--mem-report"});
+    Options options(3, argv);
+    REQUIRE(options.parse() == 0);
+    REQUIRE(options.isMemReport());
+    freeArgv(argv, 3);
+}
@@ -2,8 +2,18 @@
 #include "../playback_orchestrator.hpp"
 #include "../playback_synchronizer.hpp"
 #include "../midi_loader.hpp"
+#include "../options.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
 
 using namespace MidiPlay;
+using Catch::Approx;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
 
 // Note: PlaybackOrchestrator requires cxxmidi::player::PlayerSync and extensive
 // setup with loaded MIDI files. These tests focus on component structure and
@@ -114,4 +124,155 @@ TEST_CASE("PlaybackOrchestrator MidiLoader integration", "[orchestrator][unit]")
 // connection and file playback. These are best validated through end-to-end
 // integration tests with hardware or through the manual test checklist in
 // test/test_plan.md. These structural tests verify component design and
-// dependency relationships.
\ No newline at end of file
+// dependency relationships.
+namespace {
+
+// Runs a schedule synchronously: a few heartbeats per section, then the next section
+class ScriptedEngine : public PlaybackEngine {
+public:
+    static constexpr int HEARTBEATS = 3;
+    
+    void play() override {
+        while (true) {
+            played.push_back(schedule_[section_].number);
+            finished_ = false;
+            for (int beat = 0; beat < HEARTBEATS && !finished_ && !stopped_; beat++) {
+                if (onHeartbeat) {
+                    onHeartbeat(schedule_[section_].number, beat);
+                }
+                heartbeat_();
+            }
+            if (stopped_) {
+                return;
+            }
+            bool started = false;
+            while (!started && ++section_ < schedule_.size()) {
+                started = sectionCallback_(schedule_[section_]);
+            }
+            if (!started) {
+                finishedCallback_();
+                return;
+            }
+        }
+    }
+    void stop() override { stopped_ = true; }
+    void finish() override { finished_ = true; }
+    void rewind() override {}
+    void goToTick(uint32_t) override {}
+    void notesOff() override {}
+    void releaseHeldNotes() override {}
+    
+    void setSpeed(float s) override { speed = s; }
+    float getSpeed() const override { return speed; }
+    std::chrono::microseconds currentTimePos() const override { return std::chrono::microseconds(0); }
+    
+    void setCallbackHeartbeat(const Callback& callback) override { heartbeat_ = callback; }
+    void setCallbackFinished(const Callback& callback) override { finishedCallback_ = callback; }
+    void setCallbackEvent(const EventCallback&) override {}
+    void setJitterRecorder(JitterRecorder*) override {}
+    void setActiveNotes(ActiveNotes*) override {}
+    bool setSchedule(const PlaybackSchedule& schedule, const PlaybackSchedule::SectionCallback& callback) override {
+        schedule_ = schedule;
+        sectionCallback_ = callback;
+        return true;
+    }
+    
+    std::function<void(uint16_t section, int beat)> onHeartbeat;
+    std::vector<uint16_t> played;   // Section numbers in the order they started
+    float speed = 1.0f;
+    
+private:
+    PlaybackSchedule schedule_;
+    PlaybackSchedule::SectionCallback sectionCallback_;
+    Callback heartbeat_;
+    Callback finishedCallback_;
+    size_t section_ = 0;
+    bool finished_ = false;
+    bool stopped_ = false;
+};
+
+} // namespace
+
+TEST_CASE("PlaybackOrchestrator live commands", "[orchestrator][unit]") {
+    std::string testFile = "fixtures/test_files/simple.mid";
+    if (!fs::exists(testFile)) {
+        WARN("Test file not found: " << testFile);
+        return;
+    }
+    
+    optind = 0;
+    auto argv = makeArgv({"play", testFile, "-x3", "--no-cache"});
+    Options options(4, argv);
+    options.parse();
+    MidiLoader loader;
+    REQUIRE(loader.loadFile(testFile, options));
+    
+    ScriptedEngine engine;
+    PlaybackSynchronizer synchronizer;
+    PlaybackCommandQueue commands;
+    PlaybackOrchestrator orchestrator(engine, synchronizer, loader);
+    orchestrator.initialize();
+    orchestrator.setCommandQueue(&commands);
+    
+    auto sendDuring = [&](uint16_t verse, PlaybackCommand command) {
+        engine.onHeartbeat = [&commands, verse, command](uint16_t section, int beat) {
+            if (section == verse && beat == 0) {
+                commands.push(command);
+            }
+        };
+    };
+    
+    SECTION("without commands every verse plays") {
+        orchestrator.executePlayback();
+        REQUIRE(engine.played == std::vector<uint16_t>{1, 2, 3});
+    }
+    
+    SECTION("end after this verse") {
+        sendDuring(2, {PlaybackCommand::Kind::EndAfterVerse});
+        orchestrator.executePlayback();
+        REQUIRE(engine.played == std::vector<uint16_t>{1, 2});
+    }
+    
+    SECTION("skip to the last verse") {
+        sendDuring(1, {PlaybackCommand::Kind::LastVerse});
+        orchestrator.executePlayback();
+        REQUIRE(engine.played == std::vector<uint16_t>{1, 3});
+    }
+    
+    SECTION("stop") {
+        sendDuring(2, {PlaybackCommand::Kind::Stop});
+        orchestrator.executePlayback();
+        REQUIRE(engine.played == std::vector<uint16_t>{1, 2});
+        REQUIRE(orchestrator.isCancelled());
+    }
+    
+    SECTION("tempo changes by percent of the starting tempo") {
+        float initial = engine.speed;
+        sendDuring(1, {PlaybackCommand::Kind::Tempo, 4});
+        orchestrator.executePlayback();
+        REQUIRE(engine.speed == Approx(initial * 1.04f));
+    }
+    
+    SECTION("the position is published for observers") {
+        PositionObserver observer;
+        orchestrator.setPositionObserver(&observer);
+        std::vector<PlaybackPosition> seen;
+        engine.onHeartbeat = [&observer, &seen](uint16_t, int) { seen.push_back(observer.read()); };
+        orchestrator.executePlayback();
+        
+        REQUIRE(seen.size() == 3 * ScriptedEngine::HEARTBEATS);
+        REQUIRE(seen[0].verse == 1);
+        REQUIRE(seen[0].playing);
+        REQUIRE(seen[0].measure == 1);
+        REQUIRE(seen[0].beat == 1);
+        REQUIRE(seen[0].bpm > 0.0f);
+        REQUIRE(seen.back().verse == 3);
+        REQUIRE(seen.back().lastVerse);
+        
+        PlaybackPosition last = observer.read();
+        REQUIRE_FALSE(last.playing);
+        REQUIRE(last.sequence > seen.back().sequence);
+    }
+    
+    freeArgv(argv, 4);
+}
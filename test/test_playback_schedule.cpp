@@ -0,0 +1,201 @@
+#include "external/catch_amalgamated.hpp"
+#include "../playback_schedule.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include "../timeline_player.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <cxxmidi/message.hpp>
+#include <cxxmidi/output/abstract.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <getopt.h>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Records when each message was sent
+class RecordingOutput : public cxxmidi::output::Abstract {
+public:
+    void OpenPort(unsigned int) override {}
+    void ClosePort() override {}
+    void OpenVirtualPort(const std::string&) override {}
+    size_t GetPortCount() override { return 1; }
+    std::string GetPortName(unsigned int) override { return "recording"; }
+
+    void SendMessage(const cxxmidi::Message*) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        sent.push_back(Clock::now());
+    }
+
+    std::mutex mutex;
+    std::vector<Clock::time_point> sent;
+};
+
+// One note at tick 0, end of track at 480 ticks = 20 ms
+cxxmidi::File makeShortFile() {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+
+    cxxmidi::Track& track = file.AddTrack();
+    track.push_back(makeEvent(0, {0xFF, 0x51, 0x00, 0x4E, 0x20}));   // 20000 us per quarter
+    track.push_back(makeEvent(0, {0x90, 60, 100}));
+    track.push_back(makeEvent(480, {0xFF, 0x2F}));
+
+    return file;
+}
+
+ScheduledSection verse(uint16_t number, uint64_t pauseAfterUs) {
+    return {ScheduledSection::Kind::Verse, number, 0, pauseAfterUs};
+}
+
+} // namespace
+
+TEST_CASE("PlaybackSchedule pause duration", "[playback_schedule][unit]") {
+    SECTION("computed in one step") {
+        // 1000 ticks at 500001 us per quarter, 480 ppq: uSecPerTick would truncate to 1041
+        REQUIRE(PlaybackSchedule::pauseMicroseconds(1000, 500001, 480) == 1041668);
+    }
+
+    SECTION("zero time division gives no pause") {
+        REQUIRE(PlaybackSchedule::pauseMicroseconds(480, 500000, 0) == 0);
+    }
+}
+
+TEST_CASE("PlaybackSchedule from loaded files", "[playback_schedule][integration]") {
+    std::string introFile = "fixtures/test_files/with_intro.mid";
+    if (!fs::exists(introFile)) {
+        WARN("Test file not found: " << introFile);
+        return;
+    }
+
+    SECTION("introduction followed by every verse") {
+        optind = 0;
+        auto argv = makeArgv({"play", introFile, "-n3", "--no-cache"});
+        Options options(4, argv);
+        options.parse();
+
+        MidiLoader loader;
+        REQUIRE(loader.loadFile(introFile, options));
+        PlaybackSchedule schedule(loader);
+
+        REQUIRE(schedule.size() == 4);
+        REQUIRE(schedule[0].kind == ScheduledSection::Kind::Introduction);
+        REQUIRE(schedule[0].number == 0);
+        if (!loader.getIntroSegments().empty()) {
+            REQUIRE(schedule[0].startTick == loader.getIntroSegments().front().start);
+        }
+        for (size_t i = 1; i < schedule.size(); i++) {
+            REQUIRE(schedule[i].kind == ScheduledSection::Kind::Verse);
+            REQUIRE(schedule[i].number == i);
+            REQUIRE(schedule[i].startTick == 0);
+        }
+        REQUIRE(schedule[3].pauseAfterUs == 0);
+        freeArgv(argv, 4);
+    }
+
+    SECTION("no introduction with -x") {
+        optind = 0;
+        auto argv = makeArgv({"play", introFile, "-x2", "--no-cache"});
+        Options options(4, argv);
+        options.parse();
+
+        MidiLoader loader;
+        REQUIRE(loader.loadFile(introFile, options));
+        PlaybackSchedule schedule(loader);
+
+        REQUIRE(schedule.size() == 2);
+        REQUIRE(schedule[0].kind == ScheduledSection::Kind::Verse);
+        REQUIRE(schedule[0].number == 1);
+        freeArgv(argv, 4);
+    }
+
+    std::string dcFile = "fixtures/test_files/dc_al_fine.mid";
+    if (fs::exists(dcFile)) {
+        SECTION("D.C. al Fine adds a return to the beginning after the last verse") {
+            optind = 0;
+            auto argv = makeArgv({"play", dcFile, "-x2", "--no-cache"});
+            Options options(4, argv);
+            options.parse();
+
+            MidiLoader loader;
+            REQUIRE(loader.loadFile(dcFile, options));
+            PlaybackSchedule schedule(loader);
+
+            REQUIRE(schedule.size() == 3);
+            REQUIRE(schedule[2].kind == ScheduledSection::Kind::AlFine);
+            REQUIRE(schedule[2].pauseAfterUs == 0);
+            REQUIRE(schedule[1].pauseAfterUs == 0);
+            freeArgv(argv, 4);
+        }
+    }
+}
+
+TEST_CASE("TimelinePlayer runs a schedule", "[playback_schedule][integration]") {
+    RecordingOutput output;
+    cxxmidi::File file = makeShortFile();
+    TimelinePlayer player(output, file);
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    int finishedCount = 0;
+    player.setCallbackFinished([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        finishedCount++;
+        finished.notify_one();
+    });
+
+    constexpr uint64_t PAUSE_US = 30000;
+    PlaybackSchedule schedule;
+    schedule.add(verse(1, PAUSE_US));
+    schedule.add(verse(2, PAUSE_US));
+    schedule.add(verse(3, 0));
+    schedule.add({ScheduledSection::Kind::AlFine, 3, 0, 0});
+
+    std::vector<uint16_t> started;
+    REQUIRE(player.setSchedule(schedule, [&](const ScheduledSection& section) {
+        if (section.kind == ScheduledSection::Kind::AlFine) {
+            return false;   // Marker never reached
+        }
+        started.push_back(section.number);
+        return true;
+    }));
+
+    player.play();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(finished.wait_for(lock, std::chrono::seconds(5), [&]() { return finishedCount > 0; }));
+    }
+
+    SECTION("the finished callback fires once, after the last section") {
+        REQUIRE(finishedCount == 1);
+        REQUIRE(started == std::vector<uint16_t>{2, 3});
+    }
+
+    SECTION("each section starts a pause after the previous one ends") {
+        std::lock_guard<std::mutex> lock(output.mutex);
+        REQUIRE(output.sent.size() == 3);
+
+        // Verse length 20 ms plus the pause, measured between the note of each verse
+        for (size_t i = 1; i < output.sent.size(); i++) {
+            auto gap = std::chrono::duration_cast<std::chrono::microseconds>(output.sent[i] - output.sent[i - 1]);
+            REQUIRE(gap.count() >= static_cast<int64_t>(20000 + PAUSE_US) - 1000);
+            REQUIRE(gap.count() < static_cast<int64_t>(20000 + PAUSE_US) + 20000);
+        }
+    }
+}
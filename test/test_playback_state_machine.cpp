@@ -1,6 +1,8 @@
 #include "external/catch_amalgamated.hpp"
 #include "../playback_state_machine.hpp"
 
+#include <thread>
+
 using namespace MidiPlay;
 
 TEST_CASE("PlaybackStateMachine initialization", "[state][unit]") {
@@ -146,4 +148,63 @@ TEST_CASE("PlaybackStateMachine multiple resets", "[state][unit]") {
     REQUIRE_FALSE(sm.isRitardando());
     REQUIRE_FALSE(sm.isLastVerse());
     REQUIRE_FALSE(sm.isAlFine());
-}
\ No newline at end of file
+}
+
+TEST_CASE("PlaybackStateMachine compound transitions", "[state][unit]") {
+    PlaybackStateMachine sm;
+    sm.setDisplayWarnings(true);
+    
+    SECTION("starting a section clears the ritardando and keeps the other flags") {
+        sm.setRitardando(true);
+        sm.setAlFine(true);
+        sm.startSection(true);
+        REQUIRE(sm.isPlayingIntro());
+        REQUIRE_FALSE(sm.isRitardando());
+        REQUIRE(sm.isAlFine());
+        REQUIRE(sm.shouldDisplayWarnings());
+        
+        sm.startSection(false);
+        REQUIRE_FALSE(sm.isPlayingIntro());
+    }
+    
+    SECTION("a ritardando starts only in the introduction or the last verse") {
+        REQUIRE_FALSE(sm.startRitardando());
+        REQUIRE_FALSE(sm.isRitardando());
+        
+        sm.setLastVerse(true);
+        REQUIRE(sm.startRitardando());
+        REQUIRE(sm.isRitardando());
+        
+        sm.startSection(true);
+        sm.setLastVerse(false);
+        REQUIRE(sm.startRitardando());
+    }
+    
+    SECTION("a snapshot holds every flag") {
+        sm.setLastVerse(true);
+        uint8_t state = sm.snapshot();
+        REQUIRE((state & PlaybackStateMachine::LAST_VERSE));
+        REQUIRE((state & PlaybackStateMachine::DISPLAY_WARNINGS));
+        REQUIRE_FALSE((state & PlaybackStateMachine::PLAYING_INTRO));
+    }
+}
+
+TEST_CASE("PlaybackStateMachine flags changed from two threads", "[state][concurrency]") {
+    PlaybackStateMachine sm;
+    
+    // Each thread toggles its own flag; neither may lose the other's changes
+    std::thread other([&sm]() {
+        for (int i = 0; i < 100000; i++) {
+            sm.setRitardando(i % 2 == 0);
+        }
+    });
+    for (int i = 0; i < 100000; i++) {
+        sm.setAlFine(i % 2 == 0);
+        sm.setLastVerse(true);
+    }
+    other.join();
+    
+    REQUIRE_FALSE(sm.isRitardando());
+    REQUIRE_FALSE(sm.isAlFine());
+    REQUIRE(sm.isLastVerse());
+}
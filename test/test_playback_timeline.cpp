@@ -0,0 +1,183 @@
+#include "external/catch_amalgamated.hpp"
+#include "../playback_timeline.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <cxxmidi/message.hpp>
+#include <filesystem>
+#include <initializer_list>
+
+using namespace MidiPlay;
+using cxxmidi::Event;
+using cxxmidi::Message;
+namespace fs = std::filesystem;
+
+// Helper to create an event from its delta time and bytes
+cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes) {
+    cxxmidi::Event event;
+    event.SetDt(dt);
+    event.assign(bytes.begin(), bytes.end());
+    return event;
+}
+
+namespace {
+
+// Track 0: tempo, note on channel 1 at 480, end at 960
+// Track 1: notes on channel 2 at 0 and 480, end at 1920
+cxxmidi::File makeTwoTrackFile() {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+
+    cxxmidi::Track& first = file.AddTrack();
+    first.push_back(makeEvent(0, {0xFF, 0x51, 0x07, 0xA1, 0x20}));     // 500000 us per quarter
+    first.push_back(makeEvent(480, {0x90, 60, 100}));
+    first.push_back(makeEvent(480, {0xFF, 0x2F}));
+
+    cxxmidi::Track& second = file.AddTrack();
+    second.push_back(makeEvent(0, {0x91, 48, 90}));
+    second.push_back(makeEvent(480, {0x91, 52, 90}));
+    second.push_back(makeEvent(1440, {0xFF, 0x2F}));
+
+    return file;
+}
+
+} // namespace
+
+TEST_CASE("PlaybackTimeline merges tracks", "[playback_timeline][unit]") {
+    cxxmidi::File file = makeTwoTrackFile();
+    PlaybackTimeline timeline(file);
+
+    SECTION("end-of-track events are dropped") {
+        REQUIRE(timeline.size() == 4);
+        REQUIRE(timeline.getEndTick() == 1920);
+    }
+
+    SECTION("events are ordered by tick, then track") {
+        REQUIRE(timeline.eventAt(0).isMeta(Message::MetaType::Tempo));
+        REQUIRE(timeline.eventAt(1).status() == 0x91);
+        REQUIRE(timeline.eventAt(2).status() == 0x90);
+        REQUIRE(timeline.eventAt(3).status() == 0x91);
+        REQUIRE(timeline.eventAt(3)[1] == 52);
+    }
+
+    SECTION("delta times are relative to the previous merged event") {
+        REQUIRE(timeline.eventAt(1).dt() == 0);
+        REQUIRE(timeline.eventAt(2).dt() == 480);
+        REQUIRE(timeline.eventAt(3).dt() == 0);
+    }
+
+    SECTION("channel mask covers voice messages only") {
+        REQUIRE(timeline.getChannelMask() == 0x0003);
+    }
+}
+
+TEST_CASE("PlaybackTimeline timestamps", "[playback_timeline][unit]") {
+    SECTION("constant tempo") {
+        cxxmidi::File file = makeTwoTrackFile();
+        PlaybackTimeline timeline(file);
+
+        REQUIRE(timeline.timeAt(0) == 0);
+        REQUIRE(timeline.timeAt(2) == 500000);
+        REQUIRE(timeline.getEndTime() == 2000000);
+    }
+
+    SECTION("tempo change re-anchors later events") {
+        cxxmidi::File file;
+        file.SetTimeDivision(480);
+        cxxmidi::Track& track = file.AddTrack();
+        track.push_back(makeEvent(0, {0xFF, 0x51, 0x07, 0xA1, 0x20}));     // 500000 us per quarter
+        track.push_back(makeEvent(960, {0xFF, 0x51, 0x03, 0xD0, 0x90}));   // 250000 us per quarter
+        track.push_back(makeEvent(480, {0x90, 60, 100}));
+        track.push_back(makeEvent(0, {0xFF, 0x2F}));
+
+        PlaybackTimeline timeline(file);
+
+        REQUIRE(timeline.timeAt(1) == 1000000);
+        REQUIRE(timeline.timeAt(2) == 1250000);
+        REQUIRE(timeline.timeAtTick(480) == 500000);
+        REQUIRE(timeline.getEndTime() == 1250000);
+    }
+
+    SECTION("default tempo without a tempo event") {
+        cxxmidi::File file;
+        file.SetTimeDivision(96);
+        cxxmidi::Track& track = file.AddTrack();
+        track.push_back(makeEvent(96, {0x90, 60, 100}));
+
+        PlaybackTimeline timeline(file);
+
+        REQUIRE(timeline.timeAt(0) == 500000);
+    }
+}
+
+TEST_CASE("PlaybackTimeline seeking", "[playback_timeline][unit]") {
+    cxxmidi::File file = makeTwoTrackFile();
+    PlaybackTimeline timeline(file);
+
+    SECTION("indexAtTick finds the first event at or after the tick") {
+        REQUIRE(timeline.indexAtTick(0) == 0);
+        REQUIRE(timeline.indexAtTick(1) == 2);
+        REQUIRE(timeline.indexAtTick(480) == 2);
+        REQUIRE(timeline.indexAtTick(481) == timeline.size());
+    }
+
+    SECTION("empty timeline") {
+        PlaybackTimeline empty;
+
+        REQUIRE(empty.empty());
+        REQUIRE(empty.indexAtTick(0) == 0);
+        REQUIRE(empty.getEndTime() == 0);
+    }
+}
+
+TEST_CASE("PlaybackTimeline bars", "[playback_timeline][unit]") {
+    SECTION("4/4 without a time signature") {
+        cxxmidi::File file = makeTwoTrackFile();
+        PlaybackTimeline timeline(file);
+
+        REQUIRE(timeline.barStartAtOrBefore(0) == 0);
+        REQUIRE(timeline.barStartAtOrBefore(1919) == 0);
+        REQUIRE(timeline.barStartAtOrBefore(1920) == 1920);
+    }
+
+    SECTION("counted from each time signature") {
+        // Two bars of 4/4, then 3/4
+        cxxmidi::File file;
+        file.SetTimeDivision(480);
+        cxxmidi::Track& track = file.AddTrack();
+        track.push_back(makeEvent(0, {0xFF, 0x58, 4, 2, 24, 8}));
+        track.push_back(makeEvent(3840, {0xFF, 0x58, 3, 2, 24, 8}));
+        track.push_back(makeEvent(4000, {0x90, 60, 100}));
+        track.push_back(makeEvent(0, {0xFF, 0x2F}));
+        PlaybackTimeline timeline(file);
+
+        REQUIRE(timeline.barStartAtOrBefore(2000) == 1920);
+        REQUIRE(timeline.barStartAtOrBefore(3840) == 3840);
+        REQUIRE(timeline.barStartAtOrBefore(5279) == 3840);
+        REQUIRE(timeline.barStartAtOrBefore(5280) == 5280);
+        REQUIRE(timeline.barStartAtOrBefore(7839) == 6720);
+    }
+}
+
+TEST_CASE("PlaybackTimeline from fixture files", "[playback_timeline][integration]") {
+    for (const char* name : {"simple.mid", "with_intro.mid", "ritardando.mid", "dc_al_fine.mid"}) {
+        std::string testFile = std::string("fixtures/test_files/") + name;
+        if (!fs::exists(testFile)) {
+            WARN("Test file not found: " << testFile);
+            continue;
+        }
+
+        cxxmidi::File file;
+        file.Load(testFile.c_str());
+        PlaybackTimeline timeline(file);
+
+        INFO(testFile);
+        REQUIRE_FALSE(timeline.empty());
+        for (size_t i = 1; i < timeline.size(); i++) {
+            REQUIRE(timeline.tickAt(i) >= timeline.tickAt(i - 1));
+            REQUIRE(timeline.timeAt(i) >= timeline.timeAt(i - 1));
+        }
+        REQUIRE(timeline.getEndTime() >= timeline.timeAt(timeline.size() - 1));
+        REQUIRE(timeline.getChannelMask() != 0);
+    }
+}
@@ -0,0 +1,62 @@
+#include "external/catch_amalgamated.hpp"
+#include "../port_recovery.hpp"
+#include "../playback_timeline.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <initializer_list>
+
+using namespace MidiPlay;
+
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+// 4/4 at 480 ppq: a note on every beat of two bars
+cxxmidi::File makeTwoBars() {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    cxxmidi::Track& track = file.AddTrack();
+    for (int beat = 0; beat < 8; beat++) {
+        track.push_back(makeEvent(beat == 0 ? 0 : 480, {0x90, 60, 100}));
+    }
+    track.push_back(makeEvent(480, {0xFF, 0x2F}));
+    return file;
+}
+
+} // namespace
+
+TEST_CASE("PortRecovery marks a loss once", "[port_recovery][unit]") {
+    PortRecovery recovery;
+    REQUIRE_FALSE(recovery.markLost());     // No callback: nothing to recover with
+    REQUIRE_FALSE(recovery.isLost());
+
+    bool back = false;
+    recovery.setCallback([&back]() { return back; });
+    REQUIRE(recovery.markLost());
+    REQUIRE_FALSE(recovery.markLost());
+    REQUIRE(recovery.isLost());
+
+    recovery.acknowledge();
+    REQUIRE_FALSE(recovery.isLost());
+    REQUIRE_FALSE(recovery.reconnect());
+    REQUIRE(recovery.getReconnects() == 0);
+
+    back = true;
+    REQUIRE(recovery.reconnect());
+    REQUIRE(recovery.getReconnects() == 1);
+    REQUIRE(recovery.markLost());
+}
+
+TEST_CASE("PortRecovery resumes from the start of the bar reached", "[port_recovery][unit]") {
+    cxxmidi::File file = makeTwoBars();
+    PlaybackTimeline timeline(file);
+    size_t thirdBeatOfBarTwo = timeline.indexAtTick(1920 + 960);
+
+    REQUIRE(PortRecovery::resumeTick(timeline, thirdBeatOfBarTwo + 1, 0) == 1920);
+    REQUIRE(PortRecovery::resumeTick(timeline, timeline.indexAtTick(960) + 1, 0) == 0);
+
+    // Never before the point playback last started
+    size_t runStart = timeline.indexAtTick(1920 + 480);
+    REQUIRE(PortRecovery::resumeTick(timeline, thirdBeatOfBarTwo + 1, runStart) == 1920 + 480);
+}
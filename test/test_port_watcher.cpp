@@ -0,0 +1,23 @@
+#include "external/catch_amalgamated.hpp"
+#include "../port_watcher.hpp"
+
+#include <chrono>
+
+using namespace MidiPlay;
+
+TEST_CASE("PortWatcher waits no longer than the timeout", "[port_watcher][unit]") {
+    PortWatcher watcher;
+
+    auto start = std::chrono::steady_clock::now();
+    bool changed = watcher.waitForChange(std::chrono::milliseconds(100));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Without a sequencer (CI), or with no device plugged in meanwhile, nothing is announced
+    if (!watcher.isActive()) {
+        REQUIRE_FALSE(changed);
+        REQUIRE(elapsed < std::chrono::milliseconds(100));
+    } else if (!changed) {
+        REQUIRE(elapsed >= std::chrono::milliseconds(90));
+    }
+    REQUIRE(elapsed < std::chrono::seconds(2));
+}
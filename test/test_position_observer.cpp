@@ -0,0 +1,104 @@
+#include "external/catch_amalgamated.hpp"
+#include "../position_observer.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace MidiPlay;
+
+TEST_CASE("PlaybackPosition measures and beats", "[position_observer][unit]") {
+    PlaybackPosition position;
+
+    SECTION("3/4") {
+        position.setTick(480 * 3 * 2 + 480, 480, 3, 2);
+        REQUIRE(position.measure == 3);
+        REQUIRE(position.beat == 2);
+        REQUIRE(position.beatsPerMeasure == 3);
+    }
+
+    SECTION("6/8 counts eighth notes") {
+        position.setTick(240 * 7, 480, 6, 3);
+        REQUIRE(position.measure == 2);
+        REQUIRE(position.beat == 2);
+    }
+
+    SECTION("no time signature is 4/4") {
+        position.setTick(480 * 4 - 1, 480, 0, 0);
+        REQUIRE(position.measure == 1);
+        REQUIRE(position.beat == 4);
+        REQUIRE(position.beatsPerMeasure == 4);
+    }
+}
+
+TEST_CASE("PositionObserver keeps the latest position", "[position_observer][unit]") {
+    PositionObserver observer;
+    REQUIRE(observer.read().sequence == 0);
+    REQUIRE(observer.sequence() == 0);
+
+    PlaybackPosition position;
+    position.verse = 2;
+    position.tick = 960;
+    position.bpm = 88.0f;
+    position.ritardando = true;
+    observer.publish(position);
+
+    PlaybackPosition read = observer.read();
+    REQUIRE(read.sequence == 1);
+    REQUIRE(read.verse == 2);
+    REQUIRE(read.tick == 960);
+    REQUIRE(read.bpm == 88.0f);
+    REQUIRE(read.ritardando);
+
+    position.tick = 1440;
+    observer.publish(position);
+    observer.publish(position);
+    REQUIRE(observer.read().sequence == 3);
+    REQUIRE(observer.read().tick == 1440);
+}
+
+TEST_CASE("PositionObserver readers never see a torn position", "[position_observer][concurrency]") {
+    PositionObserver observer;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> torn{0};
+    std::atomic<size_t> reads{0};
+
+    // Every field of a position is derived from its tick
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&]() {
+            uint64_t lastSequence = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                PlaybackPosition position = observer.read();
+                if (position.sequence == 0) {
+                    continue;
+                }
+                if (position.timeUs != int64_t(position.tick) * 3 || position.measure != position.tick / 4 + 1
+                    || position.verse != int16_t(position.tick % 7) || position.playing != (position.tick % 2 == 0)
+                    || position.sequence < lastSequence) {
+                    torn++;
+                }
+                lastSequence = position.sequence;
+                reads++;
+            }
+        });
+    }
+
+    for (uint32_t tick = 0; tick < 200000; tick++) {
+        PlaybackPosition position;
+        position.tick = tick;
+        position.timeUs = int64_t(tick) * 3;
+        position.measure = tick / 4 + 1;
+        position.verse = int16_t(tick % 7);
+        position.playing = tick % 2 == 0;
+        observer.publish(position);
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    REQUIRE(torn == 0);
+    REQUIRE(reads > 0);
+    REQUIRE(observer.read().tick == 199999);
+}
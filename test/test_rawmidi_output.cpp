@@ -0,0 +1,55 @@
+#include "external/catch_amalgamated.hpp"
+#include "../rawmidi_output.hpp"
+
+#include <cxxmidi/message.hpp>
+#include <string>
+
+using namespace MidiPlay;
+
+TEST_CASE("RawMidiOutput reads the sequencer address", "[rawmidi_output][unit]") {
+    int client = -1;
+    int port = -1;
+
+    SECTION("cxxmidi port names") {
+        REQUIRE(RawMidiOutput::parseSequencerAddress("CASIO USB-MIDI:CASIO USB-MIDI MIDI 1 20:0", client, port));
+        REQUIRE(client == 20);
+        REQUIRE(port == 0);
+
+        REQUIRE(RawMidiOutput::parseSequencerAddress("UM-ONE:UM-ONE MIDI 1 24:1", client, port));
+        REQUIRE(client == 24);
+        REQUIRE(port == 1);
+    }
+
+    SECTION("names without an address") {
+        REQUIRE_FALSE(RawMidiOutput::parseSequencerAddress("Midi Through Port-0", client, port));
+        REQUIRE_FALSE(RawMidiOutput::parseSequencerAddress("", client, port));
+        REQUIRE_FALSE(RawMidiOutput::parseSequencerAddress("Port 20:", client, port));
+        REQUIRE_FALSE(RawMidiOutput::parseSequencerAddress("Port :0", client, port));
+        REQUIRE_FALSE(RawMidiOutput::parseSequencerAddress("Port 2x:0", client, port));
+        REQUIRE(client == -1);
+    }
+
+    SECTION("a port that is not a card's has no device") {
+        REQUIRE(RawMidiOutput::deviceForPort("Midi Through Port-0").empty());
+    }
+}
+
+TEST_CASE("RawMidiOutput without a device", "[rawmidi_output][unit]") {
+    RawMidiOutput output;
+    REQUIRE_FALSE(output.isOpen());
+    REQUIRE(output.GetPortCount() == 0);
+
+    SECTION("writes are counted as failed") {
+        cxxmidi::Message message(0x90, 60, 100);
+        output.SendMessage(&message);
+        output.SendMessage(&message);
+        REQUIRE(output.getWriteErrors() == 2);
+    }
+
+    SECTION("a device that does not exist is reported") {
+        REQUIRE_FALSE(output.open("hw:99,0,0"));
+        REQUIRE_FALSE(output.isOpen());
+        REQUIRE(output.getDevice() == "hw:99,0,0");
+        REQUIRE(output.getError().find("hw:99,0,0") == 0);
+    }
+}
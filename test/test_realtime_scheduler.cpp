@@ -0,0 +1,104 @@
+#include "external/catch_amalgamated.hpp"
+#include "../realtime_scheduler.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace MidiPlay;
+
+// apply() is not exercised here: mlockall(MCL_FUTURE) would constrain the
+// whole test process. It is covered by playing with --realtime on the Pi.
+
+TEST_CASE("RealtimeScheduler configuration", "[realtime][unit]") {
+    SECTION("priority is clamped to the SCHED_FIFO range") {
+        RealtimeScheduler high(1000);
+        RealtimeScheduler low(-5);
+
+        REQUIRE(high.getPriority() == sched_get_priority_max(SCHED_FIFO));
+        REQUIRE(low.getPriority() == sched_get_priority_min(SCHED_FIFO));
+    }
+
+    SECTION("priority in range is kept") {
+        RealtimeScheduler scheduler(70);
+
+        REQUIRE(scheduler.getPriority() == 70);
+    }
+
+    SECTION("default core is the last online core") {
+        RealtimeScheduler scheduler(70);
+
+        REQUIRE(scheduler.getCpu() == static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN) - 1));
+    }
+
+    SECTION("explicit core is kept") {
+        RealtimeScheduler scheduler(70, 0);
+
+        REQUIRE(scheduler.getCpu() == 0);
+        REQUIRE(scheduler.getWarnings().empty());
+    }
+}
+
+TEST_CASE("RealtimeScheduler releases helper threads", "[realtime][unit]") {
+    SECTION("a thread at normal priority is left alone") {
+        int policy = -1;
+        int cpus = 0;
+        std::thread helper([&]() {
+            RealtimeScheduler::releaseCurrentThread();
+            sched_param param{};
+            pthread_getschedparam(pthread_self(), &policy, &param);
+            cpu_set_t set;
+            pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+            cpus = CPU_COUNT(&set);
+        });
+        helper.join();
+
+        REQUIRE(policy == SCHED_OTHER);
+        REQUIRE(cpus >= 1);
+    }
+
+    SECTION("a thread that inherited SCHED_FIFO on one core drops both") {
+        bool inherited = false;
+        int policy = -1;
+        bool onPlayerCore = true;
+        std::thread helper([&]() {
+            // As if started by a thread under --realtime
+            sched_param param{};
+            param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+            cpu_set_t core;
+            CPU_ZERO(&core);
+            CPU_SET(0, &core);
+            inherited = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0
+                     && pthread_setaffinity_np(pthread_self(), sizeof(core), &core) == 0;
+            if (!inherited) {
+                return;
+            }
+
+            RealtimeScheduler::releaseCurrentThread();
+            pthread_getschedparam(pthread_self(), &policy, &param);
+            cpu_set_t set;
+            pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+            onPlayerCore = CPU_ISSET(0, &set);
+        });
+        helper.join();
+
+        if (!inherited) {
+            SKIP("Real-time scheduling not permitted here");
+        }
+        REQUIRE(policy == SCHED_OTHER);
+        if (sysconf(_SC_NPROCESSORS_ONLN) > 1) {
+            REQUIRE_FALSE(onPlayerCore);
+        }
+    }
+
+    SECTION("restore() without apply() changes nothing") {
+        RealtimeScheduler scheduler(70);
+        scheduler.restore();
+
+        int policy = -1;
+        sched_param param{};
+        pthread_getschedparam(pthread_self(), &policy, &param);
+        REQUIRE(policy == SCHED_OTHER);
+    }
+}
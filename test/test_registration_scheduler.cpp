@@ -0,0 +1,118 @@
+#include "external/catch_amalgamated.hpp"
+#include "../registration_scheduler.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <initializer_list>
+#include <vector>
+
+using namespace MidiPlay;
+using cxxmidi::Event;
+
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+void addStop(cxxmidi::Track& track, uint32_t dt, uint8_t stop, uint8_t value) {
+    track.push_back(makeEvent(dt, {0xB0, 99, 1}));
+    track.push_back(makeEvent(0, {0xB0, 98, stop}));
+    track.push_back(makeEvent(0, {0xB0, 6, value}));
+}
+
+// Absolute tick of every event of a track
+std::vector<uint32_t> ticksOf(const cxxmidi::Track& track) {
+    std::vector<uint32_t> ticks;
+    uint32_t tick = 0;
+    for (const Event& event : track) {
+        tick += event.Dt();
+        ticks.push_back(tick);
+    }
+    return ticks;
+}
+
+// Track 0: a stop change at 0, then one with each new phrase at 960 and 1920.
+// Track 1: notes 0-480 (then a rest), 960-1920 held into the next phrase, 1920-2400.
+cxxmidi::File makeHymn() {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+
+    cxxmidi::Track& stops = file.AddTrack();
+    addStop(stops, 0, 10, 127);
+    addStop(stops, 960, 11, 127);
+    addStop(stops, 960, 12, 127);
+    stops.push_back(makeEvent(480, {0xFF, 0x2F}));
+
+    cxxmidi::Track& notes = file.AddTrack();
+    notes.push_back(makeEvent(0, {0x90, 60, 100}));
+    notes.push_back(makeEvent(480, {0x90, 60, 0}));
+    notes.push_back(makeEvent(480, {0x90, 62, 100}));
+    notes.push_back(makeEvent(960, {0x90, 64, 100}));
+    notes.push_back(makeEvent(0, {0x90, 62, 0}));
+    notes.push_back(makeEvent(480, {0x90, 64, 0}));
+    notes.push_back(makeEvent(0, {0xFF, 0x2F}));
+    return file;
+}
+
+} // namespace
+
+TEST_CASE("RegistrationScheduler moves a stop change into the rest before it", "[registration_scheduler][unit]") {
+    cxxmidi::File file = makeHymn();
+
+    RegistrationScheduler::Result result = RegistrationScheduler::schedule(file, {});
+    REQUIRE(result.moved == 1);
+    REQUIRE(result.dropped == 0);
+
+    // The change at 960 goes when the first phrase ends; the one at 1920 has a note held into it
+    REQUIRE(ticksOf(file[0]) == std::vector<uint32_t>{0, 0, 0, 480, 480, 480, 1920, 1920, 1920, 2400});
+    REQUIRE(file[0][3] == makeEvent(480, {0xB0, 99, 1}));
+    REQUIRE(file[0][6].Dt() == 1440);
+    REQUIRE(file[1].size() == 7);
+}
+
+TEST_CASE("RegistrationScheduler does not pass a marker", "[registration_scheduler][unit]") {
+    cxxmidi::File file = makeHymn();
+
+    SECTION("the change waits for the marker after the rest") {
+        std::vector<Directive> directives{Directive(720, 0, DirectiveKind::IntroBegin)};
+        REQUIRE(RegistrationScheduler::schedule(file, directives).moved == 1);
+        REQUIRE(ticksOf(file[0])[3] == 721);
+    }
+
+    SECTION("a change at a marker stays there") {
+        std::vector<Directive> directives{Directive(960, 0, DirectiveKind::IntroEnd)};
+        REQUIRE(RegistrationScheduler::schedule(file, directives).moved == 0);
+        REQUIRE(ticksOf(file[0])[3] == 960);
+    }
+}
+
+TEST_CASE("RegistrationScheduler drops a change the organ already has", "[registration_scheduler][unit]") {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    cxxmidi::Track& track = file.AddTrack();
+    addStop(track, 0, 10, 127);
+    track.push_back(makeEvent(0, {0x90, 60, 100}));
+    addStop(track, 480, 10, 127);     // Same stop, same value, under a held note
+    addStop(track, 240, 10, 0);       // Same stop, off
+    track.push_back(makeEvent(240, {0x90, 60, 0}));
+    track.push_back(makeEvent(0, {0xFF, 0x2F}));
+
+    SECTION("without a marker in between") {
+        RegistrationScheduler::Result result = RegistrationScheduler::schedule(file, {});
+        REQUIRE(result.dropped == 1);
+        REQUIRE(result.moved == 0);
+        REQUIRE(track.size() == 9);
+        REQUIRE(ticksOf(track) == std::vector<uint32_t>{0, 0, 0, 0, 720, 720, 720, 960, 960});
+        REQUIRE(track[6] == makeEvent(0, {0xB0, 6, 0}));
+    }
+
+    SECTION("a marker forgets what the organ has") {
+        std::vector<Directive> directives{Directive(480, 0, DirectiveKind::Other)};
+        REQUIRE(RegistrationScheduler::schedule(file, directives).dropped == 0);
+        REQUIRE(track.size() == 12);
+    }
+
+    SECTION("so does a program change") {
+        track.insert(track.begin() + 4, makeEvent(0, {0xC0, 3}));
+        REQUIRE(RegistrationScheduler::schedule(file, {}).dropped == 0);
+    }
+}
@@ -1,6 +1,7 @@
 #include "external/catch_amalgamated.hpp"
 #include "../ritardando_effector.hpp"
 #include "../playback_state_machine.hpp"
+#include "../player_sync_engine.hpp"
 
 #include <cxxmidi/player/player_sync.hpp>
 #include <cxxmidi/output/default.hpp>
@@ -39,8 +40,8 @@ TEST_CASE("RitardandoEffector component design", "[ritardando][unit]") {
     SECTION("component has clear responsibilities") {
         // RitardandoEffector responsibilities verified through code review:
         // 1. Monitor state machine for ritardando flag
-        // 2. Apply progressive speed reduction during heartbeats
-        // 3. Use configurable decrement rate
+        // 2. Apply the speed its curve gives for the current position
+        // 3. Use a configurable curve
         REQUIRE(true);
     }
     
@@ -50,33 +51,42 @@ TEST_CASE("RitardandoEffector component design", "[ritardando][unit]") {
     }
 }
 
-TEST_CASE("RitardandoEffector constants", "[ritardando][unit]") {
-    SECTION("heartbeat interval constant defined") {
-        // HEARTBEAT_CHECK_INTERVAL should be 100000
-        // Verified through code review of ritardando_effector.hpp
-        REQUIRE(true);
+TEST_CASE("RitardandoCurve shapes", "[ritardando][unit]") {
+    SECTION("default curve") {
+        RitardandoCurve curve;
+        
+        REQUIRE(curve.getShape() == RitardandoCurve::Shape::Linear);
+        REQUIRE(curve.getTargetFactor() == Approx(0.85f));
+        REQUIRE(curve.getBeats() == Approx(8.0f));
     }
     
-    SECTION("default decrement rate constant defined") {
-        // RITARDANDO_DECREMENT should be 0.002f
-        // Verified through code review of ritardando_effector.hpp
-        REQUIRE(true);
+    SECTION("linear curve") {
+        RitardandoCurve curve(RitardandoCurve::Shape::Linear, 0.8f, 4.0f);
+        
+        REQUIRE(curve.factorAt(0.0) == Approx(1.0f));
+        REQUIRE(curve.factorAt(2.0) == Approx(0.9f));
+        REQUIRE(curve.factorAt(4.0) == Approx(0.8f));
     }
-}
-
-TEST_CASE("RitardandoEffector API surface", "[ritardando][unit]") {
-    SECTION("public methods available") {
-        // Verified through code review:
-        // - handleHeartbeat()
-        // - setDecrementRate(float)
-        // - getDecrementRate() const
-        REQUIRE(true);
+    
+    SECTION("exponential curve") {
+        RitardandoCurve curve(RitardandoCurve::Shape::Exponential, 0.81f, 4.0f);
+        
+        REQUIRE(curve.factorAt(0.0) == Approx(1.0f));
+        REQUIRE(curve.factorAt(2.0) == Approx(0.9f));
+        REQUIRE(curve.factorAt(4.0) == Approx(0.81f));
     }
     
-    SECTION("component is non-copyable") {
-        // Delete copy constructor and assignment operator
-        // Verified through code review of ritardando_effector.hpp
-        REQUIRE(true);
+    SECTION("factor holds outside the curve") {
+        RitardandoCurve curve(RitardandoCurve::Shape::Linear, 0.8f, 4.0f);
+        
+        REQUIRE(curve.factorAt(-1.0) == Approx(1.0f));
+        REQUIRE(curve.factorAt(100.0) == Approx(0.8f));
+    }
+    
+    SECTION("zero-length curve jumps to the target") {
+        RitardandoCurve curve(RitardandoCurve::Shape::Linear, 0.8f, 0.0f);
+        
+        REQUIRE(curve.factorAt(0.0) == Approx(0.8f));
     }
 }
 
@@ -85,98 +95,198 @@ TEST_CASE("RitardandoEffector API surface", "[ritardando][unit]") {
 TEST_CASE("RitardandoEffector construction", "[ritardando][integration]") {
     Default outport;
     PlayerSync player(&outport);
+    PlayerSyncEngine engine(player);
     PlaybackStateMachine stateMachine;
     
-    SECTION("constructor with default decrement rate") {
-        RitardandoEffector effector(player, stateMachine);
+    SECTION("constructor with default curve") {
+        RitardandoEffector effector(engine, stateMachine);
         
-        REQUIRE(effector.getDecrementRate() == Approx(0.002f));
+        REQUIRE(effector.getCurve().getTargetFactor() == Approx(RitardandoCurve::DEFAULT_TARGET_FACTOR));
+        REQUIRE(effector.getBeatDuration() == std::chrono::microseconds(500000));
     }
     
-    SECTION("constructor with custom decrement rate") {
-        RitardandoEffector effector(player, stateMachine, 0.005f);
+    SECTION("constructor with custom curve") {
+        RitardandoEffector effector(engine, stateMachine, RitardandoCurve(RitardandoCurve::Shape::Exponential, 0.7f, 4.0f));
         
-        REQUIRE(effector.getDecrementRate() == Approx(0.005f));
+        REQUIRE(effector.getCurve().getShape() == RitardandoCurve::Shape::Exponential);
+        REQUIRE(effector.getCurve().getTargetFactor() == Approx(0.7f));
     }
-}
-
-TEST_CASE("RitardandoEffector speed reduction", "[ritardando][integration]") {
-    Default outport;
-    PlayerSync player(&outport);
-    PlaybackStateMachine stateMachine;
-    RitardandoEffector effector(player, stateMachine);
     
-    SECTION("speed reduced when ritardando active") {
+    SECTION("heartbeat at the start of a ritardando leaves speed alone") {
+        RitardandoEffector effector(engine, stateMachine);
         stateMachine.setRitardando(true);
         player.SetSpeed(1.0f);
-        float initialSpeed = player.GetSpeed();
         
         effector.handleHeartbeat();
         
-        float newSpeed = player.GetSpeed();
-        REQUIRE(newSpeed < initialSpeed);
-        REQUIRE(newSpeed == Approx(initialSpeed - 0.002f));
+        REQUIRE(player.GetSpeed() == Approx(1.0f));
     }
+}
+
+namespace {
+
+// Engine whose position the test moves by hand
+class FakeEngine : public PlaybackEngine {
+public:
+    void play() override {}
+    void stop() override {}
+    void finish() override {}
+    void rewind() override { position = std::chrono::microseconds(0); }
+    void goToTick(uint32_t) override {}
+    void notesOff() override {}
+    void releaseHeldNotes() override {}
+    
+    void setSpeed(float s) override { speed = s; setSpeedCalls++; }
+    float getSpeed() const override { return speed; }
+    
+    std::chrono::microseconds currentTimePos() const override { return position; }
+    
+    void setCallbackHeartbeat(const Callback&) override {}
+    void setCallbackFinished(const Callback&) override {}
+    void setCallbackEvent(const EventCallback&) override {}
+    void setJitterRecorder(JitterRecorder*) override {}
+    void setActiveNotes(ActiveNotes*) override {}
+    bool setSchedule(const PlaybackSchedule&, const PlaybackSchedule::SectionCallback&) override { return false; }
+    
+    std::chrono::microseconds position{0};
+    float speed = 1.0f;
+    int setSpeedCalls = 0;
+};
+
+} // namespace
+
+TEST_CASE("RitardandoEffector follows the curve", "[ritardando][unit]") {
+    FakeEngine engine;
+    PlaybackStateMachine stateMachine;
+    RitardandoEffector effector(engine, stateMachine, RitardandoCurve(RitardandoCurve::Shape::Linear, 0.8f, 4.0f));
+    effector.setBeatDuration(std::chrono::microseconds(500000));
+    
+    engine.position = std::chrono::microseconds(3000000);
+    engine.speed = 1.25f;
     
     SECTION("speed unchanged when ritardando inactive") {
-        stateMachine.setRitardando(false);
-        player.SetSpeed(1.0f);
-        float initialSpeed = player.GetSpeed();
-        
+        engine.position += std::chrono::microseconds(1000000);
         effector.handleHeartbeat();
         
-        float newSpeed = player.GetSpeed();
-        REQUIRE(newSpeed == Approx(initialSpeed));
+        REQUIRE(engine.speed == Approx(1.25f));
+        REQUIRE(engine.setSpeedCalls == 0);
     }
     
-    SECTION("multiple heartbeats accumulate speed reduction") {
+    SECTION("speed is a function of position since the marker") {
         stateMachine.setRitardando(true);
-        player.SetSpeed(1.0f);
+        effector.handleHeartbeat();     // Curve starts here
         
+        engine.position += std::chrono::microseconds(1000000);  // 2 beats
         effector.handleHeartbeat();
+        REQUIRE(engine.speed == Approx(1.25f * 0.9f));
+        
+        engine.position += std::chrono::microseconds(5000000);  // Past the end
         effector.handleHeartbeat();
+        REQUIRE(engine.speed == Approx(1.25f * 0.8f));
+    }
+    
+    SECTION("result does not depend on heartbeat frequency") {
+        stateMachine.setRitardando(true);
         effector.handleHeartbeat();
         
-        float expectedSpeed = 1.0f - (0.002f * 3);
-        REQUIRE(player.GetSpeed() == Approx(expectedSpeed));
+        for (int i = 0; i < 150; i++) {
+            engine.position += std::chrono::microseconds(10000);
+            effector.handleHeartbeat();
+        }
+        float frequent = engine.speed;
+        
+        FakeEngine other;
+        other.position = std::chrono::microseconds(3000000);
+        other.speed = 1.25f;
+        RitardandoEffector sparse(other, stateMachine, RitardandoCurve(RitardandoCurve::Shape::Linear, 0.8f, 4.0f));
+        sparse.handleHeartbeat();
+        other.position += std::chrono::microseconds(1500000);
+        sparse.handleHeartbeat();
+        
+        REQUIRE(frequent == Approx(other.speed).margin(RitardandoEffector::SPEED_STEP));
     }
-}
-
-TEST_CASE("RitardandoEffector custom decrement rate", "[ritardando][integration]") {
-    Default outport;
-    PlayerSync player(&outport);
-    PlaybackStateMachine stateMachine;
     
-    SECTION("custom rate applied correctly") {
-        RitardandoEffector effector(player, stateMachine, 0.01f);
+    SECTION("the curve starts at the marker, whatever the heartbeat phase") {
+        stateMachine.setRitardando(true);
+        effector.start(engine.position);    // Marker at 3 s
+        
+        // Heartbeats every 100 ms, landing 3 ms after the marker on one
+        // player and 7 ms after it on the other
+        FakeEngine other;
+        other.speed = 1.25f;
+        RitardandoEffector shifted(other, stateMachine, RitardandoCurve(RitardandoCurve::Shape::Linear, 0.8f, 4.0f));
+        shifted.start(engine.position);
         
-        REQUIRE(effector.getDecrementRate() == Approx(0.01f));
+        for (auto phase = std::chrono::microseconds(3000); phase <= std::chrono::microseconds(1000000); phase += std::chrono::microseconds(100000)) {
+            engine.position = std::chrono::microseconds(3000000) + phase;
+            effector.handleHeartbeat();
+        }
+        for (auto phase = std::chrono::microseconds(7000); phase <= std::chrono::microseconds(1000000); phase += std::chrono::microseconds(100000)) {
+            other.position = std::chrono::microseconds(3000000) + phase;
+            shifted.handleHeartbeat();
+        }
         
+        // Both reach 1.5 s exactly on their last beat
+        engine.position = std::chrono::microseconds(4500000);
+        other.position = engine.position;
+        effector.handleHeartbeat();
+        shifted.handleHeartbeat();
+        REQUIRE(engine.speed == other.speed);
+        REQUIRE(engine.speed == Approx(1.25f * 0.85f));
+    }
+    
+    SECTION("tiny changes do not touch the player") {
         stateMachine.setRitardando(true);
-        player.SetSpeed(1.0f);
+        effector.handleHeartbeat();
         
+        engine.position += std::chrono::microseconds(1000);
         effector.handleHeartbeat();
         
-        float expectedSpeed = 1.0f - 0.01f;
-        REQUIRE(player.GetSpeed() == Approx(expectedSpeed));
+        REQUIRE(engine.setSpeedCalls == 0);
     }
     
-    SECTION("setDecrementRate updates rate") {
-        RitardandoEffector effector(player, stateMachine);
+    SECTION("new ritardando after the flag clears starts a new curve") {
+        stateMachine.setRitardando(true);
+        effector.handleHeartbeat();
+        engine.position += std::chrono::microseconds(2000000);
+        effector.handleHeartbeat();
+        REQUIRE(engine.speed == Approx(1.25f * 0.8f));
         
-        effector.setDecrementRate(0.005f);
-        REQUIRE(effector.getDecrementRate() == Approx(0.005f));
+        stateMachine.setRitardando(false);
+        effector.handleHeartbeat();
+        engine.speed = 1.25f;
+        engine.rewind();
         
         stateMachine.setRitardando(true);
-        player.SetSpeed(1.0f);
+        effector.handleHeartbeat();
+        engine.position += std::chrono::microseconds(1000000);
+        effector.handleHeartbeat();
+        REQUIRE(engine.speed == Approx(1.25f * 0.9f));
+    }
+    
+    SECTION("heartbeats are needed only until the curve reaches its target") {
+        REQUIRE_FALSE(effector.checkHeartbeatNeeded());
+        
+        stateMachine.setRitardando(true);
+        REQUIRE(effector.checkHeartbeatNeeded());   // The first heartbeat starts the curve
+        effector.handleHeartbeat();
+        engine.position += std::chrono::microseconds(1000000);
+        effector.handleHeartbeat();
+        REQUIRE(effector.checkHeartbeatNeeded());
         
+        engine.position += std::chrono::microseconds(1000000);
         effector.handleHeartbeat();
+        REQUIRE(engine.speed == Approx(1.25f * 0.8f));
+        REQUIRE_FALSE(effector.checkHeartbeatNeeded());
         
-        float expectedSpeed = 1.0f - 0.005f;
-        REQUIRE(player.GetSpeed() == Approx(expectedSpeed));
+        // A later ritardando needs them again, even without a heartbeat in between
+        stateMachine.setRitardando(false);
+        REQUIRE_FALSE(effector.checkHeartbeatNeeded());
+        stateMachine.setRitardando(true);
+        REQUIRE(effector.checkHeartbeatNeeded());
     }
 }
 
 // Note: Full heartbeat timing tests with actual MIDI playback callbacks
 // are best validated through end-to-end playback scenarios or manual testing
-// with hardware, as they depend on the player's heartbeat callback mechanism.
\ No newline at end of file
+// with hardware, as they depend on the player's heartbeat callback mechanism.
@@ -0,0 +1,73 @@
+#include "external/catch_amalgamated.hpp"
+#include "../section_cursor.hpp"
+
+#include <vector>
+
+using namespace MidiPlay;
+
+namespace {
+
+constexpr uint64_t PAUSE_US = 1500000;
+
+// Introduction, then three verses from tick 1920
+PlaybackSchedule makeSchedule() {
+    PlaybackSchedule schedule;
+    schedule.add({ScheduledSection::Kind::Introduction, 0, 0, PAUSE_US});
+    schedule.add({ScheduledSection::Kind::Verse, 1, 1920, PAUSE_US});
+    schedule.add({ScheduledSection::Kind::Verse, 2, 1920, PAUSE_US});
+    schedule.add({ScheduledSection::Kind::Verse, 3, 1920, 0});
+    return schedule;
+}
+
+} // namespace
+
+TEST_CASE("SectionCursor walks a schedule", "[section_cursor][unit]") {
+    SectionCursor cursor;
+    REQUIRE_FALSE(cursor.isActive());
+    REQUIRE(cursor.next() == nullptr);
+
+    std::vector<uint16_t> asked;
+    cursor.set(makeSchedule(), [&asked](const ScheduledSection& section) {
+        asked.push_back(section.number);
+        return section.number != 2;     // Skip the second verse
+    });
+    REQUIRE(cursor.isActive());
+    REQUIRE(cursor.pauseAfterUs() == PAUSE_US);
+
+    std::vector<uint16_t> played;
+    while (const ScheduledSection* section = cursor.next()) {
+        if (cursor.accept(*section)) {
+            played.push_back(section->number);
+        }
+    }
+    REQUIRE(asked == std::vector<uint16_t>{1, 2, 3});
+    REQUIRE(played == std::vector<uint16_t>{1, 3});
+    REQUIRE_FALSE(cursor.isActive());
+    REQUIRE(cursor.next() == nullptr);
+}
+
+TEST_CASE("SectionCursor without a callback plays every section", "[section_cursor][unit]") {
+    SectionCursor cursor;
+    cursor.set(makeSchedule(), nullptr);
+
+    const ScheduledSection* section = cursor.next();
+    REQUIRE(section != nullptr);
+    REQUIRE(cursor.accept(*section));
+    REQUIRE(section->startTick == 1920);
+
+    SECTION("end() stops it short") {
+        cursor.end();
+        REQUIRE_FALSE(cursor.isActive());
+        REQUIRE(cursor.next() == nullptr);
+    }
+
+    SECTION("set() starts it over") {
+        cursor.set(makeSchedule(), nullptr);
+        REQUIRE(cursor.next()->number == 1);
+    }
+
+    SECTION("An empty schedule leaves it inactive") {
+        cursor.set(PlaybackSchedule(), nullptr);
+        REQUIRE_FALSE(cursor.isActive());
+    }
+}
@@ -0,0 +1,122 @@
+#include "external/catch_amalgamated.hpp"
+#include "../seek_index.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace MidiPlay;
+
+namespace {
+
+struct TimedMessage {
+    uint32_t tick;
+    std::vector<uint8_t> bytes;
+};
+
+// Two organ stops switched on channel 1 (NRPN 0/10 and 0/11), a program change on channel 2
+std::vector<TimedMessage> registrationChanges() {
+    return {
+        {0,    {0xC1, 5}},
+        {0,    {0xB0, 99, 0}},
+        {0,    {0xB0, 98, 10}},
+        {0,    {0xB0, 6, 127}},         // Stop 10 on
+        {0,    {0x90, 60, 100}},
+        {960,  {0x80, 60, 0}},
+        {960,  {0xB0, 98, 11}},
+        {960,  {0xB0, 6, 127}},         // Stop 11 on
+        {960,  {0x90, 62, 100}},
+        {1920, {0xB0, 98, 10}},
+        {1920, {0xB0, 6, 0}},           // Stop 10 off
+        {1920, {0xC1, 7}},
+        {1920, {0x80, 62, 0}},
+    };
+}
+
+std::unique_ptr<PlaybackTimeline> makeTimeline(const std::vector<TimedMessage>& messages) {
+    size_t bytes = 0;
+    for (const TimedMessage& message : messages) {
+        bytes += message.bytes.size();
+    }
+    auto timeline = std::make_unique<PlaybackTimeline>(480, messages.size(), bytes);
+    for (const TimedMessage& message : messages) {
+        timeline->append(message.tick, message.bytes.data(), message.bytes.size());
+    }
+    timeline->extendTo(2400);
+    timeline->complete();
+    return timeline;
+}
+
+std::vector<std::vector<uint8_t>> messagesOf(const MidiBatch& batch) {
+    std::vector<std::vector<uint8_t>> messages;
+    for (size_t i = 0; i < batch.size(); i++) {
+        EventView message = batch.message(i);
+        messages.emplace_back(message.data(), message.data() + message.size());
+    }
+    return messages;
+}
+
+} // namespace
+
+TEST_CASE("SeekIndex finds the controllers of a timeline", "[seek_index][unit]") {
+    auto timeline = makeTimeline(registrationChanges());
+    SeekIndex index(*timeline);
+
+    // Program on channel 2, selection on channel 1, parameters 0/10 and 0/11
+    REQUIRE(index.getControllerCount() == 4);
+    REQUIRE(index.getMaxChaseMessages() == 1 + 2 + 4 + 4);
+}
+
+TEST_CASE("SeekIndex chases controllers skipped by a seek", "[seek_index][unit]") {
+    auto timeline = makeTimeline(registrationChanges());
+    SeekIndex index(*timeline);
+    MidiBatch batch;
+
+    SECTION("No change between two positions sends nothing") {
+        REQUIRE(index.chase(4, 4, batch) == 0);
+        REQUIRE(batch.empty());
+    }
+
+    SECTION("Jumping into the middle sets the registration from the start") {
+        size_t target = timeline->indexAtTick(960);
+        REQUIRE(index.chase(0, target, batch) == 6);
+        std::vector<std::vector<uint8_t>> expected = {
+            {0xC1, 5},
+            {0xB0, 99, 0}, {0xB0, 98, 10}, {0xB0, 6, 127},
+            {0xB0, 99, 0}, {0xB0, 98, 10},      // Selection as the file left it
+        };
+        REQUIRE(messagesOf(batch) == expected);
+    }
+
+    SECTION("Jumping back restores earlier values") {
+        size_t from = timeline->size();
+        size_t target = timeline->indexAtTick(960);
+        index.chase(from, target, batch);
+        std::vector<std::vector<uint8_t>> expected = {
+            {0xC1, 5},
+            {0xB0, 99, 0}, {0xB0, 98, 10}, {0xB0, 6, 127},
+            {0xB0, 99, 0}, {0xB0, 98, 10},
+        };
+        REQUIRE(messagesOf(batch) == expected);
+    }
+
+    SECTION("Jumping ahead sends only what changed on the way") {
+        size_t from = timeline->indexAtTick(960);
+        size_t target = timeline->indexAtTick(1920);
+        index.chase(from, target, batch);
+        std::vector<std::vector<uint8_t>> expected = {
+            {0xB0, 99, 0}, {0xB0, 98, 11}, {0xB0, 6, 127},
+            {0xB0, 99, 0}, {0xB0, 98, 11},
+        };
+        REQUIRE(messagesOf(batch) == expected);
+    }
+
+    SECTION("Notes are never chased") {
+        index.chase(0, timeline->size(), batch);
+        for (const std::vector<uint8_t>& message : messagesOf(batch)) {
+            uint8_t type = message[0] & 0xF0;
+            REQUIRE(type != 0x90);
+            REQUIRE(type != 0x80);
+        }
+    }
+}
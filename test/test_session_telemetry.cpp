@@ -0,0 +1,139 @@
+#include "external/catch_amalgamated.hpp"
+#include "../session_telemetry.hpp"
+#include "../jitter_recorder.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include "../startup_profiler.hpp"
+#include "../timing_manager.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <getopt.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace MidiPlay;
+using Phase = StartupProfiler::Phase;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+} // namespace
+
+TEST_CASE("--telemetry", "[session_telemetry][options][unit]") {
+    std::vector<std::string> args{"play", "162", "--telemetry=/var/log/midiplay.jsonl"};
+    char** argv = makeArgv(args);
+    REQUIRE(StartupProfiler::isRequested(3, argv));
+
+    optind = 0;
+    Options options(3, argv);
+    REQUIRE(options.parse() == 0);
+    REQUIRE(options.isTelemetry());
+    REQUIRE(options.getTelemetryPath() == "/var/log/midiplay.jsonl");
+    REQUIRE_FALSE(options.isJitterReport());
+    freeArgv(argv, 3);
+}
+
+TEST_CASE("SessionTelemetry records a session", "[session_telemetry][integration]") {
+    std::string path = "fixtures/test_files/simple.mid";
+    if (!fs::exists(path)) {
+        WARN("Test file not found: " << path);
+        return;
+    }
+
+    optind = 0;
+    auto argv = makeArgv({"play", path, "-n2", "--no-cache", "--telemetry=telemetry.jsonl"});
+    Options options(5, argv);
+    options.parse();
+    MidiLoader loader;
+    StartupProfiler profiler(true);
+    profiler.begin(Phase::LoadFile);
+    REQUIRE(loader.loadFile(path, options));
+    profiler.end(Phase::LoadFile);
+
+    // One event on time, one 2 ms late, one 7 ms late; the fourth does not fit
+    JitterRecorder recorder(3);
+    recorder.record(1000000, 1000000);
+    recorder.record(2000000, 4000000);
+    recorder.record(3000000, 10000000);
+    recorder.record(4000000, 4000000);
+
+    TimingManager timingManager;
+    timingManager.startTimer();
+    timingManager.endTimer();
+
+    SessionTelemetry::Record record =
+        SessionTelemetry::collect(options, loader, profiler, timingManager, &recorder, false);
+    freeArgv(argv, 5);
+
+    REQUIRE(record.events == loader.getEventCount());
+    REQUIRE(record.sent == 3);
+    REQUIRE(record.dropped == 1);
+    REQUIRE(record.late == 2);
+    REQUIRE(record.veryLate == 1);
+    REQUIRE(record.maxLatenessUs == 7000);
+    REQUIRE(record.verses == 2);
+    REQUIRE(record.expectedSeconds == Catch::Approx(loader.getProjectedDurationSeconds()));
+    REQUIRE(record.phase(Phase::LoadFile) >= 0);
+    REQUIRE(record.phase(Phase::ConnectDevice) == -1);
+    REQUIRE_FALSE(record.platform.empty());
+
+    SECTION("JSON lines are appended") {
+        fs::path jsonPath = fs::temp_directory_path() / ("midiplay-telemetry-" + std::to_string(getpid()) + ".jsonl");
+        fs::remove(jsonPath);
+        REQUIRE(SessionTelemetry::write(record, jsonPath.string()));
+        REQUIRE(SessionTelemetry::write(record, jsonPath.string()));
+        std::string json = readFile(jsonPath);
+        fs::remove(jsonPath);
+
+        std::string line = json.substr(0, json.find('\n') + 1);
+        REQUIRE(json == line + line);
+        REQUIRE(line.front() == '{');
+        REQUIRE(line.find("\"late_1ms\":2,") != std::string::npos);
+        REQUIRE(line.find("\"late_5ms\":1,") != std::string::npos);
+        REQUIRE(line.find("\"max_lateness_us\":7000,") != std::string::npos);
+        REQUIRE(line.find("\"connect_us\":-1,") != std::string::npos);
+        REQUIRE(line.find("\"MidiLoader::loadFile\":") != std::string::npos);
+        REQUIRE(line.find("\"cancelled\":false") != std::string::npos);
+    }
+
+    SECTION("a .prom path is replaced as a whole") {
+        fs::path promPath = fs::temp_directory_path() / ("midiplay-telemetry-" + std::to_string(getpid()) + ".prom");
+        REQUIRE(SessionTelemetry::write(record, promPath.string()));
+        record.cancelled = true;
+        REQUIRE(SessionTelemetry::write(record, promPath.string()));
+        std::string prom = readFile(promPath);
+        fs::remove(promPath);
+
+        REQUIRE_FALSE(fs::exists(promPath.string() + ".tmp"));
+        REQUIRE(prom.find("midiplay_session_cancelled 1\n") != std::string::npos);
+        REQUIRE(prom.find("midiplay_session_cancelled 0\n") == std::string::npos);
+        REQUIRE(prom.find("midiplay_events_late_1ms 2\n") != std::string::npos);
+        REQUIRE(prom.find("midiplay_max_lateness_seconds 0.007000\n") != std::string::npos);
+        REQUIRE(prom.find("midiplay_startup_phase_seconds{phase=\"MidiLoader::loadFile\"}") != std::string::npos);
+        REQUIRE(prom.find("connectAndDetectDevice") == std::string::npos);
+    }
+}
+
+TEST_CASE("SessionTelemetry escapes text", "[session_telemetry][unit]") {
+    SessionTelemetry::Record record;
+    record.title = "A \"Mighty\" Fortress\\";
+
+    std::ostringstream json;
+    SessionTelemetry::writeJson(record, json);
+    REQUIRE(json.str().find("\"title\":\"A \\\"Mighty\\\" Fortress\\\\\"") != std::string::npos);
+    REQUIRE(json.str().find("\"phases\":{}") != std::string::npos);
+    REQUIRE(json.str().back() == '\n');
+}
@@ -0,0 +1,119 @@
+#include "external/catch_amalgamated.hpp"
+#include "../setlist.hpp"
+#include "../hymn_preloader.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include <filesystem>
+#include <getopt.h>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+// Helper functions (shared with other test files)
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+TEST_CASE("Setlist argument splitting", "[setlist][unit]") {
+    std::vector<std::string> args;
+
+    SECTION("blanks separate arguments") {
+        REQUIRE(Setlist::splitArguments("  162 -n3\t-t80 ", args));
+        REQUIRE(args == std::vector<std::string>{"162", "-n3", "-t80"});
+    }
+
+    SECTION("quotes group blanks") {
+        REQUIRE(Setlist::splitArguments("\"hymn 162\" --title='Come, Come' -x2", args));
+        REQUIRE(args == std::vector<std::string>{"hymn 162", "--title=Come, Come", "-x2"});
+    }
+
+    SECTION("comments and blank lines have no arguments") {
+        REQUIRE(Setlist::splitArguments("   ", args));
+        REQUIRE(args.empty());
+        REQUIRE(Setlist::splitArguments("# Opening hymn", args));
+        REQUIRE(args.empty());
+        REQUIRE(Setlist::splitArguments("2 -n3   # Opening hymn", args));
+        REQUIRE(args == std::vector<std::string>{"2", "-n3"});
+    }
+
+    SECTION("an unterminated quote is an error") {
+        REQUIRE_FALSE(Setlist::splitArguments("\"hymn 162 -x2", args));
+        REQUIRE(args.empty());
+    }
+}
+
+TEST_CASE("Setlist parsing", "[setlist][unit]") {
+    Setlist setlist;
+
+    SECTION("one entry per hymn line, with its line number") {
+        REQUIRE(setlist.parse("# Service\nprelude -p\n\n2 -n3\n169 -x2 -t80\n"));
+        REQUIRE(setlist.size() == 3);
+        REQUIRE(setlist.entries()[0].args == std::vector<std::string>{"prelude", "-p"});
+        REQUIRE(setlist.entries()[0].lineNumber == 2);
+        REQUIRE(setlist.entries()[2].args == std::vector<std::string>{"169", "-x2", "-t80"});
+        REQUIRE(setlist.entries()[2].lineNumber == 5);
+    }
+
+    SECTION("a setlist without hymns is an error") {
+        REQUIRE_FALSE(setlist.parse("# Nothing yet\n\n"));
+        REQUIRE_FALSE(setlist.getError().empty());
+    }
+
+    SECTION("a bad line rejects the whole setlist") {
+        REQUIRE_FALSE(setlist.parse("2 -n3\n'169 -x2\n"));
+        REQUIRE(setlist.empty());
+        REQUIRE_FALSE(setlist.getError().empty());
+    }
+
+    SECTION("a missing file is an error") {
+        REQUIRE_FALSE(setlist.load("nonexistent_setlist.txt"));
+        REQUIRE_FALSE(setlist.getError().empty());
+    }
+}
+
+TEST_CASE("HymnPreloader", "[setlist][integration][threading]") {
+    std::string simple = "fixtures/test_files/simple.mid";
+    std::string withIntro = "fixtures/test_files/with_intro.mid";
+    if (!fs::exists(simple) || !fs::exists(withIntro)) {
+        WARN("Test MIDI files not found");
+        return;
+    }
+
+    optind = 0;
+    auto argv = makeArgv({"play", "simple", "--no-cache"});
+    Options options(3, argv);
+    options.parse();
+
+    HymnPreloader preloader;
+
+    SECTION("nothing started gives nothing") {
+        REQUIRE(preloader.take() == nullptr);
+    }
+
+    SECTION("loads in the background while another loader is live") {
+        MidiLoader current;
+        REQUIRE(current.loadFile(withIntro, options));
+
+        preloader.start(std::make_unique<MidiLoader>(), simple, options);
+
+        // A second instance loading on this thread at the same time
+        MidiLoader other;
+        REQUIRE(other.loadFile(withIntro, options));
+
+        std::unique_ptr<MidiLoader> next = preloader.take();
+        REQUIRE(next != nullptr);
+        REQUIRE_FALSE(next->getFile().empty());
+        REQUIRE(next->getTotalTicks() > 0);
+
+        // Neither load disturbed the other
+        REQUIRE(current.getIntroSegments().size() == other.getIntroSegments().size());
+        REQUIRE(current.getTitle() == other.getTitle());
+        REQUIRE(preloader.take() == nullptr);
+    }
+
+    SECTION("a failed load gives nothing") {
+        preloader.start(std::make_unique<MidiLoader>(), "nonexistent_file.mid", options);
+        REQUIRE(preloader.take() == nullptr);
+    }
+
+    freeArgv(argv, 3);
+}
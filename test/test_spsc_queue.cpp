@@ -0,0 +1,106 @@
+#include "external/catch_amalgamated.hpp"
+#include "../spsc_queue.hpp"
+#include "../playback_command.hpp"
+#include "../keyboard_control.hpp"
+
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+using namespace MidiPlay;
+
+TEST_CASE("SpscQueue single thread", "[spsc_queue][unit]") {
+    SpscQueue<int, 4> queue;
+
+    SECTION("empty queue pops nothing") {
+        REQUIRE(queue.empty());
+        REQUIRE_FALSE(queue.pop().has_value());
+    }
+
+    SECTION("first in, first out") {
+        REQUIRE(queue.push(1));
+        REQUIRE(queue.push(2));
+        REQUIRE(queue.size() == 2);
+        REQUIRE(*queue.pop() == 1);
+        REQUIRE(*queue.pop() == 2);
+        REQUIRE(queue.empty());
+    }
+
+    SECTION("a full queue refuses elements") {
+        for (int i = 0; i < 4; i++) {
+            REQUIRE(queue.push(i));
+        }
+        REQUIRE_FALSE(queue.push(4));
+        REQUIRE(*queue.pop() == 0);
+        REQUIRE(queue.push(4));
+    }
+
+    SECTION("indices wrap around the ring") {
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(queue.push(i));
+            REQUIRE(*queue.pop() == i);
+        }
+        REQUIRE(queue.empty());
+    }
+}
+
+TEST_CASE("SpscQueue between two threads", "[spsc_queue][unit][threading]") {
+    SpscQueue<uint32_t, 64> queue;
+    constexpr uint32_t COUNT = 100000;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < COUNT; i++) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    while (expected < COUNT) {
+        std::optional<uint32_t> value = queue.pop();
+        if (!value) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && *value == expected;
+        expected++;
+    }
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("KeyboardControl keys", "[spsc_queue][unit]") {
+    SECTION("key mapping") {
+        REQUIRE(KeyboardControl::commandForKey('+')->kind == PlaybackCommand::Kind::Tempo);
+        REQUIRE(KeyboardControl::commandForKey('+')->value == KeyboardControl::TEMPO_STEP_PERCENT);
+        REQUIRE(KeyboardControl::commandForKey('-')->value == -KeyboardControl::TEMPO_STEP_PERCENT);
+        REQUIRE(KeyboardControl::commandForKey('l')->kind == PlaybackCommand::Kind::LastVerse);
+        REQUIRE(KeyboardControl::commandForKey('e')->kind == PlaybackCommand::Kind::EndAfterVerse);
+        REQUIRE(KeyboardControl::commandForKey('q')->kind == PlaybackCommand::Kind::Stop);
+        REQUIRE_FALSE(KeyboardControl::commandForKey('x').has_value());
+    }
+
+    SECTION("keys read from the input become commands") {
+        int input[2];
+        REQUIRE(::pipe(input) == 0);
+        PlaybackCommandQueue queue;
+        {
+            KeyboardControl keyboard(queue, input[0]);
+            REQUIRE(keyboard.start());
+            REQUIRE(::write(input[1], "x+l", 3) == 3);
+            for (int i = 0; i < 200 && queue.size() < 2; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+        ::close(input[0]);
+        ::close(input[1]);
+
+        REQUIRE(queue.pop()->kind == PlaybackCommand::Kind::Tempo);
+        REQUIRE(queue.pop()->kind == PlaybackCommand::Kind::LastVerse);
+        REQUIRE(queue.empty());
+    }
+}
@@ -0,0 +1,95 @@
+#include "external/catch_amalgamated.hpp"
+#include "../startup_profiler.hpp"
+#include "../options.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace MidiPlay;
+using Phase = StartupProfiler::Phase;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+TEST_CASE("StartupProfiler records phases only when enabled", "[startup_profiler][unit]") {
+    SECTION("disabled records nothing") {
+        StartupProfiler profiler(false);
+        profiler.begin(Phase::LoadFile);
+        profiler.end(Phase::LoadFile);
+
+        REQUIRE_FALSE(profiler.isEnabled());
+        REQUIRE_FALSE(profiler.at(Phase::LoadFile).recorded);
+        REQUIRE(profiler.getTotalNs() == 0);
+    }
+
+    SECTION("enabled records ordered, non-overlapping phases") {
+        StartupProfiler profiler(true);
+        profiler.begin(Phase::InitializeI18n);
+        profiler.end(Phase::InitializeI18n);
+        profiler.begin(Phase::ParseOptions);
+        profiler.end(Phase::ParseOptions);
+
+        const StartupProfiler::Sample& first = profiler.at(Phase::InitializeI18n);
+        const StartupProfiler::Sample& second = profiler.at(Phase::ParseOptions);
+        REQUIRE(first.recorded);
+        REQUIRE(second.recorded);
+        REQUIRE(first.beginNs <= first.endNs);
+        REQUIRE(first.endNs <= second.beginNs);
+        REQUIRE(profiler.getTotalNs() == second.endNs);
+        REQUIRE_FALSE(profiler.at(Phase::ConnectDevice).recorded);
+    }
+}
+
+TEST_CASE("StartupProfiler reports", "[startup_profiler][unit]") {
+    StartupProfiler profiler(true);
+    profiler.begin(Phase::LoadFile);
+    profiler.end(Phase::LoadFile);
+
+    SECTION("breakdown lists recorded phases only") {
+        std::ostringstream out;
+        profiler.print(out);
+        REQUIRE(out.str().find("MidiLoader::loadFile") != std::string::npos);
+        REQUIRE(out.str().find("connectAndDetectDevice") == std::string::npos);
+    }
+
+    SECTION("JSON file") {
+        fs::path path = fs::temp_directory_path() / ("midiplay-profile-" + std::to_string(getpid()) + ".json");
+        REQUIRE(profiler.writeJson(path.string()));
+
+        std::ifstream in(path);
+        std::stringstream json;
+        json << in.rdbuf();
+        fs::remove(path);
+
+        REQUIRE(json.str().find("\"name\": \"MidiLoader::loadFile\"") != std::string::npos);
+        REQUIRE(json.str().find("\"total_us\"") != std::string::npos);
+        REQUIRE(json.str().find("getFullPath") == std::string::npos);
+    }
+}
+
+TEST_CASE("--profile-startup", "[startup_profiler][options][unit]") {
+    SECTION("recognized before and by Options") {
+        std::vector<std::string> args{"play", "162", "--profile-startup=startup.json"};
+        char** argv = makeArgv(args);
+        REQUIRE(StartupProfiler::isRequested(3, argv));
+
+        optind = 0;
+        Options options(3, argv);
+        REQUIRE(options.parse() == 0);
+        REQUIRE(options.isProfileStartup());
+        REQUIRE(options.getProfileJsonPath() == "startup.json");
+        freeArgv(argv, 3);
+    }
+
+    SECTION("absent") {
+        std::vector<std::string> args{"play", "162", "--", "--profile-startup"};
+        char** argv = makeArgv(args);
+        REQUIRE_FALSE(StartupProfiler::isRequested(4, argv));
+        freeArgv(argv, 4);
+    }
+}
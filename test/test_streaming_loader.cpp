@@ -0,0 +1,210 @@
+#include "external/catch_amalgamated.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include "../playback_timeline.hpp"
+#include "../seek_index.hpp"
+#include "../smf_reader.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+// Load a fixture the normal way and streamed, both without the cache
+struct LoadPair {
+    std::vector<std::string> normalArgs;
+    std::vector<std::string> streamArgs;
+    char** normalArgv;
+    char** streamArgv;
+    Options normalOptions;
+    Options streamOptions;
+
+    explicit LoadPair(const std::string& file)
+        : normalArgs{"play", file, "--no-cache"}
+        , streamArgs{"play", file, "--no-cache", "--stream"}
+        , normalArgv(makeArgv(normalArgs))
+        , streamArgv(makeArgv(streamArgs))
+        , normalOptions(3, normalArgv)
+        , streamOptions(4, streamArgv)
+    {
+        optind = 0;
+        normalOptions.parse();
+        optind = 0;
+        streamOptions.parse();
+    }
+
+    ~LoadPair() {
+        freeArgv(normalArgv, normalArgs.size());
+        freeArgv(streamArgv, streamArgs.size());
+    }
+};
+
+} // namespace
+
+TEST_CASE("SmfReader decodes the fixtures", "[streaming_loader][unit]") {
+    std::string testFile = "fixtures/test_files/simple.mid";
+    if (!fs::exists(testFile)) {
+        WARN("Test file not found: " << testFile);
+        return;
+    }
+
+    SECTION("header and track table") {
+        SmfReader reader;
+        REQUIRE(reader.open(testFile));
+        REQUIRE(reader.getTimeDivision() == 960);
+        REQUIRE(reader.getTrackCount() > 0);
+    }
+
+    SECTION("every track ends with end of track") {
+        SmfReader reader;
+        REQUIRE(reader.open(testFile));
+        for (size_t i = 0; i < reader.getTrackCount(); i++) {
+            SmfReader::Track track = reader.track(i);
+            cxxmidi::Event event;
+            cxxmidi::Event last;
+            while (track.next(event)) {
+                last = event;
+            }
+            REQUIRE(last.size() >= 2);
+            REQUIRE(last[0] == 0xFF);
+            REQUIRE(last[1] == 0x2F);
+        }
+    }
+
+    SECTION("a file that is not MIDI is refused") {
+        SmfReader reader;
+        REQUIRE_FALSE(reader.open("fixtures/test_configs/minimal_devices.yaml"));
+        REQUIRE_FALSE(reader.getError().empty());
+    }
+}
+
+TEST_CASE("SmfReader steps over what the preprocessor discards", "[streaming_loader][unit]") {
+    const std::vector<uint8_t> chunk = {
+        0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,   // Tempo
+        0x00, 0xB0, 0x07, 0x64,                     // Volume
+        0x0A, 0x40, 0x7F,                           // Sustain, running status
+        0x0A, 0xFF, 0x05, 0x03, 'L', 'a', 'h',      // Lyrics
+        0x0A, 0xF0, 0x03, 0x43, 0x10, 0xF7,         // SysEx
+        0x0A, 0x90, 0x3C, 0x64,                     // Note on
+        0x00, 0xB0, 0x63, 0x00,                     // NRPN MSB
+        0x05, 0x0A, 0x00,                           // Volume again, running status
+        0x05, 0x06, 0x7F,                           // Data entry, running status
+        0x00, 0xFF, 0x2F, 0x00,                     // End of track
+    };
+
+    SECTION("only loadable events are decoded, their times kept") {
+        SmfReader::Track track(chunk.data(), chunk.size());
+        cxxmidi::Event event;
+        std::vector<std::pair<uint32_t, std::vector<uint8_t>>> events;
+        while (track.nextLoadable(event)) {
+            events.push_back({event.Dt(), std::vector<uint8_t>(event.begin(), event.end())});
+        }
+
+        std::vector<std::pair<uint32_t, std::vector<uint8_t>>> expected = {
+            {0,  {0xFF, 0x51, 0x07, 0xA1, 0x20}},
+            {40, {0x90, 0x3C, 0x64}},
+            {0,  {0xB0, 0x63, 0x00}},
+            {10, {0xB0, 0x06, 0x7F}},
+            {0,  {0xFF, 0x2F}},
+        };
+        REQUIRE(events == expected);
+        REQUIRE(track.tick() == 50);
+    }
+
+    SECTION("a truncated skipped event is still an error") {
+        SmfReader::Track track(chunk.data(), 24);      // Inside the SysEx
+        cxxmidi::Event event;
+        REQUIRE(track.nextLoadable(event));
+        REQUIRE_THROWS_AS(track.nextLoadable(event), std::runtime_error);
+    }
+}
+
+TEST_CASE("--stream implies the timeline player", "[streaming_loader][unit]") {
+    optind = 0;
+    auto argv = makeArgv({"play", "162", "--stream"});
+    Options options(3, argv);
+    options.parse();
+
+    REQUIRE(options.isStreamingLoad());
+    REQUIRE(options.isTimelineEngine());
+    freeArgv(argv, 3);
+}
+
+TEST_CASE("Streaming load matches a normal load", "[streaming_loader][integration]") {
+    for (const char* name : {"simple.mid", "with_intro.mid", "ritardando.mid", "dc_al_fine.mid"}) {
+        std::string testFile = std::string("fixtures/test_files/") + name;
+        if (!fs::exists(testFile)) {
+            WARN("Test file not found: " << testFile);
+            continue;
+        }
+        INFO(name);
+
+        LoadPair pair(testFile);
+        MidiLoader normal;
+        REQUIRE(normal.loadFile(testFile, pair.normalOptions));
+        MidiLoader streamed;
+        REQUIRE(streamed.loadFile(testFile, pair.streamOptions));
+        REQUIRE(streamed.isStreaming());
+
+        // Everything decided by the scan is final before playback
+        REQUIRE(streamed.getTitle() == normal.getTitle());
+        REQUIRE(streamed.getVerses() == normal.getVerses());
+        REQUIRE(streamed.getBpm() == normal.getBpm());
+        REQUIRE(streamed.getEventCount() == normal.getEventCount());
+        REQUIRE(streamed.getDirectives().size() == normal.getDirectives().size());
+        REQUIRE(streamed.getIntroSegments().size() == normal.getIntroSegments().size());
+        for (size_t i = 0; i < normal.getIntroSegments().size(); i++) {
+            REQUIRE(streamed.getIntroSegments()[i].start == normal.getIntroSegments()[i].start);
+            REQUIRE(streamed.getIntroSegments()[i].end == normal.getIntroSegments()[i].end);
+        }
+
+        const PlaybackTimeline* timeline = streamed.getStreamingTimeline();
+        REQUIRE(timeline != nullptr);
+        PlaybackTimeline expected(normal.getFile());
+
+        // The tempo map is known up front; the head is already published
+        REQUIRE(timeline->getEndTick() <= expected.getEndTick());
+        REQUIRE(timeline->size() <= expected.size());
+
+        timeline->waitForTick(expected.getEndTick());
+        streamed.finishStreaming();
+
+        REQUIRE(timeline->isComplete());
+        REQUIRE(streamed.getStreamingSeekIndex() != nullptr);
+        REQUIRE(streamed.getStreamingSeekIndex()->getControllerCount() == SeekIndex(expected).getControllerCount());
+        REQUIRE(timeline->size() == expected.size());
+        REQUIRE(timeline->getEndTick() == expected.getEndTick());
+        REQUIRE(timeline->getEndTime() == expected.getEndTime());
+        REQUIRE(timeline->getChannelMask() == expected.getChannelMask());
+        for (size_t i = 0; i < expected.size(); i++) {
+            REQUIRE(timeline->tickAt(i) == expected.tickAt(i));
+            REQUIRE(timeline->timeAt(i) == expected.timeAt(i));
+            EventView got = timeline->eventAt(i);
+            EventView want = expected.eventAt(i);
+            REQUIRE(std::vector<uint8_t>(got.data(), got.data() + got.size()) ==
+                    std::vector<uint8_t>(want.data(), want.data() + want.size()));
+        }
+
+        // The tracks handed over afterwards are the ones a normal load produces
+        const cxxmidi::File& file = streamed.getFile();
+        REQUIRE(file.size() == normal.getFile().size());
+        for (size_t t = 0; t < file.size(); t++) {
+            REQUIRE(file[t].size() == normal.getFile()[t].size());
+            for (size_t e = 0; e < file[t].size(); e++) {
+                REQUIRE(file[t][e].Dt() == normal.getFile()[t][e].Dt());
+                REQUIRE(static_cast<const cxxmidi::Message&>(file[t][e]) ==
+                        static_cast<const cxxmidi::Message&>(normal.getFile()[t][e]));
+            }
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include "external/catch_amalgamated.hpp"
+#include "../tempo_map.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace MidiPlay;
+
+TEST_CASE("TempoMap without tempo events", "[tempo_map]") {
+    TempoMap map(480);
+
+    SECTION("Default tempo from tick 0") {
+        REQUIRE(map.size() == 1);
+        REQUIRE(map.uSecPerQuarterAt(0) == 500000);
+        REQUIRE(map.timeAt(480) == 500000);
+    }
+
+    SECTION("Adding a tempo at tick 0 replaces the default") {
+        map.add(0, 600000);
+        REQUIRE(map.size() == 1);
+        REQUIRE(map.timeAt(480) == 600000);
+    }
+
+    SECTION("A tempo of 0 is ignored") {
+        map.add(960, 0);
+        REQUIRE(map.size() == 1);
+    }
+}
+
+TEST_CASE("TempoMap tick to time", "[tempo_map]") {
+    // 120 bpm for two beats, 60 bpm for two beats, then 240 bpm
+    TempoMap map(480, {{960, 1000000}, {0, 500000}, {1920, 250000}});
+
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.timeAt(0) == 0);
+    REQUIRE(map.timeAt(960) == 1000000);
+    REQUIRE(map.timeAt(1440) == 2000000);
+    REQUIRE(map.timeAt(1920) == 3000000);
+    REQUIRE(map.timeAt(2400) == 3250000);
+    REQUIRE(map.durationUs(480, 1440) == 1500000);
+    REQUIRE(map.durationUs(1440, 480) == 0);
+    REQUIRE(map.uSecPerQuarterAt(959) == 500000);
+    REQUIRE(map.uSecPerQuarterAt(960) == 1000000);
+}
+
+TEST_CASE("TempoMap later changes win at equal ticks", "[tempo_map]") {
+    TempoMap map(480, {{960, 400000}, {960, 800000}});
+    REQUIRE(map.size() == 2);
+    REQUIRE(map.uSecPerQuarterAt(960) == 800000);
+}
+
+TEST_CASE("TempoMap does not accumulate per-tick truncation", "[tempo_map]") {
+    // 500001 us per quarter at 480 ppq is 1041.66 us per tick; truncating loses 320 us per beat
+    TempoMap map(480, {{0, 500001}});
+    REQUIRE(map.timeAt(480 * 1000) == 500001000);
+
+    // A file of many tempo changes stays exact at every change
+    std::vector<TempoChange> changes;
+    uint64_t expected = 0;
+    for (uint32_t beat = 0; beat < 200; beat++) {
+        uint32_t uSecPerQuarter = 500000 + beat * 977;
+        changes.push_back({beat * 480, uSecPerQuarter});
+        expected += uSecPerQuarter;
+    }
+    TempoMap ramp(480, changes);
+    REQUIRE(ramp.timeAt(200 * 480) == expected);
+}
+
+TEST_CASE("TempoMap time to tick", "[tempo_map]") {
+    TempoMap map(480, {{0, 500000}, {960, 1000000}, {1920, 250000}});
+
+    SECTION("Inverse of timeAt at tempo points") {
+        for (const TempoChange& change : map.getChanges()) {
+            REQUIRE(map.tickAt(map.timeAt(change.tick)) == change.tick);
+        }
+    }
+
+    SECTION("Time between ticks gives the last tick reached") {
+        REQUIRE(map.tickAt(1500000) == 1200);
+        REQUIRE(map.tickAt(1500001) == 1200);
+        REQUIRE(map.tickAt(3250000) == 2400);
+    }
+
+    SECTION("Round trip at an inexact tempo") {
+        TempoMap odd(480, {{0, 500001}, {1000, 733333}});
+        for (uint32_t tick = 0; tick < 3000; tick += 7) {
+            REQUIRE(odd.tickAt(odd.timeAt(tick)) == tick);
+        }
+    }
+}
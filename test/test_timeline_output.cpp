@@ -0,0 +1,121 @@
+#include "external/catch_amalgamated.hpp"
+#include "../timeline_output.hpp"
+#include "../active_notes.hpp"
+#include "../deadline_wait.hpp"
+#include "../midi_batch.hpp"
+#include "../playback_timeline.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <initializer_list>
+#include <vector>
+
+using namespace MidiPlay;
+
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+class CaptureOutput : public cxxmidi::output::Abstract {
+public:
+    void OpenPort(unsigned int) override {}
+    void ClosePort() override {}
+    void OpenVirtualPort(const std::string&) override {}
+    size_t GetPortCount() override { return 1; }
+    std::string GetPortName(unsigned int) override { return "capture"; }
+    void SendMessage(const cxxmidi::Message* msg) override {
+        sent.emplace_back(msg->begin(), msg->end());
+    }
+    std::vector<std::vector<uint8_t>> sent;
+};
+
+// A two-note chord on channel 1 at tick 0
+cxxmidi::File makeChord() {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    cxxmidi::Track& track = file.AddTrack();
+    track.push_back(makeEvent(0, {0x90, 60, 100}));
+    track.push_back(makeEvent(0, {0x90, 64, 100}));
+    track.push_back(makeEvent(480, {0x80, 60, 0}));
+    track.push_back(makeEvent(0, {0x80, 64, 0}));
+    track.push_back(makeEvent(0, {0xFF, 0x2F}));
+    return file;
+}
+
+void addChord(const PlaybackTimeline& timeline, MidiBatch& batch) {
+    batch.clear();
+    batch.add(timeline.eventAt(0));
+    batch.add(timeline.eventAt(1));
+}
+
+} // namespace
+
+TEST_CASE("TimelineOutput writes a batch in each mode", "[timeline_output][unit]") {
+    cxxmidi::File file = makeChord();
+    PlaybackTimeline timeline(file);
+    CaptureOutput port;
+    DeadlineWait clock;
+    TimelineOutput output(port, clock);
+    MidiBatch batch;
+    batch.reserve(4, 16);
+    addChord(timeline, batch);
+
+    SECTION("One SendMessage per message by default") {
+        REQUIRE(output.getMode() == TimelineOutput::Mode::PerMessage);
+        output.send(batch, DeadlineWait::Clock::now());
+        REQUIRE(port.sent == std::vector<std::vector<uint8_t>>{{0x90, 60, 100}, {0x90, 64, 100}});
+    }
+
+    SECTION("Stream sends the tick with running status") {
+        output.setMode(TimelineOutput::Mode::Stream, timeline);
+        REQUIRE(output.getWireStream() == nullptr);
+        output.send(batch, DeadlineWait::Clock::now());
+        REQUIRE(port.sent == std::vector<std::vector<uint8_t>>{{0x90, 60, 100, 64, 100}});
+    }
+
+    SECTION("Wire sends the bytes encoded when the mode was set") {
+        output.setMode(TimelineOutput::Mode::Wire, timeline);
+        REQUIRE(output.getWireStream() != nullptr);
+        const uint8_t* wire = nullptr;
+        size_t wireSize = 0;
+        REQUIRE(output.wireRange(0, 2, wire, wireSize));
+        output.send(batch, DeadlineWait::Clock::now(), wire, wireSize);
+        REQUIRE(port.sent == std::vector<std::vector<uint8_t>>{{0x90, 60, 100, 64, 100}});
+
+        output.setMode(TimelineOutput::Mode::PerMessage, timeline);
+        REQUIRE(output.getWireStream() == nullptr);
+        REQUIRE_FALSE(output.wireRange(0, 2, wire, wireSize));
+    }
+
+    SECTION("An empty batch sends nothing") {
+        batch.clear();
+        output.send(batch, DeadlineWait::Clock::now());
+        REQUIRE(port.sent.empty());
+    }
+
+    SECTION("Active notes see every message sent") {
+        ActiveNotes notes;
+        output.setActiveNotes(&notes);
+        output.setMode(TimelineOutput::Mode::Stream, timeline);
+        output.send(batch, DeadlineWait::Clock::now());
+        port.sent.clear();
+
+        output.releaseHeldNotes();
+        REQUIRE(port.sent.size() == 2);
+    }
+}
+
+TEST_CASE("TimelineOutput silences the channels of the timeline", "[timeline_output][unit]") {
+    CaptureOutput port;
+    DeadlineWait clock;
+    TimelineOutput output(port, clock);
+
+    output.notesOff(0x0003);    // Channels 1 and 2
+    REQUIRE(port.sent.size() == 2 * 128);
+    REQUIRE(port.sent.front() == std::vector<uint8_t>{0x80, 0, 0});
+    REQUIRE(port.sent.back() == std::vector<uint8_t>{0x81, 127, 0});
+
+    port.sent.clear();
+    output.releaseHeldNotes();  // Without active notes, nothing is known to be held
+    REQUIRE(port.sent.empty());
+}
@@ -0,0 +1,336 @@
+#include "external/catch_amalgamated.hpp"
+#include "../options.hpp"
+#include "../timeline_player.hpp"
+#include "../virtual_clock.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <getopt.h>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace MidiPlay;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+class NullOutput : public cxxmidi::output::Abstract {
+public:
+    void OpenPort(unsigned int) override {}
+    void ClosePort() override {}
+    void OpenVirtualPort(const std::string&) override {}
+    size_t GetPortCount() override { return 1; }
+    std::string GetPortName(unsigned int) override { return "null"; }
+    void SendMessage(const cxxmidi::Message*) override {}
+};
+
+// Keeps the bytes of every SendMessage call
+class CaptureOutput : public NullOutput {
+public:
+    void SendMessage(const cxxmidi::Message* msg) override {
+        sent.emplace_back(msg->begin(), msg->end());
+    }
+    std::vector<std::vector<uint8_t>> sent;
+};
+
+// A chord held for `quarters` quarter notes of 100 ms, 480 ppq
+cxxmidi::File makeHeldChord(uint32_t quarters) {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    cxxmidi::Track& track = file.AddTrack();
+    track.push_back(makeEvent(0, {0xFF, 0x51, 0x01, 0x86, 0xA0}));   // 100000 us per quarter
+    track.push_back(makeEvent(0, {0x90, 60, 100}));
+    track.push_back(makeEvent(0, {0x90, 64, 100}));
+    track.push_back(makeEvent(480 * quarters, {0x80, 60, 0}));
+    track.push_back(makeEvent(0, {0x80, 64, 0}));
+    track.push_back(makeEvent(0, {0xFF, 0x2F}));
+    return file;
+}
+
+// Plays to the end and returns how many heartbeats ran
+struct Run {
+    NullOutput output;
+    VirtualClock clock;
+    TimelinePlayer player;
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::atomic<int> heartbeats{0};
+
+    explicit Run(const cxxmidi::File& file)
+        : player(output, file)
+    {
+        player.setVirtualClock(&clock);
+        player.setCallbackFinished([this]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            finished.notify_one();
+        });
+    }
+
+    bool play() {
+        player.play();
+        std::unique_lock<std::mutex> lock(mutex);
+        return finished.wait_for(lock, std::chrono::seconds(5), [this]() { return done; });
+    }
+};
+
+} // namespace
+
+TEST_CASE("TimelinePlayer heartbeats", "[timeline_player][unit]") {
+    cxxmidi::File file = makeHeldChord(10);     // One second
+
+    SECTION("fixed: every 10 ms of the piece, 0 through 1 s") {
+        Run run(file);
+        run.player.setCallbackHeartbeat([&run]() { run.heartbeats++; });
+        REQUIRE(run.play());
+        REQUIRE(run.heartbeats == 101);
+        REQUIRE(run.player.getHeartbeats() == 101);
+    }
+
+    SECTION("tickless: none unless needed") {
+        Run run(file);
+        run.player.setTickless(true);
+        run.player.setCallbackHeartbeat([&run]() { run.heartbeats++; });
+        REQUIRE(run.play());
+        REQUIRE(run.heartbeats == 0);
+    }
+
+    SECTION("tickless: from the event that needs them until they are no longer needed") {
+        Run run(file);
+        run.player.setTickless(true);
+        run.player.setCallbackEvent([&run](const EventView& event) {
+            if (event.status() == 0x90) {
+                run.player.setHeartbeatNeeded(true);
+            }
+            return true;
+        });
+        run.player.setCallbackHeartbeat([&run]() {
+            if (++run.heartbeats == 5) {
+                run.player.setHeartbeatNeeded(false);
+            }
+        });
+        REQUIRE(run.play());
+        REQUIRE(run.heartbeats == 5);
+    }
+}
+
+TEST_CASE("TimelinePlayer tickless wakes on request", "[timeline_player][integration]") {
+    NullOutput output;
+    cxxmidi::File file = makeHeldChord(3);      // 300 ms
+    TimelinePlayer player(output, file);
+    player.setTickless(true);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    int heartbeats = 0;
+    bool done = false;
+    player.setCallbackHeartbeat([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        heartbeats++;
+        changed.notify_one();
+    });
+    player.setCallbackFinished([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        changed.notify_one();
+    });
+
+    player.play();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    player.requestHeartbeat();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    REQUIRE(changed.wait_for(lock, std::chrono::seconds(5), [&]() { return heartbeats > 0; }));
+    REQUIRE_FALSE(done);    // Long before the chord ends
+    REQUIRE(changed.wait_for(lock, std::chrono::seconds(5), [&]() { return done; }));
+    REQUIRE(heartbeats == 1);
+
+    // Start, the request, the release and the end; no 10 ms ticks in between
+    REQUIRE(player.getWakeups() < 10);
+}
+
+TEST_CASE("TimelinePlayer wire output", "[timeline_player][unit]") {
+    cxxmidi::File file = makeHeldChord(1);
+    CaptureOutput output;
+    VirtualClock clock;
+    TimelinePlayer player(output, file);
+    player.setVirtualClock(&clock);
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    player.setCallbackFinished([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        finished.notify_one();
+    });
+
+    REQUIRE(player.getWireStream() == nullptr);
+    player.setOutputMode(TimelinePlayer::OutputMode::Wire);
+    REQUIRE(player.getWireStream() != nullptr);
+
+    auto play = [&]() {
+        player.play();
+        std::unique_lock<std::mutex> lock(mutex);
+        return finished.wait_for(lock, std::chrono::seconds(5), [&]() { return done; });
+    };
+
+    SECTION("one message per tick, from the pre-encoded bytes") {
+        REQUIRE(play());
+        REQUIRE(output.sent.size() == 2);
+        REQUIRE(output.sent[0] == std::vector<uint8_t>{0x90, 60, 100, 64, 100});
+        REQUIRE(output.sent[1] == std::vector<uint8_t>{0x80, 60, 0, 64, 0});
+    }
+
+    SECTION("a tick the callback trims is encoded as sent") {
+        player.setCallbackEvent([](const EventView& event) {
+            return !(event.status() == 0x90 && event.data()[1] == 64);
+        });
+        REQUIRE(play());
+        REQUIRE(output.sent.size() == 2);
+        REQUIRE(output.sent[0] == std::vector<uint8_t>{0x90, 60, 100});
+        REQUIRE(output.sent[1] == std::vector<uint8_t>{0x80, 60, 0, 64, 0});
+    }
+
+    SECTION("other modes drop the bytes") {
+        player.setOutputMode(TimelinePlayer::OutputMode::Stream);
+        REQUIRE(player.getWireStream() == nullptr);
+    }
+}
+
+TEST_CASE("TimelinePlayer recovers from a lost device", "[timeline_player][unit]") {
+    // Program 19, then a quarter note on each beat of two bars of 4/4
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    cxxmidi::Track& track = file.AddTrack();
+    track.push_back(makeEvent(0, {0xFF, 0x51, 0x01, 0x86, 0xA0}));   // 100000 us per quarter
+    track.push_back(makeEvent(0, {0xFF, 0x58, 4, 2, 24, 8}));
+    track.push_back(makeEvent(0, {0xC0, 19}));
+    for (uint8_t beat = 0; beat < 8; beat++) {
+        track.push_back(makeEvent(beat == 0 ? 0 : 480, {0x90, static_cast<uint8_t>(60 + beat), 100}));
+    }
+    track.push_back(makeEvent(480, {0xFF, 0x2F}));
+
+    CaptureOutput output;
+    VirtualClock clock;
+    ActiveNotes notes;
+    TimelinePlayer player(output, file);
+    player.setVirtualClock(&clock);
+    player.setActiveNotes(&notes);
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    player.setCallbackFinished([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        finished.notify_one();
+    });
+
+    // The connection goes with the third beat of the second bar
+    bool lost = false;
+    player.setCallbackEvent([&](const EventView& event) {
+        if (!lost && event.status() == 0x90 && event[1] == 66) {
+            lost = true;
+            player.deviceLost();
+        }
+        return true;
+    });
+
+    auto play = [&]() {
+        player.play();
+        std::unique_lock<std::mutex> lock(mutex);
+        return finished.wait_for(lock, std::chrono::seconds(5), [&]() { return done; });
+    };
+    auto notesAfter = [&](size_t first) {
+        std::vector<uint8_t> played;
+        for (size_t i = first; i < output.sent.size(); i++) {
+            if (output.sent[i][0] == 0x90 && output.sent[i][2] > 0) {
+                played.push_back(output.sent[i][1]);
+            }
+        }
+        return played;
+    };
+
+    SECTION("resumes at the bar with the program sent again") {
+        int reconnects = 0;
+        player.setCallbackReconnect([&]() {
+            reconnects++;
+            output.sent.clear();
+            return true;
+        });
+        REQUIRE(play());
+        REQUIRE(reconnects == 1);
+        REQUIRE(player.getReconnects() == 1);
+
+        // Held notes released, then the program, then the second bar from its first beat
+        auto program = std::find(output.sent.begin(), output.sent.end(), std::vector<uint8_t>{0xC0, 19});
+        REQUIRE(program != output.sent.end());
+        REQUIRE(notesAfter(program - output.sent.begin()) == std::vector<uint8_t>{64, 65, 66, 67});
+    }
+
+    SECTION("gives up when the device does not come back") {
+        player.setCallbackReconnect([&]() {
+            output.sent.clear();
+            return false;
+        });
+        REQUIRE(play());
+        REQUIRE(player.getReconnects() == 0);
+        REQUIRE(output.sent.empty());
+    }
+
+    SECTION("ignored without a reconnect callback") {
+        REQUIRE(play());
+        REQUIRE(notesAfter(0) == std::vector<uint8_t>{60, 61, 62, 63, 64, 65, 66, 67});
+    }
+}
+
+TEST_CASE("--reconnect implies the timeline player", "[timeline_player][options][unit]") {
+    optind = 0;
+    auto argv = makeArgv({"play", "162", "--reconnect"});
+    Options options(3, argv);
+    REQUIRE(options.parse() == 0);
+    REQUIRE(options.isReconnect());
+    REQUIRE(options.isTimelineEngine());
+    freeArgv(argv, 3);
+}
+
+TEST_CASE("--tickless implies the timeline player", "[timeline_player][options][unit]") {
+    optind = 0;
+    auto argv = makeArgv({"play", "162", "--tickless"});
+    Options options(3, argv);
+    REQUIRE(options.parse() == 0);
+    REQUIRE(options.isTickless());
+    REQUIRE(options.isTimelineEngine());
+    freeArgv(argv, 3);
+}
+
+TEST_CASE("TimelinePlayer on a growing timeline chases with the index it is given", "[timeline_player][unit]") {
+    PlaybackTimeline timeline(480, 4, 16);
+    const uint8_t noteOn[] = {0x90, 60, 100};
+    timeline.append(0, noteOn, sizeof(noteOn));
+    timeline.publish();
+
+    NullOutput output;
+    TimelinePlayer player(output, timeline);
+    REQUIRE(player.getSeekIndex() == nullptr);
+
+    // As MidiLoader::getStreamingSeekIndex(): nothing until the producer completes the timeline
+    const SeekIndex* available = nullptr;
+    player.setSeekIndexSource([&available]() { return available; });
+    REQUIRE(player.getSeekIndex() == nullptr);
+
+    timeline.complete();
+    SeekIndex index(timeline);
+    available = &index;
+    REQUIRE(player.getSeekIndex() == &index);
+}
@@ -0,0 +1,134 @@
+#include "external/catch_amalgamated.hpp"
+#include "../midi_loader.hpp"
+#include "../options.hpp"
+#include "../recording_output.hpp"
+#include "../timing_harness.hpp"
+#include "../virtual_clock.hpp"
+
+#include <cxxmidi/message.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <getopt.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace MidiPlay;
+namespace fs = std::filesystem;
+
+extern char** makeArgv(const std::vector<std::string>& args);
+extern void freeArgv(char** argv, int argc);
+
+namespace {
+
+const std::vector<std::string> CORPUS = {"simple.mid", "with_intro.mid", "ritardando.mid", "dc_al_fine.mid"};
+
+// Load a fixture with two verses, or return false if it is missing
+bool loadFixture(MidiLoader& loader, const std::string& name) {
+    std::string path = "fixtures/test_files/" + name;
+    if (!fs::exists(path)) {
+        WARN("Test file not found: " << path);
+        return false;
+    }
+    optind = 0;
+    auto argv = makeArgv({"play", path, "-n2", "--no-cache"});
+    Options options(4, argv);
+    options.parse();
+    bool loaded = loader.loadFile(path, options);
+    freeArgv(argv, 4);
+    return loaded;
+}
+
+std::string failures(const TimingHarness::Report& report) {
+    std::ostringstream text;
+    for (const std::string& failure : report.failures) {
+        text << failure << "\n";
+    }
+    return text.str();
+}
+
+} // namespace
+
+TEST_CASE("RecordingOutput", "[timing_harness][unit]") {
+    VirtualClock clock;
+    RecordingOutput output(2, &clock);
+    output.setAnnotator([](RecordingOutput::Sample& sample) { sample.section = 3; });
+
+    cxxmidi::Message noteOn(0x90, 60, 100);
+    cxxmidi::Message noteOff(0x80, 60, 0);
+    output.SendMessage(&noteOn);
+    clock.advanceTo(VirtualClock::Clock::time_point(std::chrono::milliseconds(250)));
+    output.SendMessage(&noteOff);
+    output.SendMessage(&noteOn);
+
+    REQUIRE(output.size() == 2);
+    REQUIRE(output.dropped() == 1);
+    REQUIRE(output.at(0).timeNs == 0);
+    REQUIRE(output.at(0).isNoteOn());
+    REQUIRE(output.at(1).timeNs == 250000000);
+    REQUIRE(output.at(1).bytes[0] == 0x80);
+    REQUIRE_FALSE(output.at(1).isNoteOn());
+    REQUIRE(output.at(1).section == 3);
+}
+
+TEST_CASE("Timing accuracy of the schedule", "[timing_harness][integration]") {
+    std::vector<TimingHarness::Report> reports;
+    for (const std::string& name : CORPUS) {
+        MidiLoader loader;
+        if (!loadFixture(loader, name)) {
+            continue;
+        }
+        TimingHarness harness(loader, name);
+        TimingHarness::Report report =
+            harness.run(TimingHarness::Clock::Virtual, TimingHarness::Tolerances::forClock(TimingHarness::Clock::Virtual));
+
+        INFO(name << "\n" << failures(report));
+        REQUIRE(report.passed());
+        REQUIRE(report.interOnset.count > 0);
+        REQUIRE(report.verseGaps.size() >= 1);
+        if (!loader.getIntroSegments().empty() && loader.shouldPlayIntro()) {
+            REQUIRE(report.introJumps.size() == loader.getIntroSegments().size() - 1);
+        }
+        reports.push_back(report);
+    }
+
+    // Kept next to the test runner so releases can be compared
+    std::ofstream out("timing_report.txt");
+    TimingHarness::writeReport(reports, out);
+}
+
+TEST_CASE("Timing accuracy in real time", "[timing_harness][integration][realtime]") {
+    MidiLoader loader;
+    if (!loadFixture(loader, "simple.mid")) {
+        return;
+    }
+    TimingHarness harness(loader, "simple.mid");
+    TimingHarness::Report report =
+        harness.run(TimingHarness::Clock::Real, TimingHarness::Tolerances::forClock(TimingHarness::Clock::Real));
+
+    INFO(failures(report));
+    REQUIRE(report.passed());
+    REQUIRE(report.verseGaps.size() >= 1);
+}
+
+// Plays the whole corpus in real time (a few minutes); run on each Pi before a release
+TEST_CASE("Timing accuracy of the corpus in real time", "[.][timing_harness][realtime]") {
+    std::vector<TimingHarness::Report> reports;
+    for (const std::string& name : CORPUS) {
+        MidiLoader loader;
+        if (!loadFixture(loader, name)) {
+            continue;
+        }
+        TimingHarness harness(loader, name);
+        reports.push_back(
+            harness.run(TimingHarness::Clock::Real, TimingHarness::Tolerances::forClock(TimingHarness::Clock::Real)));
+    }
+
+    std::ofstream out("timing_report_realtime.txt");
+    TimingHarness::writeReport(reports, out);
+    for (const TimingHarness::Report& report : reports) {
+        INFO(report.name << "\n" << failures(report));
+        CHECK(report.passed());
+    }
+}
@@ -0,0 +1,78 @@
+#include "external/catch_amalgamated.hpp"
+#include "../wire_stream.hpp"
+#include "../playback_timeline.hpp"
+
+#include <cxxmidi/event.hpp>
+#include <cxxmidi/file.hpp>
+#include <initializer_list>
+#include <vector>
+
+using namespace MidiPlay;
+using cxxmidi::Event;
+
+extern cxxmidi::Event makeEvent(uint32_t dt, std::initializer_list<uint8_t> bytes);
+
+namespace {
+
+// Tick 0: tempo and a two-note chord; tick 480: the chord released with a note on
+cxxmidi::File makeChords() {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    cxxmidi::Track& track = file.AddTrack();
+    track.push_back(makeEvent(0, {0xFF, 0x51, 0x07, 0xA1, 0x20}));     // 500000 us per quarter
+    track.push_back(makeEvent(0, {0x90, 60, 100}));
+    track.push_back(makeEvent(0, {0x90, 64, 100}));
+    track.push_back(makeEvent(480, {0x90, 60, 0}));
+    track.push_back(makeEvent(0, {0x90, 64, 0}));
+    track.push_back(makeEvent(0, {0xC0, 19}));
+    track.push_back(makeEvent(0, {0xFF, 0x2F}));
+    return file;
+}
+
+std::vector<uint8_t> bytesOf(const WireStream& wire, size_t first, size_t last) {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    REQUIRE(wire.range(first, last, data, size));
+    return std::vector<uint8_t>(data, data + size);
+}
+
+} // namespace
+
+TEST_CASE("WireStream encodes each tick", "[wire_stream][unit]") {
+    cxxmidi::File file = makeChords();
+    PlaybackTimeline timeline(file);
+    WireStream wire(timeline);
+    REQUIRE(wire.size() == timeline.size());
+    REQUIRE(timeline.size() == 6);
+
+    SECTION("meta events are left out and status bytes are shared") {
+        REQUIRE(bytesOf(wire, 0, 3) == std::vector<uint8_t>{0x90, 60, 100, 64, 100});
+    }
+
+    SECTION("running status starts afresh at each tick") {
+        REQUIRE(bytesOf(wire, 3, 6) == std::vector<uint8_t>{0x90, 60, 0, 64, 0, 0xC0, 19});
+    }
+
+    SECTION("consecutive ticks are one range") {
+        REQUIRE(bytesOf(wire, 0, 6).size() == 12);
+        REQUIRE(wire.byteCount() == 12);
+    }
+
+    SECTION("a range inside a tick has no bytes") {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        REQUIRE_FALSE(wire.range(1, 3, data, size));
+        REQUIRE_FALSE(wire.range(3, 4, data, size));
+        REQUIRE_FALSE(wire.range(3, 3, data, size));
+        REQUIRE_FALSE(wire.range(3, 7, data, size));
+    }
+}
+
+TEST_CASE("WireStream of an empty timeline", "[wire_stream][unit]") {
+    cxxmidi::File file;
+    file.SetTimeDivision(480);
+    PlaybackTimeline timeline(file);
+    WireStream wire(timeline);
+    REQUIRE(wire.size() == 0);
+    REQUIRE(wire.byteCount() == 0);
+}
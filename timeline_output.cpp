@@ -0,0 +1,95 @@
+#include "timeline_output.hpp"
+
+#include <algorithm>
+
+namespace MidiPlay {
+
+TimelineOutput::TimelineOutput(cxxmidi::output::Abstract& port, const DeadlineWait& clock)
+    : port_(port)
+    , clock_(clock)
+{
+    message_.reserve(MESSAGE_RESERVE);
+}
+
+void TimelineOutput::reserve(size_t bytes) {
+    message_.reserve(std::max(bytes, MESSAGE_RESERVE));
+}
+
+void TimelineOutput::setMode(Mode mode, const PlaybackTimeline& timeline) {
+    mode_ = mode;
+    if (mode == Mode::Wire && !wire_ && timeline.isComplete()) {
+        wire_ = std::make_unique<WireStream>(timeline);
+    } else if (mode != Mode::Wire) {
+        wire_.reset();
+    }
+}
+
+// Player thread, with no lock held
+void TimelineOutput::send(MidiBatch& batch, Clock::time_point deadline, const uint8_t* wire, size_t wireSize) {
+    if (batch.empty()) {
+        return;
+    }
+
+    // steady_clock is CLOCK_MONOTONIC, the recorder's clock
+    int64_t scheduledNs = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+
+    if (mode_ != Mode::PerMessage) {
+        if (wire) {
+            message_.assign(wire, wire + wireSize);
+        } else {
+            const std::vector<uint8_t>& stream = batch.stream();
+            message_.assign(stream.begin(), stream.end());
+        }
+        if (notes_) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                notes_->observe(batch.message(i));
+            }
+        }
+        if (recorder_) {
+            int64_t sentNs = clock_.nowNs();
+            for (size_t i = 0; i < batch.size(); i++) {
+                recorder_->record(scheduledNs, sentNs);
+            }
+        }
+        port_.SendMessage(&message_);
+        return;
+    }
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        EventView msg = batch.message(i);
+        message_.assign(msg.data(), msg.data() + msg.size());
+        if (notes_) {
+            notes_->observe(msg);
+        }
+        if (recorder_) {
+            recorder_->record(scheduledNs, clock_.nowNs());
+        }
+        port_.SendMessage(&message_);
+    }
+}
+
+void TimelineOutput::notesOff(uint16_t channelMask) {
+    if (notes_) {
+        notes_->release(port_, releaseMessage_, true);
+        return;
+    }
+
+    releaseMessage_[2] = 0;
+    for (uint8_t channel = 0; channel < 16; channel++) {
+        if (channelMask & (1u << channel)) {
+            releaseMessage_[0] = static_cast<uint8_t>(cxxmidi::Message::Type::NoteOff) | channel;
+            for (uint8_t note = 0; note < 128; note++) {
+                releaseMessage_[1] = note;
+                port_.SendMessage(&releaseMessage_);
+            }
+        }
+    }
+}
+
+void TimelineOutput::releaseHeldNotes() {
+    if (notes_) {
+        notes_->release(port_, releaseMessage_);
+    }
+}
+
+} // namespace MidiPlay
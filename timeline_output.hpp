@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cxxmidi/message.hpp>
+#include <cxxmidi/output/abstract.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "active_notes.hpp"
+#include "deadline_wait.hpp"
+#include "jitter_recorder.hpp"
+#include "midi_batch.hpp"
+#include "playback_timeline.hpp"
+#include "wire_stream.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Writes the player's batches, the messages of one tick, to the port
+ *
+ * A batch goes out back to back (Mode::PerMessage) or as a single
+ * running-status byte stream in one SendMessage call (Mode::Stream).
+ * Mode::Wire sends the same stream from a WireStream encoded when the mode
+ * is set, for every tick no event callback changed. Stream and Wire need a
+ * port that accepts several messages per call, such as RawMidiOutput; the
+ * ALSA sequencer port behind cxxmidi::output::Default encodes only one, so
+ * PerMessage is the default.
+ *
+ * Every message sent is shown to the active notes and the jitter recorder.
+ * Configured before playback; send() runs on the player thread only.
+ */
+class TimelineOutput {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode : uint8_t {
+        PerMessage,     // One SendMessage per message, sent back to back
+        Stream,         // One SendMessage per tick, running status applied
+        Wire            // As Stream, with the bytes encoded ahead of playback
+    };
+
+    /**
+     * @param port Output port; must outlive this
+     * @param clock Clock the recorder's send times are read from; must outlive this
+     */
+    TimelineOutput(cxxmidi::output::Abstract& port, const DeadlineWait& clock);
+
+    // Disable copy/move
+    TimelineOutput(const TimelineOutput&) = delete;
+    TimelineOutput& operator=(const TimelineOutput&) = delete;
+
+    /**
+     * @brief Size the send buffer so a tick of this many bytes does not allocate
+     */
+    void reserve(size_t bytes);
+
+    /**
+     * @brief Choose how a batch is written; Wire encodes a complete @p timeline here
+     *
+     * A timeline still streaming in has no end to encode to; its ticks are
+     * encoded as they are sent.
+     */
+    void setMode(Mode mode, const PlaybackTimeline& timeline);
+    Mode getMode() const { return mode_; }
+
+    /**
+     * @brief Pre-encoded bytes of Mode::Wire; nullptr in other modes or while streaming
+     */
+    const WireStream* getWireStream() const { return wire_.get(); }
+
+    void setJitterRecorder(JitterRecorder* recorder) { recorder_ = recorder; }
+    void setActiveNotes(ActiveNotes* notes) { notes_ = notes; }
+
+    /**
+     * @brief Pre-encoded bytes of the whole tick made of events [first, last)
+     * @return false without a WireStream; the batch is then encoded as it is sent
+     */
+    bool wireRange(size_t first, size_t last, const uint8_t*& data, size_t& size) const {
+        return wire_ && wire_->range(first, last, data, size);
+    }
+
+    /**
+     * @brief Send @p batch, recording each message against @p deadline
+     * @param wire Bytes from wireRange() for exactly this batch, or nullptr
+     */
+    void send(MidiBatch& batch, Clock::time_point deadline, const uint8_t* wire = nullptr, size_t wireSize = 0);
+
+    /**
+     * @brief Silence every note: the held ones if notes are tracked, else all of @p channelMask
+     */
+    void notesOff(uint16_t channelMask);
+
+    /**
+     * @brief Release the notes held, if notes are tracked
+     */
+    void releaseHeldNotes();
+
+    static constexpr size_t MESSAGE_RESERVE = 16;   // Longer than any voice message
+
+private:
+    cxxmidi::output::Abstract& port_;
+    const DeadlineWait& clock_;
+    Mode mode_ = Mode::PerMessage;
+    std::unique_ptr<WireStream> wire_;
+    JitterRecorder* recorder_ = nullptr;
+    ActiveNotes* notes_ = nullptr;
+
+    cxxmidi::Message message_;      // Player thread
+    cxxmidi::Message releaseMessage_ = cxxmidi::Message(0, 0, 0);  // notesOff(), releaseHeldNotes(): preallocated
+};
+
+} // namespace MidiPlay
@@ -0,0 +1,452 @@
+#include "timeline_player.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace MidiPlay {
+
+TimelinePlayer::TimelinePlayer(cxxmidi::output::Abstract& output, const cxxmidi::File& file)
+    : ownedTimeline_(std::make_unique<PlaybackTimeline>(file))
+    , timeline_(*ownedTimeline_)
+    , output_(output, wait_)
+    , anchorWall_(Clock::now())
+{
+    reserveBuffers();
+    thread_ = std::thread([this]() { run(); });
+}
+
+TimelinePlayer::TimelinePlayer(cxxmidi::output::Abstract& output, const EventArena& events)
+    : ownedTimeline_(std::make_unique<PlaybackTimeline>(events))
+    , timeline_(*ownedTimeline_)
+    , output_(output, wait_)
+    , anchorWall_(Clock::now())
+{
+    reserveBuffers();
+    thread_ = std::thread([this]() { run(); });
+}
+
+TimelinePlayer::TimelinePlayer(cxxmidi::output::Abstract& output, const PlaybackTimeline& timeline)
+    : timeline_(timeline)
+    , output_(output, wait_)
+    , anchorWall_(Clock::now())
+{
+    reserveBuffers();
+    thread_ = std::thread([this]() { run(); });
+}
+
+void TimelinePlayer::reserveBuffers() {
+    // Size the output buffers for the largest chord so playback never allocates.
+    // Of a growing timeline only the start is known; a bigger chord or chase later grows the batch once.
+    bool complete = timeline_.isComplete();
+    size_t count = timeline_.size();
+    size_t maxMessages = complete ? 0 : STREAMING_BATCH_MESSAGES;
+    size_t maxBytes = 0;
+    for (size_t first = 0; first < count;) {
+        size_t last = first;
+        size_t bytes = 0;
+        while (last < count && timeline_.tickAt(last) == timeline_.tickAt(first)) {
+            bytes += timeline_.eventAt(last).size();
+            last++;
+        }
+        maxMessages = std::max(maxMessages, last - first);
+        maxBytes = std::max(maxBytes, bytes);
+        first = last;
+    }
+    if (!complete) {
+        maxBytes = std::max(maxBytes, maxMessages * 3);
+    }
+    
+    if (complete) {
+        seekIndex_ = std::make_unique<SeekIndex>(timeline_);
+        
+        // The chase and batch buffers trade places when a chase is sent
+        maxMessages = std::max(maxMessages, seekIndex_->getMaxChaseMessages());
+        maxBytes = std::max(maxBytes, seekIndex_->getMaxChaseMessages() * 3);
+        chase_.reserve(maxMessages, maxBytes);
+    }
+    batch_.reserve(maxMessages, maxBytes);
+    output_.reserve(maxBytes);
+}
+
+TimelinePlayer::~TimelinePlayer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void TimelinePlayer::play() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!playing_) {
+        playing_ = true;
+        anchorUs_ = positionUs_;
+        anchorWall_ = wait_.now();
+        generation_++;
+        cv_.notify_one();
+    }
+}
+
+void TimelinePlayer::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    playing_ = false;
+    generation_++;
+    cv_.notify_one();
+}
+
+void TimelinePlayer::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    playing_ = false;
+    seek(timeline_.size(), timeline_.getEndTime());
+    finishRequested_ = true;
+    cv_.notify_one();
+}
+
+void TimelinePlayer::rewind() {
+    goToTick(0);
+}
+
+void TimelinePlayer::goToTick(uint32_t tick) {
+    timeline_.waitForTick(tick);    // Streaming: the producer is nearly always there already
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t index = timeline_.indexAtTick(tick);
+    chaseTo(index);
+    seek(index, timeline_.timeAtTick(tick));
+    cv_.notify_one();
+}
+
+void TimelinePlayer::notesOff() {
+    output_.notesOff(timeline_.getChannelMask());
+}
+
+void TimelinePlayer::releaseHeldNotes() {
+    output_.releaseHeldNotes();
+}
+
+bool TimelinePlayer::setSchedule(const PlaybackSchedule& schedule,
+                                 const PlaybackSchedule::SectionCallback& callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sections_.set(schedule, callback);
+    return true;
+}
+
+void TimelinePlayer::setSpeed(float speed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reanchor(wait_.now());
+    speed_ = std::max(speed, MIN_SPEED);
+    generation_++;
+    cv_.notify_one();
+}
+
+void TimelinePlayer::deviceLost() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recovery_.markLost()) {
+        generation_++;
+        cv_.notify_one();
+    }
+}
+
+void TimelinePlayer::requestHeartbeat() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heartbeatRequested_ = true;
+    cv_.notify_one();
+}
+
+float TimelinePlayer::getSpeed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return speed_;
+}
+
+std::chrono::microseconds TimelinePlayer::currentTimePos() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::chrono::microseconds(positionUs_);
+}
+
+// Player thread: sleep to the next deadline, then run whatever is due
+void TimelinePlayer::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        cv_.wait(lock, [this]() { return quit_ || playing_ || finishRequested_; });
+        if (quit_) {
+            return;
+        }
+        
+        if (recovery_.isLost()) {
+            recover(lock);
+            continue;
+        }
+
+        if (finishRequested_) {
+            finishRequested_ = false;
+            if (startNextSection(lock, lastDeadline_)) {
+                continue;
+            }
+            lock.unlock();
+            if (finishedCallback_) {
+                finishedCallback_();
+            }
+            lock.lock();
+            continue;
+        }
+
+        // Next thing due: an event, a heartbeat or the end of the piece
+        bool complete = timeline_.isComplete();     // Before size(): a completed timeline has its final size
+        bool atEnd = nextIndex_ >= timeline_.size();
+        if (atEnd && !complete) {
+            // Caught up with a streaming load; wait for the producer without holding the lock
+            size_t published = nextIndex_;
+            lock.unlock();
+            timeline_.waitForMore(published, STREAMING_WAIT);
+            lock.lock();
+            continue;
+        }
+        if (heartbeatRequested_) {
+            heartbeatRequested_ = false;
+            if (heartbeatCallback_) {
+                heartbeats_.fetch_add(1, std::memory_order_relaxed);
+                lock.unlock();
+                heartbeatCallback_();
+                lock.lock();
+            }
+            continue;
+        }
+        
+        uint64_t eventUs = atEnd ? timeline_.getEndTime() : timeline_.timeAt(nextIndex_);
+        bool heartbeat = heartbeatCallback_ != nullptr;
+        if (tickless_) {
+            // Skipped heartbeats are not made up for; the next one is the next multiple from here
+            nextHeartbeatUs_ = std::max(nextHeartbeatUs_, heartbeatAtOrAfter(positionUs_));
+            heartbeat = heartbeat && heartbeatNeeded_.load(std::memory_order_relaxed);
+        }
+        heartbeat = heartbeat && nextHeartbeatUs_ <= eventUs;
+        uint64_t targetUs = heartbeat ? nextHeartbeatUs_ : eventUs;
+
+        uint64_t generation = generation_;
+        Clock::time_point deadline = deadlineFor(targetUs);
+        auto changed = [this, generation]() { return quit_ || generation_ != generation || heartbeatRequested_; };
+        if (!wait_.until(cv_, lock, deadline, changed)) {
+            continue;   // Transport changed while waiting; re-evaluate
+        }
+
+        positionUs_ = std::max(positionUs_, targetUs);
+        lastDeadline_ = deadline;
+
+        if (heartbeat) {
+            nextHeartbeatUs_ += HEARTBEAT_INTERVAL_US;
+            heartbeats_.fetch_add(1, std::memory_order_relaxed);
+            lock.unlock();
+            heartbeatCallback_();
+            lock.lock();
+            continue;
+        }
+
+        if (atEnd) {
+            playing_ = false;
+            if (startNextSection(lock, deadline)) {
+                continue;
+            }
+            lock.unlock();
+            if (finishedCallback_) {
+                finishedCallback_();
+            }
+            lock.lock();
+            continue;
+        }
+
+        // Everything at this tick goes out together
+        size_t first = nextIndex_;
+        size_t last = first + 1;
+        while (last < timeline_.size() && timeline_.tickAt(last) == timeline_.tickAt(first)) {
+            last++;
+        }
+        nextIndex_ = last;
+        uint64_t seeks = seeks_;
+        
+        // A chase waiting since the last seek goes out first; swapping keeps both buffers' capacity
+        bool chased = !chase_.empty();
+        if (chased) {
+            std::swap(batch_, chase_);
+            chase_.clear();
+        }
+        
+        lock.unlock();
+        if (chased) {
+            output_.send(batch_, deadline);
+        }
+        size_t handled = dispatchBatch(first, last, generation, deadline);
+        lock.lock();
+        
+        if (handled < last && seeks_ == seeks) {
+            nextIndex_ = handled;   // Stopped in place mid-tick; resume with the rest
+        }
+    }
+}
+
+// Runs on the player thread with no lock held. Returns the index after the
+// last event handled; short of `last` if a callback moved the transport.
+size_t TimelinePlayer::dispatchBatch(size_t first, size_t last, uint64_t generation,
+                                     Clock::time_point deadline) {
+    batch_.clear();
+    bool whole = true;      // Every message of the tick goes out
+    
+    size_t index = first;
+    while (index < last) {
+        EventView event = timeline_.eventAt(index++);
+        bool send = !eventCallback_ || eventCallback_(event);
+        
+        // Tempo is already in the timestamps; meta events are never sent
+        if (!event.empty() && !event.isMeta()) {
+            if (send) {
+                batch_.add(event);
+            } else {
+                whole = false;
+            }
+        }
+        
+        if (eventCallback_ && transportChanged(generation)) {
+            break;
+        }
+    }
+    
+    // The pre-encoded bytes hold the whole tick; anything less is encoded now
+    const uint8_t* wire = nullptr;
+    size_t wireSize = 0;
+    if (whole && index == last) {
+        output_.wireRange(first, last, wire, wireSize);
+    }
+    output_.send(batch_, deadline, wire, wireSize);
+    return index;
+}
+
+// Caller holds mutex_ through lock; it is released while the section callback
+// runs. Returns false when there is no schedule or no section left.
+bool TimelinePlayer::startNextSection(std::unique_lock<std::mutex>& lock, Clock::time_point endedAt) {
+    if (!sections_.isActive()) {
+        return false;
+    }
+    
+    // From the scheduled end, not from now: wake-up latency never lengthens a pause
+    Clock::time_point startAt = endedAt + std::chrono::microseconds(sections_.pauseAfterUs());
+    
+    while (const ScheduledSection* next = sections_.next()) {
+        uint32_t startTick = next->startTick;
+        
+        lock.unlock();
+        bool start = sections_.accept(*next);
+        if (start) {
+            timeline_.waitForTick(startTick);
+        }
+        lock.lock();
+        
+        if (quit_) {
+            return true;
+        }
+        if (start) {
+            // The callback may have changed speed or position; the section starts over regardless
+            size_t index = timeline_.indexAtTick(startTick);
+            chaseTo(index);
+            seek(index, timeline_.timeAtTick(startTick));
+            anchorWall_ = startAt;
+            finishRequested_ = false;
+            playing_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TimelinePlayer::transportChanged(uint64_t generation) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_ != generation;
+}
+
+// Caller holds mutex_
+void TimelinePlayer::seek(size_t index, uint64_t timeUs) {
+    seeks_++;
+    nextIndex_ = index;
+    runStart_ = index;
+    positionUs_ = timeUs;
+    nextHeartbeatUs_ = heartbeatAtOrAfter(timeUs);
+    anchorUs_ = timeUs;
+    anchorWall_ = wait_.now();
+    generation_++;
+}
+
+const SeekIndex* TimelinePlayer::getSeekIndex() const {
+    if (seekIndex_) {
+        return seekIndex_.get();
+    }
+    return seekIndexSource_ ? seekIndexSource_() : nullptr;
+}
+
+// Caller holds mutex_. Queues what the device needs to be in the state the file has at `index`.
+void TimelinePlayer::chaseTo(size_t index) {
+    if (const SeekIndex* seekIndex = getSeekIndex()) {
+        seekIndex->chase(std::min(nextIndex_, timeline_.size()), index, chase_);
+    }
+}
+
+// Caller holds mutex_ through lock; it is released while the callback reconnects
+void TimelinePlayer::recover(std::unique_lock<std::mutex>& lock) {
+    recovery_.acknowledge();
+    uint64_t generation = generation_;
+    
+    lock.unlock();
+    bool reconnected = recovery_.reconnect();
+    if (reconnected) {
+        notesOff();     // Notes that were sounding when the connection went may still be
+    }
+    lock.lock();
+    
+    if (quit_) {
+        return;
+    }
+    if (!reconnected) {
+        playing_ = false;
+        sections_.end();
+        seek(timeline_.size(), timeline_.getEndTime());
+        finishRequested_ = true;
+        return;
+    }
+    
+    // Back to the bar the organ was last sent, unless the transport moved meanwhile
+    size_t index = std::min(nextIndex_, timeline_.size());
+    if (generation_ == generation && index > runStart_) {
+        uint32_t tick = PortRecovery::resumeTick(timeline_, index, runStart_);
+        index = timeline_.indexAtTick(tick);
+        seek(index, timeline_.timeAtTick(tick));
+    }
+    
+    // The organ may have lost every setting; send the file's state there from scratch
+    chase_.clear();
+    if (const SeekIndex* seekIndex = getSeekIndex()) {
+        seekIndex->chase(0, index, chase_);
+    }
+}
+
+// Caller holds mutex_. Moves the anchor to "now" so a new speed applies from here on.
+void TimelinePlayer::reanchor(Clock::time_point now) {
+    if (playing_) {
+        std::chrono::duration<double, std::micro> elapsed = now - anchorWall_;
+        uint64_t reachedUs = anchorUs_ + static_cast<uint64_t>(std::max(0.0, elapsed.count() * speed_));
+        anchorUs_ = std::max(positionUs_, reachedUs);
+    } else {
+        anchorUs_ = positionUs_;
+    }
+    anchorWall_ = now;
+}
+
+uint64_t TimelinePlayer::heartbeatAtOrAfter(uint64_t timeUs) {
+    return (timeUs + HEARTBEAT_INTERVAL_US - 1) / HEARTBEAT_INTERVAL_US * HEARTBEAT_INTERVAL_US;
+}
+
+// Caller holds mutex_
+TimelinePlayer::Clock::time_point TimelinePlayer::deadlineFor(uint64_t timeUs) const {
+    double pieceUs = static_cast<double>(static_cast<int64_t>(timeUs - anchorUs_));
+    std::chrono::duration<double, std::micro> wait(pieceUs / speed_);
+    return anchorWall_ + std::chrono::duration_cast<Clock::duration>(wait);
+}
+
+} // namespace MidiPlay
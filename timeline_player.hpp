@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cxxmidi/file.hpp>
+#include <cxxmidi/output/abstract.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "active_notes.hpp"
+#include "deadline_wait.hpp"
+#include "jitter_recorder.hpp"
+#include "midi_batch.hpp"
+#include "playback_engine.hpp"
+#include "playback_timeline.hpp"
+#include "port_recovery.hpp"
+#include "section_cursor.hpp"
+#include "seek_index.hpp"
+#include "timeline_output.hpp"
+#include "virtual_clock.hpp"
+#include "wire_stream.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief PlaybackEngine that plays a PlaybackTimeline on its own thread
+ *
+ * Every event already carries its absolute time, so the player thread only
+ * sleeps until the next deadline, runs the event callback and sends the
+ * bytes. Deadlines are computed from an anchor (wall clock, timeline time)
+ * taken at play(), seeks and speed changes, so lateness never accumulates.
+ *
+ * All events at one tick are handled as a batch: the event callback runs
+ * for each, then TimelineOutput writes the accepted messages to the port
+ * together, in the OutputMode chosen.
+ *
+ * With a PlaybackSchedule set, the player thread moves from one section to
+ * the next itself (SectionCursor), with no round-trip through the main
+ * thread.
+ *
+ * A timeline still being filled by a streaming load can be played as it
+ * grows: at the published end the player waits for more instead of
+ * finishing, and a seek past it waits until the producer gets there.
+ *
+ * A seek is a binary search in the timeline. For a complete timeline the
+ * player also keeps a SeekIndex (a streamed one is handed its producer's),
+ * and the controller changes a seek skips (organ stops, programs) go out
+ * just before the first event at the new position, so an introduction made
+ * of several segments keeps the registration the file sets for each.
+ *
+ * With a reconnect callback set, deviceLost() makes the player stop
+ * sending and recover the port on its own thread (PortRecovery), then play
+ * on from the start of the bar it had reached.
+ *
+ * The player thread waits for each deadline in a DeadlineWait. With a
+ * VirtualClock set it never sleeps: each deadline moves the clock instead,
+ * for rendering a performance without playing it.
+ *
+ * With precise timing the wait ends in an absolute clock_nanosleep and a
+ * short spin, and a transport change during that stretch is acted on once
+ * it ends.
+ *
+ * The heartbeat callback fires every HEARTBEAT_INTERVAL_US of piece time,
+ * with currentTimePos() reporting exactly that multiple while it runs.
+ * Tickless, it fires on those multiples only while setHeartbeatNeeded(true)
+ * holds, and once, at the current position, after requestHeartbeat(); the
+ * rest of the time the player sleeps straight to the next event, through
+ * held chords and the pauses between verses.
+ *
+ * Callbacks run on the player thread without any lock held, so they may
+ * call back into the engine (stop, goToTick, play, finish) as
+ * MusicalDirector does. Callbacks, the jitter recorder and active notes
+ * must be set before the first play().
+ */
+class TimelinePlayer : public PlaybackEngine {
+public:
+    using OutputMode = TimelineOutput::Mode;
+    
+    /**
+     * @brief Constructor
+     * @param output Output port; must outlive the player
+     * @param file Loaded file, merged into a timeline immediately
+     */
+    TimelinePlayer(cxxmidi::output::Abstract& output, const cxxmidi::File& file);
+
+    /**
+     * @brief Constructor
+     * @param output Output port; must outlive the player
+     * @param events Loaded file's events (MidiLoader::getEvents()), merged into a timeline immediately
+     */
+    TimelinePlayer(cxxmidi::output::Abstract& output, const EventArena& events);
+
+    /**
+     * @brief Constructor for a timeline owned elsewhere, e.g. one a streaming load is filling
+     *
+     * Seeks chase controllers only with an index from setSeekIndexSource().
+     * @param output Output port; must outlive the player
+     * @param timeline Timeline to play; must outlive the player
+     */
+    TimelinePlayer(cxxmidi::output::Abstract& output, const PlaybackTimeline& timeline);
+
+    ~TimelinePlayer() override;
+
+    // Disable copy/move: the player thread refers to this object
+    TimelinePlayer(const TimelinePlayer&) = delete;
+    TimelinePlayer& operator=(const TimelinePlayer&) = delete;
+
+    void play() override;
+    void stop() override;
+    void finish() override;
+    void rewind() override;
+    void goToTick(uint32_t tick) override;
+    void notesOff() override;
+    void releaseHeldNotes() override;
+
+    void setSpeed(float speed) override;
+    float getSpeed() const override;
+
+    std::chrono::microseconds currentTimePos() const override;
+
+    void setCallbackHeartbeat(const Callback& callback) override { heartbeatCallback_ = callback; }
+    void setHeartbeatNeeded(bool needed) override { heartbeatNeeded_.store(needed, std::memory_order_relaxed); }
+    void requestHeartbeat() override;
+    void setCallbackFinished(const Callback& callback) override { finishedCallback_ = callback; }
+    void setCallbackEvent(const EventCallback& callback) override { eventCallback_ = callback; }
+    
+    /**
+     * @brief Reopen the port after deviceLost(); set before the first play()
+     *
+     * Giving up ends playback as if the last section had finished.
+     */
+    using ReconnectCallback = PortRecovery::ReconnectCallback;
+    void setCallbackReconnect(const ReconnectCallback& callback) { recovery_.setCallback(callback); }
+    
+    /**
+     * @brief Say the port stopped delivering; any thread may, and only the first call until reconnected counts
+     *
+     * Playback resumes from the start of the bar last sent to, never
+     * before the point it last started or seeked to. Ignored without a
+     * reconnect callback.
+     */
+    void deviceLost();
+    
+    /**
+     * @brief Times the port was reopened after deviceLost()
+     */
+    uint64_t getReconnects() const { return recovery_.getReconnects(); }
+    void setJitterRecorder(JitterRecorder* recorder) override { output_.setJitterRecorder(recorder); }
+    void setActiveNotes(ActiveNotes* notes) override { output_.setActiveNotes(notes); }
+    bool setSchedule(const PlaybackSchedule& schedule,
+                     const PlaybackSchedule::SectionCallback& callback) override;
+
+    /**
+     * @brief Choose how a tick's messages are written; set before play()
+     *
+     * Wire encodes a complete timeline here, on the calling thread.
+     */
+    void setOutputMode(OutputMode mode) { output_.setMode(mode, timeline_); }
+    OutputMode getOutputMode() const { return output_.getMode(); }
+    
+    /**
+     * @brief Where seeks on a timeline owned elsewhere find its SeekIndex; set before play()
+     * @param source Called on each seek; gives nullptr until the timeline is complete
+     */
+    void setSeekIndexSource(std::function<const SeekIndex*()> source) { seekIndexSource_ = std::move(source); }
+    
+    /**
+     * @brief Heartbeats only when needed or requested; set before play()
+     *
+     * The heartbeat otherwise fires every HEARTBEAT_INTERVAL_US of piece
+     * time. Tickless, it fires on those multiples only while
+     * setHeartbeatNeeded(true) holds, and once after requestHeartbeat(), so
+     * the player sleeps straight through held chords and pauses.
+     */
+    void setTickless(bool tickless) { tickless_ = tickless; }
+    bool isTickless() const { return tickless_; }
+    
+    /**
+     * @brief Times the player thread woke from a wait, and heartbeats run, since construction
+     */
+    uint64_t getWakeups() const { return wait_.getWakeups(); }
+    uint64_t getHeartbeats() const { return heartbeats_.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Sleep with clock_nanosleep and spin to each deadline; set before play()
+     */
+    void setPreciseTiming(bool precise) { wait_.setPrecise(precise); }
+    bool isPreciseTiming() const { return wait_.isPrecise(); }
+
+    /**
+     * @brief Run on a virtual clock instead of the wall clock; set before play()
+     * @param clock Clock that outlives the player, or nullptr for real time
+     */
+    void setVirtualClock(VirtualClock* clock) { wait_.setVirtualClock(clock); }
+    
+    const PlaybackTimeline& getTimeline() const { return timeline_; }
+    
+    /**
+     * @brief Pre-encoded bytes of OutputMode::Wire; nullptr in other modes or while streaming
+     */
+    const WireStream* getWireStream() const { return output_.getWireStream(); }
+    
+    /**
+     * @brief Controller index used on seeks; nullptr while the timeline is still streaming in
+     */
+    const SeekIndex* getSeekIndex() const;
+
+    static constexpr uint64_t HEARTBEAT_INTERVAL_US = 10000;
+    static constexpr float MIN_SPEED = 0.01f;
+    static constexpr size_t STREAMING_BATCH_MESSAGES = 64;  // Batch reserve while the timeline is still growing
+    static constexpr std::chrono::milliseconds STREAMING_WAIT{5};   // Longest wait for the producer between checks
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+    size_t dispatchBatch(size_t first, size_t last, uint64_t generation, Clock::time_point deadline);
+    bool transportChanged(uint64_t generation) const;
+    bool startNextSection(std::unique_lock<std::mutex>& lock, Clock::time_point endedAt);
+    void recover(std::unique_lock<std::mutex>& lock);
+    void reanchor(Clock::time_point now);
+    void seek(size_t index, uint64_t timeUs);
+    void chaseTo(size_t index);
+    Clock::time_point deadlineFor(uint64_t timeUs) const;
+    static uint64_t heartbeatAtOrAfter(uint64_t timeUs);
+    void reserveBuffers();
+
+    std::unique_ptr<PlaybackTimeline> ownedTimeline_;   // Set when built from a file
+    const PlaybackTimeline& timeline_;
+    std::unique_ptr<SeekIndex> seekIndex_;
+    std::function<const SeekIndex*()> seekIndexSource_;    // Timeline owned elsewhere
+    DeadlineWait wait_;
+    TimelineOutput output_;
+
+    Callback heartbeatCallback_;
+    Callback finishedCallback_;
+    EventCallback eventCallback_;
+    bool tickless_ = false;
+    std::atomic<bool> heartbeatNeeded_{false};  // Tickless: periodic heartbeats wanted
+    std::atomic<uint64_t> heartbeats_{0};
+
+    // === State (guarded by mutex_) ===
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t nextIndex_ = 0;          // Next event to dispatch
+    MidiBatch chase_;               // Controller changes skipped by a seek, sent before the next batch
+    uint64_t positionUs_ = 0;       // Piece time reached
+    uint64_t nextHeartbeatUs_ = 0;
+    float speed_ = 1.0f;
+    Clock::time_point anchorWall_;  // Wall clock time of anchorUs_
+    uint64_t anchorUs_ = 0;
+    uint64_t generation_ = 0;       // Bumped by every transport change to cut a wait short
+    uint64_t seeks_ = 0;            // Bumped by every seek
+    size_t runStart_ = 0;           // Event the last seek went to
+    bool playing_ = false;
+    bool finishRequested_ = false;
+    bool quit_ = false;
+    bool heartbeatRequested_ = false;
+    SectionCursor sections_;
+    PortRecovery recovery_;
+    Clock::time_point lastDeadline_;   // Deadline of the last event or heartbeat reached
+
+    MidiBatch batch_;               // Reused for output; touched only by the player thread
+
+    std::thread thread_;            // Started last, after all state is initialized
+};
+
+} // namespace MidiPlay
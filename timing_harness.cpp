@@ -0,0 +1,400 @@
+#include "timing_harness.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "constants.hpp"
+#include "jitter_recorder.hpp"
+#include "playback_orchestrator.hpp"
+#include "playback_synchronizer.hpp"
+#include "recording_output.hpp"
+#include "session_telemetry.hpp"
+#include "timeline_player.hpp"
+#include "virtual_clock.hpp"
+
+namespace MidiPlay {
+
+namespace {
+
+constexpr size_t NOTES_OFF_MESSAGES = 16 * 128;             // notesOff() without active notes tracked
+constexpr int64_t MIN_RITARDANDO_INTERVAL_US = 200000;      // Shorter intervals say more about jitter than the curve
+constexpr int CURVE_STEPS = 32;                             // Integration steps over one interval
+
+TimingHarness::Stats summarize(std::vector<int64_t> errors) {
+    TimingHarness::Stats stats;
+    if (errors.empty()) {
+        return stats;
+    }
+    std::sort(errors.begin(), errors.end());
+    stats.count = errors.size();
+    stats.p50Us = errors[(errors.size() - 1) / 2];
+    stats.p99Us = errors[(errors.size() - 1) * 99 / 100];
+    stats.maxUs = errors.back();
+    return stats;
+}
+
+const char* clockName(TimingHarness::Clock clock) {
+    return clock == TimingHarness::Clock::Virtual ? "virtual" : "real";
+}
+
+} // namespace
+
+// One pass through the piece as heard: the introduction, a verse or the D.C. al Fine return
+struct TimingHarness::Pass {
+    struct Onset {
+        int64_t timeNs;
+        int64_t positionUs;
+        float speed;
+        uint16_t segment;   // Introduction segment; 0 elsewhere
+    };
+
+    ScheduledSection::Kind kind;
+    uint16_t section;
+    std::vector<Onset> onsets;
+};
+
+TimingHarness::Tolerances TimingHarness::Tolerances::forClock(Clock clock) {
+    Tolerances tolerances;
+    if (clock == Clock::Virtual) {
+        // Only rounding to whole microseconds
+        tolerances.interOnsetP99Us = 5;
+        tolerances.interOnsetMaxUs = 5;
+        tolerances.gapUs = 5;
+        tolerances.ritardandoFactor = 0.005;
+    } else {
+        tolerances.interOnsetP99Us = 2000;
+        tolerances.interOnsetMaxUs = 10000;
+        tolerances.gapUs = 5000;
+        tolerances.ritardandoFactor = 0.02;
+    }
+    return tolerances;
+}
+
+TimingHarness::TimingHarness(const MidiLoader& midiLoader, const std::string& name)
+    : midiLoader_(midiLoader)
+    , name_(name)
+{
+}
+
+TimingHarness::Report TimingHarness::run(Clock clock, const Tolerances& tolerances) const {
+    Report report;
+    report.name = name_;
+    report.clock = clock;
+
+    VirtualClock virtualClock;
+    size_t capacity = midiLoader_.getEventCount() * (midiLoader_.getVerses() + 2) + NOTES_OFF_MESSAGES;
+    RecordingOutput output(capacity, clock == Clock::Virtual ? &virtualClock : nullptr);
+    JitterRecorder sections(0);     // Only labels the sections; the engine's own samples are not kept
+    {
+        TimelinePlayer player(output, midiLoader_.getEvents());
+        if (clock == Clock::Virtual) {
+            player.setVirtualClock(&virtualClock);
+        }
+        output.setAnnotator([&player, &sections](RecordingOutput::Sample& sample) {
+            sample.positionUs = player.currentTimePos().count();
+            sample.speed = player.getSpeed();
+            sample.section = sections.section();
+        });
+
+        PlaybackSynchronizer synchronizer;
+        PlaybackOrchestrator orchestrator(player, synchronizer, midiLoader_);
+        orchestrator.initialize();
+        orchestrator.setDisplayWarnings(false);
+        orchestrator.setJitterRecorder(&sections);
+        orchestrator.executePlayback();
+    }   // Joins the player thread before the samples are read
+    output.setAnnotator(nullptr);
+
+    // Onsets by pass; within a verse, going back to the beginning is the D.C. al Fine return
+    std::vector<Pass> passes;
+    for (size_t i = 0; i < output.size(); i++) {
+        const RecordingOutput::Sample& sample = output.at(i);
+        if (!sample.isNoteOn()) {
+            continue;
+        }
+        bool newPass = passes.empty() || passes.back().section != sample.section
+                    || (sample.section != 0 && sample.positionUs < passes.back().onsets.back().positionUs);
+        if (newPass) {
+            ScheduledSection::Kind kind = ScheduledSection::Kind::Verse;
+            if (sample.section == 0) {
+                kind = ScheduledSection::Kind::Introduction;
+            } else if (!passes.empty() && passes.back().section == sample.section) {
+                kind = ScheduledSection::Kind::AlFine;
+            }
+            passes.push_back({kind, sample.section, {}});
+        }
+        passes.back().onsets.push_back({sample.timeNs, sample.positionUs, sample.speed, 0});
+    }
+
+    report.messages = output.size();
+    for (Pass& pass : passes) {
+        report.onsets += pass.onsets.size();
+        if (pass.kind == ScheduledSection::Kind::Introduction) {
+            assignSegments(pass);
+            measureIntroJumps(pass, report);
+        }
+        measureRitardando(pass, report);
+    }
+    report.interOnset = measureInterOnset(passes);
+    measureGaps(passes, report);
+
+    if (output.dropped() > 0) {
+        report.failures.push_back(std::to_string(output.dropped()) + " messages not recorded");
+    }
+    check(tolerances, report);
+    return report;
+}
+
+uint64_t TimingHarness::timeAt(uint32_t tick) const {
+    return midiLoader_.getTempoMap().timeAt(tick);
+}
+
+void TimingHarness::assignSegments(Pass& pass) const {
+    const std::vector<IntroductionSegment>& segments = midiLoader_.getIntroSegments();
+    if (segments.empty()) {
+        return;     // The whole piece, without jumps
+    }
+
+    // A jump goes back, or past the end of the segment playing
+    size_t segment = 0;
+    int64_t previous = 0;
+    for (size_t i = 0; i < pass.onsets.size(); i++) {
+        Pass::Onset& onset = pass.onsets[i];
+        auto pastEnd = [&]() { return onset.positionUs > static_cast<int64_t>(timeAt(segments[segment].end)); };
+        if (i > 0 && onset.positionUs < previous && segment + 1 < segments.size()) {
+            segment++;
+        }
+        while (segment + 1 < segments.size() && pastEnd()) {
+            segment++;
+        }
+        onset.segment = static_cast<uint16_t>(segment);
+        previous = onset.positionUs;
+    }
+}
+
+TimingHarness::Stats TimingHarness::measureInterOnset(const std::vector<Pass>& passes) {
+    std::vector<int64_t> errors;
+    for (const Pass& pass : passes) {
+        for (size_t i = 1; i < pass.onsets.size(); i++) {
+            const Pass::Onset& a = pass.onsets[i - 1];
+            const Pass::Onset& b = pass.onsets[i];
+            // Steady speed only; a ritardando is measured against its curve
+            if (a.segment != b.segment || a.speed != b.speed || b.positionUs < a.positionUs) {
+                continue;
+            }
+            double expectedUs = (b.positionUs - a.positionUs) / static_cast<double>(b.speed);
+            double actualUs = (b.timeNs - a.timeNs) / 1000.0;
+            errors.push_back(std::llround(std::fabs(actualUs - expectedUs)));
+        }
+    }
+    return summarize(std::move(errors));
+}
+
+void TimingHarness::measureGaps(const std::vector<Pass>& passes, Report& report) const {
+    const std::vector<IntroductionSegment>& segments = midiLoader_.getIntroSegments();
+    const std::vector<Directive>& directives = midiLoader_.getDirectives();
+    auto daCapo = std::find_if(directives.begin(), directives.end(),
+                               [](const Directive& directive) { return directive.kind == DirectiveKind::DaCapoAlFine; });
+    uint64_t pieceEndUs = timeAt(midiLoader_.getTotalTicks());
+
+    for (size_t i = 1; i < passes.size(); i++) {
+        const Pass& from = passes[i - 1];
+        const Pass& to = passes[i];
+        if (from.onsets.empty() || to.onsets.empty()) {
+            continue;
+        }
+
+        // Where each section ends and starts in the piece, as PlaybackSchedule plans them
+        uint64_t endUs = pieceEndUs;
+        if (from.kind == ScheduledSection::Kind::Introduction && !segments.empty()) {
+            endUs = timeAt(segments.back().end);
+        } else if (to.kind == ScheduledSection::Kind::AlFine && daCapo != directives.end()) {
+            endUs = timeAt(daCapo->tick);
+        }
+        uint64_t startUs = 0;
+        if (to.kind == ScheduledSection::Kind::Introduction && !segments.empty()) {
+            startUs = timeAt(segments.front().start);
+        }
+        uint64_t pauseUs = to.kind == ScheduledSection::Kind::AlFine ? 0 : midiLoader_.getPauseMicroseconds();
+
+        const Pass::Onset& last = from.onsets.back();
+        const Pass::Onset& first = to.onsets.front();
+        double expectedUs = (static_cast<int64_t>(endUs) - last.positionUs) / static_cast<double>(last.speed)
+                          + static_cast<double>(pauseUs)
+                          + (first.positionUs - static_cast<int64_t>(startUs)) / static_cast<double>(first.speed);
+
+        Gap gap;
+        gap.from = from.section;
+        gap.to = to.section;
+        gap.expectedUs = std::llround(expectedUs);
+        gap.actualUs = (first.timeNs - last.timeNs + 500) / 1000;
+        report.verseGaps.push_back(gap);
+    }
+}
+
+void TimingHarness::measureIntroJumps(const Pass& pass, Report& report) const {
+    const std::vector<IntroductionSegment>& segments = midiLoader_.getIntroSegments();
+    for (size_t i = 1; i < pass.onsets.size(); i++) {
+        const Pass::Onset& last = pass.onsets[i - 1];
+        const Pass::Onset& first = pass.onsets[i];
+        if (first.segment == last.segment) {
+            continue;
+        }
+
+        // The rest of one segment, then straight into the next
+        int64_t endUs = static_cast<int64_t>(timeAt(segments[last.segment].end));
+        int64_t startUs = static_cast<int64_t>(timeAt(segments[first.segment].start));
+        double expectedUs = (endUs - last.positionUs) / static_cast<double>(last.speed)
+                          + (first.positionUs - startUs) / static_cast<double>(first.speed);
+
+        Gap gap;
+        gap.from = last.segment;
+        gap.to = first.segment;
+        gap.expectedUs = std::llround(expectedUs);
+        gap.actualUs = (first.timeNs - last.timeNs + 500) / 1000;
+        report.introJumps.push_back(gap);
+    }
+}
+
+void TimingHarness::measureRitardando(const Pass& pass, Report& report) const {
+    if (pass.onsets.empty()) {
+        return;
+    }
+    float startSpeed = pass.onsets.front().speed;
+    auto slowed = std::find_if(pass.onsets.begin(), pass.onsets.end(),
+                               [startSpeed](const Pass::Onset& onset) { return onset.speed < startSpeed; });
+    if (slowed == pass.onsets.end()) {
+        return;
+    }
+
+    // The marker that started it: the last one before the music slowed
+    const std::vector<Directive>& directives = midiLoader_.getDirectives();
+    const Directive* marker = nullptr;
+    for (const Directive& directive : directives) {
+        if (directive.kind == DirectiveKind::Ritardando
+            && static_cast<int64_t>(timeAt(directive.tick)) <= slowed->positionUs) {
+            marker = &directive;
+        }
+    }
+    int fileTempo = midiLoader_.getFileTempo();
+    if (!marker || fileTempo <= 0) {
+        return;
+    }
+
+    // RitardandoEffector starts the curve at the first heartbeat from the marker
+    constexpr int64_t interval = static_cast<int64_t>(TimelinePlayer::HEARTBEAT_INTERVAL_US);
+    int64_t originUs = (static_cast<int64_t>(timeAt(marker->tick)) + interval - 1) / interval * interval;
+    double beatUs = static_cast<double>(MidiPlay::MICROSECONDS_PER_MINUTE) / fileTempo;
+    auto factorAt = [&](double positionUs) {
+        return static_cast<double>(curve_.factorAt((positionUs - originUs) / beatUs));
+    };
+
+    Ritardando ritardando;
+    ritardando.section = pass.section;
+    ritardando.targetFactor = curve_.getTargetFactor();
+    for (size_t i = 1; i < pass.onsets.size(); i++) {
+        const Pass::Onset& a = pass.onsets[i - 1];
+        const Pass::Onset& b = pass.onsets[i];
+        int64_t pieceUs = b.positionUs - a.positionUs;
+        if (a.positionUs < originUs || a.segment != b.segment || pieceUs < MIN_RITARDANDO_INTERVAL_US) {
+            continue;
+        }
+
+        // Time the curve gives the interval, against the time it took
+        double expectedUs = 0.0;
+        double stepUs = static_cast<double>(pieceUs) / CURVE_STEPS;
+        for (int step = 0; step < CURVE_STEPS; step++) {
+            expectedUs += stepUs / (startSpeed * factorAt(a.positionUs + (step + 0.5) * stepUs));
+        }
+        double actualUs = (b.timeNs - a.timeNs) / 1000.0;
+        if (actualUs <= 0.0) {
+            continue;
+        }
+        double heard = pieceUs / (actualUs * startSpeed);
+        double expected = pieceUs / (expectedUs * startSpeed);
+        ritardando.maxDeviation = std::max(ritardando.maxDeviation, std::fabs(heard - expected));
+        ritardando.intervals++;
+    }
+    ritardando.finalFactor = pass.onsets.back().speed / startSpeed;
+    ritardando.reachedEnd = pass.onsets.back().positionUs >= originUs + curve_.getBeats() * beatUs;
+    report.ritardandos.push_back(ritardando);
+}
+
+void TimingHarness::check(const Tolerances& tolerances, Report& report) {
+    auto fail = [&report](const std::string& what, int64_t value, int64_t limit) {
+        report.failures.push_back(what + " " + std::to_string(value) + " us, over " + std::to_string(limit) + " us");
+    };
+
+    if (report.onsets == 0) {
+        report.failures.push_back("No notes played");
+    }
+    if (report.interOnset.p99Us > tolerances.interOnsetP99Us) {
+        fail("Inter-onset error p99", report.interOnset.p99Us, tolerances.interOnsetP99Us);
+    }
+    if (report.interOnset.maxUs > tolerances.interOnsetMaxUs) {
+        fail("Inter-onset error max", report.interOnset.maxUs, tolerances.interOnsetMaxUs);
+    }
+    for (const Gap& gap : report.verseGaps) {
+        if (std::llabs(gap.errorUs()) > tolerances.gapUs) {
+            fail("Gap " + std::to_string(gap.from) + " -> " + std::to_string(gap.to) + " error",
+                 gap.errorUs(), tolerances.gapUs);
+        }
+    }
+    for (const Gap& gap : report.introJumps) {
+        if (std::llabs(gap.errorUs()) > tolerances.gapUs) {
+            fail("Intro jump " + std::to_string(gap.from) + " -> " + std::to_string(gap.to) + " error",
+                 gap.errorUs(), tolerances.gapUs);
+        }
+    }
+    for (const Ritardando& ritardando : report.ritardandos) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(4);
+        if (ritardando.maxDeviation > tolerances.ritardandoFactor) {
+            text << "Ritardando in section " << ritardando.section << " off the curve by "
+                 << ritardando.maxDeviation << ", over " << tolerances.ritardandoFactor;
+            report.failures.push_back(text.str());
+        } else if (ritardando.reachedEnd
+                   && std::fabs(ritardando.finalFactor - ritardando.targetFactor) > tolerances.ritardandoFactor) {
+            text << "Ritardando in section " << ritardando.section << " ends at " << ritardando.finalFactor
+                 << " instead of " << ritardando.targetFactor;
+            report.failures.push_back(text.str());
+        }
+    }
+}
+
+void TimingHarness::writeReport(const std::vector<Report>& reports, std::ostream& out) {
+    out << "Timing accuracy on " << platformName() << std::endl;
+    for (const Report& report : reports) {
+        out << std::endl << report.name << " (" << clockName(report.clock) << " clock): "
+            << (report.passed() ? "PASS" : "FAIL") << std::endl;
+        out << "  Messages " << report.messages << ", onsets " << report.onsets << std::endl;
+        out << "  Inter-onset error us  p50 " << report.interOnset.p50Us << "  p99 " << report.interOnset.p99Us
+            << "  max " << report.interOnset.maxUs << "  (" << report.interOnset.count << " intervals)" << std::endl;
+        for (const Gap& gap : report.verseGaps) {
+            out << "  Gap " << gap.from << " -> " << gap.to << " us  expected " << gap.expectedUs
+                << "  actual " << gap.actualUs << "  error " << gap.errorUs() << std::endl;
+        }
+        for (const Gap& gap : report.introJumps) {
+            out << "  Intro jump " << gap.from << " -> " << gap.to << " us  expected " << gap.expectedUs
+                << "  actual " << gap.actualUs << "  error " << gap.errorUs() << std::endl;
+        }
+        for (const Ritardando& ritardando : report.ritardandos) {
+            out << std::fixed << std::setprecision(4)
+                << "  Ritardando in section " << ritardando.section << "  deviation " << ritardando.maxDeviation
+                << "  (" << ritardando.intervals << " intervals)  speed " << ritardando.finalFactor
+                << " of " << ritardando.targetFactor << std::endl;
+            out.unsetf(std::ios::floatfield);
+        }
+        for (const std::string& failure : report.failures) {
+            out << "  FAIL: " << failure << std::endl;
+        }
+    }
+}
+
+std::string TimingHarness::platformName() {
+    return SessionTelemetry::platformName();
+}
+
+} // namespace MidiPlay
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "midi_loader.hpp"
+#include "ritardando_curve.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief Plays a loaded hymn into a RecordingOutput and measures when things sounded
+ *
+ * The whole playback flow (PlaybackOrchestrator on a TimelinePlayer) runs as
+ * for a performance, on the real clock or on a VirtualClock. Every note
+ * onset is recorded with its send time and the engine's position and speed,
+ * and compared with what the file and options call for:
+ * - inter-onset error: time between two onsets against their distance in the
+ *   piece at the speed playing, wherever the speed is steady
+ * - verse gaps: last onset of a section to the first of the next, against the
+ *   rest of the section, the pause and the start of the next one
+ * - intro jumps: last onset of an introduction segment to the first of the
+ *   next, against the two segment boundaries
+ * - ritardando shape: the speed heard between onsets after a ritardando
+ *   marker against the RitardandoCurve, and the speed it ends at
+ *
+ * The virtual clock checks the schedule itself, exactly; the real clock adds
+ * the wake-up and send latency of the machine it runs on. A report lists the
+ * results against tolerances, in a form that can be compared between
+ * releases and between machines.
+ */
+class TimingHarness {
+public:
+    enum class Clock : uint8_t {
+        Virtual,    // No waiting; checks the schedule
+        Real        // Plays in real time; checks the machine as well
+    };
+
+    struct Tolerances {
+        int64_t interOnsetP99Us = 0;
+        int64_t interOnsetMaxUs = 0;
+        int64_t gapUs = 0;              // Verse gaps and intro jumps
+        double ritardandoFactor = 0.0;  // Speed factor, heard against the curve
+
+        static Tolerances forClock(Clock clock);
+    };
+
+    /**
+     * @brief Absolute errors in microseconds
+     */
+    struct Stats {
+        size_t count = 0;
+        int64_t p50Us = 0;
+        int64_t p99Us = 0;
+        int64_t maxUs = 0;
+    };
+
+    /**
+     * @brief Silence between two sections, or two introduction segments
+     */
+    struct Gap {
+        uint16_t from = 0;      // Section (verse gaps) or segment (intro jumps)
+        uint16_t to = 0;
+        int64_t expectedUs = 0;
+        int64_t actualUs = 0;
+
+        int64_t errorUs() const { return actualUs - expectedUs; }
+    };
+
+    struct Ritardando {
+        uint16_t section = 0;
+        size_t intervals = 0;       // Onset intervals compared with the curve
+        double maxDeviation = 0.0;  // Speed factor heard against the curve
+        float finalFactor = 1.0f;   // Speed at the last onset over speed at the marker
+        float targetFactor = 1.0f;  // Where the curve ends
+        bool reachedEnd = false;    // The last onset is past the end of the curve
+    };
+
+    struct Report {
+        std::string name;
+        Clock clock = Clock::Virtual;
+        size_t messages = 0;
+        size_t onsets = 0;
+        Stats interOnset;
+        std::vector<Gap> verseGaps;
+        std::vector<Gap> introJumps;
+        std::vector<Ritardando> ritardandos;
+        std::vector<std::string> failures;  // Tolerances exceeded; empty if the run passed
+
+        bool passed() const { return failures.empty(); }
+    };
+
+    /**
+     * @param midiLoader Loaded hymn; its options (verses, tempo, intro) apply
+     * @param name For the report, usually the file name
+     */
+    TimingHarness(const MidiLoader& midiLoader, const std::string& name);
+
+    /**
+     * @brief Play the hymn, measure it and check the tolerances
+     */
+    Report run(Clock clock, const Tolerances& tolerances) const;
+
+    /**
+     * @brief Write reports as a table, headed by the machine they ran on
+     */
+    static void writeReport(const std::vector<Report>& reports, std::ostream& out);
+
+    /**
+     * @brief Board model or machine architecture, as in SessionTelemetry
+     */
+    static std::string platformName();
+
+private:
+    struct Pass;
+
+    const MidiLoader& midiLoader_;
+    std::string name_;
+    RitardandoCurve curve_;     // The orchestrator's: RitardandoEffector's default
+
+    uint64_t timeAt(uint32_t tick) const;
+    void assignSegments(Pass& pass) const;
+    static Stats measureInterOnset(const std::vector<Pass>& passes);
+    void measureGaps(const std::vector<Pass>& passes, Report& report) const;
+    void measureIntroJumps(const Pass& pass, Report& report) const;
+    void measureRitardando(const Pass& pass, Report& report) const;
+    static void check(const Tolerances& tolerances, Report& report);
+};
+
+} // namespace MidiPlay
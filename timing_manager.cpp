@@ -2,9 +2,11 @@
 #include "constants.hpp"
 #include "i18n.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <sys/resource.h>
 
 namespace MidiPlay {
 
@@ -16,10 +18,30 @@ TimingManager::TimingManager()
 
 void TimingManager::startTimer() {
     startTime_ = std::chrono::high_resolution_clock::now();
+    cpuStart_ = processCpuTime();
 }
 
 void TimingManager::endTimer() {
     endTime_ = std::chrono::high_resolution_clock::now();
+    cpuEnd_ = processCpuTime();
+}
+
+std::chrono::microseconds TimingManager::processCpuTime() {
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+         + std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+double TimingManager::getCpuPercent() const {
+    double elapsed = getElapsedSeconds();
+    if (elapsed <= 0.0) {
+        return 0.0;
+    }
+    std::chrono::duration<double> cpu = cpuEnd_ - cpuStart_;
+    return cpu.count() * 100.0 / elapsed;
 }
 
 double TimingManager::getElapsedSeconds() const {
@@ -42,6 +64,51 @@ void TimingManager::displayElapsedTime() const {
               << std::endl << std::endl;
 }
 
+void TimingManager::displayJitterReport(const JitterRecorder& recorder) const {
+    static constexpr size_t BAR_WIDTH = 40;
+    
+    std::cout << _("Send lateness (microseconds):") << std::endl;
+    
+    for (const JitterRecorder::SectionStats& stats : recorder.summarize()) {
+        if (stats.section == 0) {
+            std::cout << _("  Introduction: ");
+        } else {
+            std::cout << _("  Verse ") << stats.section << ": ";
+        }
+        std::cout << stats.count << _(" events, p50 ") << stats.p50Us
+                  << _(", p99 ") << stats.p99Us << _(", max ") << stats.maxUs << std::endl;
+        
+        size_t largest = *std::max_element(stats.histogram.begin(), stats.histogram.end());
+        for (size_t bucket = 0; bucket < JitterRecorder::BUCKET_COUNT; bucket++) {
+            std::ostringstream label;
+            if (bucket < JitterRecorder::BUCKET_LIMITS_US.size()) {
+                label << "< " << JitterRecorder::BUCKET_LIMITS_US[bucket];
+            } else {
+                label << ">= " << JitterRecorder::BUCKET_LIMITS_US.back();
+            }
+            size_t width = largest > 0 ? stats.histogram[bucket] * BAR_WIDTH / largest : 0;
+            std::cout << "    " << std::setw(8) << std::setfill(' ') << label.str() << " "
+                      << std::string(width, '#') << " " << stats.histogram[bucket] << std::endl;
+        }
+    }
+    
+    if (recorder.dropped() > 0) {
+        std::cout << _("  Samples not recorded (buffer full): ") << recorder.dropped() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void TimingManager::displayLoadReport(uint64_t wakeups, uint64_t heartbeats) const {
+    double elapsed = getElapsedSeconds();
+    double perSecond = elapsed > 0.0 ? wakeups / elapsed : 0.0;
+    
+    std::ostringstream line;    // Keeps the fixed format off std::cout
+    line << _("Player load: CPU ") << std::fixed << std::setprecision(1) << getCpuPercent()
+         << _("%, ") << perSecond << _(" wake-ups per second (") << wakeups << _(" wake-ups, ")
+         << heartbeats << _(" heartbeats)");
+    std::cout << line.str() << std::endl << std::endl;
+}
+
 std::string TimingManager::formatTime(int totalSeconds) {
     int minutes = totalSeconds / MidiPlay::SECONDS_PER_MINUTE;
     int seconds = totalSeconds % MidiPlay::SECONDS_PER_MINUTE;
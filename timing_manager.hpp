@@ -1,8 +1,11 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <string>
 
+#include "jitter_recorder.hpp"
+
 namespace MidiPlay {
 
 /**
@@ -12,6 +15,8 @@ namespace MidiPlay {
  * - Session start/end time recording
  * - Elapsed time calculation
  * - Formatted time display (MM:SS format)
+ * - Per-event send lateness report (--jitter)
+ * - Process CPU time over the session, for the player load report
  */
 class TimingManager {
 public:
@@ -50,6 +55,24 @@ public:
      */
     void displayElapsedTime() const;
     
+    /**
+     * @brief Display send lateness per section: p50, p99, max and a histogram
+     * @param recorder Recorder filled during playback
+     */
+    void displayJitterReport(const JitterRecorder& recorder) const;
+    
+    /**
+     * @brief CPU time the process used between startTimer() and endTimer(), in percent of one core
+     */
+    double getCpuPercent() const;
+    
+    /**
+     * @brief Display CPU use and how often the player thread woke
+     * @param wakeups Player thread wake-ups during the session
+     * @param heartbeats Heartbeat callbacks run during the session
+     */
+    void displayLoadReport(uint64_t wakeups, uint64_t heartbeats) const;
+    
     /**
      * @brief Get start time (for SignalHandler compatibility)
      * @return Reference to start time point
@@ -57,17 +80,21 @@ public:
     const std::chrono::time_point<std::chrono::high_resolution_clock>& getStartTime() const {
         return startTime_;
     }
-
-private:
-    std::chrono::time_point<std::chrono::high_resolution_clock> startTime_;
-    std::chrono::time_point<std::chrono::high_resolution_clock> endTime_;
     
     /**
-     * @brief Helper to format elapsed seconds into MM:SS
-     * @param totalSeconds Total elapsed seconds
+     * @brief Format a number of seconds as M:SS
+     * @param totalSeconds Total seconds
      * @return Formatted string
      */
     static std::string formatTime(int totalSeconds);
+
+private:
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime_;
+    std::chrono::time_point<std::chrono::high_resolution_clock> endTime_;
+    std::chrono::microseconds cpuStart_{0};     // User plus system time of the process
+    std::chrono::microseconds cpuEnd_{0};
+    
+    static std::chrono::microseconds processCpuTime();
 };
 
 } // namespace MidiPlay
\ No newline at end of file
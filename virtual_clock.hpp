@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace MidiPlay {
+
+/**
+ * @brief Clock that only moves when told to, for playing without waiting
+ *
+ * A TimelinePlayer given a VirtualClock never sleeps: where it would wait
+ * for a deadline it moves the clock to that deadline and carries on, so a
+ * whole hymn, pauses and ritardandos included, runs as fast as the events
+ * can be handled while every timestamp stays what real playback would use.
+ *
+ * Starts at the steady_clock epoch. Time never goes backwards.
+ */
+class VirtualClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point now() const {
+        return Clock::time_point(Clock::duration(ns_.load(std::memory_order_acquire)));
+    }
+
+    /**
+     * @brief Move to @p time if it is later than now
+     */
+    void advanceTo(Clock::time_point time) {
+        int64_t target = std::chrono::duration_cast<Clock::duration>(time.time_since_epoch()).count();
+        int64_t current = ns_.load(std::memory_order_relaxed);
+        while (target > current && !ns_.compare_exchange_weak(current, target, std::memory_order_release)) {
+            // current now holds the value another thread stored; retry if still earlier
+        }
+    }
+
+    /**
+     * @brief Time since the epoch in nanoseconds, as JitterRecorder samples are
+     */
+    int64_t nowNs() const { return ns_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<int64_t> ns_{0};
+};
+
+} // namespace MidiPlay
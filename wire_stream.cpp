@@ -0,0 +1,34 @@
+#include "wire_stream.hpp"
+
+#include "midi_batch.hpp"
+
+namespace MidiPlay {
+
+WireStream::WireStream(const PlaybackTimeline& timeline) {
+    size_t count = timeline.size();
+    offsets_.assign(count + 1, NOT_TICK_START);
+
+    // About three bytes per message; a chord's repeated status bytes are left out
+    bytes_.reserve(count * 3);
+
+    MidiBatch batch;
+    size_t index = 0;
+    while (index < count) {
+        uint32_t tick = timeline.tickAt(index);
+        offsets_[index] = static_cast<uint32_t>(bytes_.size());
+
+        batch.clear();
+        for (; index < count && timeline.tickAt(index) == tick; index++) {
+            EventView event = timeline.eventAt(index);
+            if (!event.empty() && !event.isMeta()) {
+                batch.add(event);
+            }
+        }
+        const std::vector<uint8_t>& stream = batch.stream();
+        bytes_.insert(bytes_.end(), stream.begin(), stream.end());
+    }
+    offsets_[count] = static_cast<uint32_t>(bytes_.size());
+    bytes_.shrink_to_fit();
+}
+
+} // namespace MidiPlay
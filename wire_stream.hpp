@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "playback_timeline.hpp"
+
+namespace MidiPlay {
+
+/**
+ * @brief A timeline's events encoded once as the bytes a raw MIDI port is sent
+ *
+ * For every tick of a complete PlaybackTimeline, the messages a player sends
+ * (every event but meta events) are encoded ahead of time as one MidiBatch
+ * byte stream with running status, and stored back to back. Sending a tick
+ * is then a single write of bytes that already exist, with no encoding on
+ * the player thread.
+ *
+ * Running status starts afresh at every tick, so each tick's bytes stand on
+ * their own after a seek or a jump. Only whole ticks are encoded: range()
+ * has nothing for a run of events that starts or ends inside one.
+ */
+class WireStream {
+public:
+    /**
+     * @param timeline Complete timeline; only read during construction
+     */
+    explicit WireStream(const PlaybackTimeline& timeline);
+
+    // Disable copy/move
+    WireStream(const WireStream&) = delete;
+    WireStream& operator=(const WireStream&) = delete;
+
+    /**
+     * @brief Encoded bytes of the events first up to last
+     * @return false unless first and last both begin a tick (or last is the end)
+     */
+    bool range(size_t first, size_t last, const uint8_t*& data, size_t& size) const {
+        if (first >= last || last >= offsets_.size()
+            || offsets_[first] == NOT_TICK_START || offsets_[last] == NOT_TICK_START) {
+            return false;
+        }
+        data = bytes_.data() + offsets_[first];
+        size = offsets_[last] - offsets_[first];
+        return true;
+    }
+
+    /**
+     * @brief Events covered; range() takes indexes up to and including this
+     */
+    size_t size() const { return offsets_.size() - 1; }
+
+    /**
+     * @brief Encoded bytes of the whole timeline
+     */
+    size_t byteCount() const { return bytes_.size(); }
+
+    /**
+     * @brief Bytes held, including unused capacity
+     */
+    size_t getMemoryBytes() const {
+        return bytes_.capacity() + offsets_.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr uint32_t NOT_TICK_START = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint8_t> bytes_;
+    std::vector<uint32_t> offsets_;     // Per event, where its tick's bytes start; one more for the end
+};
+
+} // namespace MidiPlay